@@ -424,62 +424,14 @@ bool CG_SkeletalPoseGetAttachment( orientation_t *orient, cgs_skeleton_t *skel,
 //
 //========================================================================
 
-#define TBC_Block_Size	    1024
-static int TBC_Size;
-
-bonepose_t *TBC;        //Temporary Boneposes Cache
-static int TBC_Count;
-
-
-/*
-* CG_InitTemporaryBoneposesCache
-* allocate space for temporary boneposes
-*/
-void CG_InitTemporaryBoneposesCache( void )
-{
-	TBC_Size = TBC_Block_Size;
-	TBC = ( bonepose_t * )CG_Malloc( sizeof( bonepose_t ) * TBC_Size );
-	TBC_Count = 0;
-}
-
-/*
-* CG_ExpandTemporaryBoneposesCache
-*/
-static void CG_ExpandTemporaryBoneposesCache( int num )
-{
-	bonepose_t *temp;
-
-	temp = TBC;
-
-	TBC = ( bonepose_t * )CG_Malloc( sizeof( bonepose_t ) * ( TBC_Size + max( num, TBC_Block_Size ) ) );
-	memcpy( TBC, temp, sizeof( bonepose_t ) * TBC_Size );
-	TBC_Size += max( num, TBC_Block_Size );
-
-	CG_Free( temp );
-}
-
-/*
-* CG_ResetTemporaryBoneposesCache
-*/
-void CG_ResetTemporaryBoneposesCache( void )
-{
-	TBC_Count = 0;
-}
-
 /*
 * CG_RegisterTemporaryExternalBoneposes
 * These boneposes are RESET after drawing EACH FRAME
+* They come from the engine's frame arena, so they never move while the frame is built
 */
 bonepose_t *CG_RegisterTemporaryExternalBoneposes( cgs_skeleton_t *skel )
 {
-	bonepose_t *boneposes;
-	if( ( TBC_Count + skel->numBones ) > TBC_Size )
-		CG_ExpandTemporaryBoneposesCache( skel->numBones );
-
-	boneposes = &TBC[TBC_Count];
-	TBC_Count += skel->numBones;
-
-	return boneposes;
+	return ( bonepose_t * )CG_FrameMalloc( sizeof( bonepose_t ) * skel->numBones );
 }
 
 /*
@@ -503,13 +455,3 @@ cgs_skeleton_t *CG_SetBoneposesForTemporaryEntity( entity_t *ent )
 
 	return skel;
 }
-
-/*
-* CG_FreeTemporaryBoneposesCache
-*/
-void CG_FreeTemporaryBoneposesCache( void )
-{
-	CG_Free( TBC );
-	TBC_Size = 0;
-	TBC_Count = 0;
-}
@@ -949,6 +949,7 @@ extern cvar_t *cg_flashWindowCount;
 
 #define CG_Malloc( size ) trap_MemAlloc( size, __FILE__, __LINE__ )
 #define CG_Free( data ) trap_MemFree( data, __FILE__, __LINE__ )
+#define CG_FrameMalloc( size ) trap_MemFrameAlloc( size, __FILE__, __LINE__ )	// released at the end of the frame
 
 int CG_API( void );
 void CG_Init(	const char *serverName, unsigned int playerNum,
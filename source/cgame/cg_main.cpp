@@ -1181,7 +1181,6 @@ void CG_Init( const char *serverName, unsigned int playerNum,
 	CG_RefreshQuickMenu();
 
 	CG_RegisterVariables();
-	CG_InitTemporaryBoneposesCache();
 	CG_PModelsInit();
 
 	CG_ScreenInit();
@@ -1239,7 +1238,6 @@ void CG_Shutdown( void )
 	CG_DemocamShutdown();
 	CG_ScreenShutdown();
 	CG_UnregisterCGameCommands();
-	CG_FreeTemporaryBoneposesCache();
 }
 
 //======================================================================
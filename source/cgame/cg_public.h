@@ -43,7 +43,7 @@ typedef void ( *fdrawchar_t )( int x, int y, int w, int h, float s1, float t1, f
 
 // cg_public.h -- client game dll information visible to engine
 
-#define	CGAME_API_VERSION   98
+#define	CGAME_API_VERSION   99
 
 //
 // structs and variables shared with the main engine
@@ -255,6 +255,7 @@ typedef struct
 	// managed memory allocation
 	void *( *Mem_Alloc )( size_t size, const char *filename, int fileline );
 	void ( *Mem_Free )( void *data, const char *filename, int fileline );
+	void *( *Mem_FrameAlloc )( size_t size, const char *filename, int fileline );
 
 	// l10n
 	void ( *L10n_ClearDomain )( void );
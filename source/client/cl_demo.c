@@ -265,6 +265,9 @@ void CL_DemoCompleted( void )
 	}
 	demofilelen = demofilelentotal = 0;
 
+	if( cls.demo.keyframes )
+		Mem_ZoneFree( cls.demo.keyframes );
+
 	cls.demo.playing = false;
 	cls.demo.basetime = cls.demo.duration = cls.demo.time = 0;
 	Mem_ZoneFree( cls.demo.filename );
@@ -343,6 +346,57 @@ void CL_ReadDemoPackets( void )
 	cls.demo.play_jump = false;
 }
 
+/*
+* CL_LoadDemoKeyframes
+* 
+* Server demos carry the keyframe index in their meta data, for other
+* demos it's built by scanning the file once and cached next to it.
+*/
+static void CL_LoadDemoKeyframes( void )
+{
+	cls.demo.keyframes_loaded = true;
+	cls.demo.keyframes = Mem_ZoneMalloc( sizeof( *cls.demo.keyframes ) * SNAP_MAX_DEMO_KEYFRAMES );
+
+	cls.demo.numKeyframes = SNAP_GetDemoKeyframes( cls.demo.meta_data, cls.demo.meta_data_realsize, 
+		cls.demo.keyframes, SNAP_MAX_DEMO_KEYFRAMES );
+	if( cls.demo.numKeyframes )
+		return;
+
+	cls.demo.numKeyframes = SNAP_LoadDemoKeyframesCache( cls.demo.filename, demofilelentotal, 
+		cls.demo.keyframes, SNAP_MAX_DEMO_KEYFRAMES );
+	if( cls.demo.numKeyframes )
+		return;
+
+	cls.demo.numKeyframes = SNAP_BuildDemoKeyframes( demofilehandle, cls.demo.keyframes, SNAP_MAX_DEMO_KEYFRAMES );
+	if( cls.demo.numKeyframes )
+		SNAP_SaveDemoKeyframesCache( cls.demo.filename, demofilelentotal, cls.demo.keyframes, cls.demo.numKeyframes );
+
+	Com_DPrintf( "Indexed %i demo keyframes\n", cls.demo.numKeyframes );
+}
+
+/*
+* CL_SeekDemoKeyframe
+* 
+* Reads up to the keyframe only keeping track of the configstrings
+*/
+static void CL_SeekDemoKeyframe( const snapdemokeyframe_t *keyframe )
+{
+	msg_t msg;
+	uint8_t *msgbuf;
+
+	msgbuf = Mem_TempMalloc( MAX_MSGLEN );
+	MSG_Init( &msg, msgbuf, MAX_MSGLEN );
+
+	while( FS_Tell( demofilehandle ) < keyframe->offset )
+	{
+		if( SNAP_ReadDemoMessage( demofilehandle, &msg ) == -1 )
+			break;
+		CL_ParseDemoSeekMessage( &msg );
+	}
+
+	Mem_TempFree( msgbuf );
+}
+
 /*
 * CL_LatchedDemoJump
 * 
@@ -350,21 +404,41 @@ void CL_ReadDemoPackets( void )
 */
 void CL_LatchedDemoJump( void )
 {
+	const snapdemokeyframe_t *keyframe;
+	unsigned int receivedTime;
+
 	if( cls.demo.paused || ! cls.demo.play_jump_latched ) {
 		return;
 	}
 
 	cls.gametime = cls.demo.play_jump_time;
 
-	if( cl.serverTime < cl.snapShots[cl.receivedSnapNum&UPDATE_MASK].serverTime )
+	receivedTime = cl.snapShots[cl.receivedSnapNum&UPDATE_MASK].serverTime;
+	if( cl.serverTime < receivedTime )
 		cl.pendingSnapNum = 0;
 
 	CL_AdjustServerTime( 1 );
 
-	if( cl.serverTime < cl.snapShots[cl.receivedSnapNum&UPDATE_MASK].serverTime )
+	if( !cls.demo.keyframes_loaded )
+		CL_LoadDemoKeyframes();
+	keyframe = SNAP_FindDemoKeyframe( cls.demo.keyframes, cls.demo.numKeyframes, cl.serverTime );
+
+	if( cl.serverTime < receivedTime )
 	{
 		demofilelen = demofilelentotal;
 		FS_Seek( demofilehandle, 0, FS_SEEK_SET );
+		if( keyframe )
+		{
+			// replay the server commands from the start
+			cls.lastExecutedServerCommand = 0;
+			CL_SeekDemoKeyframe( keyframe );
+		}
+		cl.currentSnapNum = cl.receivedSnapNum = 0;
+	}
+	else if( keyframe && keyframe->serverTime > receivedTime && keyframe->offset > FS_Tell( demofilehandle ) )
+	{
+		CL_SeekDemoKeyframe( keyframe );
+		cl.pendingSnapNum = 0;
 		cl.currentSnapNum = cl.receivedSnapNum = 0;
 	}
 
@@ -553,6 +627,92 @@ void CL_DemoJump_f( void )
 	cls.demo.play_jump_latched = true;
 }
 
+#ifdef _DEBUG
+/*
+* CL_DemoSeekTest_f
+* 
+* Rewinds to a keyframe twice, once over the current configstrings like
+* demojump does and once from cleared ones. Both must end up the same,
+* or configstrings changed after the keyframe would survive a rewind.
+* Debug builds only, it replays over the live configstrings and baselines.
+*/
+void CL_DemoSeekTest_f( void )
+{
+	int i, pos, len, lastcmd, changed, mismatches;
+	char *saved, *rewound;
+	const snapdemokeyframe_t *keyframe;
+
+	if( !cls.demo.playing )
+	{
+		Com_Printf( "Can only run demoseektest when playing a demo\n" );
+		return;
+	}
+
+	if( !cls.demo.keyframes_loaded )
+		CL_LoadDemoKeyframes();
+	if( !cls.demo.numKeyframes )
+	{
+		Com_Printf( "demoseektest: the demo has no keyframes\n" );
+		return;
+	}
+
+	keyframe = NULL;
+	if( Cmd_Argc() > 1 )
+		keyframe = SNAP_FindDemoKeyframe( cls.demo.keyframes, cls.demo.numKeyframes, cl.serverTime - atoi( Cmd_Argv( 1 ) ) * 1000 );
+	if( !keyframe )
+		keyframe = &cls.demo.keyframes[0];
+
+	saved = Mem_TempMalloc( sizeof( cl.configstrings ) );
+	rewound = Mem_TempMalloc( sizeof( cl.configstrings ) );
+	memcpy( saved, cl.configstrings, sizeof( cl.configstrings ) );
+
+	pos = FS_Tell( demofilehandle );
+	len = demofilelen;
+	lastcmd = cls.lastExecutedServerCommand;
+
+	FS_Seek( demofilehandle, 0, FS_SEEK_SET );
+	cls.lastExecutedServerCommand = 0;
+	CL_SeekDemoKeyframe( keyframe );
+	memcpy( rewound, cl.configstrings, sizeof( cl.configstrings ) );
+
+	memset( cl.configstrings, 0, sizeof( cl.configstrings ) );
+	FS_Seek( demofilehandle, 0, FS_SEEK_SET );
+	cls.lastExecutedServerCommand = 0;
+	CL_SeekDemoKeyframe( keyframe );
+
+	for( i = 0, changed = 0, mismatches = 0; i < MAX_CONFIGSTRINGS; i++ )
+	{
+		if( strcmp( rewound + i * MAX_CONFIGSTRING_CHARS, cl.configstrings[i] ) )
+			mismatches++;
+		if( strcmp( saved + i * MAX_CONFIGSTRING_CHARS, cl.configstrings[i] ) )
+			changed++;
+	}
+
+	// put everything back where playback left it
+	for( i = 0; i < MAX_CONFIGSTRINGS; i++ )
+	{
+		if( strcmp( saved + i * MAX_CONFIGSTRING_CHARS, cl.configstrings[i] ) ||
+			strcmp( saved + i * MAX_CONFIGSTRING_CHARS, rewound + i * MAX_CONFIGSTRING_CHARS ) )
+		{
+			Q_strncpyz( cl.configstrings[i], saved + i * MAX_CONFIGSTRING_CHARS, sizeof( cl.configstrings[i] ) );
+			CL_GameModule_ConfigString( i, cl.configstrings[i] );
+		}
+	}
+
+	FS_Seek( demofilehandle, pos, FS_SEEK_SET );
+	demofilelen = len;
+	cls.lastExecutedServerCommand = lastcmd;
+
+	Mem_TempFree( rewound );
+	Mem_TempFree( saved );
+
+	Com_Printf( "demoseektest: rewound to %ims, %i configstrings changed since, %i mismatches: %s\n",
+		keyframe->serverTime, changed, mismatches, mismatches ? "FAILED" : "passed" );
+	if( !changed )
+		Com_Printf( "demoseektest: play past a configstring change for a meaningful result\n" );
+}
+#endif
+
 /*
 * CL_PlayDemoToAvi_f
 * 
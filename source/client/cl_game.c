@@ -51,7 +51,7 @@ static inline int CL_GameModule_CM_TransformedPointContents( vec3_t p, struct cm
 
 static inline void CL_GameModule_CM_TransformedBoxTrace( trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
 	struct cmodel_s *cmodel, int brushmask, vec3_t origin, vec3_t angles ) {
-	CM_TransformedBoxTrace( cl.cms, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
+	CM_TransformedBoxTrace( cl.cms, NULL, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
 }
 
 static inline void CL_GameModule_CM_RoundUpToHullSize( vec3_t mins, vec3_t maxs, struct cmodel_s *cmodel ) {
@@ -183,6 +183,13 @@ static void CL_GameModule_MemFree( void *data, const char *filename, int filelin
 	_Mem_Free( data, MEMPOOL_CLIENTGAME, 0, filename, fileline );
 }
 
+/*
+* CL_GameModule_MemFrameAlloc
+*/
+static void *CL_GameModule_MemFrameAlloc( size_t size, const char *filename, int fileline ) {
+	return _Mem_FrameAllocExt( size, 0, 0, filename, fileline );
+}
+
 /*
 * CL_GameModule_SoundUpdate
 */
@@ -545,6 +552,7 @@ void CL_GameModule_Init( void )
 
 	import.Mem_Alloc = CL_GameModule_MemAlloc;
 	import.Mem_Free = CL_GameModule_MemFree;
+	import.Mem_FrameAlloc = CL_GameModule_MemFrameAlloc;
 
 	import.L10n_LoadLangPOFile = &CL_GameModule_L10n_LoadLangPOFile;
 	import.L10n_TranslateString = &CL_GameModule_L10n_TranslateString;
@@ -228,12 +228,11 @@ static void CL_SendConnectPacket( void )
 	userinfo_modified = false;
 
 	Com_DPrintf("CL_MM_Initialized: %d, cls.mm_ticket: %u\n", CL_MM_Initialized(), cls.mm_ticket );
-	if( CL_MM_Initialized() && cls.mm_ticket != 0 )
-		Netchan_OutOfBandPrint( cls.socket, &cls.serveraddress, "connect %i %i %i \"%s\" %i %u\n",
-				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 0, cls.mm_ticket );
-	else
-		Netchan_OutOfBandPrint( cls.socket, &cls.serveraddress, "connect %i %i %i \"%s\" %i\n",
-				APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 0 );
+
+	// the ticket is 0 when we don't have one, it's followed by the codecs we can decompress
+	Netchan_OutOfBandPrint( cls.socket, &cls.serveraddress, "connect %i %i %i \"%s\" %i %u %s\n",
+		APP_PROTOCOL_VERSION, Netchan_GamePort(), cls.challenge, Cvar_Userinfo(), 0,
+		CL_MM_Initialized() ? cls.mm_ticket : 0, Com_NetCodecOffer() );
 }
 
 /*
@@ -1154,6 +1153,8 @@ static void CL_ConnectionlessPacket( const socket_t *socket, const netadr_t *add
 	// server connection
 	if( !strcmp( c, "client_connect" ) )
 	{
+		int codec;
+
 		if( cls.state == CA_CONNECTED )
 		{
 			Com_Printf( "Dup connect received.  Ignored.\n" );
@@ -1176,8 +1177,10 @@ static void CL_ConnectionlessPacket( const socket_t *socket, const netadr_t *add
 		cls.rejected = false;
 
 		Q_strncpyz( cls.session, MSG_ReadStringLine( msg ), sizeof( cls.session ) );
+		codec = Com_NetCodecForName( MSG_ReadStringLine( msg ) );
 
 		Netchan_Setup( &cls.netchan, socket, address, Netchan_GamePort() );
+		cls.netchan.codec = codec < 0 ? NETCODEC_ZLIB : codec;
 		memset( cl.configstrings, 0, sizeof( cl.configstrings ) );
 		CL_SetClientState( CA_HANDSHAKE );
 		CL_AddReliableCommand( "new" );
@@ -1337,7 +1340,7 @@ static bool CL_ProcessPacket( netchan_t *netchan, msg_t *msg )
 	MSG_ReadLong( msg ); // sequence_ack
 	if( msg->compressed )
 	{
-		zerror = Netchan_DecompressMessage( msg );
+		zerror = Netchan_DecompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{
 			// compression error. Drop the packet
@@ -2201,6 +2204,9 @@ static void CL_InitLocal( void )
 	Cmd_AddCommand( "pingserver", CL_PingServer_f );
 	Cmd_AddCommand( "demopause", CL_PauseDemo_f );
 	Cmd_AddCommand( "demojump", CL_DemoJump_f );
+#ifdef _DEBUG
+	Cmd_AddCommand( "demoseektest", CL_DemoSeekTest_f );
+#endif
 	Cmd_AddCommand( "showserverip", CL_ShowServerIP_f );
 	Cmd_AddCommand( "downloadstatus", CL_DownloadStatus_f );
 	Cmd_AddCommand( "downloadcancel", CL_DownloadCancel_f );
@@ -2241,6 +2247,9 @@ static void CL_ShutdownLocal( void )
 	Cmd_RemoveCommand( "pingserver" );
 	Cmd_RemoveCommand( "demopause" );
 	Cmd_RemoveCommand( "demojump" );
+#ifdef _DEBUG
+	Cmd_RemoveCommand( "demoseektest" );
+#endif
 	Cmd_RemoveCommand( "showserverip" );
 	Cmd_RemoveCommand( "downloadstatus" );
 	Cmd_RemoveCommand( "downloadcancel" );
@@ -2421,7 +2430,7 @@ void CL_Netchan_Transmit( msg_t *msg )
 	// do not enable client compression until I fix the compression+fragmentation rare case bug
 	if( ( cl_compresspackets->integer && msg->cursize > 60 ) || cl_compresspackets->integer > 1 )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( &cls.netchan, msg );
 		if( zerror < 0 ) // it's compression error, just send uncompressed
 		{
 			Com_DPrintf( "CL_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
@@ -1461,3 +1461,115 @@ void CL_ParseServerMessage( msg_t *msg )
 	if( cls.demo.recording && !cls.demo.waiting )
 		CL_WriteDemoMessage( msg );
 }
+
+/*
+* CL_SkipServerData
+* 
+* Reads past the serverdata of a demo message without resetting the client state
+*/
+static void CL_SkipServerData( msg_t *msg )
+{
+	int sv_bitflags, numpure;
+
+	MSG_ReadLong( msg );	// protocol
+	MSG_ReadLong( msg );	// servercount
+	MSG_ReadShort( msg );	// snapFrameTime
+	MSG_ReadString( msg );	// base game directory
+	MSG_ReadString( msg );	// game directory
+	MSG_ReadShort( msg );	// playernum
+	MSG_ReadString( msg );	// level name
+
+	sv_bitflags = MSG_ReadByte( msg );
+	if( sv_bitflags & SV_BITFLAGS_HTTP )
+	{
+		if( sv_bitflags & SV_BITFLAGS_HTTP_BASEURL )
+			MSG_ReadString( msg );
+		else
+			MSG_ReadShort( msg );
+	}
+
+	for( numpure = MSG_ReadShort( msg ); numpure > 0; numpure-- )
+	{
+		MSG_ReadString( msg );
+		MSG_ReadLong( msg );
+	}
+}
+
+/*
+* CL_ParseDemoSeekMessage
+* 
+* Used when seeking in demos, only keeps the configstrings and baselines
+* up to date and skips the frames without decoding them.
+*/
+void CL_ParseDemoSeekMessage( msg_t *msg )
+{
+	int cmd, cmdNum, len;
+	char *text;
+
+	while( msg->readcount < msg->cursize )
+	{
+		cmd = MSG_ReadByte( msg );
+
+		switch( cmd )
+		{
+		case svc_nop:
+			break;
+
+		case svc_servercmd:
+		case svc_servercs:
+			cmdNum = 0;
+			if( cmd == svc_servercmd && !cls.reliable )
+				cmdNum = MSG_ReadLong( msg );
+			text = MSG_ReadString( msg );
+
+			if( cmdNum > 0 )
+			{
+				if( cmdNum <= cls.lastExecutedServerCommand )
+					break;
+				cls.lastExecutedServerCommand = cmdNum;
+			}
+
+			Cmd_TokenizeString( text );
+			if( !strcmp( Cmd_Argv( 0 ), "cs" ) )
+				CL_ParseConfigstringCommand();
+			break;
+
+		case svc_spawnbaseline:
+			CL_ParseBaseline( msg );
+			break;
+
+		case svc_clcack:
+			MSG_ReadLong( msg );
+			MSG_ReadLong( msg );
+			break;
+
+		case svc_frame:
+			SNAP_SkipFrame( msg, NULL );
+			break;
+
+		case svc_demoinfo:
+			MSG_ReadLong( msg );
+			MSG_ReadLong( msg );
+			MSG_ReadLong( msg );
+			len = MSG_ReadLong( msg );
+			MSG_SkipData( msg, len );
+			break;
+
+		case svc_extension:
+			MSG_ReadByte( msg );
+			MSG_ReadByte( msg );
+			len = MSG_ReadShort( msg );
+			MSG_SkipData( msg, len );
+			break;
+
+		case svc_serverdata:
+			// the initial configstrings and baselines follow it in the same message
+			CL_SkipServerData( msg );
+			break;
+
+		default:
+			// anything we can't skip ends the message
+			return;
+		}
+	}
+}
@@ -204,6 +204,10 @@ typedef struct
 
 	char meta_data[SNAP_MAX_DEMO_META_DATA_SIZE];
 	size_t meta_data_realsize;
+
+	snapdemokeyframe_t *keyframes;	// loaded on the first jump
+	int numKeyframes;
+	bool keyframes_loaded;
 } cl_demo_t;
 
 typedef cl_demo_t demorec_t;
@@ -566,6 +570,9 @@ void CL_Stop_f( void );
 void CL_Record_f( void );
 void CL_PauseDemo_f( void );
 void CL_DemoJump_f( void );
+#ifdef _DEBUG
+void CL_DemoSeekTest_f( void );
+#endif
 void CL_BeginDemoAviDump( void );
 size_t CL_ReadDemoMetaData( const char *demopath, char *meta_data, size_t meta_data_size );
 char **CL_DemoComplete( const char *partial );
@@ -576,6 +583,7 @@ char **CL_DemoComplete( const char *partial );
 // cl_parse.c
 //
 void CL_ParseServerMessage( msg_t *msg );
+void CL_ParseDemoSeekMessage( msg_t *msg );
 #define SHOWNET(msg,s) _SHOWNET(msg,s,cl_shownet->integer);
 
 void CL_FreeDownloadList( void );
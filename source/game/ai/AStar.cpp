@@ -27,9 +27,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //
 //==========================================
 
-static short int alist[MAX_NODES];  //list contains all studied nodes, Open and Closed together
-static int alist_numNodes;
-
 enum
 {
 	NOLIST,
@@ -39,15 +36,21 @@ enum
 
 typedef struct
 {
+	unsigned int generation;    // the node data is only valid when it matches astarGeneration
 	short int parent;
+	short int list;
+	int heapIndex;              // position inside the open heap while in open list
 	int G;
 	int H;
 
-	short int list;
-
 } astarnode_t;
 
-astarnode_t astarnodes[MAX_NODES];
+static astarnode_t *astarnodes;
+static unsigned int astarGeneration;
+static int astarNumAllocatedNodes;
+
+static short int *openHeap;     // binary min-heap of the open list, sorted by F
+static int openHeap_numNodes;
 
 struct astarpath_s *Apath;
 //==========================================
@@ -55,11 +58,33 @@ struct astarpath_s *Apath;
 //
 //==========================================
 static short int originNode;
-static short int goalNode;
+static short int goalNode;      // -1 when searching the costs to every node
 static short int currentNode;
 
 static int ValidLinksMask;
-#define DEFAULT_MOVETYPES_MASK ( LINK_MOVE|LINK_STAIRS|LINK_FALL|LINK_WATER|LINK_WATERJUMP|LINK_JUMPPAD|LINK_PLATFORM|LINK_TELEPORT );
+#define DEFAULT_MOVETYPES_MASK ( LINK_MOVE|LINK_STAIRS|LINK_FALL|LINK_WATER|LINK_WATERJUMP|LINK_JUMPPAD|LINK_PLATFORM|LINK_TELEPORT )
+
+//==========================================
+// cached costs from an origin node to every other node,
+// they stay valid until the links change
+//==========================================
+#define ASTAR_COSTROWS	64
+
+typedef struct
+{
+	int origin;
+	int movetypes;
+	int numNodes;
+	unsigned int revision;
+	unsigned int lastUsed;
+	int numAllocatedCosts;
+	int *cost;                  // -1 when unreachable
+
+} astarcostrow_t;
+
+static astarcostrow_t astarCostRows[ASTAR_COSTROWS];
+static unsigned int astarCostRevision = 1;
+static unsigned int astarCostCounter;
 //==========================================
 //
 //
@@ -68,7 +93,7 @@ static int ValidLinksMask;
 
 int AStar_nodeIsInClosed( int node )
 {
-	if( astarnodes[node].list == CLOSEDLIST )
+	if( astarnodes[node].generation == astarGeneration && astarnodes[node].list == CLOSEDLIST )
 		return 1;
 
 	return 0;
@@ -76,7 +101,7 @@ int AStar_nodeIsInClosed( int node )
 
 int AStar_nodeIsInOpen( int node )
 {
-	if( astarnodes[node].list == OPENLIST )
+	if( astarnodes[node].generation == astarGeneration && astarnodes[node].list == OPENLIST )
 		return 1;
 
 	return 0;
@@ -84,28 +109,77 @@ int AStar_nodeIsInOpen( int node )
 
 static void AStar_InitLists( void )
 {
-	memset( astarnodes, 0, sizeof( astarnodes ) ); //jabot092
+	// bumping the generation invalidates all the nodes without touching them
+	astarGeneration++;
+	if( !astarGeneration )
+	{
+		memset( astarnodes, 0, sizeof( astarnode_t ) * astarNumAllocatedNodes ); //jabot092
+		astarGeneration = 1;
+	}
+
 	if( Apath ) Apath->numNodes = 0;
-	alist_numNodes = 0;
+	openHeap_numNodes = 0;
 }
 
-static int AStar_PLinkDistance( int n1, int n2 )
+static inline astarnode_t *AStar_TouchNode( int node )
 {
-	int i;
+	astarnode_t *anode = &astarnodes[node];
 
-	//teleporters are exceptional
-	//if( nodes[n1].flags & NODEFLAGS_TELEPORTER_IN )
-	//	n1++; //it's tele out is stored in the next node in the array
+	if( anode->generation != astarGeneration )
+	{
+		anode->generation = astarGeneration;
+		anode->list = NOLIST;
+	}
+
+	return anode;
+}
+
+static inline int AStar_F( int node )
+{
+	return astarnodes[node].G + astarnodes[node].H;
+}
 
-	for( i = 0; i < pLinks[n1].numLinks; i++ )
+static void AStar_HeapUp( int pos )
+{
+	int node = openHeap[pos];
+	int F = AStar_F( node );
+	int parent;
+
+	while( pos > 0 )
 	{
-		if( pLinks[n1].nodes[i] == n2 )
-		{
-			return (int)pLinks[n1].dist[i];
-		}
+		parent = ( pos - 1 ) >> 1;
+		if( AStar_F( openHeap[parent] ) <= F )
+			break;
+
+		openHeap[pos] = openHeap[parent];
+		astarnodes[openHeap[pos]].heapIndex = pos;
+		pos = parent;
+	}
+
+	openHeap[pos] = node;
+	astarnodes[node].heapIndex = pos;
+}
+
+static void AStar_HeapDown( int pos )
+{
+	int node = openHeap[pos];
+	int F = AStar_F( node );
+	int child;
+
+	while( ( child = ( pos << 1 ) + 1 ) < openHeap_numNodes )
+	{
+		if( child + 1 < openHeap_numNodes && AStar_F( openHeap[child + 1] ) < AStar_F( openHeap[child] ) )
+			child++;
+		if( F <= AStar_F( openHeap[child] ) )
+			break;
+
+		openHeap[pos] = openHeap[child];
+		astarnodes[openHeap[pos]].heapIndex = pos;
+		pos = child;
 	}
 
-	return -1;
+	openHeap[pos] = node;
+	astarnodes[node].heapIndex = pos;
 }
 
 static int  Astar_HDist_ManhatanGuess( int node )
@@ -114,6 +188,10 @@ static int  Astar_HDist_ManhatanGuess( int node )
 	int i;
 	int HDist;
 
+	// no heuristic when looking for the costs to all nodes
+	if( goalNode < 0 )
+		return 0;
+
 	//teleporters are exceptional
 	if( nodes[node].flags & NODEFLAGS_TELEPORTER_IN )
 	{
@@ -133,13 +211,7 @@ static int  Astar_HDist_ManhatanGuess( int node )
 
 static void AStar_PutInClosed( int node )
 {
-	if( !astarnodes[node].list )
-	{
-		alist[alist_numNodes] = node;
-		alist_numNodes++;
-	}
-
-	astarnodes[node].list = CLOSEDLIST;
+	AStar_TouchNode( node )->list = CLOSEDLIST;
 }
 
 static void AStar_PutAdjacentsInOpen( int node )
@@ -149,6 +221,8 @@ static void AStar_PutAdjacentsInOpen( int node )
 	for( i = 0; i < pLinks[node].numLinks; i++ )
 	{
 		int addnode;
+		int G;
+		astarnode_t *anode;
 
 		//ignore invalid links
 		if( !( ValidLinksMask & pLinks[node].moveType[i] ) )
@@ -160,82 +234,60 @@ static void AStar_PutAdjacentsInOpen( int node )
 		if( addnode == node )
 			continue;
 
+		anode = AStar_TouchNode( addnode );
+
 		//ignore if it's already in closed list
-		if( AStar_nodeIsInClosed( addnode ) )
+		if( anode->list == CLOSEDLIST )
 			continue;
 
+		G = astarnodes[node].G + pLinks[node].dist[i];
+
 		//if it's already inside open list
-		if( AStar_nodeIsInOpen( addnode ) )
+		if( anode->list == OPENLIST )
 		{
-			int plinkDist;
-
-			plinkDist = AStar_PLinkDistance( node, addnode );
-			if( plinkDist != -1 )
+			//compare G distances and choose best parent
+			if( anode->G > G )
 			{
-				//compare G distances and choose best parent
-				if( astarnodes[addnode].G > ( astarnodes[node].G + plinkDist ) )
-				{
-					astarnodes[addnode].parent = node;
-					astarnodes[addnode].G = astarnodes[node].G + plinkDist;
-				}
+				anode->parent = node;
+				anode->G = G;
+				AStar_HeapUp( anode->heapIndex );
 			}
 		}
 		else
 		{
 			//just put it in
+			anode->parent = node;
+			anode->G = G;
+			anode->H = Astar_HDist_ManhatanGuess( addnode );
+			anode->list = OPENLIST;
 
-			int plinkDist;
-
-			plinkDist = AStar_PLinkDistance( node, addnode );
-			if( plinkDist == -1 )
-			{
-				plinkDist = AStar_PLinkDistance( addnode, node );
-				if( plinkDist == -1 )
-					plinkDist = 999; //jalFIXME
-
-				//ERROR
-				//printf("WARNING: AStar_PutAdjacentsInOpen - Couldn't find distance between nodes\n");
-			}
-
-			//put in global list
-			if( !astarnodes[addnode].list )
-			{
-				alist[alist_numNodes] = addnode;
-				alist_numNodes++;
-			}
-
-			astarnodes[addnode].parent = node;
-			astarnodes[addnode].G = astarnodes[node].G + plinkDist;
-			astarnodes[addnode].H = Astar_HDist_ManhatanGuess( addnode );
-			astarnodes[addnode].list = OPENLIST;
+			openHeap[openHeap_numNodes] = addnode;
+			AStar_HeapUp( openHeap_numNodes++ );
 		}
 	}
 }
 
 static int AStar_FindInOpen_BestF( void )
 {
-	int i;
-	int bestF = -1;
-	int best = -1;
+	int best;
 
-	for( i = 0; i < alist_numNodes; i++ )
-	{
-		int node = alist[i];
+	if( !openHeap_numNodes )
+		return -1;
 
-		if( astarnodes[node].list != OPENLIST )
-			continue;
-
-		if( bestF == -1 || bestF > ( astarnodes[node].G + astarnodes[node].H ) )
-		{
-			bestF = astarnodes[node].G + astarnodes[node].H;
-			best = node;
-		}
+	// the node stays in open list until it gets closed
+	best = openHeap[0];
+	openHeap_numNodes--;
+	if( openHeap_numNodes )
+	{
+		openHeap[0] = openHeap[openHeap_numNodes];
+		AStar_HeapDown( 0 );
 	}
+
 	//printf("BEST:%i\n", best);
 	return best;
 }
 
-static void AStar_ListsToPath( void )
+static bool AStar_ListsToPath( void )
 {
 	int count = 0;
 	int cur = goalNode;
@@ -245,6 +297,14 @@ static void AStar_ListsToPath( void )
 	pnode = Apath->nodes;
 	while( cur != originNode )
 	{
+		// can't happen as nodes appear only once in a path, unless the parents are broken
+		if( count == Apath->numAllocatedNodes )
+		{
+			G_Printf( S_COLOR_RED "AStar_ListsToPath: path from %i to %i doesn't fit in %i nodes\n",
+				originNode, goalNode, Apath->numAllocatedNodes );
+			return false;
+		}
+
 		*pnode = cur;
 		pnode++;
 		cur = astarnodes[cur].parent;
@@ -253,6 +313,7 @@ static void AStar_ListsToPath( void )
 
 	Apath->totalDistance = astarnodes[goalNode].G;
 	Apath->numNodes = count-1;
+	return true;
 }
 
 static int AStar_FillLists( void )
@@ -269,7 +330,7 @@ static int AStar_FillLists( void )
 	return ( currentNode != -1 ); //if -1 path is blocked
 }
 
-int AStar_ResolvePath( int n1, int n2, int movetypes )
+static void AStar_StartSearch( int n1, int n2, int movetypes )
 {
 	ValidLinksMask = movetypes;
 	if( !ValidLinksMask )
@@ -280,6 +341,12 @@ int AStar_ResolvePath( int n1, int n2, int movetypes )
 	originNode = n1;
 	goalNode = n2;
 	currentNode = originNode;
+	AStar_TouchNode( originNode )->G = 0;
+}
+
+int AStar_ResolvePath( int n1, int n2, int movetypes )
+{
+	AStar_StartSearch( n1, n2, movetypes );
 
 	while( !AStar_nodeIsInOpen( goalNode ) )
 	{
@@ -287,7 +354,8 @@ int AStar_ResolvePath( int n1, int n2, int movetypes )
 			return 0; //failed
 	}
 
-	AStar_ListsToPath();
+	if( !AStar_ListsToPath() )
+		return 0; //too long
 
 	return 1;
 }
@@ -299,6 +367,14 @@ int AStar_GetPath( int origin, int goal, int movetypes, struct astarpath_s *path
 	if( goal < 0 )
 		return 0;
 
+	if( path->numAllocatedNodes < nav.num_nodes )
+	{
+		if( path->nodes )
+			G_Free( path->nodes );
+		path->numAllocatedNodes = numAllocatedNodes;
+		path->nodes = ( short int * )G_Malloc( sizeof( short int ) * path->numAllocatedNodes );
+	}
+
 	if( !AStar_ResolvePath( origin, goal, movetypes ) )
 		return 0;
 
@@ -306,3 +382,121 @@ int AStar_GetPath( int origin, int goal, int movetypes, struct astarpath_s *path
 	path->goalNode = goal;
 	return 1;
 }
+
+/*
+* AStar_FreePath
+*/
+void AStar_FreePath( struct astarpath_s *path )
+{
+	if( path->nodes )
+		G_Free( path->nodes );
+	path->nodes = NULL;
+	path->numAllocatedNodes = 0;
+	path->numNodes = 0;
+}
+
+/*
+* AStar_ReserveNodes
+* Called when the navigation nodes storage grows
+*/
+void AStar_ReserveNodes( int numNodes )
+{
+	if( numNodes <= astarNumAllocatedNodes )
+		return;
+
+	// contents don't need preserving, stale generations are reset on allocation
+	if( astarnodes )
+	{
+		G_Free( astarnodes );
+		G_Free( openHeap );
+	}
+
+	astarnodes = ( astarnode_t * )G_Malloc( sizeof( astarnode_t ) * numNodes );
+	openHeap = ( short int * )G_Malloc( sizeof( short int ) * numNodes );
+	astarNumAllocatedNodes = numNodes;
+	astarGeneration = 0;
+}
+
+/*
+* AStar_InvalidateCosts
+* Must be called whenever nodes or links are modified
+*/
+void AStar_InvalidateCosts( void )
+{
+	astarCostRevision++;
+}
+
+/*
+* AStar_BuildCostRow
+* Expands the whole graph from the origin node, without heuristic
+*/
+static void AStar_BuildCostRow( astarcostrow_t *row, int origin, int movetypes )
+{
+	int i;
+
+	if( row->numAllocatedCosts < nav.num_nodes )
+	{
+		if( row->cost )
+			G_Free( row->cost );
+		row->numAllocatedCosts = numAllocatedNodes;
+		row->cost = ( int * )G_Malloc( sizeof( int ) * row->numAllocatedCosts );
+	}
+
+	Apath = NULL;
+	AStar_StartSearch( origin, -1, movetypes );
+	while( AStar_FillLists() );
+
+	for( i = 0; i < nav.num_nodes; i++ )
+		row->cost[i] = AStar_nodeIsInClosed( i ) ? astarnodes[i].G : -1;
+
+	row->origin = origin;
+	row->movetypes = movetypes;
+	row->numNodes = nav.num_nodes;
+	row->revision = astarCostRevision;
+}
+
+/*
+* AStar_GetCost
+* Returns the cost of the shortest path between the two nodes, or -1.
+* Costs from the same origin are cached, so evaluating many goals is cheap.
+*/
+int AStar_GetCost( int origin, int goal, int movetypes )
+{
+	int i;
+	astarcostrow_t *row, *best = NULL;
+
+	if( origin < 0 || goal < 0 )
+		return -1;
+
+	// A* never found a path to its own origin, keep it that way
+	if( origin == goal )
+		return -1;
+
+	if( !movetypes )
+		movetypes = DEFAULT_MOVETYPES_MASK;
+
+	for( i = 0, row = astarCostRows; i < ASTAR_COSTROWS; i++, row++ )
+	{
+		if( row->revision == astarCostRevision && row->origin == origin && row->movetypes == movetypes )
+		{
+			best = row;
+			break;
+		}
+
+		// replace stale rows first, then the least recently used
+		if( !best || ( best->revision == astarCostRevision &&
+			( row->revision != astarCostRevision || row->lastUsed < best->lastUsed ) ) )
+			best = row;
+	}
+
+	row = best;
+	if( row->revision != astarCostRevision || row->origin != origin || row->movetypes != movetypes )
+		AStar_BuildCostRow( row, origin, movetypes );
+
+	row->lastUsed = ++astarCostCounter;
+
+	if( goal >= row->numNodes )
+		return -1;
+
+	return row->cost[goal];
+}
@@ -22,7 +22,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 typedef struct astarpath_s
 {
 	int numNodes;
-	short int nodes[2048]; //MAX_NODES jabot092(2)
+	short int *nodes;           // grown by AStar_GetPath so it can hold a path through every node
+	int numAllocatedNodes;
 	int originNode;
 	int goalNode;
 	int totalDistance;
@@ -37,3 +38,7 @@ int AStar_nodeIsInPath( int node );
 int AStar_ResolvePath( int origin, int goal, int movetypes );
 //===========================================
 int AStar_GetPath( int origin, int goal, int movetypes, struct astarpath_s *path );
+void AStar_FreePath( struct astarpath_s *path );
+int AStar_GetCost( int origin, int goal, int movetypes );
+void AStar_InvalidateCosts( void );
+void AStar_ReserveNodes( int numNodes );
@@ -54,7 +54,7 @@ player_dropping_nodes_t	player;
 */
 static int AI_AddNode( vec3_t origin, int flagsmask )
 {
-	if( nav.num_nodes + 1 > MAX_NODES )
+	if( !AI_ReserveNodes( nav.num_nodes + 1 ) )
 		return -1;
 
 	if( flagsmask & NODEFLAGS_WATER )
@@ -107,6 +107,9 @@ void AI_DeleteNode( int node )
 		nav.num_nodes--;
 		memset( &nodes[nav.num_nodes], 0, sizeof( nav_node_t ) );
 		memset( &pLinks[nav.num_nodes], 0, sizeof( nav_plink_t ) );
+
+		AStar_InvalidateCosts();
+		AI_ResetNodesGrid();
 	}
 }
 
@@ -524,7 +527,7 @@ void AITools_InitEditnodes( void )
 		nav.serverNodesStart = 0;
 
 		// clear up the plinks
-		memset( pLinks, 0, sizeof( nav_plink_t ) * MAX_NODES );
+		memset( pLinks, 0, sizeof( nav_plink_t ) * numAllocatedNodes );
 	}
 
 	Com_Printf( "       : EDIT MODE: ON\n" );
@@ -545,8 +548,8 @@ void AITools_InitMakenodes( void )
 
 		// clear up nodes and plinks
 		nav.num_nodes = nav.serverNodesStart = 0;
-		memset( nodes, 0, sizeof( nav_node_t ) * MAX_NODES );
-		memset( pLinks, 0, sizeof( nav_plink_t ) * MAX_NODES );
+		memset( nodes, 0, sizeof( nav_node_t ) * numAllocatedNodes );
+		memset( pLinks, 0, sizeof( nav_plink_t ) * numAllocatedNodes );
 	}
 
 	Com_Printf( "       : EDIT MODE: ON\n" );
@@ -87,8 +87,8 @@ bool AI_VisibleOrigins( vec3_t spot1, vec3_t spot2 )
 //=================
 int AI_findNodeInRadius( int from, vec3_t org, float rad, bool ignoreHeight )
 {
-	vec3_t eorg;
-	int j;
+	const int *list;
+	int i, count;
 
 	if( from < 0 )
 		return -1;
@@ -99,18 +99,11 @@ int AI_findNodeInRadius( int from, vec3_t org, float rad, bool ignoreHeight )
 	else
 		from++;
 
-	for(; from < nav.num_nodes; from++ )
+	count = AI_NodesInRadius( org, rad, ignoreHeight, &list );
+	for( i = 0; i < count; i++ )
 	{
-		for( j = 0; j < 3; j++ )
-			eorg[j] = org[j] - nodes[from].origin[j];
-
-		if( ignoreHeight )
-			eorg[2] = 0;
-
-		if( VectorLengthFast( eorg ) > rad )
-			continue;
-
-		return from;
+		if( list[i] >= from )
+			return list[i];
 	}
 
 	return -1;
@@ -163,16 +156,16 @@ bool AI_AddLink( int n1, int n2, int linkType )
 {
 	assert( n1 >= 0 );
 	assert( n2 >= 0 );
-	assert( n1 < MAX_NODES );
-	assert( n2 < MAX_NODES );
+	assert( n1 < numAllocatedNodes );
+	assert( n2 < numAllocatedNodes );
 
 	//never store self-link
 	if( n1 == n2 )
 		return false;
 
-	if( n1 < 0 || n1 >= MAX_NODES )
+	if( n1 < 0 || n1 >= numAllocatedNodes )
 		return false;
-	if( n2 < 0 || n2 >= MAX_NODES )
+	if( n2 < 0 || n2 >= numAllocatedNodes )
 		return false;
 
 	if( nodes[n1].flags & NODEFLAGS_DONOTENTER || nodes[n2].flags & NODEFLAGS_DONOTENTER )
@@ -197,6 +190,8 @@ bool AI_AddLink( int n1, int n2, int linkType )
 	
 	pLinks[n1].numLinks++;
 
+	AStar_InvalidateCosts();
+
 	return true;
 }
 
@@ -1090,7 +1085,11 @@ void AI_LinkNavigationFile( bool silent )
 		return;
 
 	if( nav.serverNodesStart && nav.serverNodesStart < nav.num_nodes )
+	{
 		nav.num_nodes = nav.serverNodesStart;
+		AStar_InvalidateCosts();
+		AI_ResetNodesGrid();
+	}
 
 	// remove any possible node flag added by the server
 	for( i = 0; i < nav.num_nodes; i++ )
@@ -65,7 +65,8 @@ extern cvar_t *sv_botpersonality;
 //=============================================================
 
 #define MAX_GOALENTS 1024
-#define MAX_NODES 2048        //jalToDo: needs dynamic alloc (big terrain maps)
+#define MAX_NODES 32767       // node numbers are stored as short int
+#define MIN_ALLOCATED_NODES 2048 // nodes storage grows from this size
 #define NODE_INVALID  -1
 #define NODE_DENSITY 128         // Density setting for nodes
 #define NODE_TIMEOUT 1500 // (milli)seconds to reach the next node
@@ -159,8 +160,9 @@ typedef struct nav_path_s
 
 } nav_path_t;
 
-extern nav_plink_t pLinks[MAX_NODES];      // pLinks array
-extern nav_node_t nodes[MAX_NODES];        // nodes array
+extern nav_plink_t *pLinks;      // pLinks array
+extern nav_node_t *nodes;        // nodes array
+extern int numAllocatedNodes;    // size of the nodes and pLinks arrays
 
 typedef struct
 {
@@ -350,12 +352,15 @@ void AI_NodeReached( edict_t *self );
 int AI_GetNodeFlags( int node );
 void AI_GetNodeOrigin( int node, vec3_t origin );
 bool AI_NodeHasTimedOut( edict_t *self );
+void AI_ResetNodesGrid( void );
+int AI_NodesInRadius( vec3_t org, float rad, bool ignoreHeight, const int **list );
 
 
 // ai_nodes.c
 //----------------------------------------------------------
 
 void AI_InitNavigationData( bool silent );
+bool AI_ReserveNodes( int numNodes );
 void AI_SaveNavigation( void );
 int	    AI_FlagsForNode( vec3_t origin, edict_t *passent );
 bool    AI_LoadPLKFile( char *mapname );
@@ -135,6 +135,7 @@ void G_FreeAI( edict_t *ent )
 	if( ent->ai->type == AI_ISBOT ) {
 		game.numBots--;
 	}
+	AStar_FreePath( &ent->ai->path );
 	G_Free( ent->ai );
 	ent->ai = NULL;
 }
@@ -30,20 +30,220 @@ ai_navigation_t	nav;
 
 int AI_FindCost( int from, int to, int movetypes )
 {
-	astarpath_t path;
+	return AStar_GetCost( from, to, movetypes );
+}
+
+//==========================================
+// nodes grid
+// Uniform grid over the nodes XY plane, so node lookups only visit the cells around
+// the searched origin. Nodes are linked lazily as they are added to the nodes list.
+//==========================================
 
-	if( !AStar_GetPath( from, to, movetypes, &path ) )
-		return -1;
+#define NODES_GRID_CELLSIZE	NODE_DENSITY
+#define NODES_GRID_HASHSIZE	1024        // must be a power of two
 
-	return path.totalDistance;
+typedef struct
+{
+	int node;
+	float dist;
+} nav_candidate_t;
+
+typedef struct
+{
+	int numIndexed;             // nodes below this number are linked into the grid
+	int numAllocated;
+	int *next;                  // next node in the same hash chain
+	int heads[NODES_GRID_HASHSIZE];
+
+	int numCandidates;
+	nav_candidate_t *candidates;
+
+	// last radius query, AI_findNodeInRadius iterates over it repeatedly
+	bool radiusValid;
+	vec3_t radiusOrigin;
+	float radius;
+	bool radiusIgnoreHeight;
+	int numRadiusNodes;
+	int *radiusNodes;
+} nav_nodesgrid_t;
+
+static nav_nodesgrid_t nodesGrid;
+
+static inline int AI_NodesGridCell( float v )
+{
+	return (int)floor( v / NODES_GRID_CELLSIZE );
+}
+
+static inline int AI_NodesGridHash( int cx, int cy )
+{
+	// unsigned, so the multiplications can wrap around
+	return (int)( ( ( (unsigned)cx * 73856093u ) ^ ( (unsigned)cy * 19349663u ) ) & ( NODES_GRID_HASHSIZE - 1 ) );
+}
+
+/*
+* AI_ResetNodesGrid
+* Must be called when nodes are removed or reordered
+*/
+void AI_ResetNodesGrid( void )
+{
+	nodesGrid.numIndexed = 0;
+	nodesGrid.radiusValid = false;
+	memset( nodesGrid.heads, -1, sizeof( nodesGrid.heads ) );
+}
+
+static void AI_UpdateNodesGrid( void )
+{
+	int h;
+
+	if( nodesGrid.numAllocated < numAllocatedNodes )
+	{
+		if( nodesGrid.numAllocated )
+		{
+			G_Free( nodesGrid.next );
+			G_Free( nodesGrid.candidates );
+			G_Free( nodesGrid.radiusNodes );
+		}
+
+		nodesGrid.numAllocated = numAllocatedNodes;
+		nodesGrid.next = ( int * )G_Malloc( sizeof( int ) * nodesGrid.numAllocated );
+		nodesGrid.candidates = ( nav_candidate_t * )G_Malloc( sizeof( nav_candidate_t ) * nodesGrid.numAllocated );
+		nodesGrid.radiusNodes = ( int * )G_Malloc( sizeof( int ) * nodesGrid.numAllocated );
+		AI_ResetNodesGrid();
+	}
+	else if( nav.num_nodes < nodesGrid.numIndexed )
+	{
+		AI_ResetNodesGrid();
+	}
+
+	if( nodesGrid.numIndexed == nav.num_nodes )
+		return;
+
+	for( ; nodesGrid.numIndexed < nav.num_nodes; nodesGrid.numIndexed++ )
+	{
+		h = AI_NodesGridHash( AI_NodesGridCell( nodes[nodesGrid.numIndexed].origin[0] ),
+			AI_NodesGridCell( nodes[nodesGrid.numIndexed].origin[1] ) );
+		nodesGrid.next[nodesGrid.numIndexed] = nodesGrid.heads[h];
+		nodesGrid.heads[h] = nodesGrid.numIndexed;
+	}
+
+	nodesGrid.radiusValid = false;
+}
+
+static inline void AI_TestNodeCandidate( int node, vec3_t org, float rad, bool ignoreHeight, unsigned int flagsmask )
+{
+	vec3_t eorg;
+	float dist;
+
+	if( flagsmask != NODE_ALL && !( nodes[node].flags & flagsmask ) )
+		return;
+
+	VectorSubtract( org, nodes[node].origin, eorg );
+	if( ignoreHeight )
+		eorg[2] = 0;
+
+	dist = VectorLengthFast( eorg );
+	if( dist > rad )
+		return;
+
+	nodesGrid.candidates[nodesGrid.numCandidates].node = node;
+	nodesGrid.candidates[nodesGrid.numCandidates].dist = dist;
+	nodesGrid.numCandidates++;
+}
+
+/*
+* AI_GatherNodes
+* Collects the nodes within rad into nodesGrid.candidates, in no particular order
+*/
+static void AI_GatherNodes( vec3_t org, float rad, bool ignoreHeight, unsigned int flagsmask )
+{
+	int node, cx, cy, mincx, mincy, maxcx, maxcy;
+	float margin;
+
+	AI_UpdateNodesGrid();
+
+	nodesGrid.numCandidates = 0;
+	if( !nav.num_nodes || rad < 0 )
+		return;
+
+	// VectorLengthFast is an approximation, give it some room
+	margin = rad * 0.01f + 1.0f;
+	mincx = AI_NodesGridCell( org[0] - rad - margin );
+	mincy = AI_NodesGridCell( org[1] - rad - margin );
+	maxcx = AI_NodesGridCell( org[0] + rad + margin );
+	maxcy = AI_NodesGridCell( org[1] + rad + margin );
+
+	// huge radius, it's cheaper to go through all of them
+	if( (float)( maxcx - mincx + 1 ) * (float)( maxcy - mincy + 1 ) > nav.num_nodes )
+	{
+		for( node = 0; node < nav.num_nodes; node++ )
+			AI_TestNodeCandidate( node, org, rad, ignoreHeight, flagsmask );
+		return;
+	}
+
+	for( cx = mincx; cx <= maxcx; cx++ )
+	{
+		for( cy = mincy; cy <= maxcy; cy++ )
+		{
+			for( node = nodesGrid.heads[AI_NodesGridHash( cx, cy )]; node != -1; node = nodesGrid.next[node] )
+			{
+				// other cells can share the hash chain
+				if( AI_NodesGridCell( nodes[node].origin[0] ) != cx || AI_NodesGridCell( nodes[node].origin[1] ) != cy )
+					continue;
+
+				AI_TestNodeCandidate( node, org, rad, ignoreHeight, flagsmask );
+			}
+		}
+	}
+}
+
+static int AI_NodeCandidateCmpDist( const void *a, const void *b )
+{
+	const nav_candidate_t *c1 = ( const nav_candidate_t * )a;
+	const nav_candidate_t *c2 = ( const nav_candidate_t * )b;
+
+	if( c1->dist != c2->dist )
+		return c1->dist < c2->dist ? -1 : 1;
+	return c1->node - c2->node;
+}
+
+static int AI_NodeCmp( const void *a, const void *b )
+{
+	return *( const int * )a - *( const int * )b;
+}
+
+/*
+* AI_NodesInRadius
+* Returns the nodes within rad sorted by node number. The last query is cached.
+*/
+int AI_NodesInRadius( vec3_t org, float rad, bool ignoreHeight, const int **list )
+{
+	int i;
+
+	AI_UpdateNodesGrid();
+
+	if( !nodesGrid.radiusValid || nodesGrid.radius != rad || nodesGrid.radiusIgnoreHeight != ignoreHeight
+		|| !VectorCompare( nodesGrid.radiusOrigin, org ) )
+	{
+		AI_GatherNodes( org, rad, ignoreHeight, NODE_ALL );
+
+		for( i = 0; i < nodesGrid.numCandidates; i++ )
+			nodesGrid.radiusNodes[i] = nodesGrid.candidates[i].node;
+		nodesGrid.numRadiusNodes = nodesGrid.numCandidates;
+		qsort( nodesGrid.radiusNodes, nodesGrid.numRadiusNodes, sizeof( int ), AI_NodeCmp );
+
+		VectorCopy( org, nodesGrid.radiusOrigin );
+		nodesGrid.radius = rad;
+		nodesGrid.radiusIgnoreHeight = ignoreHeight;
+		nodesGrid.radiusValid = true;
+	}
+
+	*list = nodesGrid.radiusNodes;
+	return nodesGrid.numRadiusNodes;
 }
 
 int AI_FindClosestReachableNode( vec3_t origin, edict_t *passent, int range, unsigned int flagsmask )
 {
 	int i;
-	float closest;
-	float dist;
-	int node = -1;
 	trace_t	tr;
 	vec3_t maxs, mins;
 
@@ -57,27 +257,23 @@ int AI_FindClosestReachableNode( vec3_t origin, edict_t *passent, int range, uns
 		VectorCopy( vec3_origin, mins );
 	}
 
-	closest = range;
+	AI_GatherNodes( origin, range, false, flagsmask );
+
+	// trace nearest first, the first visible one is the closest
+	qsort( nodesGrid.candidates, nodesGrid.numCandidates, sizeof( nav_candidate_t ), AI_NodeCandidateCmpDist );
 
-	for( i = 0; i < nav.num_nodes; i++ )
+	for( i = 0; i < nodesGrid.numCandidates; i++ )
 	{
-		if( flagsmask == NODE_ALL || nodes[i].flags & flagsmask )
-		{
-			dist = DistanceFast( nodes[i].origin, origin );
+		if( nodesGrid.candidates[i].dist >= range )
+			break;
 
-			if( dist < closest )
-			{
-				// make sure it is visible
-				G_Trace( &tr, origin, mins, maxs, nodes[i].origin, passent, MASK_NODESOLID );
-				if( tr.fraction == 1.0 )
-				{
-					node = i;
-					closest = dist;
-				}
-			}
-		}
+		// make sure it is visible
+		G_Trace( &tr, origin, mins, maxs, nodes[nodesGrid.candidates[i].node].origin, passent, MASK_NODESOLID );
+		if( tr.fraction == 1.0 )
+			return nodesGrid.candidates[i].node;
 	}
-	return node;
+
+	return -1;
 }
 
 int AI_FindClosestNode( vec3_t origin, float mindist, int range, unsigned int flagsmask )
@@ -91,16 +287,15 @@ int AI_FindClosestNode( vec3_t origin, float mindist, int range, unsigned int fl
 
 	closest = range;
 
-	for( i = 0; i < nav.num_nodes; i++ )
+	AI_GatherNodes( origin, range, false, flagsmask );
+
+	for( i = 0; i < nodesGrid.numCandidates; i++ )
 	{
-		if( flagsmask == NODE_ALL || nodes[i].flags & flagsmask )
+		dist = nodesGrid.candidates[i].dist;
+		if( dist > mindist && ( dist < closest || ( dist == closest && node != NODE_INVALID && nodesGrid.candidates[i].node < node ) ) )
 		{
-			dist = DistanceFast( nodes[i].origin, origin );
-			if( dist > mindist && dist < closest )
-			{
-				node = i;
-				closest = dist;
-			}
+			node = nodesGrid.candidates[i].node;
+			closest = dist;
 		}
 	}
 	return node;
@@ -29,8 +29,46 @@ in NO WAY supported by Steve Yeager.
 
 //ACE
 
-nav_plink_t pLinks[MAX_NODES];      // pLinks array
-nav_node_t nodes[MAX_NODES];        // nodes array
+nav_plink_t *pLinks;      // pLinks array
+nav_node_t *nodes;        // nodes array
+int numAllocatedNodes;
+
+/*
+* AI_ReserveNodes
+* Grow the nodes storage so it can hold at least numNodes
+*/
+bool AI_ReserveNodes( int numNodes )
+{
+	int newSize;
+	nav_node_t *newNodes;
+	nav_plink_t *newLinks;
+
+	if( numNodes <= numAllocatedNodes )
+		return true;
+	if( numNodes > MAX_NODES )
+		return false;
+
+	newSize = max( numAllocatedNodes * 2, MIN_ALLOCATED_NODES );
+	clamp( newSize, numNodes, MAX_NODES );
+
+	newNodes = ( nav_node_t * )G_Malloc( sizeof( nav_node_t ) * newSize );
+	newLinks = ( nav_plink_t * )G_Malloc( sizeof( nav_plink_t ) * newSize );
+	if( numAllocatedNodes )
+	{
+		memcpy( newNodes, nodes, sizeof( nav_node_t ) * numAllocatedNodes );
+		memcpy( newLinks, pLinks, sizeof( nav_plink_t ) * numAllocatedNodes );
+		G_Free( nodes );
+		G_Free( pLinks );
+	}
+
+	nodes = newNodes;
+	pLinks = newLinks;
+	numAllocatedNodes = newSize;
+
+	AStar_ReserveNodes( newSize );
+
+	return true;
+}
 
 
 //===========================================================
@@ -93,7 +131,7 @@ static void AI_JumpadGuess_ShowPoint( vec3_t origin, char *modelname )
 	ent->s.modelindex = trap_ModelIndex( modelname );
 	ent->nextThink = level.time + 20000000;
 	ent->think = G_FreeEdict;
-	ent->classname = "checkent";
+	G_SetClassname( ent, "checkent" );
 	ent->r.svflags &= ~SVF_NOCLIENT;
 
 	GClip_LinkEntity( ent );
@@ -120,7 +158,7 @@ static bool AI_PredictJumpadDestity( edict_t *ent, vec3_t out )
 		return false;
 
 	// get target entity
-	target = G_Find( NULL, FOFS( targetname ), ent->target );
+	target = G_FindByTargetname( NULL, ent->target );
 	if( !target )
 		return false;
 
@@ -213,7 +251,7 @@ static int AI_AddNode_JumpPad( edict_t *ent )
 	vec3_t out;
 	int closest_node;
 
-	if( nav.num_nodes + 1 > MAX_NODES )
+	if( !AI_ReserveNodes( nav.num_nodes + 2 ) )
 		return NODE_INVALID;
 
 	if( !AI_PredictJumpadDestity( ent, out ) )
@@ -288,6 +326,9 @@ static int AI_AddNode_Door( edict_t *ent )
 	if( ent->flags & FL_TEAMSLAVE )
 		return NODE_INVALID; // only team master will drop the nodes
 
+	if( !AI_ReserveNodes( nav.num_nodes + 4 ) )
+		return NODE_INVALID;
+
 	for( i = 0; i < 4; i++ )
 		dropped[i] = NODE_INVALID;
 
@@ -457,7 +498,7 @@ static int AI_AddNode_Platform( edict_t *ent )
 	int candidate;
 	vec3_t lorg;
 
-	if( nav.num_nodes + 2 > MAX_NODES )
+	if( !AI_ReserveNodes( nav.num_nodes + 2 ) )
 		return NODE_INVALID;
 
 	if( ent->flags & FL_TEAMSLAVE )
@@ -529,10 +570,10 @@ static int AI_AddNode_Teleporter( edict_t *ent )
 	vec3_t v1, v2;
 	edict_t	*dest;
 
-	if( nav.num_nodes + 1 > MAX_NODES )
+	if( !AI_ReserveNodes( nav.num_nodes + 2 ) )
 		return NODE_INVALID;
 
-	dest = G_Find( NULL, FOFS( targetname ), ent->target );
+	dest = G_FindByTargetname( NULL, ent->target );
 	if( !dest )
 		return NODE_INVALID;
 
@@ -593,7 +634,7 @@ static int AI_AddNode_Teleporter( edict_t *ent )
 */
 static int AI_AddNode_GoalEntityNode( edict_t *ent )
 {
-	if( nav.num_nodes + 1 > MAX_NODES )
+	if( !AI_ReserveNodes( nav.num_nodes + 1 ) )
 		return NODE_INVALID;
 
 	VectorCopy( ent->s.origin, nodes[nav.num_nodes].origin );
@@ -1109,9 +1150,10 @@ bool AI_LoadPLKFile( char *mapname )
 	}
 
 	trap_FS_Read( &nav.num_nodes, sizeof( int ), filenum );
-	if( nav.num_nodes > MAX_NODES )
+	if( nav.num_nodes < 0 || !AI_ReserveNodes( nav.num_nodes ) )
 	{
 		trap_FS_FCloseFile( filenum );
+		nav.num_nodes = 0;
 		G_Printf( "AI_LoadPLKFile: Too many nodes\n" );
 		return false;
 	}
@@ -1205,8 +1247,11 @@ void AI_InitNavigationData( bool silent )
 	const int maxgoalEnts = sizeof( nav.goalEnts ) / sizeof( nav.goalEnts[0] );
 
 	memset( &nav, 0, sizeof( nav ) );
-	memset( nodes, 0, sizeof( nav_node_t ) * MAX_NODES );
-	memset( pLinks, 0, sizeof( nav_plink_t ) * MAX_NODES );
+	AI_ReserveNodes( MIN_ALLOCATED_NODES );
+	memset( nodes, 0, sizeof( nav_node_t ) * numAllocatedNodes );
+	memset( pLinks, 0, sizeof( nav_plink_t ) * numAllocatedNodes );
+	AStar_InvalidateCosts();
+	AI_ResetNodesGrid();
 
 	nav.goalEntsFree = nav.goalEnts;
 	nav.goalEntsHeadnode.id = -1;
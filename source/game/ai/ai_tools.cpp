@@ -132,7 +132,7 @@ void AITools_DrawPath( edict_t *self, int node_to )
 
 	drawnpath_timeout = level.time + 4 * game.snapFrameTime;
 
-	if( self->ai->path.goalNode != node_to )
+	if( !self->ai->path.nodes || self->ai->path.goalNode != node_to )
 		return;
 
 	pos = self->ai->path.numNodes;
@@ -2234,7 +2234,7 @@ static asstring_t *objectGameEntity_getTargetname( edict_t *self )
 
 static void objectGameEntity_setTargetname( asstring_t *targetname, edict_t *self )
 {
-	self->targetname = G_RegisterLevelString( targetname->buffer );
+	G_SetTargetname( self, G_RegisterLevelString( targetname->buffer ) );
 }
 
 static asstring_t *objectGameEntity_getTarget( edict_t *self )
@@ -2259,7 +2259,7 @@ static asstring_t *objectGameEntity_getSoundName( edict_t *self )
 
 static void objectGameEntity_setClassname( asstring_t *classname, edict_t *self )
 {
-	self->classname = G_RegisterLevelString( classname->buffer );
+	G_SetClassname( self, G_RegisterLevelString( classname->buffer ) );
 }
 
 static void objectGameEntity_setMap( asstring_t *map, edict_t *self )
@@ -2334,25 +2334,35 @@ static edict_t *objectGameEntity_DropItem( gsitem_t *item, edict_t *self )
 	return Drop_Item( self, item );
 }
 
-static CScriptArrayInterface *objectGameEntity_findTargets( edict_t *self )
+static CScriptArrayInterface *asFunc_G_FindByName( edict_t *( *find )( edict_t *, const char * ), const char *name )
 {
 	asIObjectType *ot = asEntityArrayType();
-	CScriptArrayInterface *arr = angelExport->asCreateArrayCpp( 0, ot );
 
-	if( self->target && self->target[0] != '\0' )
-	{
-		int count = 0;
-		edict_t *ent = NULL;
-		while( ( ent = G_Find( ent, FOFS( targetname ), self->target ) ) != NULL ) {
-			arr->Resize( count + 1 );
-			*((edict_t **)arr->At( count )) = ent;
-			count++;
-		}
+	int count = 0;
+	edict_t *ent = NULL;
+	while( ( ent = find( ent, name ) ) != NULL ) {
+		count++;
+	}
+
+	CScriptArrayInterface *arr = angelExport->asCreateArrayCpp( count, ot );
+
+	count = 0;
+	while( ( ent = find( ent, name ) ) != NULL ) {
+		*((edict_t **)arr->At( count )) = ent;
+		count++;
 	}
 
 	return arr;
 }
 
+static CScriptArrayInterface *objectGameEntity_findTargets( edict_t *self )
+{
+	if( self->target && self->target[0] != '\0' )
+		return asFunc_G_FindByName( G_FindByTargetname, self->target );
+
+	return angelExport->asCreateArrayCpp( 0, asEntityArrayType() );
+}
+
 static CScriptArrayInterface *objectGameEntity_findTargeting( edict_t *self )
 {
 	asIObjectType *ot = asEntityArrayType();
@@ -2695,7 +2705,7 @@ static edict_t *asFunc_G_Spawn( asstring_t *classname )
 	ent = G_Spawn();
 
 	if( classname && classname->len ) {
-		ent->classname = G_RegisterLevelString( classname->buffer );
+		G_SetClassname( ent, G_RegisterLevelString( classname->buffer ) );
 	}
 
 	ent->scriptSpawned = true;
@@ -3156,20 +3166,12 @@ static CScriptArrayInterface *asFunc_G_FindInRadius( asvec3_t *org, float radius
 
 static CScriptArrayInterface *asFunc_G_FindByClassname( asstring_t *str )
 {
-	const char *classname = str->buffer;
-
-	asIObjectType *ot = asEntityArrayType();
-	CScriptArrayInterface *arr = angelExport->asCreateArrayCpp( 0, ot );
-
-	int count = 0;
-	edict_t *ent = NULL;
-	while( ( ent = G_Find( ent, FOFS( classname ), classname ) ) != NULL ) {
-		arr->Resize( count + 1 );
-		*((edict_t **)arr->At( count )) = ent;
-		count++;
-	}
+	return asFunc_G_FindByName( G_FindByClassname, str->buffer );
+}
 
-	return arr;
+static CScriptArrayInterface *asFunc_G_FindByTargetname( asstring_t *str )
+{
+	return asFunc_G_FindByName( G_FindByTargetname, str->buffer );
 }
 
 static void asFunc_PositionedSound( asvec3_t *origin, int channel, int soundindex, float attenuation )
@@ -3321,6 +3323,7 @@ static const asglobfuncs_t asGlobFuncs[] =
 	{ "Item @G_GetItemByClassname( const String &in name )", asFUNCTION(asFunc_GS_FindItemByClassname), NULL },
 	{ "array<Entity @> @G_FindInRadius( const Vec3 &in, float radius )", asFUNCTION(asFunc_G_FindInRadius), NULL },
 	{ "array<Entity @> @G_FindByClassname( const String &in )", asFUNCTION(asFunc_G_FindByClassname), NULL },
+	{ "array<Entity @> @G_FindByTargetname( const String &in )", asFUNCTION(asFunc_G_FindByTargetname), NULL },
 
 	// misc management utils
 	{ "void G_RemoveProjectiles( Entity @ )", asFUNCTION(asFunc_G_Match_RemoveProjectiles), NULL },
@@ -41,25 +41,34 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	AREA_TRIGGERS	2
 
 
-#define AREA_GRID		128
-#define AREA_GRIDNODES	(AREA_GRID * AREA_GRID)
-#define AREA_GRIDMINSIZE 64.0f	// minimum areagrid cell size, smaller values 
-								// work better for lots of small objects, higher
-								// values for large objects
+// entities are linked into a loose multi-level grid: a single cell at the finest level
+// where their box fits, by the cell their center is in. The cells of each level have
+// twice the size of the previous level's ones, a query looks through the cells it
+// overlaps, extended by half a cell, at every level which has entities.
+#define AREA_GRID			128		// divisions of the finest level, a power of two
+#define AREA_GRID_LEVELS	8		// down to a single cell
+#define AREA_GRIDNODES		( ( AREA_GRID * AREA_GRID * 4 - 1 ) / 3 )	// of all levels
+#define AREA_GRIDMINSIZE	64.0f	// minimum areagrid cell size, smaller values 
+									// work better for lots of small objects, higher
+									// values for large objects
+
+#define AREA_GRID_OUTSIDE	AREA_GRID_LEVELS		// too big or outside the grid
+#define AREA_GRID_UNLINKED	( AREA_GRID_LEVELS + 1 )
 
 typedef struct
 {
-	link_t grid[AREA_GRIDNODES];
+	link_t grid[AREA_GRIDNODES];	// finest level first
 	link_t outside;
+	int numlinked[AREA_GRID_LEVELS + 1];	// per level, and outside
+
+	link_t entlinks[MAX_EDICTS];
+	uint8_t entlevel[MAX_EDICTS];
+
 	vec3_t bias;
-	vec3_t scale;
+	vec3_t scale;					// of the finest level
 	vec3_t mins;
 	vec3_t maxs;
 	vec3_t size;
-	int marknumber;
-	// since the areagrid can have multiple references to one entity,
-	// we should avoid extensive checking on entities already encountered
-	int entmarknumber[MAX_EDICTS];
 } areagrid_t;
 
 static areagrid_t g_areagrid;
@@ -67,32 +76,72 @@ static areagrid_t g_areagrid;
 extern cvar_t *g_antilag;
 extern cvar_t *g_antilag_maxtimedelta;
 
-#define	CFRAME_UPDATE_BACKUP	64  // copies of entity_state_t to keep buffered (1 second of backup at 62 fps).
+#define	CFRAME_UPDATE_BACKUP	64  // backed up collision frames (1 second of backup at 62 fps).
 #define	CFRAME_UPDATE_MASK	( CFRAME_UPDATE_BACKUP-1 )
 
+// antilag records are shared by all backed up frames in a single ring, only solid, hit-testable
+// entities are recorded. If frames get too crowded the oldest ones are simply lost.
+#define CFRAME_MAX_RECORDS	( CFRAME_UPDATE_BACKUP * 256 )	// must be a power of two, >= MAX_EDICTS
+#define CFRAME_RECORDS_MASK	( CFRAME_MAX_RECORDS-1 )
+
 typedef struct c4clipedict_s
 {
 	entity_state_t s;
 	entity_shared_t	r;
 } c4clipedict_t;
 
-//backups of all server frames areas and edicts
+//backups of all server frames solid edicts
 typedef struct c4frame_s
 {
-	c4clipedict_t clipEdicts[MAX_EDICTS];   // fixme: there is a g_maxentities cvar. We have to adjust to it
-	int numedicts;
+	unsigned int firstRecord;       // into the records ring, never wraps around
+	int numRecords;                 // sorted by entity number
 
 	unsigned int timestamp;
 	unsigned int framenum;
 } c4frame_t;
 
-c4frame_t sv_collisionframes[CFRAME_UPDATE_BACKUP];
+typedef struct
+{
+	unsigned int numWritten;
+
+	// structure-of-arrays so that backing up and looking up touch as little memory as possible
+	short entNum[CFRAME_MAX_RECORDS];
+	uint8_t solid[CFRAME_MAX_RECORDS];          // entity_shared_t::solid
+	uint8_t type[CFRAME_MAX_RECORDS];
+	int ssolid[CFRAME_MAX_RECORDS];             // entity_state_t::solid
+	int modelindex[CFRAME_MAX_RECORDS];
+	vec3_t origin[CFRAME_MAX_RECORDS];
+	vec3_t angles[CFRAME_MAX_RECORDS];
+	vec3_t mins[CFRAME_MAX_RECORDS];
+	vec3_t maxs[CFRAME_MAX_RECORDS];
+	vec3_t absmin[CFRAME_MAX_RECORDS];
+	vec3_t absmax[CFRAME_MAX_RECORDS];
+} c4records_t;
+
+static c4frame_t sv_collisionframes[CFRAME_UPDATE_BACKUP];
+static c4records_t sv_collisionRecords;
 static unsigned int sv_collisionFrameNum = 0;
 
+/*
+* GClip_IsBackUpEntity
+*
+* Only entities that can be hit are worth going back in time for
+*/
+static inline bool GClip_IsBackUpEntity( const edict_t *ent, int entNum )
+{
+	if( !ent->r.inuse || ent->r.solid == SOLID_NOT )
+		return false;
+	if( ent->r.solid == SOLID_TRIGGER && !(entNum >= 1 && entNum <= gs.maxclients) )
+		return false;
+	return true;
+}
+
 void GClip_BackUpCollisionFrame( void )
 {
 	c4frame_t *cframe;
+	c4records_t *rec = &sv_collisionRecords;
 	edict_t	*svedict;
+	unsigned int r;
 	int i;
 
 	if( !g_antilag->integer )
@@ -103,25 +152,83 @@ void GClip_BackUpCollisionFrame( void )
 	cframe = &sv_collisionframes[sv_collisionFrameNum & CFRAME_UPDATE_MASK];
 	cframe->timestamp = game.serverTime;
 	cframe->framenum = sv_collisionFrameNum;
+	cframe->firstRecord = rec->numWritten;
+	cframe->numRecords = 0;
 	sv_collisionFrameNum++;
 
-	//memset( cframe->clipEdicts, 0, sizeof(cframe->clipEdicts) );
-
 	//backup edicts
 	for( i = 0; i < game.numentities; i++ )
 	{
 		svedict = &game.edicts[i];
-
-		cframe->clipEdicts[i].r.inuse = svedict->r.inuse;
-		cframe->clipEdicts[i].r.solid = svedict->r.solid;
-		if( !svedict->r.inuse || svedict->r.solid == SOLID_NOT 
-			|| ( svedict->r.solid == SOLID_TRIGGER && !(i >= 1 && i <= gs.maxclients) ) )
+		if( !GClip_IsBackUpEntity( svedict, i ) )
 			continue;
 
-		cframe->clipEdicts[i].r = svedict->r;
-		cframe->clipEdicts[i].s = svedict->s;
+		r = rec->numWritten & CFRAME_RECORDS_MASK;
+		rec->entNum[r] = i;
+		rec->solid[r] = svedict->r.solid;
+		rec->type[r] = svedict->s.type;
+		rec->ssolid[r] = svedict->s.solid;
+		rec->modelindex[r] = svedict->s.modelindex;
+		VectorCopy( svedict->s.origin, rec->origin[r] );
+		VectorCopy( svedict->s.angles, rec->angles[r] );
+		VectorCopy( svedict->r.mins, rec->mins[r] );
+		VectorCopy( svedict->r.maxs, rec->maxs[r] );
+		VectorCopy( svedict->r.absmin, rec->absmin[r] );
+		VectorCopy( svedict->r.absmax, rec->absmax[r] );
+
+		rec->numWritten++;
+		cframe->numRecords++;
 	}
-	cframe->numedicts = game.numentities;
+}
+
+/*
+* GClip_FindCollisionRecord
+*
+* Returns the index of the entity record in the given frame or -1
+*/
+static int GClip_FindCollisionRecord( const c4frame_t *cframe, int entNum )
+{
+	const c4records_t *rec = &sv_collisionRecords;
+	int lo, hi, mid, r;
+
+	// the records of this frame have been overwritten by newer frames
+	if( rec->numWritten - cframe->firstRecord > CFRAME_MAX_RECORDS )
+		return -1;
+
+	lo = 0;
+	hi = cframe->numRecords - 1;
+	while( lo <= hi )
+	{
+		mid = ( lo + hi ) >> 1;
+		r = ( cframe->firstRecord + mid ) & CFRAME_RECORDS_MASK;
+		if( rec->entNum[r] == entNum )
+			return r;
+		if( rec->entNum[r] < entNum )
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+
+	return -1;
+}
+
+/*
+* GClip_RestoreCollisionRecord
+*/
+static void GClip_RestoreCollisionRecord( c4clipedict_t *clipent, int r )
+{
+	const c4records_t *rec = &sv_collisionRecords;
+
+	clipent->r.solid = (solid_t)rec->solid[r];
+	clipent->s.type = rec->type[r];
+	clipent->s.solid = rec->ssolid[r];
+	clipent->s.modelindex = rec->modelindex[r];
+	VectorCopy( rec->origin[r], clipent->s.origin );
+	VectorCopy( rec->angles[r], clipent->s.angles );
+	VectorCopy( rec->mins[r], clipent->r.mins );
+	VectorCopy( rec->maxs[r], clipent->r.maxs );
+	VectorCopy( rec->absmin[r], clipent->r.absmin );
+	VectorCopy( rec->absmax[r], clipent->r.absmax );
 }
 
 static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime )
@@ -129,27 +236,28 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 	static int index = 0;
 	static c4clipedict_t clipEnts[8];
 	static c4clipedict_t *clipent;
-	static c4clipedict_t clipentNewer; // for interpolation
+	const c4records_t *rec = &sv_collisionRecords;
 	c4frame_t *cframe = NULL;
 	unsigned int backTime, cframenum, bf, i;
+	int r = -1, rNewer;
+	vec3_t originNewer, anglesNewer, minsNewer, maxsNewer; // for interpolation
 	edict_t	*ent = game.edicts + entNum;
 
 	// pick one of the 8 slots to prevent overwritings
 	clipent = &clipEnts[index];
 	index = ( index + 1 )&7;
 
+	// the non-spatial data always comes from the current entity
+	clipent->r = ent->r;
+	clipent->s = ent->s;
+
 	if( !entNum || deltaTime >= 0 || !g_antilag->integer )
 	{                                                    // current time entity
-		clipent->r = ent->r;
-		clipent->s = ent->s;
 		return clipent;
 	}
 
-	if( !ent->r.inuse || ent->r.solid == SOLID_NOT 
-		|| ( ent->r.solid == SOLID_TRIGGER && !(entNum >= 1 && entNum <= gs.maxclients) ) )
+	if( !GClip_IsBackUpEntity( ent, entNum ) )
 	{
-		clipent->r = ent->r;
-		clipent->s = ent->s;
 		return clipent;
 	}
 
@@ -168,10 +276,10 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 	for( bf = 1; bf < CFRAME_UPDATE_BACKUP && bf < sv_collisionFrameNum; bf++ ) // never overpass limits
 	{
 		cframe = &sv_collisionframes[( cframenum-bf ) & CFRAME_UPDATE_MASK];
+		r = GClip_FindCollisionRecord( cframe, entNum );
 
 		// if solid has changed, we can't keep moving backwards
-		if( ent->r.solid != cframe->clipEdicts[entNum].r.solid 
-			|| ent->r.inuse != cframe->clipEdicts[entNum].r.inuse )
+		if( r < 0 || ent->r.solid != rec->solid[r] )
 		{
 			bf--;
 			if( bf == 0 )
@@ -182,6 +290,7 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 			else
 			{
 				cframe = &sv_collisionframes[( cframenum-bf ) & CFRAME_UPDATE_MASK];
+				r = GClip_FindCollisionRecord( cframe, entNum );
 			}
 			break;
 		}
@@ -190,16 +299,14 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 			break;
 	}
 
-	if( !cframe )
+	if( !cframe || r < 0 )
 	{
 		// current time entity
-		clipent->r = ent->r;
-		clipent->s = ent->s;
 		return clipent;
 	}
 
 	// setup with older for the data that is not interpolated
-	*clipent = cframe->clipEdicts[entNum];
+	GClip_RestoreCollisionRecord( clipent, r );
 
 	// if we found an older than desired backtime frame, interpolate to find a more precise position.
 	if( game.serverTime > cframe->timestamp+backTime )
@@ -211,16 +318,26 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 			// interpolate from 1st backed up to current
 			lerpFrac = (float)( ( game.serverTime - backTime ) - cframe->timestamp ) 
 				/ (float)( game.serverTime - cframe->timestamp );
-			clipentNewer.r = ent->r;
-			clipentNewer.s = ent->s;
+			VectorCopy( ent->s.origin, originNewer );
+			VectorCopy( ent->s.angles, anglesNewer );
+			VectorCopy( ent->r.mins, minsNewer );
+			VectorCopy( ent->r.maxs, maxsNewer );
 		}
 		else
 		{
 			// interpolate between 2 backed up
 			c4frame_t *cframeNewer = &sv_collisionframes[( cframenum-( bf-1 ) ) & CFRAME_UPDATE_MASK];
+
+			rNewer = GClip_FindCollisionRecord( cframeNewer, entNum );
+			if( rNewer < 0 )
+				return clipent;
+
 			lerpFrac = (float)( ( game.serverTime - backTime ) - cframe->timestamp ) 
 				/ (float)( cframeNewer->timestamp - cframe->timestamp );
-			clipentNewer = cframeNewer->clipEdicts[entNum];
+			VectorCopy( rec->origin[rNewer], originNewer );
+			VectorCopy( rec->angles[rNewer], anglesNewer );
+			VectorCopy( rec->mins[rNewer], minsNewer );
+			VectorCopy( rec->maxs[rNewer], maxsNewer );
 		}
 
 #if 0
@@ -229,11 +346,11 @@ static c4clipedict_t *GClip_GetClipEdictForDeltaTime( int entNum, int deltaTime
 #endif
 
 		// interpolate
-		VectorLerp( clipent->s.origin, lerpFrac, clipentNewer.s.origin, clipent->s.origin );
-		VectorLerp( clipent->r.mins, lerpFrac, clipentNewer.r.mins, clipent->r.mins );
-		VectorLerp( clipent->r.maxs, lerpFrac, clipentNewer.r.maxs, clipent->r.maxs );
+		VectorLerp( clipent->s.origin, lerpFrac, originNewer, clipent->s.origin );
+		VectorLerp( clipent->r.mins, lerpFrac, minsNewer, clipent->r.mins );
+		VectorLerp( clipent->r.maxs, lerpFrac, maxsNewer, clipent->r.maxs );
 		for( i = 0; i < 3; i++ )
-			clipent->s.angles[i] = LerpAngle( clipent->s.angles[i], clipentNewer.s.angles[i], lerpFrac );
+			clipent->s.angles[i] = LerpAngle( clipent->s.angles[i], anglesNewer[i], lerpFrac );
 	}
 
 #if 0
@@ -275,11 +392,6 @@ static void GClip_Init_AreaGrid( areagrid_t *areagrid, const vec3_t world_mins,
 {
 	int i;
 
-	// the areagrid_marknumber is not allowed to be 0
-	if( areagrid->marknumber < 1 ) {
-		areagrid->marknumber = 1;
-	}
-
 	// choose either the world box size, or a larger box to ensure the grid isn't too fine
 	areagrid->size[0] = max( world_maxs[0] - world_mins[0], AREA_GRID * AREA_GRIDMINSIZE );
 	areagrid->size[1] = max( world_maxs[1] - world_mins[1], AREA_GRID * AREA_GRIDMINSIZE );
@@ -303,13 +415,15 @@ static void GClip_Init_AreaGrid( areagrid_t *areagrid, const vec3_t world_mins,
 	for( i = 0; i < AREA_GRIDNODES; i++ ) {
 		GClip_ClearLink( &areagrid->grid[i] );
 	}
+	memset( areagrid->numlinked, 0, sizeof( areagrid->numlinked ) );
 
-	memset( areagrid->entmarknumber, 0, sizeof( areagrid->entmarknumber ) );
+	memset( areagrid->entlinks, 0, sizeof( areagrid->entlinks ) );
+	memset( areagrid->entlevel, AREA_GRID_UNLINKED, sizeof( areagrid->entlevel ) );
 
 	if( developer->integer ) {
-		Com_Printf( "areagrid settings: divisions %ix%ix1 : box %f %f %f "
+		Com_Printf( "areagrid settings: divisions %ix%ix1, %i levels : box %f %f %f "
 			": %f %f %f size %f %f %f grid %f %f %f (mingrid %f)\n", 
-			AREA_GRID, AREA_GRID, 
+			AREA_GRID, AREA_GRID, AREA_GRID_LEVELS,
 			areagrid->mins[0], areagrid->mins[1], areagrid->mins[2],
 			areagrid->maxs[0], areagrid->maxs[1], areagrid->maxs[2], 
 			areagrid->size[0], areagrid->size[1], areagrid->size[2], 
@@ -318,170 +432,163 @@ static void GClip_Init_AreaGrid( areagrid_t *areagrid, const vec3_t world_mins,
 	}
 }
 
+/*
+* GClip_AreaGridLevelNodes
+*/
+static inline link_t *GClip_AreaGridLevelNodes( areagrid_t *areagrid, int level )
+{
+	// the levels before this one have 4 times the nodes of the next one each
+	return areagrid->grid + ( AREA_GRID * AREA_GRID - ( AREA_GRID >> level ) * ( AREA_GRID >> level ) ) * 4 / 3;
+}
+
 /*
 * GClip_UnlinkEntity_AreaGrid
 */
-static void GClip_UnlinkEntity_AreaGrid( edict_t *ent )
+static void GClip_UnlinkEntity_AreaGrid( areagrid_t *areagrid, int entNum )
 {
-	for( int i = 0; i < MAX_ENT_AREAS; i++ ) {
-		if( !ent->areagrid[i].prev ) {
-			break;
-		}
-		GClip_RemoveLink( &ent->areagrid[i] );
-		ent->areagrid[i].prev = ent->areagrid[i].next = NULL;
+	if( areagrid->entlevel[entNum] == AREA_GRID_UNLINKED ) {
+		return;
 	}
+
+	GClip_RemoveLink( &areagrid->entlinks[entNum] );
+	areagrid->numlinked[areagrid->entlevel[entNum]]--;
+	areagrid->entlevel[entNum] = AREA_GRID_UNLINKED;
 }
 
 /*
 * GClip_LinkEntity_AreaGrid
 */
-static void GClip_LinkEntity_AreaGrid( areagrid_t *areagrid, edict_t *ent )
+static void GClip_LinkEntity_AreaGrid( areagrid_t *areagrid, int entNum, const vec3_t absmin, const vec3_t absmax )
 {
-	link_t *grid;
-	int igrid[3], igridmins[3], igridmaxs[3], gridnum, entitynumber;
-	
-	entitynumber = NUM_FOR_EDICT( ent );
-	if( entitynumber <= 0 || entitynumber >= game.maxentities || EDICT_NUM( entitynumber ) != ent )
-	{
-		Com_Printf( "GClip_LinkEntity_AreaGrid: invalid edict %p "
-			"(edicts is %p, edict compared to prog->edicts is %i)\n", 
-			(void *)ent, game.edicts, entitynumber );
-		return;
+	float gmins[2], gmaxs[2], extent, center[2];
+	int i, level, cell[2], dim;
+
+	GClip_UnlinkEntity_AreaGrid( areagrid, entNum );
+
+	// to finest level cells
+	for( i = 0; i < 2; i++ ) {
+		gmins[i] = ( absmin[i] + areagrid->bias[i] ) * areagrid->scale[i];
+		gmaxs[i] = ( absmax[i] + areagrid->bias[i] ) * areagrid->scale[i];
+		center[i] = ( gmins[i] + gmaxs[i] ) * 0.5f;
 	}
+	extent = max( gmaxs[0] - gmins[0], gmaxs[1] - gmins[1] );
 
-	igridmins[0] = (int) floor( (ent->r.absmin[0] + areagrid->bias[0]) * areagrid->scale[0] );
-	igridmins[1] = (int) floor( (ent->r.absmin[1] + areagrid->bias[1]) * areagrid->scale[1] );
-	//igridmins[2] = (int) floor( (ent->r.absmin[2] + areagrid->bias[2]) * areagrid->scale[2] );
-	igridmaxs[0] = (int) floor( (ent->r.absmax[0] + areagrid->bias[0]) * areagrid->scale[0] ) + 1;
-	igridmaxs[1] = (int) floor( (ent->r.absmax[1] + areagrid->bias[1]) * areagrid->scale[1] ) + 1;
-	//igridmaxs[2] = (int) floor( (ent->r.absmax[2] + areagrid->bias[2]) * areagrid->scale[2] ) + 1;
-	if( igridmins[0] < 0 || igridmaxs[0] > AREA_GRID 
-		|| igridmins[1] < 0 || igridmaxs[1] > AREA_GRID 
-		|| ((igridmaxs[0] - igridmins[0]) * (igridmaxs[1] - igridmins[1])) > MAX_ENT_AREAS )
-	{
-		// wow, something outside the grid, store it as such
-		GClip_InsertLinkBefore( &ent->areagrid[0], &areagrid->outside, entitynumber );
-		return;
+	for( level = 0; level < AREA_GRID_LEVELS; level++ ) {
+		if( extent <= (float)( 1 << level ) ) {
+			break;
+		}
 	}
 
-	gridnum = 0;
-	for( igrid[1] = igridmins[1]; igrid[1] < igridmaxs[1]; igrid[1]++ ) {
-		grid = areagrid->grid + igrid[1] * AREA_GRID + igridmins[0];
-		for( igrid[0] = igridmins[0]; igrid[0] < igridmaxs[0]; igrid[0]++, grid++, gridnum++ )
-			GClip_InsertLinkBefore( &ent->areagrid[gridnum], grid, entitynumber );
+	if( level == AREA_GRID_LEVELS
+		|| center[0] < 0 || center[0] >= AREA_GRID || center[1] < 0 || center[1] >= AREA_GRID ) {
+		// wow, something outside the grid, store it as such
+		level = AREA_GRID_OUTSIDE;
+		GClip_InsertLinkBefore( &areagrid->entlinks[entNum], &areagrid->outside, entNum );
 	}
+	else {
+		dim = AREA_GRID >> level;
+		cell[0] = min( (int)center[0] >> level, dim - 1 );
+		cell[1] = min( (int)center[1] >> level, dim - 1 );
+		GClip_InsertLinkBefore( &areagrid->entlinks[entNum],
+			GClip_AreaGridLevelNodes( areagrid, level ) + cell[1] * dim + cell[0], entNum );
+	}
+
+	areagrid->entlevel[entNum] = level;
+	areagrid->numlinked[level]++;
 }
 
 /*
-* GClip_EntitiesInBox_AreaGrid
+* GClip_AreaGridCandidates
+*
+* Lists the entities linked in cells overlapping the box, every entity at most once.
+* These may not touch the box, their bounds should be tested by the caller.
 */
-static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, const vec3_t mins, const vec3_t maxs, 
-	int *list, int maxcount, int areatype, int timeDelta )
+static int GClip_AreaGridCandidates( areagrid_t *areagrid, const vec3_t mins, const vec3_t maxs, int *list, int maxcount )
 {
 	int numlist;
-	link_t *grid;
-	link_t *l;
-	c4clipedict_t *clipEnt;
-	vec3_t paddedmins, paddedmaxs;
-	int igrid[3], igridmins[3], igridmaxs[3];
-
-	// LordHavoc: discovered this actually causes its own bugs (dm6 teleporters 
-	// being too close to info_teleport_destination)
-	//VectorSet( paddedmins, mins[0] - 1.0f, mins[1] - 1.0f, mins[2] - 1.0f );
-	//VectorSet( paddedmaxs, maxs[0] + 1.0f, maxs[1] + 1.0f, maxs[2] + 1.0f );
-	VectorCopy( mins, paddedmins );
-	VectorCopy( maxs, paddedmaxs );
-
-	// FIXME: if areagrid_marknumber wraps, all entities need their
-	// ent->priv.server->areagridmarknumber reset
-	areagrid->marknumber++;
-
-	igridmins[0] = (int) floor( (paddedmins[0] + areagrid->bias[0]) * areagrid->scale[0] );
-	igridmins[1] = (int) floor( (paddedmins[1] + areagrid->bias[1]) * areagrid->scale[1] );
-	//igridmins[2] = (int) ( (paddedmins[2] + areagrid->bias[2]) * areagrid->scale[2] );
-	igridmaxs[0] = (int) floor( (paddedmaxs[0] + areagrid->bias[0]) * areagrid->scale[0] ) + 1;
-	igridmaxs[1] = (int) floor( (paddedmaxs[1] + areagrid->bias[1]) * areagrid->scale[1] ) + 1;
-	//igridmaxs[2] = (int) ( (paddedmaxs[2] + areagrid->bias[2]) * areagrid->scale[2] ) + 1;
-	igridmins[0] = max( 0, igridmins[0] );
-	igridmins[1] = max( 0, igridmins[1] );
-	//igridmins[2] = max( 0, igridmins[2] );
-	igridmaxs[0] = min( AREA_GRID, igridmaxs[0] );
-	igridmaxs[1] = min( AREA_GRID, igridmaxs[1] );
-	//igridmaxs[2] = min( AREA_GRID, igridmaxs[2] );
-
-	// paranoid debugging
-	//VectorSet( igridmins, 0, 0, 0 );VectorSet( igridmaxs, AREA_GRID, AREA_GRID, AREA_GRID );
+	int i, level, dim;
+	int igrid[2], igridmins[2], igridmaxs[2];
+	float gmins[2], gmaxs[2], cellscale;
+	link_t *nodes, *grid, *l;
 
 	numlist = 0;
 
 	// add entities not linked into areagrid because they are too big or
 	// outside the grid bounds
-	if( areagrid->outside.next )
-	{
+	if( areagrid->numlinked[AREA_GRID_OUTSIDE] ) {
 		grid = &areagrid->outside;
-		for( l = grid->next; l != grid; l = l->next ) {
-			clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
+		for( l = grid->next; l != grid && numlist < maxcount; l = l->next ) {
+			list[numlist++] = l->entNum;
+		}
+	}
 
-			if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
-				continue;
-			}
-			areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
+	for( i = 0; i < 2; i++ ) {
+		gmins[i] = ( mins[i] + areagrid->bias[i] ) * areagrid->scale[i];
+		gmaxs[i] = ( maxs[i] + areagrid->bias[i] ) * areagrid->scale[i];
+	}
 
-			if( !clipEnt->r.inuse ) {
-				continue; // deactivated
-			}
-			if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
-				continue;
-			}
-			if( areatype == AREA_SOLID && 
-				( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
-				continue;
-			}
+	// add grid linked entities, the entities of a cell may stick out of it by half its size
+	for( level = 0; level < AREA_GRID_LEVELS; level++ ) {
+		if( !areagrid->numlinked[level] ) {
+			continue;
+		}
 
-			if( BoundsIntersect( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax )) {
-				if( numlist < maxcount ) {
-					list[numlist] = l->entNum;
+		// in cells of this level, with some slack for rounding errors
+		dim = AREA_GRID >> level;
+		cellscale = 1.0f / (float)( 1 << level );
+		for( i = 0; i < 2; i++ ) {
+			igridmins[i] = max( (int)floor( gmins[i] * cellscale - 0.51f ), 0 );
+			igridmaxs[i] = min( (int)floor( gmaxs[i] * cellscale + 0.51f ) + 1, dim );
+		}
+
+		nodes = GClip_AreaGridLevelNodes( areagrid, level );
+		for( igrid[1] = igridmins[1]; igrid[1] < igridmaxs[1]; igrid[1]++ ) {
+			grid = nodes + igrid[1] * dim + igridmins[0];
+			for( igrid[0] = igridmins[0]; igrid[0] < igridmaxs[0]; igrid[0]++, grid++ ) {
+				for( l = grid->next; l != grid && numlist < maxcount; l = l->next ) {
+					list[numlist++] = l->entNum;
 				}
-				numlist++;
 			}
 		}
 	}
 
-	// add grid linked entities
-	for( igrid[1] = igridmins[1]; igrid[1] < igridmaxs[1]; igrid[1]++ ) {
-		grid = areagrid->grid + igrid[1] * AREA_GRID + igridmins[0];
+	return numlist;
+}
 
-		for( igrid[0] = igridmins[0]; igrid[0] < igridmaxs[0]; igrid[0]++, grid++ ) {
-			if( !grid->next ) {
-				continue;
-			}
+/*
+* GClip_EntitiesInBox_AreaGrid
+*/
+static int GClip_EntitiesInBox_AreaGrid( areagrid_t *areagrid, const vec3_t mins, const vec3_t maxs, 
+	int *list, int maxcount, int areatype, int timeDelta )
+{
+	int i, numcandidates, numlist;
+	int candidates[MAX_EDICTS];
+	c4clipedict_t *clipEnt;
 
-			for( l = grid->next; l != grid; l = l->next ) {
-				clipEnt = GClip_GetClipEdictForDeltaTime( l->entNum, timeDelta );
+	// LordHavoc: discovered that padding the box actually causes its own bugs (dm6 teleporters 
+	// being too close to info_teleport_destination)
+	numcandidates = GClip_AreaGridCandidates( areagrid, mins, maxs, candidates, MAX_EDICTS );
 
-				if( areagrid->entmarknumber[l->entNum] == areagrid->marknumber ) {
-					continue;
-				}
-				areagrid->entmarknumber[l->entNum] = areagrid->marknumber;
+	numlist = 0;
+	for( i = 0; i < numcandidates; i++ ) {
+		clipEnt = GClip_GetClipEdictForDeltaTime( candidates[i], timeDelta );
 
-				if( !clipEnt->r.inuse ) {
-					continue; // deactivated
-				}
-				if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
-					continue;
-				}
-				if( areatype == AREA_SOLID && 
-					( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
-					continue;
-				}
+		if( !clipEnt->r.inuse ) {
+			continue; // deactivated
+		}
+		if( areatype == AREA_TRIGGERS && clipEnt->r.solid != SOLID_TRIGGER ) {
+			continue;
+		}
+		if( areatype == AREA_SOLID && 
+			( clipEnt->r.solid == SOLID_TRIGGER || clipEnt->r.solid == SOLID_NOT ) ) {
+			continue;
+		}
 
-				if( BoundsIntersect( paddedmins, paddedmaxs, clipEnt->r.absmin, clipEnt->r.absmax )) {
-					if( numlist < maxcount ) {
-						list[numlist] = l->entNum;
-					}
-					numlist++;
-				}
+		if( BoundsIntersect( mins, maxs, clipEnt->r.absmin, clipEnt->r.absmax )) {
+			if( numlist < maxcount ) {
+				list[numlist] = candidates[i];
 			}
+			numlist++;
 		}
 	}
 
@@ -513,7 +620,7 @@ void GClip_UnlinkEntity( edict_t *ent )
 {
 	if( !ent->linked )
 		return; // not linked in anywhere
-	GClip_UnlinkEntity_AreaGrid( ent );
+	GClip_UnlinkEntity_AreaGrid( &g_areagrid, NUM_FOR_EDICT( ent ) );
 	ent->linked = false;
 }
 
@@ -684,7 +791,7 @@ void GClip_LinkEntity( edict_t *ent )
 	ent->linkcount++;
 	ent->linked = true;
 
-	GClip_LinkEntity_AreaGrid( &g_areagrid, ent );
+	GClip_LinkEntity_AreaGrid( &g_areagrid, NUM_FOR_EDICT( ent ), ent->r.absmin, ent->r.absmax );
 }
 
 /*
@@ -809,6 +916,35 @@ typedef struct
 	int contentmask;
 } moveclip_t;
 
+/*
+* GClip_IgnoreForTrace
+*
+* Entities a trace started by passent never collides with
+*/
+static inline bool GClip_IgnoreForTrace( c4clipedict_t *touch, int passent, int contentmask )
+{
+	if( passent >= 0 )
+	{
+		// when they are offseted in time, they can be a different pointer but be the same entity
+		if( touch->s.number == passent )
+			return true;
+		if( touch->r.owner && ( touch->r.owner->s.number == passent ) )
+			return true;
+		if( game.edicts[passent].r.owner 
+			&& ( game.edicts[passent].r.owner->s.number == touch->s.number ) )
+			return true;
+
+		// wsw : jal : never clipmove against SVF_PROJECTILE entities
+		if( touch->r.svflags & SVF_PROJECTILE )
+			return true;
+	}
+
+	if( ( touch->r.svflags & SVF_CORPSE ) && !( contentmask & CONTENTS_CORPSE ) )
+		return true;
+
+	return false;
+}
+
 /*
 * GClip_ClipMoveToEntities
 */
@@ -828,23 +964,7 @@ typedef struct
 	for( i = 0; i < num; i++ )
 	{
 		touch = GClip_GetClipEdictForDeltaTime( touchlist[i], timeDelta );
-		if( clip->passent >= 0 )
-		{
-			// when they are offseted in time, they can be a different pointer but be the same entity
-			if( touch->s.number == clip->passent )
-				continue;
-			if( touch->r.owner && ( touch->r.owner->s.number == clip->passent ) )
-				continue;
-			if( game.edicts[clip->passent].r.owner 
-				&& ( game.edicts[clip->passent].r.owner->s.number == touch->s.number ) )
-				continue;
-
-			// wsw : jal : never clipmove against SVF_PROJECTILE entities
-			if( touch->r.svflags & SVF_PROJECTILE )
-				continue;
-		}
-
-		if( ( touch->r.svflags & SVF_CORPSE ) && !( clip->contentmask & CONTENTS_CORPSE ) )
+		if( GClip_IgnoreForTrace( touch, clip->passent, clip->contentmask ) )
 			continue;
 
 		// might intersect, so do an exact clip
@@ -970,6 +1090,130 @@ void G_Trace4D( trace_t *tr, vec3_t start, vec3_t mins, vec3_t maxs,
 {
 	GClip_Trace( tr, start, mins, maxs, end, passedict, contentmask, timeDelta );
 }
+
+#define GCLIP_TRACEBATCH	32
+
+/*
+* GClip_TraceBatch
+* 
+* Clips every query against the same world and entities as GClip_Trace would.
+* The world is still traced query by query, but the solid entities are gathered
+* once for the bounds of the whole batch, and the collision model of each entity
+* is set up once for all the queries whose bounds reach it.
+* The entities are visited in a different order than for a single trace, so when
+* several of them stop a query at exactly the same fraction, or it starts inside
+* more than one of them, trace.ent may name a different one.
+*/
+static void GClip_TraceBatch( gclip_tracequery_t *queries, int numqueries, 
+	edict_t *passedict, int contentmask, int timeDelta )
+{
+	int i, j, k, n, num, numactive, passent;
+	int active[GCLIP_TRACEBATCH];
+	bool hit[GCLIP_TRACEBATCH];
+	vec3_t boxmins[GCLIP_TRACEBATCH], boxmaxs[GCLIP_TRACEBATCH];
+	vec3_t batchmins, batchmaxs;
+	int touchlist[MAX_EDICTS];
+	c4clipedict_t *touch;
+	gclip_tracequery_t *q;
+	trace_t trace;
+	struct cmodel_s	*cmodel;
+	float *angles;
+
+	passent = passedict ? ENTNUM( passedict ) : -1;
+
+	for( ; numqueries > 0; queries += n, numqueries -= n )
+	{
+		n = min( numqueries, GCLIP_TRACEBATCH );
+
+		// clip to world
+		numactive = 0;
+		ClearBounds( batchmins, batchmaxs );
+		for( i = 0, q = queries; i < n; i++, q++ )
+		{
+			if( passedict == world )
+			{
+				memset( &q->trace, 0, sizeof( trace_t ) );
+				q->trace.fraction = 1;
+				q->trace.ent = -1;
+			}
+			else
+			{
+				trap_CM_TransformedBoxTrace( &q->trace, q->start, q->end, q->mins, q->maxs, NULL, contentmask, NULL, NULL );
+				q->trace.ent = q->trace.fraction < 1.0 ? world->s.number : -1;
+				if( q->trace.fraction == 0 )
+					continue; // blocked by the world
+			}
+
+			GClip_TraceBounds( q->start, q->mins, q->maxs, q->end, boxmins[i], boxmaxs[i] );
+			AddPointToBounds( boxmins[i], batchmins, batchmaxs );
+			AddPointToBounds( boxmaxs[i], batchmins, batchmaxs );
+			active[numactive++] = i;
+		}
+
+		if( !numactive )
+			continue;
+
+		// clip to other solid entities
+		num = GClip_AreaEdicts( batchmins, batchmaxs, touchlist, MAX_EDICTS, AREA_SOLID, timeDelta );
+
+		for( i = 0; i < num && numactive; i++ )
+		{
+			touch = GClip_GetClipEdictForDeltaTime( touchlist[i], timeDelta );
+			if( GClip_IgnoreForTrace( touch, passent, contentmask ) )
+				continue;
+
+			for( j = 0, k = 0; j < numactive; j++ )
+			{
+				hit[j] = BoundsIntersect( boxmins[active[j]], boxmaxs[active[j]], touch->r.absmin, touch->r.absmax );
+				k += hit[j];
+			}
+			if( !k )
+				continue;
+
+			// might intersect, so do an exact clip
+			cmodel = GClip_CollisionModelForEntity( &touch->s, &touch->r );
+
+			if( ISBRUSHMODEL( touch->s.modelindex ) )
+				angles = touch->s.angles;
+			else
+				angles = vec3_origin; // boxes don't rotate
+
+			for( j = 0, k = 0; j < numactive; j++ )
+			{
+				q = &queries[active[j]];
+
+				if( hit[j] )
+				{
+					trap_CM_TransformedBoxTrace( &trace, q->start, q->end, q->mins, q->maxs, 
+						cmodel, contentmask, touch->s.origin, angles );
+
+					if( trace.allsolid || trace.fraction < q->trace.fraction )
+					{
+						trace.ent = touch->s.number;
+						q->trace = trace;
+					}
+					else if( trace.startsolid )
+						q->trace.startsolid = true;
+					if( q->trace.allsolid )
+						continue; // done with this one
+				}
+
+				active[k++] = active[j];
+			}
+			numactive = k;
+		}
+	}
+}
+
+void G_TraceBatch( gclip_tracequery_t *queries, int numqueries, edict_t *passedict, int contentmask )
+{
+	GClip_TraceBatch( queries, numqueries, passedict, contentmask, 0 );
+}
+
+void G_TraceBatch4D( gclip_tracequery_t *queries, int numqueries, edict_t *passedict, int contentmask, int timeDelta )
+{
+	GClip_TraceBatch( queries, numqueries, passedict, contentmask, timeDelta );
+}
 //===========================================================================
 
 
@@ -1167,41 +1411,93 @@ void G_PMoveTouchTriggers( pmove_t *pm, vec3_t previous_origin )
 }
 
 /*
-* GClip_FindBoxInRadius
-* Returns entities that have their boxes within a spherical area
+* GClip_FindBoxInRadiusBatch4D
+* For each query returns entities that have their boxes within its spherical area.
+* Queries close to each other share a single area lookup.
 */
-int GClip_FindBoxInRadius4D( vec3_t org, float rad, int *list, int maxcount, int timeDelta )
+void GClip_FindBoxInRadiusBatch4D( gclip_radiusquery_t *queries, int numqueries, int timeDelta )
 {
-	int i, num;
-	int listnum;
+	int i, j, num;
 	edict_t *check;
-	vec3_t mins, maxs;
-	float rad_ = rad * 1.42;
+	c4clipedict_t *clipEnt;
+	gclip_radiusquery_t *q;
+	vec3_t mins[MAX_EDICTS], maxs[MAX_EDICTS];
+	vec3_t unionmins, unionmaxs;
+	float rad, area, unionarea;
 	int touch[MAX_EDICTS];
 
-	VectorSet( mins, org[0] - (rad_ + 1), org[1] - (rad_ + 1), org[2] - (rad_ + 1) );
-	VectorSet( maxs, org[0] + (rad_ + 1), org[1] + (rad_ + 1), org[2] + (rad_ + 1) );
+	if( numqueries <= 0 )
+		return;
+	if( numqueries > MAX_EDICTS )
+	{
+		GClip_FindBoxInRadiusBatch4D( queries + MAX_EDICTS, numqueries - MAX_EDICTS, timeDelta );
+		numqueries = MAX_EDICTS;
+	}
 
-	listnum = 0;
-	num = GClip_AreaEdicts( mins, maxs, touch, MAX_EDICTS, AREA_ALL, timeDelta );
+	ClearBounds( unionmins, unionmaxs );
+	area = 0;
+	for( i = 0, q = queries; i < numqueries; i++, q++ )
+	{
+		rad = q->radius * 1.42 + 1;
+		VectorSet( mins[i], q->org[0] - rad, q->org[1] - rad, q->org[2] - rad );
+		VectorSet( maxs[i], q->org[0] + rad, q->org[1] + rad, q->org[2] + rad );
+		AddPointToBounds( mins[i], unionmins, unionmaxs );
+		AddPointToBounds( maxs[i], unionmins, unionmaxs );
+		area += ( maxs[i][0] - mins[i][0] ) * ( maxs[i][1] - mins[i][1] );
+		q->numlist = 0;
+	}
+
+	// scattered queries are better off with their own lookups
+	unionarea = ( unionmaxs[0] - unionmins[0] ) * ( unionmaxs[1] - unionmins[1] );
+	if( numqueries > 1 && unionarea > area * 2 )
+	{
+		for( i = 0; i < numqueries; i++ )
+			GClip_FindBoxInRadiusBatch4D( queries + i, 1, timeDelta );
+		return;
+	}
+
+	num = GClip_AreaEdicts( unionmins, unionmaxs, touch, MAX_EDICTS, AREA_ALL, timeDelta );
 
 	for( i = 0; i < num; i++ )
 	{
 		check = EDICT_NUM( touch[i] );
-
-		// make absolute mins and maxs
-		if( !BoundsAndSphereIntersect( check->r.absmin, check->r.absmax, org, rad ) )
-			continue;
 		if( check->s.solid == SOLID_NOT )
 			continue;
 
-		if( listnum < maxcount ) {
-			list[listnum] = touch[i];
+		clipEnt = GClip_GetClipEdictForDeltaTime( touch[i], timeDelta );
+
+		for( j = 0, q = queries; j < numqueries; j++, q++ )
+		{
+			if( numqueries > 1 && !BoundsIntersect( mins[j], maxs[j], clipEnt->r.absmin, clipEnt->r.absmax ) )
+				continue;
+
+			// make absolute mins and maxs
+			if( !BoundsAndSphereIntersect( check->r.absmin, check->r.absmax, q->org, q->radius ) )
+				continue;
+
+			if( q->numlist < q->maxcount ) {
+				q->list[q->numlist] = touch[i];
+			}
+			q->numlist++;
 		}
-		listnum++;
 	}
+}
+
+/*
+* GClip_FindBoxInRadius
+* Returns entities that have their boxes within a spherical area
+*/
+int GClip_FindBoxInRadius4D( vec3_t org, float rad, int *list, int maxcount, int timeDelta )
+{
+	gclip_radiusquery_t query;
+
+	VectorCopy( org, query.org );
+	query.radius = rad;
+	query.list = list;
+	query.maxcount = maxcount;
+	GClip_FindBoxInRadiusBatch4D( &query, 1, timeDelta );
 
-	return listnum;
+	return query.numlist;
 }
 
 /*
@@ -1238,3 +1534,209 @@ entity_state_t *G_GetEntityStateForDeltaTime( int entNum, int deltaTime )
 	return &clipEnt->s;
 }
 
+//===========================================================================
+
+#define CLIPBENCH_MAX_QUERIES	1000000
+
+/*
+* GClip_SaveLayout
+*
+* Writes the boxes of the linked entities, to run the benchmark with a real entity layout
+*/
+static void GClip_SaveLayout( const char *filename )
+{
+	int i, filenum;
+	char line[256];
+	vec3_t world_mins, world_maxs;
+	edict_t *ent;
+
+	if( trap_FS_FOpenFile( filename, &filenum, FS_WRITE ) == -1 )
+	{
+		G_Printf( "Couldn't open %s for writing\n", filename );
+		return;
+	}
+
+	trap_CM_InlineModelBounds( trap_CM_InlineModel( 0 ), world_mins, world_maxs );
+	Q_snprintfz( line, sizeof( line ), "world %f %f %f %f %f %f\n", world_mins[0], world_mins[1], world_mins[2],
+		world_maxs[0], world_maxs[1], world_maxs[2] );
+	trap_FS_Write( line, strlen( line ), filenum );
+
+	for( i = 1, ent = game.edicts + 1; i < game.numentities; i++, ent++ )
+	{
+		if( !ent->r.inuse || g_areagrid.entlevel[i] == AREA_GRID_UNLINKED )
+			continue;
+		Q_snprintfz( line, sizeof( line ), "%i %f %f %f %f %f %f\n", i, ent->r.absmin[0], ent->r.absmin[1], ent->r.absmin[2],
+			ent->r.absmax[0], ent->r.absmax[1], ent->r.absmax[2] );
+		trap_FS_Write( line, strlen( line ), filenum );
+	}
+
+	trap_FS_FCloseFile( filenum );
+	G_Printf( "Wrote %s\n", filename );
+}
+
+/*
+* GClip_Benchmark_f
+*
+* clipbench save <name>: records the current entity layout
+* clipbench <name> [queries]: links a recorded layout into a grid of its own and runs
+* trace and splash sized box queries on it, checking them against a linear scan
+*/
+void GClip_Benchmark_f( void )
+{
+	char filename[MAX_QPATH];
+	char *buffer, *data, *token;
+	int i, j, k, length, filenum, numqueries, numents;
+	int ents[MAX_EDICTS], entindex[MAX_EDICTS], list[MAX_EDICTS];
+	vec3_t (*bounds)[2], world_mins, world_maxs, center;
+	vec3_t *qmins, *qmaxs;
+	vec3_t entbounds[2];
+	float size;
+	int64_t gridHits, scanHits, candidates;
+	unsigned int gridTime, scanTime, mismatches;
+	areagrid_t *areagrid;
+
+	if( trap_Cmd_Argc() < 2 || ( !Q_stricmp( trap_Cmd_Argv( 1 ), "save" ) && trap_Cmd_Argc() < 3 ) )
+	{
+		G_Printf( "Usage: clipbench save <name> or clipbench <name> [queries]\n" );
+		return;
+	}
+
+	if( !Q_stricmp( trap_Cmd_Argv( 1 ), "save" ) )
+	{
+		Q_snprintfz( filename, sizeof( filename ), "clipbench/%s.txt", trap_Cmd_Argv( 2 ) );
+		GClip_SaveLayout( filename );
+		return;
+	}
+
+	Q_snprintfz( filename, sizeof( filename ), "clipbench/%s.txt", trap_Cmd_Argv( 1 ) );
+	numqueries = trap_Cmd_Argc() > 2 ? atoi( trap_Cmd_Argv( 2 ) ) : 100000;
+	clamp( numqueries, 1, CLIPBENCH_MAX_QUERIES );
+
+	length = trap_FS_FOpenFile( filename, &filenum, FS_READ );
+	if( length <= 0 )
+	{
+		G_Printf( "Couldn't read %s\n", filename );
+		return;
+	}
+	buffer = ( char * )G_Malloc( length + 1 );
+	trap_FS_Read( buffer, length, filenum );
+	trap_FS_FCloseFile( filenum );
+	buffer[length] = 0;
+
+	bounds = ( vec3_t (*)[2] )G_Malloc( sizeof( *bounds ) * MAX_EDICTS );
+	memset( entindex, -1, sizeof( entindex ) );
+	data = buffer;
+	numents = 0;
+	VectorClear( world_mins );
+	VectorClear( world_maxs );
+	while( ( token = COM_Parse( &data ) ) && token[0] )
+	{
+		if( !Q_stricmp( token, "world" ) )
+		{
+			for( j = 0; j < 6; j++ )
+				( j < 3 ? world_mins : world_maxs )[j % 3] = atof( COM_Parse( &data ) );
+			continue;
+		}
+
+		i = atoi( token );
+		for( j = 0; j < 6; j++ )
+			entbounds[j / 3][j % 3] = atof( COM_Parse( &data ) );
+		if( i <= 0 || i >= MAX_EDICTS || numents == MAX_EDICTS )
+			continue;
+		if( entindex[i] >= 0 )
+		{
+			G_Printf( "%s: entity %i is listed more than once, ignored\n", filename, i );
+			continue;
+		}
+
+		VectorCopy( entbounds[0], bounds[numents][0] );
+		VectorCopy( entbounds[1], bounds[numents][1] );
+		entindex[i] = numents;
+		ents[numents++] = i;
+	}
+	G_Free( buffer );
+
+	areagrid = ( areagrid_t * )G_Malloc( sizeof( *areagrid ) );
+	GClip_Init_AreaGrid( areagrid, world_mins, world_maxs );
+	for( i = 0; i < numents; i++ )
+		GClip_LinkEntity_AreaGrid( areagrid, ents[i], bounds[i][0], bounds[i][1] );
+
+	// queries around the entities: small ones like traces, and bigger ones like splash damage
+	qmins = ( vec3_t * )G_Malloc( sizeof( *qmins ) * numqueries );
+	qmaxs = ( vec3_t * )G_Malloc( sizeof( *qmaxs ) * numqueries );
+	srand( 1 );
+	for( i = 0; i < numqueries; i++ )
+	{
+		j = numents ? rand() % numents : 0;
+		if( numents )
+			VectorAdd( bounds[j][0], bounds[j][1], center );
+		else
+			VectorAdd( world_mins, world_maxs, center );
+		VectorScale( center, 0.5f, center );
+		size = ( i & 1 ) ? 100 + rand() % 300 : 16 + rand() % 64;
+		for( k = 0; k < 3; k++ )
+		{
+			center[k] += ( rand() % 512 ) - 256;
+			qmins[i][k] = center[k] - size;
+			qmaxs[i][k] = center[k] + size;
+		}
+	}
+
+	gridHits = candidates = 0;
+	gridTime = trap_Milliseconds();
+	for( i = 0; i < numqueries; i++ )
+	{
+		int num = GClip_AreaGridCandidates( areagrid, qmins[i], qmaxs[i], list, MAX_EDICTS );
+		candidates += num;
+		for( j = 0; j < num; j++ )
+		{
+			k = entindex[list[j]];
+			if( BoundsIntersect( qmins[i], qmaxs[i], bounds[k][0], bounds[k][1] ) )
+				gridHits++;
+		}
+	}
+	gridTime = trap_Milliseconds() - gridTime;
+
+	scanHits = 0;
+	scanTime = trap_Milliseconds();
+	for( i = 0; i < numqueries; i++ )
+	{
+		for( k = 0; k < numents; k++ )
+		{
+			if( BoundsIntersect( qmins[i], qmaxs[i], bounds[k][0], bounds[k][1] ) )
+				scanHits++;
+		}
+	}
+	scanTime = trap_Milliseconds() - scanTime;
+
+	// check every query found what the scan did
+	mismatches = 0;
+	for( i = 0; i < numqueries; i++ )
+	{
+		int num = GClip_AreaGridCandidates( areagrid, qmins[i], qmaxs[i], list, MAX_EDICTS );
+		for( k = 0; k < numents; k++ )
+		{
+			if( !BoundsIntersect( qmins[i], qmaxs[i], bounds[k][0], bounds[k][1] ) )
+				continue;
+			for( j = 0; j < num && list[j] != ents[k]; j++ );
+			if( j == num )
+				mismatches++;
+		}
+	}
+
+	G_Printf( "%s: %i entities, %i queries\n", filename, numents, numqueries );
+	G_Printf( "entities per level:" );
+	for( i = 0; i < AREA_GRID_LEVELS; i++ )
+		G_Printf( " %i", areagrid->numlinked[i] );
+	G_Printf( ", outside %i\n", areagrid->numlinked[AREA_GRID_OUTSIDE] );
+	G_Printf( "grid: %u ms, %.1f candidates and %.1f hits per query\n", gridTime,
+		(double)candidates / numqueries, (double)gridHits / numqueries );
+	G_Printf( "scan: %u ms, %.1f hits per query\n", scanTime, (double)scanHits / numqueries );
+	if( mismatches )
+		G_Printf( S_COLOR_RED "%u entities missed by the grid\n", mismatches );
+
+	G_Free( qmaxs );
+	G_Free( qmins );
+	G_Free( areagrid );
+	G_Free( bounds );
+}
@@ -674,6 +674,7 @@ static void G_UpdateFrameTime( unsigned int msec )
 static void G_RunEntities( void )
 {
 	edict_t	*ent;
+	uint64_t profStart = trap_Prof_Begin();
 
 	for( ent = &game.edicts[0]; ENTNUM( ent ) < game.numentities; ent++ )
 	{
@@ -701,6 +702,8 @@ static void G_RunEntities( void )
 		else
 			ent->s.effects &= ~EF_TAKEDAMAGE;
 	}
+
+	trap_Prof_End( game.prof.runEntities, profStart );
 }
 
 /*
@@ -710,6 +713,7 @@ static void G_RunClients( void )
 {
 	int i, step;
 	edict_t *ent;
+	uint64_t profStart = trap_Prof_Begin();
 
 	if( level.framenum & 1 )
 	{
@@ -735,6 +739,20 @@ static void G_RunClients( void )
 		else
 			ent->s.effects &= ~EF_TAKEDAMAGE;
 	}
+
+	trap_Prof_End( game.prof.runClients, profStart );
+}
+
+/*
+* G_RunGametypeProfiled
+*/
+static void G_RunGametypeProfiled( void )
+{
+	uint64_t profStart = trap_Prof_Begin();
+
+	G_RunGametype();
+
+	trap_Prof_End( game.prof.gametype, profStart );
 }
 
 /*
@@ -771,7 +789,11 @@ static edict_t *G_GetNextThinkClient( edict_t *current )
 */
 void G_RunFrame( unsigned int msec, unsigned int serverTime )
 {
+	uint64_t profStart, profEnd, scriptTime;
+	bool scriptTimed;
+
 	G_CheckCvars();
+	G_SyncEntityNames();
 
 	game.localTime = time( NULL );
 
@@ -795,7 +817,7 @@ void G_RunFrame( unsigned int msec, unsigned int serverTime )
 		}
 
 		G_RunClients();
-		G_RunGametype();
+		G_RunGametypeProfiled();
 		G_LevelGarbageCollect();
 		return;
 	}
@@ -811,12 +833,26 @@ void G_RunFrame( unsigned int msec, unsigned int serverTime )
 	G_SpawnQueue_Think();
 
 	// run the world
+	// profiling may be turned off between the two reads, which then returns 0
+	profStart = trap_Prof_Begin();
 	G_asCallMapPreThink();
+	profEnd = trap_Prof_Begin();
+	scriptTimed = profStart && profEnd >= profStart;
+	scriptTime = scriptTimed ? profEnd - profStart : 0;
+
 	G_RunClients();
 	G_RunEntities();
-	G_RunGametype();
+	G_RunGametypeProfiled();
+
+	profStart = trap_Prof_Begin();
 	G_asCallMapPostThink();
+	profEnd = trap_Prof_Begin();
+	if( scriptTimed && profStart && profEnd >= profStart )
+		trap_Prof_AddSample( game.prof.mapScripts, scriptTime + profEnd - profStart );
+
+	profStart = trap_Prof_Begin();
 	GClip_BackUpCollisionFrame();
+	trap_Prof_End( game.prof.backupCollision, profStart );
 
 	G_LevelGarbageCollect();
 }
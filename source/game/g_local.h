@@ -169,6 +169,17 @@ typedef struct
 	int numBots;
 
 	unsigned int levelSpawnCount;	// the number of times G_InitLevel was called
+
+	// frame profiler stages, see trap_Prof_RegisterStage
+	struct
+	{
+		int runClients;
+		int runEntities;
+		int ai;                     // per bot
+		int gametype;
+		int mapScripts;
+		int backupCollision;
+	} prof;
 } game_locals_t;
 
 #define TIMEOUT_TIME					180000
@@ -598,6 +609,13 @@ bool Add_Armor( edict_t *ent, edict_t *other, bool pick_it );
 bool KillBox( edict_t *ent );
 float LookAtKillerYAW( edict_t *self, edict_t *inflictor, edict_t *attacker );
 edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match );
+edict_t *G_FindByClassname( edict_t *from, const char *classname );
+edict_t *G_FindByTargetname( edict_t *from, const char *targetname );
+void G_SetClassname( edict_t *ent, const char *classname );
+void G_SetTargetname( edict_t *ent, const char *targetname );
+void G_UpdateEntityNames( edict_t *ent );
+void G_SyncEntityNames( void );
+void G_ResetEntityNames( void );
 edict_t *G_FindBoxInRadius( edict_t *from, edict_t *to, vec3_t org, float rad );
 edict_t *G_PickTarget( const char *targetname );
 void G_UseTargets( edict_t *ent, edict_t *activator );
@@ -731,8 +749,6 @@ void SP_trigger_gravity( edict_t *ent );
 //
 // g_clip.c
 //
-#define MAX_ENT_AREAS 16
-
 typedef struct link_s
 {
 	struct link_s *prev, *next;
@@ -743,8 +759,30 @@ int	G_PointContents( vec3_t p );
 void G_Trace( trace_t *tr, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask );
 int G_PointContents4D( vec3_t p, int timeDelta );
 void G_Trace4D( trace_t *tr, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passedict, int contentmask, int timeDelta );
+
+typedef struct
+{
+	vec3_t start, end;
+	vec3_t mins, maxs;      // relative, zero for rays
+	trace_t trace;          // result, as from G_Trace except for the entity picked on exact ties
+} gclip_tracequery_t;
+
+void G_TraceBatch( gclip_tracequery_t *queries, int numqueries, edict_t *passedict, int contentmask );
+void G_TraceBatch4D( gclip_tracequery_t *queries, int numqueries, edict_t *passedict, int contentmask, int timeDelta );
 void GClip_BackUpCollisionFrame( void );
 int GClip_FindBoxInRadius4D( vec3_t org, float rad, int *list, int maxcount, int timeDelta );
+
+typedef struct
+{
+	vec3_t org;
+	float radius;
+	int *list;
+	int maxcount;
+	int numlist;	// may be more than maxcount
+} gclip_radiusquery_t;
+
+void GClip_FindBoxInRadiusBatch4D( gclip_radiusquery_t *queries, int numqueries, int timeDelta );
+void GClip_Benchmark_f( void );
 void G_SplashFrac4D( int entNum, vec3_t hitpoint, float maxradius, vec3_t pushdir, float *kickFrac, float *dmgFrac, int timeDelta );
 void GClip_ClearWorld( void );
 void GClip_SetBrushModel( edict_t *ent, const char *name );
@@ -1300,9 +1338,6 @@ struct edict_s
 
 	int linkcount;
 
-	// physics grid areas this edict is linked into
-	link_t areagrid[MAX_ENT_AREAS];
-
 	entity_state_t olds; // state in the last sent frame snap
 
 	int movetype;
@@ -247,6 +247,13 @@ void G_Init( unsigned int seed, unsigned int framemsec, int protocol, const char
 	Q_strncpyz( game.demoExtension, demoExtension, sizeof( game.demoExtension ) );
 	game.levelSpawnCount = 0;
 
+	game.prof.runClients = trap_Prof_RegisterStage( "g_runclients" );
+	game.prof.runEntities = trap_Prof_RegisterStage( "g_runentities" );
+	game.prof.ai = trap_Prof_RegisterStage( "g_ai" );
+	game.prof.gametype = trap_Prof_RegisterStage( "g_gametype" );
+	game.prof.mapScripts = trap_Prof_RegisterStage( "g_mapscripts" );
+	game.prof.backupCollision = trap_Prof_RegisterStage( "g_backupcollision" );
+
 	g_maxvelocity = trap_Cvar_Get( "g_maxvelocity", "16000", 0 );
 	if( g_maxvelocity->value < 20 )
 	{
@@ -443,7 +450,7 @@ static edict_t *CreateTargetChangeLevel( const char *map )
 	edict_t *ent;
 
 	ent = G_Spawn();
-	ent->classname = "target_changelevel";
+	G_SetClassname( ent, "target_changelevel" );
 	Q_strncpyz( level.nextmap, map, sizeof( level.nextmap ) );
 	ent->map = level.nextmap;
 	return ent;
@@ -614,7 +621,7 @@ static edict_t *G_ChooseNextMap( void )
 		return CreateTargetChangeLevel( level.nextmap );
 
 	// search for a changelevel
-	ent = G_Find( NULL, FOFS( classname ), "target_changelevel" );
+	ent = G_FindByClassname( NULL, "target_changelevel" );
 	if( !ent )
 	{
 		// the map designer didn't include a changelevel,
@@ -20,7 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 // g_public.h -- game dll information visible to server
 
-#define	GAME_API_VERSION    50
+#define	GAME_API_VERSION    51
 
 //===============================================================
 
@@ -97,6 +97,12 @@ typedef struct
 
 	unsigned int ( *Milliseconds )( void );
 
+	// frame profiler
+	int ( *Prof_RegisterStage )( const char *name );
+	uint64_t ( *Prof_Begin )( void );
+	void ( *Prof_End )( int stage, uint64_t start );
+	void ( *Prof_AddSample )( int stage, uint64_t usec );
+
 	bool ( *inPVS )( const vec3_t p1, const vec3_t p2 );
 
 	int ( *CM_NumInlineModels )( void );
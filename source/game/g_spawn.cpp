@@ -494,6 +494,7 @@ static char *ED_ParseEdict( char *data, edict_t *ent )
 
 	if( !init )
 		ent->classname = NULL;
+	G_UpdateEntityNames( ent );
 	if( ent->classname && ent->helpmessage )
 		ent->mapmessage_index = G_RegisterHelpMessage( ent->helpmessage );
 
@@ -734,7 +735,10 @@ static void G_FreeEntities( void )
 	int i;
 
 	if( !level.time )
+	{
 		memset( game.edicts, 0, game.maxentities * sizeof( game.edicts[0] ) );
+		G_ResetEntityNames();
+	}
 	else
 	{
 		G_FreeEdict( world );
@@ -823,7 +827,7 @@ static void G_SpawnEntities( void )
 				if( G_Gametype_CanSpawnItem( item ) )
 				{
 					// override entity's classname with whatever item specifies
-					ent->classname = item->classname;
+					G_SetClassname( ent, item->classname );
 					PrecacheItem( item );
 					continue;
 				}
@@ -94,12 +94,12 @@ edict_t *G_SelectIntermissionSpawnPoint( void )
 	int i;
 
 	// find an intermission spot
-	ent = G_Find( NULL, FOFS( classname ), "info_player_intermission" );
+	ent = G_FindByClassname( NULL, "info_player_intermission" );
 	if( !ent )
 	{ // the map creator forgot to put in an intermission point...
-		ent = G_Find( NULL, FOFS( classname ), "info_player_start" );
+		ent = G_FindByClassname( NULL, "info_player_start" );
 		if( !ent )
-			ent = G_Find( NULL, FOFS( classname ), "info_player_deathmatch" );
+			ent = G_FindByClassname( NULL, "info_player_deathmatch" );
 	}
 	else
 	{
@@ -107,9 +107,9 @@ edict_t *G_SelectIntermissionSpawnPoint( void )
 		i = rand() & 3;
 		while( i-- )
 		{
-			ent = G_Find( ent, FOFS( classname ), "info_player_intermission" );
+			ent = G_FindByClassname( ent, "info_player_intermission" );
 			if( !ent )  // wrap around the list
-				ent = G_Find( ent, FOFS( classname ), "info_player_intermission" );
+				ent = G_FindByClassname( ent, "info_player_intermission" );
 		}
 	}
 
@@ -136,7 +136,7 @@ static edict_t *SelectRandomDeathmatchSpawnPoint( edict_t *ent )
 	if( ent && GS_TeamBasedGametype() )
 		ignore_team = ent->s.team;
 
-	while( ( spot = G_Find( spot, FOFS( classname ), "info_player_deathmatch" ) ) != NULL )
+	while( ( spot = G_FindByClassname( spot, "info_player_deathmatch" ) ) != NULL )
 	{
 		count++;
 		range = PlayersRangeFromSpot( spot, ignore_team );
@@ -176,7 +176,7 @@ static edict_t *SelectRandomDeathmatchSpawnPoint( edict_t *ent )
 	spot = NULL;
 	do
 	{
-		spot = G_Find( spot, FOFS( classname ), "info_player_deathmatch" );
+		spot = G_FindByClassname( spot, "info_player_deathmatch" );
 		if( spot == spot1 || spot == spot2 )
 			selection++;
 	}
@@ -341,12 +341,12 @@ void SelectSpawnPoint( edict_t *ent, edict_t **spawnpoint, vec3_t origin, vec3_t
 	// find a single player start spot
 	if( !spot )
 	{
-		spot = G_Find( spot, FOFS( classname ), "info_player_start" );
+		spot = G_FindByClassname( spot, "info_player_start" );
 		if( !spot )
 		{
-			spot = G_Find( spot, FOFS( classname ), "team_CTF_alphaspawn" );
+			spot = G_FindByClassname( spot, "team_CTF_alphaspawn" );
 			if( !spot )
-				spot = G_Find( spot, FOFS( classname ), "team_CTF_betaspawn" );
+				spot = G_FindByClassname( spot, "team_CTF_betaspawn" );
 			if( !spot )
 				spot = world;
 		}
@@ -410,6 +410,8 @@ void G_AddServerCommands( void )
 	trap_Cmd_AddCommand( "listraces", G_ListRaces_f );
 
 	trap_Cmd_AddCommand( "listlocations", Cmd_ListLocations_f );
+
+	trap_Cmd_AddCommand( "clipbench", GClip_Benchmark_f );
 }
 
 /*
@@ -445,4 +447,6 @@ void G_RemoveCommands( void )
 	trap_Cmd_RemoveCommand( "listraces" );
 
 	trap_Cmd_RemoveCommand( "listlocations" );
+
+	trap_Cmd_RemoveCommand( "clipbench" );
 }
@@ -84,6 +84,26 @@ static inline unsigned int trap_Milliseconds( void )
 	return GAME_IMPORT.Milliseconds();
 }
 
+static inline int trap_Prof_RegisterStage( const char *name )
+{
+	return GAME_IMPORT.Prof_RegisterStage( name );
+}
+
+static inline uint64_t trap_Prof_Begin( void )
+{
+	return GAME_IMPORT.Prof_Begin();
+}
+
+static inline void trap_Prof_End( int stage, uint64_t start )
+{
+	GAME_IMPORT.Prof_End( stage, start );
+}
+
+static inline void trap_Prof_AddSample( int stage, uint64_t usec )
+{
+	GAME_IMPORT.Prof_AddSample( stage, usec );
+}
+
 static inline bool trap_inPVS( const vec3_t p1, const vec3_t p2 )
 {
 	return GAME_IMPORT.inPVS( p1, p2 ) == true;
@@ -251,7 +251,7 @@ static void use_target_spawner( edict_t *self, edict_t *other, edict_t *activato
 	edict_t	*ent;
 
 	ent = G_Spawn();
-	ent->classname = self->target;
+	G_SetClassname( ent, self->target );
 	VectorCopy( self->s.origin, ent->s.origin );
 	VectorCopy( self->s.angles, ent->s.angles );
 	G_CallSpawn( ent );
@@ -479,7 +479,7 @@ void target_laser_start( edict_t *self )
 	{
 		if( self->target )
 		{
-			ent = G_Find( NULL, FOFS( targetname ), self->target );
+			ent = G_FindByTargetname( NULL, self->target );
 			if( !ent )
 				if( developer->integer )
 					G_Printf( "%s at %s: %s is a bad target\n", self->classname, vtos( self->s.origin ), self->target );
@@ -549,7 +549,7 @@ static void target_lightramp_use( edict_t *self, edict_t *other, edict_t *activa
 		e = NULL;
 		while( 1 )
 		{
-			e = G_Find( e, FOFS( targetname ), self->target );
+			e = G_FindByTargetname( e, self->target );
 			if( !e )
 				break;
 			if( Q_stricmp( e->classname, "light" ) )
@@ -881,7 +881,7 @@ static void target_give_use( edict_t *self, edict_t *other, edict_t *activator )
 	numsounds = 0;
 
 	// more than one item can be given
-	while( ( give = G_Find( give, FOFS( targetname ), self->target ) ) != NULL )
+	while( ( give = G_FindByTargetname( give, self->target ) ) != NULL )
 	{
 		// sanity
 		item = give->item;
@@ -967,7 +967,7 @@ static void target_teleporter_use( edict_t *self, edict_t *other, edict_t *activ
 	if( self->spawnflags & 1 && activator->r.client->ps.pmove.pm_type != PM_SPECTATOR )
 		return;
 
-	dest = G_Find( NULL, FOFS( targetname ), self->target );
+	dest = G_FindByTargetname( NULL, self->target );
 	if( !dest )
 	{
 		if( developer->integer )
@@ -715,7 +715,7 @@ static void old_teleporter_touch( edict_t *self, edict_t *other, cplane_t *plane
 
 	self->timeStamp = level.time + ( self->wait * 1000 );
 
-	dest = G_Find( NULL, FOFS( targetname ), self->target );
+	dest = G_FindByTargetname( NULL, self->target );
 	if( !dest )
 	{
 		if( developer->integer )
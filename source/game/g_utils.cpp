@@ -529,6 +529,248 @@ void G_ProjectSource( vec3_t point, vec3_t distance, vec3_t forward, vec3_t righ
 }
 
 
+/*
+* Entity name indices
+*
+* classname and targetname lookups go through hash tables instead of scanning all the
+* entities. Every bucket keeps its entities in number order, so the iteration order is
+* the same as the scan's. Entities are indexed by the name pointer they hold: setting the
+* names with G_SetClassname and G_SetTargetname keeps the index current, entities with
+* names written directly are picked up by G_UpdateEntityNames or at the next frame.
+* Indices are stored +1 so the zeroed tables are empty.
+*/
+#define ENTNAME_HASH_SIZE	1024
+
+enum
+{
+	ENTNAME_CLASSNAME,
+	ENTNAME_TARGETNAME,
+
+	ENTNAME_TOTAL_KEYS
+};
+
+typedef struct
+{
+	const char *name;	// the pointer which was indexed
+	int bucket;			// bucket + 1, 0 when not linked
+	int prev, next;		// entity number + 1
+} entnamelink_t;
+
+typedef struct
+{
+	int head, tail;		// entity number + 1
+} entnamebucket_t;
+
+static entnamelink_t entNameLinks[ENTNAME_TOTAL_KEYS][MAX_EDICTS];
+static entnamebucket_t entNameBuckets[ENTNAME_TOTAL_KEYS][ENTNAME_HASH_SIZE];
+
+/*
+* G_EntityNameHash
+*/
+static int G_EntityNameHash( const char *name )
+{
+	unsigned int hash = 2166136261u;
+
+	for( ; *name; name++ )
+		hash = ( hash ^ (unsigned char)tolower( *name ) ) * 16777619u;
+
+	return hash & ( ENTNAME_HASH_SIZE - 1 );
+}
+
+/*
+* G_EntityNameField
+*/
+static inline const char *G_EntityNameField( const edict_t *ent, int key )
+{
+	return key == ENTNAME_CLASSNAME ? ent->classname : ent->targetname;
+}
+
+/*
+* G_UnlinkEntityName
+*/
+static void G_UnlinkEntityName( int key, int num )
+{
+	entnamelink_t *link = &entNameLinks[key][num];
+	entnamebucket_t *bucket;
+
+	if( !link->bucket )
+		return;
+
+	bucket = &entNameBuckets[key][link->bucket - 1];
+	if( link->prev )
+		entNameLinks[key][link->prev - 1].next = link->next;
+	else
+		bucket->head = link->next;
+	if( link->next )
+		entNameLinks[key][link->next - 1].prev = link->prev;
+	else
+		bucket->tail = link->prev;
+
+	memset( link, 0, sizeof( *link ) );
+}
+
+/*
+* G_LinkEntityName
+*/
+static void G_LinkEntityName( int key, int num, const char *name )
+{
+	entnamelink_t *link = &entNameLinks[key][num];
+	entnamebucket_t *bucket;
+	int prev;
+
+	link->name = name;
+	link->bucket = G_EntityNameHash( name ) + 1;
+	bucket = &entNameBuckets[key][link->bucket - 1];
+
+	// entities mostly get their names in spawn order, so look from the tail
+	for( prev = bucket->tail; prev && prev - 1 > num; prev = entNameLinks[key][prev - 1].prev );
+
+	link->prev = prev;
+	if( prev )
+	{
+		link->next = entNameLinks[key][prev - 1].next;
+		entNameLinks[key][prev - 1].next = num + 1;
+	}
+	else
+	{
+		link->next = bucket->head;
+		bucket->head = num + 1;
+	}
+	if( link->next )
+		entNameLinks[key][link->next - 1].prev = num + 1;
+	else
+		bucket->tail = num + 1;
+}
+
+/*
+* G_UpdateEntityName
+*/
+static void G_UpdateEntityName( int key, edict_t *ent )
+{
+	int num = ENTNUM( ent );
+	const char *name = G_EntityNameField( ent, key );
+	entnamelink_t *link = &entNameLinks[key][num];
+
+	if( link->name == name && ( link->bucket != 0 ) == ( name != NULL ) )
+		return;
+
+	G_UnlinkEntityName( key, num );
+	if( name )
+		G_LinkEntityName( key, num, name );
+}
+
+/*
+* G_UpdateEntityNames
+*/
+void G_UpdateEntityNames( edict_t *ent )
+{
+	G_UpdateEntityName( ENTNAME_CLASSNAME, ent );
+	G_UpdateEntityName( ENTNAME_TARGETNAME, ent );
+}
+
+/*
+* G_SyncEntityNames
+*
+* Picks up the names which were written directly into the entities
+*/
+void G_SyncEntityNames( void )
+{
+	int i;
+
+	for( i = 0; i < game.numentities; i++ )
+		G_UpdateEntityNames( game.edicts + i );
+}
+
+/*
+* G_ResetEntityNames
+*/
+void G_ResetEntityNames( void )
+{
+	memset( entNameLinks, 0, sizeof( entNameLinks ) );
+	memset( entNameBuckets, 0, sizeof( entNameBuckets ) );
+}
+
+/*
+* G_SetClassname
+*/
+void G_SetClassname( edict_t *ent, const char *classname )
+{
+	ent->classname = classname;
+	G_UpdateEntityNames( ent );
+}
+
+/*
+* G_SetTargetname
+*/
+void G_SetTargetname( edict_t *ent, const char *targetname )
+{
+	ent->targetname = targetname;
+	G_UpdateEntityNames( ent );
+}
+
+/*
+* G_FindByName
+*/
+static edict_t *G_FindByName( int key, edict_t *from, const char *match )
+{
+	int bucket, fromnum, next;
+	const char *s;
+	edict_t *ent;
+
+	bucket = G_EntityNameHash( match );
+
+	if( !from )
+	{
+		next = entNameBuckets[key][bucket].head;
+	}
+	else
+	{
+		// the entity may have been freed or renamed since it was returned
+		fromnum = ENTNUM( from );
+		if( entNameLinks[key][fromnum].bucket == bucket + 1 )
+		{
+			next = entNameLinks[key][fromnum].next;
+		}
+		else
+		{
+			for( next = entNameBuckets[key][bucket].head; next && next - 1 <= fromnum; next = entNameLinks[key][next - 1].next );
+		}
+	}
+
+	for( ; next; next = entNameLinks[key][next - 1].next )
+	{
+		ent = game.edicts + next - 1;
+		if( !ent->r.inuse )
+			continue;
+		s = G_EntityNameField( ent, key );
+		if( s && !Q_stricmp( s, match ) )
+			return ent;
+	}
+
+	return NULL;
+}
+
+/*
+* G_FindByClassname
+* 
+* Returns the next active entity after from, or the first one if NULL, with the
+* given classname, or NULL if there are no more.
+*/
+edict_t *G_FindByClassname( edict_t *from, const char *classname )
+{
+	return G_FindByName( ENTNAME_CLASSNAME, from, classname );
+}
+
+/*
+* G_FindByTargetname
+* 
+* Same as G_FindByClassname, for targetnames
+*/
+edict_t *G_FindByTargetname( edict_t *from, const char *targetname )
+{
+	return G_FindByName( ENTNAME_TARGETNAME, from, targetname );
+}
+
 /*
 * G_Find
 * 
@@ -543,6 +785,11 @@ edict_t *G_Find( edict_t *from, size_t fieldofs, const char *match )
 {
 	char *s;
 
+	if( fieldofs == FOFS( classname ) )
+		return G_FindByClassname( from, match );
+	if( fieldofs == FOFS( targetname ) )
+		return G_FindByTargetname( from, match );
+
 	if( !from )
 		from = world;
 	else
@@ -588,7 +835,7 @@ edict_t *G_PickTarget( const char *targetname )
 
 	while( 1 )
 	{
-		ent = G_Find( ent, FOFS( targetname ), targetname );
+		ent = G_FindByTargetname( ent, targetname );
 		if( !ent )
 			break;
 		choice[num_choices++] = ent;
@@ -638,7 +885,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator )
 	{
 		// create a temp object to fire at a later time
 		t = G_Spawn();
-		t->classname = "delayed_use";
+		G_SetClassname( t, "delayed_use" );
 		t->nextThink = level.time + 1000 * ent->delay;
 		t->think = Think_Delay;
 		t->activator = activator;
@@ -686,7 +933,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator )
 	if( ent->killtarget )
 	{
 		t = NULL;
-		while( ( t = G_Find( t, FOFS( targetname ), ent->killtarget ) ) )
+		while( ( t = G_FindByTargetname( t, ent->killtarget ) ) )
 		{
 			G_FreeEdict( t );
 			if( !ent->r.inuse )
@@ -705,7 +952,7 @@ void G_UseTargets( edict_t *ent, edict_t *activator )
 	if( ent->target )
 	{
 		t = NULL;
-		while( ( t = G_Find( t, FOFS( targetname ), ent->target ) ) )
+		while( ( t = G_FindByTargetname( t, ent->target ) ) )
 		{
 			if( t == ent )
 			{
@@ -798,6 +1045,7 @@ void G_FreeEdict( edict_t *ed )
 	G_asReleaseEntityBehaviors( ed );
 
 	memset( ed, 0, sizeof( *ed ) );
+	G_UpdateEntityNames( ed );
 	ed->r.inuse = false;
 	ed->s.number = ENTNUM( ed );
 	ed->r.svflags = SVF_NOCLIENT;
@@ -813,7 +1061,7 @@ void G_FreeEdict( edict_t *ed )
 void G_InitEdict( edict_t *e )
 {
 	e->r.inuse = true;
-	e->classname = NULL;
+	G_SetClassname( e, NULL );
 	e->gravity = 1.0;
 	e->s.number = ENTNUM( e );
 	e->timeDelta = 0;
@@ -2465,7 +2713,7 @@ int G_MapLocationTAGForOrigin( const vec3_t origin )
 	float hotdist = 3.0f*8192.0f*8192.0f;
 	vec3_t v;
 
-	while( ( what = G_Find( what, FOFS( classname ), "target_location" ) ) != NULL )
+	while( ( what = G_FindByClassname( what, "target_location" ) ) != NULL )
 	{
 		VectorSubtract( what->s.origin, origin, v );
 
@@ -286,7 +286,7 @@ static edict_t *W_Fire_LinearProjectile( edict_t *self, vec3_t start, vec3_t ang
 	projectile->touch = W_Touch_Projectile; //generic one. Should be replaced after calling this func
 	projectile->nextThink = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -346,7 +346,7 @@ static edict_t *W_Fire_TossProjectile( edict_t *self, vec3_t start, vec3_t angle
 	projectile->touch = W_Touch_Projectile; //generic one. Should be replaced after calling this func
 	projectile->nextThink = level.time + timeout;
 	projectile->think = G_FreeEdict;
-	projectile->classname = NULL; // should be replaced after calling this func.
+	G_SetClassname( projectile, NULL ); // should be replaced after calling this func.
 	projectile->style = 0;
 	projectile->s.sound = 0;
 	projectile->timeStamp = level.time;
@@ -476,7 +476,7 @@ edict_t *W_Fire_GunbladeBlast( edict_t *self, vec3_t start, vec3_t angles, float
 	blast->s.type = ET_BLASTER;
 	blast->s.effects |= EF_STRONG_WEAPON;
 	blast->touch = W_Touch_GunbladeBlast;
-	blast->classname = "gunblade_blast";
+	G_SetClassname( blast, "gunblade_blast" );
 	blast->style = mod;
 
 	blast->s.sound = trap_SoundIndex( S_WEAPON_PLASMAGUN_S_FLY );
@@ -533,35 +533,84 @@ void W_Fire_Bullet( edict_t *self, vec3_t start, vec3_t angles, int seed, int ra
 	}
 }
 
+#define SPREAD_BATCH_PELLETS	32
+
+/*
+* G_Fire_SpreadBatch
+*
+* Traces a batch of pellets and applies their damage, the same as
+* running GS_TraceBullet for each of them
+*/
+static void G_Fire_SpreadBatch( edict_t *self, gclip_tracequery_t *pellets, int count, vec3_t dir, 
+	float damage, int kick, int stun, int dflags, int mod, int timeDelta )
+{
+	int i, content_mask = MASK_SHOT | MASK_WATER;
+	trace_t *trace;
+	edict_t *hit;
+	vec3_t water_start;
+
+	if( G_PointContents4D( pellets[0].start, timeDelta ) & MASK_WATER )
+		content_mask &= ~MASK_WATER;
+
+	G_TraceBatch4D( pellets, count, self, content_mask, timeDelta );
+
+	for( i = 0; i < count; i++ )
+	{
+		trace = &pellets[i].trace;
+
+		// an earlier pellet may have gibbed what this one hit
+		if( trace->ent > 0 && ( !game.edicts[trace->ent].r.inuse || game.edicts[trace->ent].r.solid == SOLID_NOT ) )
+			G_Trace4D( trace, pellets[i].start, NULL, NULL, pellets[i].end, self, content_mask, timeDelta );
+
+		// see if we hit water, re-trace ignoring water this time
+		if( trace->contents & MASK_WATER )
+		{
+			VectorCopy( trace->endpos, water_start );
+			G_Trace4D( trace, water_start, NULL, NULL, pellets[i].end, self, MASK_SHOT, timeDelta );
+		}
+
+		if( trace->ent != -1 )
+		{
+			hit = &game.edicts[trace->ent];
+			if( hit->takedamage )
+			{
+				G_Damage( hit, self, self, dir, dir, trace->endpos, damage, kick, stun, dflags, mod );
+			}
+			else
+			{
+				if( !( trace->surfFlags & SURF_NOIMPACT ) )
+				{
+				}
+			}
+		}
+	}
+}
+
 //Sunflower spiral with Fibonacci numbers 
 static void G_Fire_SunflowerPattern( edict_t *self, vec3_t start, vec3_t dir, int *seed, int count, 
 	int hspread, int vspread, int range, float damage, int kick, int stun, int dflags, int mod, int timeDelta )
 {
-	int i;
+	int i, n;
 	float r;
 	float u;
 	float fi;
-	trace_t trace;
+	gclip_tracequery_t pellets[SPREAD_BATCH_PELLETS];
 
-	for( i = 0; i < count; i++ )
+	for( n = 0, i = 0; i < count; i++ )
 	{
 		fi = i * 2.4; //magic value creating Fibonacci numbers
 		r = cos( (float)*seed + fi ) * hspread * sqrt(fi);
 		u = sin( (float)*seed + fi ) * vspread * sqrt(fi); 
 
-		GS_TraceBullet( &trace, start, dir, r, u, range, ENTNUM( self ), timeDelta );
-		if( trace.ent != -1 )
+		VectorCopy( start, pellets[n].start );
+		GS_BulletEndPoint( start, dir, r, u, range, pellets[n].end );
+		VectorClear( pellets[n].mins );
+		VectorClear( pellets[n].maxs );
+
+		if( ++n == SPREAD_BATCH_PELLETS || i == count - 1 )
 		{
-			if( game.edicts[trace.ent].takedamage )
-			{
-				G_Damage( &game.edicts[trace.ent], self, self, dir, dir, trace.endpos, damage, kick, stun, dflags, mod );
-			}
-			else
-			{
-				if( !( trace.surfFlags & SURF_NOIMPACT ) )
-				{
-				}
-			}
+			G_Fire_SpreadBatch( self, pellets, n, dir, damage, kick, stun, dflags, mod, timeDelta );
+			n = 0;
 		}
 	}
 }
@@ -735,7 +784,7 @@ edict_t *W_Fire_Grenade( edict_t *self, vec3_t start, vec3_t angles, int speed,
 	grenade->touch = W_Touch_Grenade;
 	grenade->use = NULL;
 	grenade->think = W_Grenade_Explode;
-	grenade->classname = "grenade";
+	G_SetClassname( grenade, "grenade" );
 	grenade->enemy = NULL;
 
 	if( mod == MOD_GRENADE_S )
@@ -848,7 +897,7 @@ edict_t *W_Fire_Rocket( edict_t *self, vec3_t start, vec3_t angles, int speed, f
 	rocket->s.attenuation = ATTN_STATIC;
 	rocket->touch = W_Touch_Rocket;
 	rocket->think = G_FreeEdict;
-	rocket->classname = "rocket";
+	G_SetClassname( rocket, "rocket" );
 	rocket->style = mod;
 
 	return rocket;
@@ -985,7 +1034,7 @@ edict_t *W_Fire_Plasma( edict_t *self, vec3_t start, vec3_t angles, float damage
 
 	plasma = W_Fire_LinearProjectile( self, start, angles, speed, damage, minKnockback, maxKnockback, stun, minDamage, radius, timeout, timeDelta );
 	plasma->s.type = ET_PLASMA;
-	plasma->classname = "plasma";
+	G_SetClassname( plasma, "plasma" );
 	plasma->style = mod;
 
 	plasma->think = W_Think_Plasma;
@@ -1274,7 +1323,7 @@ edict_t *W_Fire_Electrobolt_Weak( edict_t *self, vec3_t start, vec3_t angles, fl
 	bolt->s.type = ET_ELECTRO_WEAK; //add particle trail and light
 	bolt->s.ownerNum = ENTNUM( self );
 	bolt->touch = W_Touch_Bolt;
-	bolt->classname = "bolt";
+	G_SetClassname( bolt, "bolt" );
 	bolt->style = mod;
 	bolt->s.effects &= ~EF_STRONG_WEAPON;
 
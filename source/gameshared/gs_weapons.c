@@ -30,12 +30,28 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define BULLET_WATER_REFRACTION 1.5f
 
+/*
+* GS_BulletEndPoint
+*
+* Where a bullet fired along dir, offset by r and u of spread, stops when it hits nothing
+*/
+void GS_BulletEndPoint( vec3_t start, vec3_t dir, float r, float u, int range, vec3_t end )
+{
+	mat3_t axis;
+
+	VectorNormalizeFast( dir );
+	NormalVectorToAxis( dir, axis );
+
+	VectorMA( start, range, &axis[AXIS_FORWARD], end );
+	if( r ) VectorMA( end, r, &axis[AXIS_RIGHT], end );
+	if( u ) VectorMA( end, u, &axis[AXIS_UP], end );
+}
+
 /*
 * GS_TraceBullet
 */
 trace_t *GS_TraceBullet( trace_t *trace, vec3_t start, vec3_t dir, float r, float u, int range, int ignore, int timeDelta )
 {
-	mat3_t axis;
 	vec3_t end;
 	bool water = false;
 	vec3_t water_start;
@@ -44,8 +60,7 @@ trace_t *GS_TraceBullet( trace_t *trace, vec3_t start, vec3_t dir, float r, floa
 
 	assert( trace );
 
-	VectorNormalizeFast( dir );
-	NormalVectorToAxis( dir, axis );
+	GS_BulletEndPoint( start, dir, r, u, range, end );
 
 	if( module_PointContents( start, timeDelta ) & MASK_WATER )
 	{
@@ -59,10 +74,6 @@ trace_t *GS_TraceBullet( trace_t *trace, vec3_t start, vec3_t dir, float r, floa
 		//u *= BULLET_WATER_REFRACTION;
 	}
 
-	VectorMA( start, range, &axis[AXIS_FORWARD], end );
-	if( r ) VectorMA( end, r, &axis[AXIS_RIGHT], end );
-	if( u ) VectorMA( end, u, &axis[AXIS_UP], end );
-
 	module_Trace( trace, start, vec3_origin, vec3_origin, end, ignore, content_mask, timeDelta );
 
 	// see if we hit water
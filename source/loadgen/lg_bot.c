@@ -0,0 +1,712 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "lg_local.h"
+
+#include <setjmp.h>
+
+/*
+* Each bot is a connection of its own, going through the same handshake,
+* usercmd and snapshot paths as the real client (see cl_main.c, cl_parse.c
+* and cl_input.c), minus everything that needs the map or the cgame.
+*/
+
+// for jumping over bot handling when it's disconnected
+static jmp_buf lg_abortframe;
+
+static void LG_Bot_SendMessagesToServer( lgbot_t *bot, bool sendNow );
+
+/*
+* LG_Bot_Error
+* Must only be called from inside LG_Bot_Run
+*/
+static void LG_Bot_Error( lgbot_t *bot, const char *format, ... )
+{
+	va_list	argptr;
+	char msg[1024];
+
+	va_start( argptr, format );
+	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
+	va_end( argptr );
+
+	Com_Printf( "%s: %s\n", bot->name, msg );
+
+	LG_Bot_Disconnect( bot, "%s", msg );
+	longjmp( lg_abortframe, -1 );
+}
+
+/*
+* LG_Bot_AddReliableCommand
+*/
+static void LG_Bot_AddReliableCommand( lgbot_t *bot, const char *cmd )
+{
+	int index;
+
+	if( bot->reliableSequence > MAX_RELIABLE_COMMANDS + bot->reliableAcknowledge )
+	{
+		// so we don't get recursive error from disconnect commands
+		bot->reliableAcknowledge = bot->reliableSequence;
+		LG_Bot_Error( bot, "Client command overflow" );
+	}
+
+	bot->reliableSequence++;
+	index = bot->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 );
+	Q_strncpyz( bot->reliableCommands[index], cmd, sizeof( bot->reliableCommands[index] ) );
+}
+
+/*
+* LG_Bot_ClearState
+*/
+static void LG_Bot_ClearState( lgbot_t *bot )
+{
+	bot->lastExecutedServerCommand = 0;
+	bot->reliableAcknowledge = 0;
+	bot->reliableSequence = 0;
+	bot->reliableSent = 0;
+	memset( bot->reliableCommands, 0, sizeof( bot->reliableCommands ) );
+
+	bot->ucmdHead = 1;
+	bot->ucmdSent = 0;
+	bot->ucmdAcknowledged = 0;
+	bot->ucmdExecuted = 0;
+	bot->lastUcmdTime = 0;
+
+	bot->lastFrame = NULL;
+	bot->lastFrameTime = 0;
+}
+
+/*
+* LG_Bot_Init
+*/
+void LG_Bot_Init( lgbot_t *bot, int number )
+{
+	int i;
+
+	memset( bot, 0, sizeof( *bot ) );
+
+	bot->number = number;
+	bot->state = CA_UNINITIALIZED;
+	Q_snprintfz( bot->name, sizeof( bot->name ), "loadgen%03i", number + 1 );
+
+	// the server tells clients behind the same address apart by the game port.
+	// every process takes its own from the milliseconds since it started, so a
+	// client or TV server on this host has a small one, keep the bots above it
+	bot->game_port = 0x8000 | ( ( Netchan_GamePort() + number ) & 0x7fff );
+
+	bot->frames = Mem_Alloc( lg.mempool, sizeof( *bot->frames ) * UPDATE_BACKUP );
+	bot->frames_areabits = Mem_Alloc( lg.mempool, UPDATE_BACKUP * LG_MAX_AREABYTES );
+	for( i = 0; i < UPDATE_BACKUP; i++ )
+	{
+		bot->frames[i].areabytes = LG_MAX_AREABYTES;
+		bot->frames[i].areabits = bot->frames_areabits + i * LG_MAX_AREABYTES;
+	}
+	bot->baselines = Mem_Alloc( lg.mempool, sizeof( *bot->baselines ) * MAX_EDICTS );
+}
+
+/*
+* LG_Bot_Free
+*/
+void LG_Bot_Free( lgbot_t *bot )
+{
+	if( bot->state > CA_DISCONNECTED )
+		LG_Bot_Disconnect( bot, "Load test stopped" );
+
+	Mem_Free( bot->frames );
+	Mem_Free( bot->frames_areabits );
+	Mem_Free( bot->baselines );
+	bot->frames = NULL;
+	bot->frames_areabits = NULL;
+	bot->baselines = NULL;
+}
+
+/*
+* LG_Bot_Userinfo
+*/
+static const char *LG_Bot_Userinfo( lgbot_t *bot )
+{
+	static char userinfo[MAX_INFO_STRING];
+
+	userinfo[0] = '\0';
+	Info_SetValueForKey( userinfo, "name", bot->name );
+	Info_SetValueForKey( userinfo, "rate", "90000" );
+	if( lg_password->string[0] )
+		Info_SetValueForKey( userinfo, "password", lg_password->string );
+
+	return userinfo;
+}
+
+/*
+* LG_Bot_Connect
+*/
+void LG_Bot_Connect( lgbot_t *bot )
+{
+	netadr_t socketaddress;
+
+	NET_InitAddress( &socketaddress, lg.serveraddress.type );
+	if( !NET_OpenSocket( &bot->socket, SOCKET_UDP, &socketaddress, false ) )
+	{
+		Com_Printf( "%s: Couldn't open UDP socket: %s\n", bot->name, NET_ErrorString() );
+		bot->state = CA_DISCONNECTED;
+		return;
+	}
+
+	LG_Bot_ClearState( bot );
+
+	bot->state = CA_CONNECTING;
+	bot->connect_time = lg.realtime;
+	bot->connect_count = 0;
+	bot->lastPacketReceivedTime = lg.realtime;
+
+	// spread the bots over the script so they don't move in lockstep
+	bot->scriptStep = bot->number % lg.script->numsteps;
+	bot->scriptStepTime = ( bot->number * 37 ) % lg.script->steps[bot->scriptStep].msec;
+	VectorClear( bot->viewangles );
+	bot->viewangles[YAW] = ( bot->number * 53 ) % 360;
+
+	Netchan_OutOfBandPrint( &bot->socket, &lg.serveraddress, "getchallenge\n" );
+}
+
+/*
+* LG_Bot_Disconnect
+*/
+void LG_Bot_Disconnect( lgbot_t *bot, const char *format, ... )
+{
+	va_list	argptr;
+	char msg[1024];
+
+	va_start( argptr, format );
+	Q_vsnprintfz( msg, sizeof( msg ), format, argptr );
+	va_end( argptr );
+
+	Com_DPrintf( "%s: Disconnected: %s\n", bot->name, msg );
+
+	if( bot->state > CA_CONNECTING )
+	{
+		int i;
+
+		// drop anything still pending, this may be called from outside LG_Bot_Run
+		// so it must not go through the overflow check
+		bot->reliableAcknowledge = bot->reliableSequence++;
+		Q_strncpyz( bot->reliableCommands[bot->reliableSequence & ( MAX_RELIABLE_COMMANDS - 1 )], "disconnect",
+			sizeof( bot->reliableCommands[0] ) );
+
+		for( i = 0; i < 3; i++ )
+			LG_Bot_SendMessagesToServer( bot, true );
+	}
+
+	if( bot->state > CA_DISCONNECTED )
+		NET_CloseSocket( &bot->socket );
+
+	bot->state = CA_DISCONNECTED;
+}
+
+//=============================================================================
+
+/*
+* LG_Bot_SendConnectPacket
+*/
+static void LG_Bot_SendConnectPacket( lgbot_t *bot )
+{
+	Netchan_OutOfBandPrint( &bot->socket, &lg.serveraddress, "connect %i %i %i \"%s\" %i %u %s\n",
+		APP_PROTOCOL_VERSION, bot->game_port, bot->challenge, LG_Bot_Userinfo( bot ), 0, 0, Com_NetCodecOffer() );
+}
+
+/*
+* LG_Bot_ConnectionlessPacket
+*/
+static void LG_Bot_ConnectionlessPacket( lgbot_t *bot, msg_t *msg )
+{
+	char *s, *c;
+	int codec;
+
+	MSG_BeginReading( msg );
+	MSG_ReadLong( msg );    // skip the -1 marker
+
+	s = MSG_ReadStringLine( msg );
+	Cmd_TokenizeString( s );
+	c = Cmd_Argv( 0 );
+
+	if( !strcmp( c, "challenge" ) )
+	{
+		if( bot->state != CA_CONNECTING )
+			return;
+
+		bot->challenge = atoi( Cmd_Argv( 1 ) );
+		bot->connect_time = lg.realtime;
+		LG_Bot_SendConnectPacket( bot );
+	}
+	else if( !strcmp( c, "client_connect" ) )
+	{
+		if( bot->state != CA_CONNECTING )
+			return;
+
+		MSG_ReadStringLine( msg ); // session
+		codec = Com_NetCodecForName( MSG_ReadStringLine( msg ) );
+
+		Netchan_Setup( &bot->netchan, &bot->socket, &lg.serveraddress, bot->game_port );
+		bot->netchan.codec = codec < 0 ? NETCODEC_ZLIB : codec;
+		bot->state = CA_HANDSHAKE;
+		LG_Bot_AddReliableCommand( bot, "new" );
+	}
+	else if( !strcmp( c, "reject" ) )
+	{
+		MSG_ReadStringLine( msg ); // type
+		MSG_ReadStringLine( msg ); // flags
+		LG_Bot_Error( bot, "Server refused: %s", MSG_ReadStringLine( msg ) );
+	}
+	else
+	{
+		Com_DPrintf( "%s: Bad connectionless packet: %s\n", bot->name, c );
+	}
+}
+
+/*
+* LG_Bot_ParseServerCommand
+*/
+static void LG_Bot_ParseServerCommand( lgbot_t *bot, msg_t *msg )
+{
+	const char *s;
+
+	Cmd_TokenizeString( MSG_ReadString( msg ) );
+	s = Cmd_Argv( 0 );
+
+	if( !strcmp( s, "cmd" ) )
+	{
+		// the server drives the configstrings and baselines download this way
+		if( Cmd_Argc() > 1 )
+			LG_Bot_AddReliableCommand( bot, Cmd_Args() );
+	}
+	else if( !strcmp( s, "precache" ) )
+	{
+		LG_Bot_AddReliableCommand( bot, va( "begin %i", atoi( Cmd_Argv( 1 ) ) ) );
+	}
+	else if( !strcmp( s, "reconnect" ) )
+	{
+		// the server is changing levels
+		bot->state = CA_HANDSHAKE;
+		LG_Bot_AddReliableCommand( bot, "new" );
+	}
+	else if( !strcmp( s, "disconnect" ) )
+	{
+		LG_Bot_Error( bot, "Server disconnected: %s", Cmd_Argv( 2 ) );
+	}
+
+	// everything else is only meaningful to a real client
+}
+
+/*
+* LG_Bot_ParseServerData
+*/
+static void LG_Bot_ParseServerData( lgbot_t *bot, msg_t *msg )
+{
+	int i, bitflags, numpure;
+
+	i = MSG_ReadLong( msg );
+	if( i != APP_PROTOCOL_VERSION )
+		LG_Bot_Error( bot, "Server returned version %i, not %i", i, APP_PROTOCOL_VERSION );
+
+	bot->servercount = MSG_ReadLong( msg );
+	bot->snapFrameTime = (unsigned int)MSG_ReadShort( msg );
+
+	MSG_ReadString( msg ); // basegame
+	MSG_ReadString( msg ); // game
+
+	bot->playernum = MSG_ReadShort( msg );
+
+	MSG_ReadString( msg ); // level name
+
+	bitflags = MSG_ReadByte( msg );
+	if( bitflags & SV_BITFLAGS_RELIABLE )
+		LG_Bot_Error( bot, "Reliable servers aren't supported" );
+	if( bitflags & SV_BITFLAGS_HTTP )
+	{
+		if( bitflags & SV_BITFLAGS_HTTP_BASEURL )
+			MSG_ReadString( msg );
+		else
+			MSG_ReadShort( msg );
+	}
+
+	// we don't load any content, so the pure list is of no use
+	numpure = MSG_ReadShort( msg );
+	while( numpure-- > 0 )
+	{
+		MSG_ReadString( msg );
+		MSG_ReadLong( msg );
+	}
+
+	// a new level, the frames and baselines we have are of no use
+	bot->lastFrame = NULL;
+	bot->lastFrameTime = 0;
+	memset( bot->baselines, 0, sizeof( *bot->baselines ) * MAX_EDICTS );
+
+	bot->state = CA_CONNECTED;
+	LG_Bot_AddReliableCommand( bot, va( "configstrings %i 0", bot->servercount ) );
+}
+
+/*
+* LG_Bot_ParseFrame
+*/
+static void LG_Bot_ParseFrame( lgbot_t *bot, msg_t *msg )
+{
+	snapshot_t *snap;
+	unsigned int ucmdExecuted;
+	int offset;
+
+	snap = SNAP_ParseFrame( msg, bot->lastFrame, NULL, bot->frames, bot->baselines, 0 );
+
+	// ignore older than already received
+	if( bot->lastFrame && snap->serverFrame <= bot->lastFrame->serverFrame )
+		return;
+
+	if( !snap->valid )
+	{
+		bot->framesInvalid++;
+		return;
+	}
+
+	if( lg.measureTime )
+	{
+		bot->framesReceived++;
+
+		if( bot->lastFrame && snap->serverFrame == bot->lastFrame->serverFrame + 1 )
+			LG_AddSample( &lg.interval, lg.realtime - bot->lastFrameTime );
+
+		// how far behind the server's clock the frame arrived, relative to the best
+		// arrival seen so far. Late ticks on the server show up here
+		offset = (int)( lg.realtime - snap->serverTime );
+		if( bot->framesReceived == 1 || offset < bot->frameTimeOffset )
+			bot->frameTimeOffset = offset;
+		LG_AddSample( &lg.lateness, offset - bot->frameTimeOffset );
+
+		// the server reports the last ucmd it ran, time it from when it was first sent
+		ucmdExecuted = snap->ucmdExecuted;
+		if( ucmdExecuted > bot->ucmdExecuted && ucmdExecuted <= bot->ucmdSent &&
+			ucmdExecuted + CMD_BACKUP > bot->ucmdHead )
+			LG_AddSample( &lg.latency, lg.realtime - bot->cmdSentTime[ucmdExecuted & CMD_MASK] );
+	}
+
+	if( snap->ucmdExecuted > bot->ucmdExecuted && snap->ucmdExecuted <= bot->ucmdSent )
+		bot->ucmdExecuted = snap->ucmdExecuted;
+
+	bot->lastFrame = snap;
+	bot->lastFrameTime = lg.realtime;
+
+	// getting a valid frame message ends the connection process
+	if( bot->state != CA_ACTIVE )
+	{
+		bot->state = CA_ACTIVE;
+		Com_DPrintf( "%s: Active\n", bot->name );
+	}
+}
+
+/*
+* LG_Bot_ParseServerMessage
+*/
+static void LG_Bot_ParseServerMessage( lgbot_t *bot, msg_t *msg )
+{
+	int cmd;
+
+	while( bot->state >= CA_HANDSHAKE )
+	{
+		if( msg->readcount > msg->cursize )
+			LG_Bot_Error( bot, "Bad server message" );
+
+		cmd = MSG_ReadByte( msg );
+		if( cmd == -1 )
+			break;
+
+		switch( cmd )
+		{
+		default:
+			LG_Bot_Error( bot, "Illegible server message" );
+
+		case svc_nop:
+			break;
+
+		case svc_servercmd:
+			{
+				int cmdNum = MSG_ReadLong( msg );
+				if( cmdNum < 0 )
+					LG_Bot_Error( bot, "Invalid cmdNum value" );
+				if( cmdNum <= bot->lastExecutedServerCommand )
+				{
+					MSG_ReadString( msg ); // read but ignore
+					break;
+				}
+				bot->lastExecutedServerCommand = cmdNum;
+			}
+			// fall trough
+		case svc_servercs:
+			LG_Bot_ParseServerCommand( bot, msg );
+			break;
+
+		case svc_serverdata:
+			if( bot->state != CA_HANDSHAKE )
+				return; // ignore rest of the packet (serverdata is always sent alone)
+			LG_Bot_ParseServerData( bot, msg );
+			break;
+
+		case svc_spawnbaseline:
+			SNAP_ParseBaseline( msg, bot->baselines );
+			break;
+
+		case svc_clcack:
+			bot->reliableAcknowledge = (unsigned)MSG_ReadLong( msg );
+			bot->ucmdAcknowledged = (unsigned)MSG_ReadLong( msg );
+			break;
+
+		case svc_frame:
+			LG_Bot_ParseFrame( bot, msg );
+			break;
+
+		case svc_extension:
+			{
+				int len;
+
+				MSG_ReadByte( msg );			// extension id
+				MSG_ReadByte( msg );			// version number
+				len = MSG_ReadShort( msg );		// command length
+				MSG_SkipData( msg, len );		// command data
+			}
+			break;
+		}
+	}
+}
+
+//=============================================================================
+
+/*
+* LG_Bot_ProcessPacket
+*/
+static bool LG_Bot_ProcessPacket( netchan_t *netchan, msg_t *msg )
+{
+	int zerror;
+
+	if( !Netchan_Process( netchan, msg ) )
+		return false; // wasn't accepted for some reason
+
+	// now if compressed, expand it
+	MSG_BeginReading( msg );
+	MSG_ReadLong( msg ); // sequence
+	MSG_ReadLong( msg ); // sequence_ack
+	if( msg->compressed )
+	{
+		zerror = Netchan_DecompressMessage( netchan, msg );
+		if( zerror < 0 )
+		{          // compression error. Drop the packet
+			Com_DPrintf( "Compression error %i. Dropping packet\n", zerror );
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+* LG_Bot_ReadPackets
+*/
+static void LG_Bot_ReadPackets( lgbot_t *bot )
+{
+	msg_t msg;
+	uint8_t msgData[MAX_MSGLEN];
+	int ret;
+	netadr_t address;
+
+	MSG_Init( &msg, msgData, sizeof( msgData ) );
+	MSG_Clear( &msg );
+
+	while( ( ret = NET_GetPacket( &bot->socket, &address, &msg ) ) != 0 )
+	{
+		if( ret == -1 )
+			LG_Bot_Error( bot, "Error receiving packet: %s", NET_ErrorString() );
+
+		if( !NET_CompareAddress( &lg.serveraddress, &address ) )
+			continue;
+
+		if( lg.measureTime )
+			bot->bytesReceived += msg.cursize;
+
+		// remote command packet
+		if( *(int *)msg.data == -1 )
+		{
+			LG_Bot_ConnectionlessPacket( bot, &msg );
+			continue;
+		}
+
+		if( bot->state >= CA_HANDSHAKE )
+		{
+			if( !LG_Bot_ProcessPacket( &bot->netchan, &msg ) )
+				continue;
+
+			LG_Bot_ParseServerMessage( bot, &msg );
+			bot->lastPacketReceivedTime = lg.realtime;
+		}
+	}
+
+	if( lg.realtime > bot->lastPacketReceivedTime + lg_timeout->value * 1000 )
+		LG_Bot_Error( bot, "Server timed out" );
+}
+
+/*
+* LG_Bot_CheckForResend
+*/
+static void LG_Bot_CheckForResend( lgbot_t *bot )
+{
+	if( lg.realtime - bot->connect_time < 3000 )
+		return;
+
+	bot->connect_count++;
+	bot->connect_time = lg.realtime;
+
+	Netchan_OutOfBandPrint( &bot->socket, &lg.serveraddress, "getchallenge\n" );
+}
+
+/*
+* LG_Bot_NewUcmd
+*/
+static void LG_Bot_NewUcmd( lgbot_t *bot )
+{
+	usercmd_t *ucmd, *oldcmd;
+	int msec;
+
+	msec = bot->lastUcmdTime ? lg.realtime - bot->lastUcmdTime : 1000 / max( lg_ucmdfps->integer, 1 );
+	clamp( msec, 1, 255 );
+
+	ucmd = &bot->cmds[bot->ucmdHead & CMD_MASK];
+	memset( ucmd, 0, sizeof( *ucmd ) );
+
+	// our guess of the server time, as the client does without the smoothing
+	ucmd->serverTimeStamp = bot->lastFrame->serverTime + ( lg.realtime - bot->lastFrameTime );
+	oldcmd = &bot->cmds[( bot->ucmdHead - 1 ) & CMD_MASK];
+	if( bot->ucmdHead > 1 && ucmd->serverTimeStamp > oldcmd->serverTimeStamp )
+		msec = min( ucmd->serverTimeStamp - oldcmd->serverTimeStamp, 255 );
+	ucmd->msec = msec;
+
+	LG_Script_BuildUcmd( lg.script, bot, ucmd, msec );
+
+	bot->ucmdHead++;
+	bot->lastUcmdTime = lg.realtime;
+}
+
+/*
+* LG_Bot_WriteUcmdsToMessage
+*/
+static void LG_Bot_WriteUcmdsToMessage( lgbot_t *bot, msg_t *msg )
+{
+	unsigned int i, ucmdFirst;
+	usercmd_t nullcmd;
+
+	// resend up to LG_UCMD_MAX_RESEND unacknowledged ones, like the client does
+	ucmdFirst = bot->ucmdAcknowledged + 1;
+	if( ucmdFirst + LG_UCMD_MAX_RESEND <= bot->ucmdSent )
+		ucmdFirst = bot->ucmdSent + 1 - LG_UCMD_MAX_RESEND;
+	if( bot->ucmdHead - ucmdFirst > CMD_MASK )
+		ucmdFirst = bot->ucmdHead - 3;
+
+	MSG_WriteByte( msg, clc_move );
+	MSG_WriteLong( msg, bot->lastFrame ? bot->lastFrame->serverFrame : -1 );
+	MSG_WriteLong( msg, bot->ucmdHead );
+	MSG_WriteByte( msg, (uint8_t)( bot->ucmdHead - ucmdFirst ) );
+
+	memset( &nullcmd, 0, sizeof( nullcmd ) );
+	for( i = ucmdFirst; i < bot->ucmdHead; i++ )
+	{
+		MSG_WriteDeltaUsercmd( msg, i == ucmdFirst ? &nullcmd : &bot->cmds[( i - 1 ) & CMD_MASK],
+			&bot->cmds[i & CMD_MASK] );
+
+		// the latency is timed from the first time a ucmd is sent
+		if( i > bot->ucmdSent )
+			bot->cmdSentTime[i & CMD_MASK] = lg.realtime;
+	}
+
+	bot->ucmdSent = bot->ucmdHead - 1;
+}
+
+/*
+* LG_Bot_SendMessagesToServer
+*/
+static void LG_Bot_SendMessagesToServer( lgbot_t *bot, bool sendNow )
+{
+	msg_t message;
+	uint8_t messageData[MAX_MSGLEN];
+	unsigned int i;
+	bool active;
+
+	if( bot->state < CA_HANDSHAKE )
+		return;
+
+	// ucmds are generated at their own rate and sent in bunches at lg_pps, as the client does
+	active = bot->state == CA_ACTIVE && bot->lastFrame;
+	if( active && lg.realtime >= bot->lastUcmdTime + 1000 / max( lg_ucmdfps->integer, 1 ) )
+		LG_Bot_NewUcmd( bot );
+
+	if( !sendNow && lg.realtime < bot->lastPacketSentTime + ( active ? 1000 / max( lg_pps->integer, 1 ) : 100 ) )
+		return;
+
+	MSG_Init( &message, messageData, sizeof( messageData ) );
+	MSG_Clear( &message );
+
+	if( active && bot->ucmdHead > 1 )
+		LG_Bot_WriteUcmdsToMessage( bot, &message );
+
+	MSG_WriteByte( &message, clc_svcack );
+	MSG_WriteLong( &message, (unsigned int)bot->lastExecutedServerCommand );
+
+	// write any unacknowledged clientCommands
+	for( i = bot->reliableAcknowledge + 1; i <= bot->reliableSequence; i++ )
+	{
+		if( !bot->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )][0] )
+			continue;
+
+		MSG_WriteByte( &message, clc_clientcommand );
+		MSG_WriteLong( &message, i );
+		MSG_WriteString( &message, bot->reliableCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+	}
+	bot->reliableSent = bot->reliableSequence;
+
+	// if we got here with unsent fragments, fire them all now
+	Netchan_PushAllFragments( &bot->netchan );
+	Netchan_Transmit( &bot->netchan, &message );
+
+	if( lg.measureTime )
+		bot->bytesSent += message.cursize;
+	bot->lastPacketSentTime = lg.realtime;
+}
+
+/*
+* LG_Bot_Run
+*/
+void LG_Bot_Run( lgbot_t *bot )
+{
+	if( setjmp( lg_abortframe ) )  // disconnect while running
+		return;
+
+	if( bot->state <= CA_DISCONNECTED )
+		return;
+
+	LG_Bot_ReadPackets( bot );
+
+	if( bot->state == CA_CONNECTING )
+		LG_Bot_CheckForResend( bot );
+	else if( bot->netchan.unsentFragments )
+		Netchan_TransmitNextFragment( &bot->netchan );
+	else
+		LG_Bot_SendMessagesToServer( bot, false );
+}
@@ -0,0 +1,401 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "lg_local.h"
+
+/*
+* HTTP download test: a number of kept-alive connections downloading the same
+* file from the server's builtin web server over and over, like the clients
+* fetching the map after a map change. Requests may be pipelined. The server
+* only serves files without a game session to its own host, so this is a local
+* test.
+*/
+
+#define LG_HTTP_RECV_SIZE	0x10000
+
+static uint8_t lg_http_recvbuf[LG_HTTP_RECV_SIZE];
+
+/*
+* LG_HTTP_CloseConn
+*/
+static void LG_HTTP_CloseConn( lghttpconn_t *conn )
+{
+	if( conn->socket.open )
+		NET_CloseSocket( &conn->socket );
+	memset( conn, 0, sizeof( *conn ) );
+}
+
+/*
+* LG_HTTP_OpenConn
+*/
+static bool LG_HTTP_OpenConn( lghttpconn_t *conn )
+{
+	netadr_t socketaddress;
+
+	LG_HTTP_CloseConn( conn );
+
+	NET_InitAddress( &socketaddress, lg.http.address.type );
+	if( !NET_OpenSocket( &conn->socket, SOCKET_TCP, &socketaddress, false ) )
+	{
+		Com_Printf( "Couldn't open a TCP socket: %s\n", NET_ErrorString() );
+		return false;
+	}
+
+	if( NET_Connect( &conn->socket, &lg.http.address ) == CONNECTION_FAILED )
+	{
+		Com_Printf( "Couldn't connect to %s: %s\n", NET_AddressToString( &lg.http.address ), NET_ErrorString() );
+		LG_HTTP_CloseConn( conn );
+		return false;
+	}
+
+	conn->lastActive = Sys_Milliseconds();
+	return true;
+}
+
+/*
+* LG_HTTP_Fail
+*
+* Drops the connection and the requests in it, a new one is opened on the next frame
+*/
+static void LG_HTTP_Fail( lghttpconn_t *conn, const char *reason )
+{
+	Com_DPrintf( "httptest: %s\n", reason );
+	lg.http.failed += conn->queued;
+	lg.http.errors++;
+	LG_HTTP_CloseConn( conn );
+}
+
+/*
+* LG_HTTP_ParseHeader
+*
+* Returns false if the response can't be read
+*/
+static bool LG_HTTP_ParseHeader( lghttpconn_t *conn )
+{
+	const char *p;
+
+	if( strncmp( conn->header, "HTTP/1.", 7 ) || !( p = strchr( conn->header, ' ' ) ) )
+		return false;
+	conn->status = atoi( p + 1 );
+
+	conn->contentRemaining = -1;
+	for( p = strstr( conn->header, "\r\n" ); p; p = strstr( p + 2, "\r\n" ) )
+	{
+		if( !Q_strnicmp( p + 2, "Content-Length:", 15 ) )
+		{
+			conn->contentRemaining = atoll( p + 2 + 15 );
+			break;
+		}
+	}
+
+	return conn->contentRemaining >= 0;
+}
+
+/*
+* LG_HTTP_CompleteResponse
+*/
+static void LG_HTTP_CompleteResponse( lghttpconn_t *conn )
+{
+	if( conn->status == 200 || conn->status == 206 )
+		lg.http.completed++;
+	else
+		lg.http.failed++;
+
+	LG_AddSample( &lg.http.latency, (int)( Sys_Milliseconds() - conn->requestTime[0] ) );
+
+	conn->queued--;
+	memmove( conn->requestTime, conn->requestTime + 1, sizeof( conn->requestTime[0] ) * conn->queued );
+	conn->headerLength = 0;
+	conn->headerDone = false;
+}
+
+/*
+* LG_HTTP_ReadResponses
+*
+* Reads what's on the socket, which may be several pipelined responses
+*/
+static void LG_HTTP_ReadResponses( lghttpconn_t *conn )
+{
+	int ret;
+	size_t i, len;
+	char *end;
+
+	while( conn->socket.open && ( ret = NET_Get( &conn->socket, NULL, lg_http_recvbuf, sizeof( lg_http_recvbuf ) ) ) != 0 )
+	{
+		if( ret < 0 )
+		{
+			LG_HTTP_Fail( conn, NET_ErrorString() );
+			return;
+		}
+
+		conn->lastActive = Sys_Milliseconds();
+		lg.http.bytesReceived += ret;
+
+		for( i = 0; i < (size_t)ret; )
+		{
+			if( !conn->queued )
+			{
+				LG_HTTP_Fail( conn, "response to no request" );
+				return;
+			}
+
+			if( !conn->headerDone )
+			{
+				len = min( (size_t)ret - i, sizeof( conn->header ) - 1 - conn->headerLength );
+				memcpy( conn->header + conn->headerLength, lg_http_recvbuf + i, len );
+				conn->header[conn->headerLength + len] = '\0';
+
+				end = strstr( conn->header, "\r\n\r\n" );
+				if( !end )
+				{
+					if( conn->headerLength + len == sizeof( conn->header ) - 1 )
+					{
+						LG_HTTP_Fail( conn, "oversized response header" );
+						return;
+					}
+					conn->headerLength += len;
+					i += len;
+					continue;
+				}
+
+				// skip the header bytes which were in this read
+				i += ( end + 4 - conn->header ) - conn->headerLength;
+				*end = '\0';
+				conn->headerDone = true;
+				if( !LG_HTTP_ParseHeader( conn ) )
+				{
+					LG_HTTP_Fail( conn, "bad response header" );
+					return;
+				}
+			}
+			else
+			{
+				len = (size_t)min( (int64_t)( (size_t)ret - i ), conn->contentRemaining );
+				conn->contentRemaining -= len;
+				i += len;
+			}
+
+			if( !conn->contentRemaining )
+				LG_HTTP_CompleteResponse( conn );
+		}
+	}
+}
+
+/*
+* LG_HTTP_RunConn
+*/
+static void LG_HTTP_RunConn( lghttpconn_t *conn )
+{
+	connection_status_t status;
+	unsigned int now;
+	int sent;
+
+	if( !conn->socket.open && !LG_HTTP_OpenConn( conn ) )
+	{
+		lg.http.errors++;
+		return;
+	}
+
+	now = Sys_Milliseconds();
+	if( now > conn->lastActive + lg_timeout->integer * 1000 )
+	{
+		LG_HTTP_Fail( conn, "timed out" );
+		return;
+	}
+
+	if( !conn->connected )
+	{
+		status = NET_CheckConnect( &conn->socket );
+		if( status == CONNECTION_FAILED )
+		{
+			LG_HTTP_Fail( conn, NET_ErrorString() );
+			return;
+		}
+		if( status == CONNECTION_INPROGRESS )
+			return;
+		conn->connected = true;
+	}
+
+	// keep the pipeline full, the requests are small enough to go out whole
+	while( conn->queued < lg.http.pipeline )
+	{
+		sent = NET_Send( &conn->socket, lg.http.request, lg.http.requestLength, &lg.http.address );
+		if( sent == 0 )
+			break;
+		if( sent != (int)lg.http.requestLength )
+		{
+			LG_HTTP_Fail( conn, sent < 0 ? NET_ErrorString() : "partial request sent" );
+			return;
+		}
+		conn->requestTime[conn->queued++] = now;
+	}
+
+	LG_HTTP_ReadResponses( conn );
+}
+
+/*
+* LG_HTTP_Report
+*/
+static void LG_HTTP_Report( void )
+{
+	float seconds;
+
+	seconds = max( Sys_Milliseconds() - lg.http.startTime, 1 ) * 0.001f;
+
+	Com_Printf( "httptest: %s, %i connections, pipeline %i, %.1fs\n", NET_AddressToString( &lg.http.address ),
+		lg.http.numconns, lg.http.pipeline, seconds );
+	Com_Printf( "%i downloads, %i failed, %i connection errors\n", lg.http.completed, lg.http.failed, lg.http.errors );
+	Com_Printf( "in: %.1f MB/s, %.1f downloads/s\n", lg.http.bytesReceived / ( 1024.0 * 1024.0 ) / seconds,
+		lg.http.completed / seconds );
+
+	Com_Printf( "%-16s %8s %6s %6s %6s %6s %6s %6s\n", "ms", "samples", "min", "p50", "p90", "p99", "p99.9", "max" );
+	LG_PrintSamples( "download", &lg.http.latency );
+}
+
+/*
+* LG_HTTP_StopTest
+*/
+static void LG_HTTP_StopTest( bool report )
+{
+	int i;
+
+	if( !lg.http.running )
+		return;
+
+	if( report )
+		LG_HTTP_Report();
+
+	for( i = 0; i < lg.http.numconns; i++ )
+		LG_HTTP_CloseConn( &lg.http.conns[i] );
+	Mem_Free( lg.http.conns );
+	lg.http.conns = NULL;
+	lg.http.numconns = 0;
+
+	LG_FreeSamples( &lg.http.latency );
+
+	lg.http.running = false;
+
+	if( report && lg_autoquit->integer )
+		Cbuf_AddText( "quit\n" );
+}
+
+/*
+* LG_HTTP_Test_f
+*
+* The server must run on the same host with sv_http_localfiles 1, the connections
+* have no game session.
+*/
+static void LG_HTTP_Test_f( void )
+{
+	netadr_t address;
+	int numconns;
+
+	if( Cmd_Argc() < 4 )
+	{
+		Com_Printf( "Usage: %s <address> <connections> <file> [seconds] [pipeline]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( lg.http.running )
+	{
+		Com_Printf( "An HTTP test is already running, use httpstop first\n" );
+		return;
+	}
+
+	if( !NET_StringToAddress( Cmd_Argv( 1 ), &address ) )
+	{
+		Com_Printf( "Bad server address: %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+	if( !NET_GetAddressPort( &address ) )
+		NET_SetAddressPort( &address, PORT_HTTP_SERVER );
+
+	numconns = atoi( Cmd_Argv( 2 ) );
+	clamp( numconns, 1, 1024 );
+
+	memset( &lg.http, 0, sizeof( lg.http ) );
+	lg.http.address = address;
+	lg.http.pipeline = Cmd_Argc() > 5 ? atoi( Cmd_Argv( 5 ) ) : 1;
+	clamp( lg.http.pipeline, 1, LG_HTTP_MAX_PIPELINE );
+	lg.http.duration = ( Cmd_Argc() > 4 ? max( atoi( Cmd_Argv( 4 ) ), 1 ) : 10 ) * 1000;
+
+	Q_snprintfz( lg.http.request, sizeof( lg.http.request ),
+		"GET /files/%s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n\r\n",
+		Cmd_Argv( 3 ), NET_AddressToString( &address ) );
+	lg.http.requestLength = strlen( lg.http.request );
+
+	lg.http.numconns = numconns;
+	lg.http.conns = Mem_Alloc( lg.mempool, sizeof( *lg.http.conns ) * numconns );
+	lg.http.startTime = Sys_Milliseconds();
+	lg.http.running = true;
+
+	Com_Printf( "Downloading %s from %s over %i connections\n", Cmd_Argv( 3 ), NET_AddressToString( &address ), numconns );
+}
+
+/*
+* LG_HTTP_Stop_f
+*/
+static void LG_HTTP_Stop_f( void )
+{
+	if( !lg.http.running )
+	{
+		Com_Printf( "No HTTP test running\n" );
+		return;
+	}
+
+	LG_HTTP_StopTest( true );
+}
+
+/*
+* LG_HTTP_Init
+*/
+void LG_HTTP_Init( void )
+{
+	Cmd_AddCommand( "httptest", LG_HTTP_Test_f );
+	Cmd_AddCommand( "httpstop", LG_HTTP_Stop_f );
+}
+
+/*
+* LG_HTTP_Frame
+*/
+void LG_HTTP_Frame( void )
+{
+	int i;
+
+	if( !lg.http.running )
+		return;
+
+	for( i = 0; i < lg.http.numconns; i++ )
+		LG_HTTP_RunConn( &lg.http.conns[i] );
+
+	if( Sys_Milliseconds() >= lg.http.startTime + lg.http.duration )
+		LG_HTTP_StopTest( true );
+}
+
+/*
+* LG_HTTP_Shutdown
+*/
+void LG_HTTP_Shutdown( void )
+{
+	LG_HTTP_StopTest( false );
+
+	Cmd_RemoveCommand( "httptest" );
+	Cmd_RemoveCommand( "httpstop" );
+}
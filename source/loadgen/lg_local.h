@@ -0,0 +1,217 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifndef __LG_LOCAL_H
+#define __LG_LOCAL_H
+
+#include "../qcommon/qcommon.h"
+
+#include "../cgame/cg_public.h"
+
+// the areabits length is sent as a byte, so this fits any map
+#define LG_MAX_AREABYTES	255
+
+#define LG_MAX_SCRIPT_STEPS	256
+
+#define LG_UCMD_MAX_RESEND	3
+
+#define LG_HTTP_MAX_PIPELINE	16
+#define LG_HTTP_MAX_HEADER		0x2000
+
+//=============================================================================
+
+typedef struct
+{
+	int msec;                   // how long the step lasts
+	float forwardmove, sidemove, upmove;
+	int buttons;
+	float yawspeed;             // degrees per second
+	float pitch;
+} lgscriptstep_t;
+
+typedef struct
+{
+	char name[MAX_QPATH];
+	int numsteps;
+	lgscriptstep_t steps[LG_MAX_SCRIPT_STEPS];
+} lgscript_t;
+
+typedef struct
+{
+	int *values;
+	int count;
+	int size;
+} lgsamples_t;
+
+typedef struct lgbot_s
+{
+	int number;
+	connstate_t state;
+	char name[MAX_NAME_BYTES];
+
+	socket_t socket;
+	netchan_t netchan;
+	int game_port;
+
+	unsigned int connect_time;
+	int connect_count;
+	int challenge;
+
+	unsigned int lastPacketReceivedTime;
+	unsigned int lastPacketSentTime;
+
+	unsigned int reliableSequence;          // the last one we put in the list to be sent
+	unsigned int reliableSent;              // the last one we sent to the server
+	unsigned int reliableAcknowledge;       // the last one the server has executed
+	char reliableCommands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];
+	int lastExecutedServerCommand;
+
+	// serverdata
+	int servercount;
+	unsigned int snapFrameTime;
+	int playernum;
+
+	// user commands, with the time each one was first sent
+	usercmd_t cmds[CMD_BACKUP];
+	unsigned int cmdSentTime[CMD_BACKUP];
+	unsigned int ucmdHead;                  // the next one to be generated
+	unsigned int ucmdSent;                  // the last one we sent to the server
+	unsigned int ucmdAcknowledged;          // the last one the server has received
+	unsigned int ucmdExecuted;              // the last one the server has run, from the frames
+	unsigned int lastUcmdTime;
+
+	// frames
+	snapshot_t *frames;
+	uint8_t *frames_areabits;
+	snapshot_t *lastFrame;
+	entity_state_t *baselines;
+	unsigned int lastFrameTime;             // realtime the last frame arrived at
+	int frameTimeOffset;                    // smallest realtime - serverTime seen
+
+	// script state
+	int scriptStep;
+	unsigned int scriptStepTime;
+	float viewangles[3];
+
+	// stats
+	uint64_t bytesReceived, bytesSent;
+	int framesReceived, framesInvalid;
+} lgbot_t;
+
+typedef struct
+{
+	socket_t socket;
+	bool connected;
+	unsigned int lastActive;
+
+	// requests sent and not answered yet, oldest first
+	int queued;
+	unsigned int requestTime[LG_HTTP_MAX_PIPELINE];
+
+	// response being read
+	char header[LG_HTTP_MAX_HEADER];
+	size_t headerLength;
+	bool headerDone;
+	int status;
+	int64_t contentRemaining;
+} lghttpconn_t;
+
+typedef struct
+{
+	bool running;
+	netadr_t address;
+	char request[MAX_STRING_CHARS];
+	size_t requestLength;
+	int pipeline;
+	int numconns;
+	lghttpconn_t *conns;
+
+	unsigned int startTime;
+	unsigned int duration;
+
+	int completed, failed, errors;
+	uint64_t bytesReceived;
+	lgsamples_t latency;                    // request sent to the last byte of its response
+} lghttptest_t;
+
+typedef struct
+{
+	unsigned int realtime;
+	struct mempool_s *mempool;
+
+	bool running;
+	netadr_t serveraddress;
+	char servername[MAX_QPATH];
+	int numbots;
+	lgbot_t *bots;
+	const lgscript_t *script;
+
+	unsigned int startTime;
+	unsigned int duration;                  // 0 to run until loadstop
+	unsigned int measureTime;               // realtime the first bot went active
+
+	// samples, in milliseconds
+	lgsamples_t latency;                    // ucmd sent to its execution seen in a frame
+	lgsamples_t interval;                   // between consecutive frames of a bot
+	lgsamples_t lateness;                   // frame arrival behind the server's clock
+
+	lghttptest_t http;
+} lg_t;
+
+extern lg_t lg;
+
+extern cvar_t *lg_password;
+extern cvar_t *lg_connectdelay;
+extern cvar_t *lg_ucmdfps;
+extern cvar_t *lg_pps;
+extern cvar_t *lg_timeout;
+extern cvar_t *lg_autoquit;
+
+//
+// lg_main.c
+//
+void LG_AddSample( lgsamples_t *samples, int value );
+void LG_FreeSamples( lgsamples_t *samples );
+void LG_PrintSamples( const char *name, lgsamples_t *samples );
+
+//
+// lg_bot.c
+//
+void LG_Bot_Init( lgbot_t *bot, int number );
+void LG_Bot_Connect( lgbot_t *bot );
+void LG_Bot_Disconnect( lgbot_t *bot, const char *format, ... );
+void LG_Bot_Free( lgbot_t *bot );
+void LG_Bot_Run( lgbot_t *bot );
+
+//
+// lg_http.c
+//
+void LG_HTTP_Init( void );
+void LG_HTTP_Frame( void );
+void LG_HTTP_Shutdown( void );
+
+//
+// lg_script.c
+//
+const lgscript_t *LG_FindScript( const char *name );
+void LG_FreeScripts( void );
+void LG_Script_BuildUcmd( const lgscript_t *script, lgbot_t *bot, usercmd_t *ucmd, int msec );
+
+#endif // __LG_LOCAL_H
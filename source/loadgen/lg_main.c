@@ -0,0 +1,374 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "lg_local.h"
+
+/*
+* Headless load generator: connects a number of bots to a server through the
+* network, as real clients would, and reports what the server delivers back.
+*/
+
+lg_t lg;
+
+cvar_t *lg_password;
+cvar_t *lg_connectdelay;
+cvar_t *lg_ucmdfps;
+cvar_t *lg_pps;
+cvar_t *lg_timeout;
+cvar_t *lg_autoquit;
+
+/*
+* LG_AddSample
+*/
+void LG_AddSample( lgsamples_t *samples, int value )
+{
+	if( samples->count == samples->size )
+	{
+		samples->size = samples->size ? samples->size * 2 : 1024;
+		if( samples->values )
+			samples->values = Mem_Realloc( samples->values, sizeof( *samples->values ) * samples->size );
+		else
+			samples->values = Mem_Alloc( lg.mempool, sizeof( *samples->values ) * samples->size );
+	}
+
+	samples->values[samples->count++] = value;
+}
+
+/*
+* LG_FreeSamples
+*/
+void LG_FreeSamples( lgsamples_t *samples )
+{
+	if( samples->values )
+		Mem_Free( samples->values );
+	memset( samples, 0, sizeof( *samples ) );
+}
+
+/*
+* LG_CompareSamples
+*/
+static int LG_CompareSamples( const void *a, const void *b )
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+* LG_PrintSamples
+*/
+void LG_PrintSamples( const char *name, lgsamples_t *samples )
+{
+	static const float percentiles[] = { 0.5f, 0.9f, 0.99f, 0.999f };
+	int i, *v;
+
+	if( !samples->count )
+	{
+		Com_Printf( "%-16s %8i\n", name, 0 );
+		return;
+	}
+
+	qsort( samples->values, samples->count, sizeof( *samples->values ), LG_CompareSamples );
+
+	v = samples->values;
+	Com_Printf( "%-16s %8i %6i", name, samples->count, v[0] );
+	for( i = 0; i < (int)( sizeof( percentiles ) / sizeof( percentiles[0] ) ); i++ )
+		Com_Printf( " %6i", v[(int)( ( samples->count - 1 ) * percentiles[i] )] );
+	Com_Printf( " %6i\n", v[samples->count - 1] );
+}
+
+/*
+* LG_Report
+*/
+static void LG_Report( void )
+{
+	int i, active, framesReceived, framesInvalid;
+	uint64_t bytesReceived, bytesSent;
+	unsigned int snapFrameTime;
+	float seconds;
+	lgbot_t *bot;
+
+	active = framesReceived = framesInvalid = 0;
+	bytesReceived = bytesSent = 0;
+	snapFrameTime = 0;
+	for( i = 0, bot = lg.bots; i < lg.numbots; i++, bot++ )
+	{
+		if( bot->state == CA_ACTIVE )
+			active++;
+		if( bot->snapFrameTime )
+			snapFrameTime = bot->snapFrameTime;
+		framesReceived += bot->framesReceived;
+		framesInvalid += bot->framesInvalid;
+		bytesReceived += bot->bytesReceived;
+		bytesSent += bot->bytesSent;
+	}
+
+	Com_Printf( "loadtest: %s, %i/%i bots active, script \"%s\"\n", lg.servername, active, lg.numbots, lg.script->name );
+	if( !lg.measureTime )
+	{
+		Com_Printf( "no bot got into the game, nothing measured\n" );
+		return;
+	}
+
+	seconds = max( lg.realtime - lg.measureTime, 1 ) * 0.001f;
+	Com_Printf( "measured %.1fs, %i frames, %i invalid, server snap frame time %ums\n", seconds,
+		framesReceived, framesInvalid, snapFrameTime );
+	Com_Printf( "in:  %8.1f KB/s, %6.2f KB/s per bot\n", bytesReceived / 1024.0 / seconds,
+		bytesReceived / 1024.0 / seconds / max( active, 1 ) );
+	Com_Printf( "out: %8.1f KB/s, %6.2f KB/s per bot\n", bytesSent / 1024.0 / seconds,
+		bytesSent / 1024.0 / seconds / max( active, 1 ) );
+
+	Com_Printf( "%-16s %8s %6s %6s %6s %6s %6s %6s\n", "ms", "samples", "min", "p50", "p90", "p99", "p99.9", "max" );
+	LG_PrintSamples( "ucmd latency", &lg.latency );
+	LG_PrintSamples( "frame interval", &lg.interval );
+	LG_PrintSamples( "frame lateness", &lg.lateness );
+}
+
+/*
+* LG_StopTest
+*/
+static void LG_StopTest( bool report )
+{
+	int i;
+
+	if( !lg.running )
+		return;
+
+	if( report )
+		LG_Report();
+
+	for( i = 0; i < lg.numbots; i++ )
+		LG_Bot_Free( &lg.bots[i] );
+	Mem_Free( lg.bots );
+	lg.bots = NULL;
+	lg.numbots = 0;
+
+	LG_FreeSamples( &lg.latency );
+	LG_FreeSamples( &lg.interval );
+	LG_FreeSamples( &lg.lateness );
+
+	lg.running = false;
+
+	if( report && lg_autoquit->integer )
+		Cbuf_AddText( "quit\n" );
+}
+
+/*
+* LG_LoadTest_f
+*/
+static void LG_LoadTest_f( void )
+{
+	int i, numbots;
+	netadr_t address;
+	const lgscript_t *script;
+
+	if( Cmd_Argc() < 3 )
+	{
+		Com_Printf( "Usage: %s <address> <bots> [seconds] [script]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	if( lg.running )
+	{
+		Com_Printf( "A load test is already running, use loadstop first\n" );
+		return;
+	}
+
+	if( !NET_StringToAddress( Cmd_Argv( 1 ), &address ) )
+	{
+		Com_Printf( "Bad server address: %s\n", Cmd_Argv( 1 ) );
+		return;
+	}
+	if( !NET_GetAddressPort( &address ) )
+		NET_SetAddressPort( &address, PORT_SERVER );
+
+	numbots = atoi( Cmd_Argv( 2 ) );
+	clamp( numbots, 1, MAX_CLIENTS );
+
+	script = LG_FindScript( Cmd_Argc() > 4 ? Cmd_Argv( 4 ) : "strafe" );
+	if( !script )
+		return;
+
+	memset( &lg.latency, 0, sizeof( lg.latency ) );
+	memset( &lg.interval, 0, sizeof( lg.interval ) );
+	memset( &lg.lateness, 0, sizeof( lg.lateness ) );
+
+	lg.serveraddress = address;
+	Q_strncpyz( lg.servername, Cmd_Argv( 1 ), sizeof( lg.servername ) );
+	lg.script = script;
+	lg.duration = Cmd_Argc() > 3 ? max( atoi( Cmd_Argv( 3 ) ), 0 ) * 1000 : 0;
+	lg.startTime = lg.realtime;
+	lg.measureTime = 0;
+
+	lg.numbots = numbots;
+	lg.bots = Mem_Alloc( lg.mempool, sizeof( *lg.bots ) * numbots );
+	for( i = 0; i < numbots; i++ )
+		LG_Bot_Init( &lg.bots[i], i );
+
+	lg.running = true;
+
+	Com_Printf( "Connecting %i bots to %s, script \"%s\"\n", numbots, NET_AddressToString( &address ), script->name );
+}
+
+/*
+* LG_LoadStop_f
+*/
+static void LG_LoadStop_f( void )
+{
+	if( !lg.running )
+	{
+		Com_Printf( "No load test running\n" );
+		return;
+	}
+
+	LG_StopTest( true );
+}
+
+/*
+* LG_LoadReport_f
+*/
+static void LG_LoadReport_f( void )
+{
+	if( !lg.running )
+	{
+		Com_Printf( "No load test running\n" );
+		return;
+	}
+
+	LG_Report();
+}
+
+/*
+* LG_Init
+*/
+void LG_Init( void )
+{
+	Com_Printf( "Initializing " APPLICATION " load generator\n" );
+
+	memset( &lg, 0, sizeof( lg ) );
+	lg.mempool = Mem_AllocPool( NULL, "Load generator" );
+
+	lg_password = Cvar_Get( "lg_password", "", 0 );
+	lg_connectdelay = Cvar_Get( "lg_connectdelay", "50", 0 );
+	lg_ucmdfps = Cvar_Get( "lg_ucmdfps", "62", 0 );
+	lg_pps = Cvar_Get( "lg_pps", "40", 0 );
+	lg_timeout = Cvar_Get( "lg_timeout", "30", 0 );
+	lg_autoquit = Cvar_Get( "lg_autoquit", "0", 0 );
+
+	Cmd_AddCommand( "loadtest", LG_LoadTest_f );
+	Cmd_AddCommand( "loadstop", LG_LoadStop_f );
+	Cmd_AddCommand( "loadreport", LG_LoadReport_f );
+
+	LG_HTTP_Init();
+}
+
+/*
+* LG_Frame
+*/
+void LG_Frame( int realmsec, int gamemsec )
+{
+	int i, started, disconnected;
+	lgbot_t *bot;
+
+	lg.realtime += realmsec;
+
+	// datagrams sent during the frame are pushed out together at the end of it
+	NET_BeginSendQueue( NULL );
+
+	if( lg.running )
+	{
+		started = disconnected = 0;
+		for( i = 0, bot = lg.bots; i < lg.numbots; i++, bot++ )
+		{
+			// stagger the connections so the server doesn't see a burst of them
+			if( bot->state == CA_UNINITIALIZED )
+			{
+				if( lg.realtime < lg.startTime + i * lg_connectdelay->integer )
+					continue;
+				LG_Bot_Connect( bot );
+			}
+
+			LG_Bot_Run( bot );
+
+			started++;
+			if( bot->state == CA_DISCONNECTED )
+				disconnected++;
+
+			// start measuring when all bots are started and some got in
+			if( !lg.measureTime && bot->state == CA_ACTIVE && started == lg.numbots )
+				lg.measureTime = lg.realtime;
+		}
+
+		if( disconnected == lg.numbots )
+		{
+			Com_Printf( "All bots disconnected\n" );
+			LG_StopTest( true );
+		}
+		else if( lg.duration && lg.measureTime && lg.realtime >= lg.measureTime + lg.duration )
+		{
+			LG_StopTest( true );
+		}
+	}
+
+	LG_HTTP_Frame();
+
+	NET_FlushSendQueue();
+
+	Sys_Sleep( 1 );
+}
+
+/*
+* LG_Shutdown
+*/
+void LG_Shutdown( const char *finalmsg )
+{
+	LG_StopTest( false );
+	LG_HTTP_Shutdown();
+	LG_FreeScripts();
+
+	Cmd_RemoveCommand( "loadtest" );
+	Cmd_RemoveCommand( "loadstop" );
+	Cmd_RemoveCommand( "loadreport" );
+
+	Mem_FreePool( &lg.mempool );
+}
+
+/*
+* Just some renaming so we can call the functions above LG not SV
+*/
+
+void SV_Init( void )
+{
+	LG_Init();
+}
+
+void SV_Shutdown( const char *finalmsg )
+{
+	LG_Shutdown( finalmsg );
+}
+
+void SV_ShutdownGame( const char *finalmsg, bool reconnect )
+{
+	// a malformed frame threw ERR_DROP, report what we had
+	LG_StopTest( true );
+}
+
+void SV_Frame( int realmsec, int gamemsec )
+{
+	LG_Frame( realmsec, gamemsec );
+}
@@ -0,0 +1,196 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "lg_local.h"
+
+/*
+* A script is a looping list of steps, each one holding the movement and
+* buttons for a number of milliseconds. Besides the built-in ones, scripts
+* are read from loadgen/<name>.lgs, one step per line:
+*
+* <msec> <forwardmove> <sidemove> <upmove> <buttons> <yawspeed> <pitch>
+*/
+
+#define LG_SCRIPT_EXTENSION ".lgs"
+
+static const lgscript_t lg_builtinScripts[] =
+{
+	// stands still, only the connection overhead
+	{ "idle", 1, {
+		{ 1000, 0, 0, 0, 0, 0, 0 },
+	} },
+
+	// runs around in wide circles
+	{ "walk", 2, {
+		{ 2000, 1, 0, 0, 0, 45, 0 },
+		{ 2000, 1, 0, 0, 0, -45, 0 },
+	} },
+
+	// strafe jumps from side to side
+	{ "strafe", 4, {
+		{ 400, 1, 1, 0, 0, 90, 0 },
+		{ 100, 1, 1, 1, 0, 90, 0 },
+		{ 400, 1, -1, 0, 0, -90, 0 },
+		{ 100, 1, -1, 1, 0, -90, 0 },
+	} },
+
+	// keeps firing while dodging and turning around, the heaviest on the game
+	{ "fight", 6, {
+		{ 300, 1, 1, 0, BUTTON_ATTACK, 180, -10 },
+		{ 100, 1, 1, 1, BUTTON_ATTACK, 180, -10 },
+		{ 300, -1, -1, 0, BUTTON_ATTACK, -180, 10 },
+		{ 100, -1, -1, 1, BUTTON_ATTACK|BUTTON_SPECIAL, -180, 10 },
+		{ 300, 0, 1, -1, BUTTON_ATTACK, 360, 0 },
+		{ 200, 1, 0, 0, 0, 0, 0 },
+	} },
+};
+
+#define LG_NUM_BUILTIN_SCRIPTS ( sizeof( lg_builtinScripts ) / sizeof( lg_builtinScripts[0] ) )
+
+static lgscript_t *lg_loadedScript;
+
+/*
+* LG_LoadScript
+*/
+static lgscript_t *LG_LoadScript( const char *name )
+{
+	char filename[MAX_QPATH];
+	char *buf;
+	const char *ptr, *token;
+	float values[7];
+	int i;
+	lgscript_t *script;
+	lgscriptstep_t *step;
+
+	Q_snprintfz( filename, sizeof( filename ), "loadgen/%s", name );
+	COM_DefaultExtension( filename, LG_SCRIPT_EXTENSION, sizeof( filename ) );
+
+	FS_LoadFile( filename, (void **)&buf, NULL, 0 );
+	if( !buf )
+	{
+		Com_Printf( "Couldn't load %s\n", filename );
+		return NULL;
+	}
+
+	script = Mem_Alloc( lg.mempool, sizeof( *script ) );
+	Q_strncpyz( script->name, name, sizeof( script->name ) );
+
+	ptr = buf;
+	while( ptr && script->numsteps < LG_MAX_SCRIPT_STEPS )
+	{
+		for( i = 0; i < 7; i++ )
+		{
+			token = COM_ParseExt( &ptr, i == 0 );
+			if( !token[0] )
+				break;
+			values[i] = atof( token );
+		}
+		if( !i )
+			break;
+		if( i < 7 )
+		{
+			Com_Printf( "%s: incomplete step %i\n", filename, script->numsteps + 1 );
+			break;
+		}
+
+		step = &script->steps[script->numsteps++];
+		step->msec = max( (int)values[0], 1 );
+		step->forwardmove = bound( -1.0f, values[1], 1.0f );
+		step->sidemove = bound( -1.0f, values[2], 1.0f );
+		step->upmove = bound( -1.0f, values[3], 1.0f );
+		step->buttons = (int)values[4] & 0xff;
+		step->yawspeed = values[5];
+		step->pitch = bound( -89.0f, values[6], 89.0f );
+	}
+
+	FS_FreeFile( buf );
+
+	if( !script->numsteps )
+	{
+		Com_Printf( "%s has no steps\n", filename );
+		Mem_Free( script );
+		return NULL;
+	}
+
+	return script;
+}
+
+/*
+* LG_FindScript
+*/
+const lgscript_t *LG_FindScript( const char *name )
+{
+	unsigned int i;
+
+	for( i = 0; i < LG_NUM_BUILTIN_SCRIPTS; i++ )
+	{
+		if( !Q_stricmp( lg_builtinScripts[i].name, name ) )
+			return &lg_builtinScripts[i];
+	}
+
+	if( lg_loadedScript && !Q_stricmp( lg_loadedScript->name, name ) )
+		return lg_loadedScript;
+
+	LG_FreeScripts();
+	lg_loadedScript = LG_LoadScript( name );
+	return lg_loadedScript;
+}
+
+/*
+* LG_FreeScripts
+*/
+void LG_FreeScripts( void )
+{
+	if( lg_loadedScript )
+	{
+		Mem_Free( lg_loadedScript );
+		lg_loadedScript = NULL;
+	}
+}
+
+/*
+* LG_Script_BuildUcmd
+*/
+void LG_Script_BuildUcmd( const lgscript_t *script, lgbot_t *bot, usercmd_t *ucmd, int msec )
+{
+	const lgscriptstep_t *step;
+
+	bot->scriptStepTime += msec;
+	while( bot->scriptStepTime >= (unsigned int)script->steps[bot->scriptStep].msec )
+	{
+		bot->scriptStepTime -= script->steps[bot->scriptStep].msec;
+		bot->scriptStep = ( bot->scriptStep + 1 ) % script->numsteps;
+	}
+
+	step = &script->steps[bot->scriptStep];
+
+	bot->viewangles[YAW] = anglemod( bot->viewangles[YAW] + step->yawspeed * msec * 0.001f );
+	bot->viewangles[PITCH] = step->pitch;
+
+	// snap push fracs so client and server version match
+	ucmd->forwardmove = ( (int)( UCMD_PUSHFRAC_SNAPSIZE * step->forwardmove ) ) / UCMD_PUSHFRAC_SNAPSIZE;
+	ucmd->sidemove = ( (int)( UCMD_PUSHFRAC_SNAPSIZE * step->sidemove ) ) / UCMD_PUSHFRAC_SNAPSIZE;
+	ucmd->upmove = ( (int)( UCMD_PUSHFRAC_SNAPSIZE * step->upmove ) ) / UCMD_PUSHFRAC_SNAPSIZE;
+	ucmd->buttons = step->buttons;
+
+	ucmd->angles[0] = ANGLE2SHORT( bot->viewangles[0] );
+	ucmd->angles[1] = ANGLE2SHORT( bot->viewangles[1] );
+	ucmd->angles[2] = ANGLE2SHORT( bot->viewangles[2] );
+}
@@ -0,0 +1,1085 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// cm_cache.c -- on-disk cache of post-processed collision data
+
+#include "qcommon.h"
+#include "cm_local.h"
+
+#define CM_CACHE_IDENT		"CMCF"
+#define CM_CACHE_VERSION	3
+
+// the cache holds everything CM_LoadQ3BrushModel builds from the bsp,
+// so later loads of the map don't need to read the bsp at all. it never
+// leaves the machine, so it's stored in native byte order and planes,
+// plane quads, facet trees and visibility are used right from the file mapping
+
+#define	CMC_SHADERREFS		0
+#define	CMC_SHADERNAMES		1
+#define	CMC_PLANES			2
+#define	CMC_BRUSHSIDES		3
+#define	CMC_BRUSHES			4
+#define	CMC_PLANEQUADS		5
+#define	CMC_MARKBRUSHES		6
+#define	CMC_PATCHES			7
+#define	CMC_MARKFACES		8
+#define	CMC_LEAFS			9
+#define	CMC_NODES			10
+#define	CMC_MODELS			11
+#define	CMC_MODELREFS		12
+#define	CMC_VISIBILITY		13
+#define	CMC_ENTITIES		14
+
+#define	CMC_NUMLUMPS		15
+
+// lumps start on 16 byte boundaries
+#define CMC_LUMP_ALIGN		16
+
+// structures stored as they are in memory, a build with a different layout must not use the cache
+#define CM_CACHE_LAYOUT		( (int)( sizeof( cplane_t ) | ( sizeof( cplanequad_t ) << 8 ) | ( sizeof( cfacetnode_t ) << 16 ) ) )
+
+typedef struct
+{
+	char ident[4];
+	int version;
+	int layout;
+	unsigned int checksum;          // md5 of the bsp, handed out as the map checksum
+	int64_t bspmtime;
+	int bsplength;
+	unsigned int pakchecksum;       // of the pk3 the bsp is loaded from, 0 for a loose file
+	uint8_t bspheader[CM_MAP_HEADER_SIZE];
+	int numfaces;
+	float world_mins[3], world_maxs[3];
+	lump_t lumps[CMC_NUMLUMPS];
+} cmcacheheader_t;
+
+typedef struct
+{
+	int contents;
+	int flags;
+	int name;                       // offset into CMC_SHADERNAMES
+} cmcacheshaderref_t;
+
+typedef struct
+{
+	int planenum;
+	int surfFlags;
+} cmcachebrushside_t;
+
+typedef struct
+{
+	int contents;
+	int firstside;
+	int numsides;
+} cmcachebrush_t;
+
+typedef struct
+{
+	int face;
+	int contents;
+	float mins[3], maxs[3];
+	int numfacets;
+	int numnodes;
+	int numsides;
+} cmcachepatch_t;
+
+// a patch record is followed by its tree nodes, facets, then the surface
+// flags, planes and plane quads of all facet sides
+typedef struct
+{
+	int contents;
+	int numsides;
+} cmcachefacet_t;
+
+typedef struct
+{
+	int contents;
+	int cluster;
+	int area;
+	int firstmarkbrush;
+	int nummarkbrushes;
+	int firstmarkface;
+	int nummarkfaces;
+} cmcacheleaf_t;
+
+typedef struct
+{
+	int planenum;
+	int children[2];
+} cmcachenode_t;
+
+typedef struct
+{
+	float mins[3], maxs[3];
+	int nummarkfaces;               // face numbers in CMC_MODELREFS
+	int nummarkbrushes;             // followed by brush numbers
+} cmcachemodel_t;
+
+typedef struct
+{
+	uint8_t *data;
+	size_t size;
+	size_t pos;
+} cmcachereader_t;
+
+typedef struct
+{
+	int file;
+	int pos;
+	cmcacheheader_t header;
+} cmcachewriter_t;
+
+/*
+===============================================================================
+
+CACHE LOADING
+
+===============================================================================
+*/
+
+/*
+* CM_CacheRead
+*
+* Returns a pointer to the next size bytes of the cache, or NULL if the file is too short
+*/
+static void *CM_CacheRead( cmcachereader_t *reader, size_t size )
+{
+	void *p;
+
+	if( size > reader->size - reader->pos )
+		return NULL;
+
+	p = reader->data + reader->pos;
+	reader->pos += size;
+	return p;
+}
+
+/*
+* CM_CacheLump
+*
+* Returns the lump data and the number of elements in it, or NULL if the lump doesn't fit the file
+*/
+static void *CM_CacheLump( cmodel_state_t *cms, int lump, size_t elemsize, int *count )
+{
+	const cmcacheheader_t *header = ( const cmcacheheader_t * )cms->map_cachedata;
+	const lump_t *l = &header->lumps[lump];
+
+	if( l->fileofs < (int)sizeof( *header ) || ( l->fileofs & ( CMC_LUMP_ALIGN - 1 ) ) || l->filelen < 0 )
+		return NULL;
+	if( (size_t)l->fileofs > cms->map_cachesize || (size_t)l->filelen > cms->map_cachesize - l->fileofs )
+		return NULL;
+	if( l->filelen % elemsize )
+		return NULL;
+
+	*count = l->filelen / elemsize;
+	return cms->map_cachedata + l->fileofs;
+}
+
+/*
+* CM_IsCachedData
+*
+* Returns true if p points into the cache the map was loaded from, such memory must not be freed
+*/
+bool CM_IsCachedData( cmodel_state_t *cms, const void *p )
+{
+	return cms->map_cachedata && ( const uint8_t * )p >= cms->map_cachedata &&
+		( const uint8_t * )p < cms->map_cachedata + cms->map_cachesize;
+}
+
+/*
+* CM_LoadCachedShaderrefs
+*/
+static bool CM_LoadCachedShaderrefs( cmodel_state_t *cms )
+{
+	int i, count, numchars;
+	char *names;
+	cmcacheshaderref_t *in;
+	cshaderref_t *out;
+
+	in = CM_CacheLump( cms, CMC_SHADERREFS, sizeof( *in ), &count );
+	names = CM_CacheLump( cms, CMC_SHADERNAMES, 1, &numchars );
+	if( !in || !names || count < 1 || numchars < 1 || names[numchars - 1] )
+		return false;
+
+	for( i = 0; i < count; i++ )
+	{
+		if( in[i].name < 0 || in[i].name >= numchars )
+			return false;
+	}
+
+	out = cms->map_shaderrefs = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->numshaderrefs = count;
+
+	out[0].name = Mem_Alloc( cms->mempool, numchars );
+	memcpy( out[0].name, names, numchars );
+
+	for( i = 0; i < count; i++, in++, out++ )
+	{
+		out->name = cms->map_shaderrefs[0].name + in->name;
+		out->contents = in->contents;
+		out->flags = in->flags;
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedBrushes
+*/
+static bool CM_LoadCachedBrushes( cmodel_state_t *cms )
+{
+	int i, count, numquads;
+	cmcachebrushside_t *insides;
+	cmcachebrush_t *in;
+	cbrushside_t *side;
+	cbrush_t *out;
+	cplanequad_t *quads;
+
+	cms->map_planes = CM_CacheLump( cms, CMC_PLANES, sizeof( *cms->map_planes ), &cms->numplanes );
+	if( !cms->map_planes || cms->numplanes < 1 )
+		return false;
+
+	insides = CM_CacheLump( cms, CMC_BRUSHSIDES, sizeof( *insides ), &count );
+	if( !insides || count < 1 )
+		return false;
+
+	side = cms->map_brushsides = Mem_Alloc( cms->mempool, count * sizeof( *side ) );
+	cms->numbrushsides = count;
+
+	for( i = 0; i < count; i++, insides++, side++ )
+	{
+		if( insides->planenum < 0 || insides->planenum >= cms->numplanes )
+			return false;
+		side->plane = cms->map_planes + insides->planenum;
+		side->surfFlags = insides->surfFlags;
+	}
+
+	in = CM_CacheLump( cms, CMC_BRUSHES, sizeof( *in ), &count );
+	if( !in || count < 1 )
+		return false;
+
+	out = cms->map_brushes = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->numbrushes = count;
+
+	for( i = 0, numquads = 0; i < count; i++, in++, out++ )
+	{
+		if( in->numsides < 0 || in->firstside < 0 || in->firstside > cms->numbrushsides - in->numsides )
+			return false;
+		out->contents = in->contents;
+		out->numsides = in->numsides;
+		out->brushsides = cms->map_brushsides + in->firstside;
+		numquads += CM_NumPlaneQuads( out->numsides );
+	}
+
+	quads = CM_CacheLump( cms, CMC_PLANEQUADS, sizeof( *quads ), &count );
+	if( !quads || count != numquads )
+		return false;
+
+	cms->map_planequads = numquads ? quads : NULL;
+	for( i = 0, out = cms->map_brushes; i < cms->numbrushes; i++, out++ )
+	{
+		out->planequads = quads;
+		quads += CM_NumPlaneQuads( out->numsides );
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedMarkBrushes
+*/
+static bool CM_LoadCachedMarkBrushes( cmodel_state_t *cms )
+{
+	int i, count;
+	int *in;
+	cbrush_t **out;
+
+	in = CM_CacheLump( cms, CMC_MARKBRUSHES, sizeof( *in ), &count );
+	if( !in || count < 1 )
+		return false;
+
+	out = cms->map_markbrushes = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->nummarkbrushes = count;
+
+	for( i = 0; i < count; i++ )
+	{
+		if( in[i] < 0 || in[i] >= cms->numbrushes )
+			return false;
+		out[i] = cms->map_brushes + in[i];
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedPatch
+*
+* Facet planes, plane quads and tree nodes are used right from the cache,
+* only the facets and their sides are allocated
+*/
+static bool CM_LoadCachedPatch( cmodel_state_t *cms, cmcachereader_t *reader )
+{
+	int i, j, numquads;
+	int *surfFlags;
+	cmcachepatch_t *in;
+	cmcachefacet_t *infacets;
+	cfacetnode_t *innodes;
+	cplane_t *planes;
+	cplanequad_t *quads;
+	cface_t *patch;
+	cbrush_t *facet;
+	cfacetnode_t *node;
+	cbrushside_t *s;
+
+	in = CM_CacheRead( reader, sizeof( *in ) );
+	if( !in )
+		return false;
+	if( in->face < 0 || in->face >= cms->numfaces || cms->map_faces[in->face].facets )
+		return false;
+	if( in->numfacets <= 0 || in->numnodes <= 0 || in->numnodes >= in->numfacets * 2 )
+		return false;
+	if( in->numsides < in->numfacets || in->numsides > in->numfacets * MAX_FACET_PLANES )
+		return false;
+
+	innodes = CM_CacheRead( reader, in->numnodes * sizeof( *innodes ) );
+	infacets = CM_CacheRead( reader, in->numfacets * sizeof( *infacets ) );
+	if( !innodes || !infacets )
+		return false;
+
+	for( i = 0; i < in->numnodes; i++ )
+	{
+		node = &innodes[i];
+		if( node->skip <= i || node->skip > in->numnodes )
+			return false;
+		if( node->numfacets < 0 || node->firstfacet < 0 || node->firstfacet + node->numfacets > in->numfacets )
+			return false;
+	}
+
+	for( i = 0, j = 0, numquads = 0; i < in->numfacets; i++ )
+	{
+		if( infacets[i].numsides <= 0 || infacets[i].numsides > MAX_FACET_PLANES )
+			return false;
+		j += infacets[i].numsides;
+		numquads += CM_NumPlaneQuads( infacets[i].numsides );
+	}
+	if( j != in->numsides )
+		return false;
+
+	surfFlags = CM_CacheRead( reader, in->numsides * sizeof( *surfFlags ) );
+	planes = CM_CacheRead( reader, in->numsides * sizeof( *planes ) );
+	quads = CM_CacheRead( reader, numquads * sizeof( *quads ) );
+	if( !surfFlags || !planes || !quads )
+		return false;
+
+	patch = &cms->map_faces[in->face];
+	patch->contents = in->contents;
+	VectorCopy( in->mins, patch->mins );
+	VectorCopy( in->maxs, patch->maxs );
+	patch->numnodes = in->numnodes;
+	patch->nodes = innodes;
+
+	// freed with patch->facets, like the block CM_CreatePatch allocates
+	patch->numfacets = in->numfacets;
+	patch->facets = Mem_Alloc( cms->mempool, in->numfacets * sizeof( cbrush_t ) + in->numsides * sizeof( cbrushside_t ) );
+	s = ( cbrushside_t * )( patch->facets + in->numfacets );
+
+	for( i = 0, facet = patch->facets; i < patch->numfacets; i++, facet++ )
+	{
+		facet->contents = infacets[i].contents;
+		facet->numsides = infacets[i].numsides;
+		facet->brushsides = s;
+		facet->planequads = quads;
+		quads += CM_NumPlaneQuads( facet->numsides );
+
+		for( j = 0; j < facet->numsides; j++, s++ )
+		{
+			s->plane = planes++;
+			s->surfFlags = *surfFlags++;
+		}
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedFaces
+*/
+static bool CM_LoadCachedFaces( cmodel_state_t *cms, int numfaces )
+{
+	int length;
+	cmcachereader_t reader;
+
+	if( numfaces < 1 )
+		return false;
+
+	reader.data = CM_CacheLump( cms, CMC_PATCHES, 1, &length );
+	if( !reader.data )
+		return false;
+	reader.size = length;
+	reader.pos = 0;
+
+	cms->map_faces = Mem_Alloc( cms->mempool, numfaces * sizeof( *cms->map_faces ) );
+	cms->numfaces = numfaces;
+
+	while( reader.pos < reader.size )
+	{
+		if( !CM_LoadCachedPatch( cms, &reader ) )
+			return false;
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedMarkFaces
+*/
+static bool CM_LoadCachedMarkFaces( cmodel_state_t *cms )
+{
+	int i, count;
+	int *in;
+	cface_t **out;
+
+	in = CM_CacheLump( cms, CMC_MARKFACES, sizeof( *in ), &count );
+	if( !in || count < 1 )
+		return false;
+
+	out = cms->map_markfaces = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->nummarkfaces = count;
+
+	for( i = 0; i < count; i++ )
+	{
+		if( in[i] < 0 || in[i] >= cms->numfaces )
+			return false;
+		out[i] = cms->map_faces + in[i];
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedLeafs
+*/
+static bool CM_LoadCachedLeafs( cmodel_state_t *cms )
+{
+	int i, count;
+	cmcacheleaf_t *in;
+	cleaf_t *out;
+
+	in = CM_CacheLump( cms, CMC_LEAFS, sizeof( *in ), &count );
+	if( !in || count < 1 )
+		return false;
+
+	out = cms->map_leafs = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->numleafs = count;
+
+	for( i = 0; i < count; i++, in++, out++ )
+	{
+		if( in->nummarkbrushes < 0 || in->firstmarkbrush < 0 || in->firstmarkbrush > cms->nummarkbrushes - in->nummarkbrushes )
+			return false;
+		if( in->nummarkfaces < 0 || in->firstmarkface < 0 || in->firstmarkface > cms->nummarkfaces - in->nummarkfaces )
+			return false;
+
+		out->contents = in->contents;
+		out->cluster = in->cluster;
+		out->area = in->area;
+		out->markbrushes = cms->map_markbrushes + in->firstmarkbrush;
+		out->nummarkbrushes = in->nummarkbrushes;
+		out->markfaces = cms->map_markfaces + in->firstmarkface;
+		out->nummarkfaces = in->nummarkfaces;
+
+		if( out->area >= cms->numareas )
+			cms->numareas = out->area + 1;
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedNodes
+*/
+static bool CM_LoadCachedNodes( cmodel_state_t *cms )
+{
+	int i, j, count, child;
+	cmcachenode_t *in;
+	cnode_t *out;
+
+	in = CM_CacheLump( cms, CMC_NODES, sizeof( *in ), &count );
+	if( !in || count < 1 )
+		return false;
+
+	out = cms->map_nodes = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->numnodes = count;
+
+	for( i = 0; i < count; i++, in++, out++ )
+	{
+		if( in->planenum < 0 || in->planenum >= cms->numplanes )
+			return false;
+		out->plane = cms->map_planes + in->planenum;
+
+		for( j = 0; j < 2; j++ )
+		{
+			child = in->children[j];
+			if( child >= count || -1 - child >= cms->numleafs )
+				return false;
+			out->children[j] = child;
+		}
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedModels
+*/
+static bool CM_LoadCachedModels( cmodel_state_t *cms )
+{
+	int i, j, count, numrefs;
+	int *refs;
+	cmcachemodel_t *in;
+	cmodel_t *out;
+
+	in = CM_CacheLump( cms, CMC_MODELS, sizeof( *in ), &count );
+	refs = CM_CacheLump( cms, CMC_MODELREFS, sizeof( *refs ), &numrefs );
+	if( !in || !refs || count < 1 )
+		return false;
+
+	out = cms->map_cmodels = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
+	cms->numcmodels = count;
+
+	for( i = 0; i < count; i++, in++, out++ )
+	{
+		if( in->nummarkfaces < 0 || in->nummarkbrushes < 0 || in->nummarkfaces + in->nummarkbrushes > numrefs )
+			return false;
+
+		out->nummarkfaces = in->nummarkfaces;
+		out->markfaces = Mem_Alloc( cms->mempool, out->nummarkfaces * sizeof( cface_t * ) );
+		out->nummarkbrushes = in->nummarkbrushes;
+		out->markbrushes = Mem_Alloc( cms->mempool, out->nummarkbrushes * sizeof( cbrush_t * ) );
+
+		for( j = 0; j < out->nummarkfaces; j++, refs++ )
+		{
+			if( *refs < 0 || *refs >= cms->numfaces )
+				return false;
+			out->markfaces[j] = cms->map_faces + *refs;
+		}
+		for( j = 0; j < out->nummarkbrushes; j++, refs++ )
+		{
+			if( *refs < 0 || *refs >= cms->numbrushes )
+				return false;
+			out->markbrushes[j] = cms->map_brushes + *refs;
+		}
+		numrefs -= out->nummarkfaces + out->nummarkbrushes;
+
+		VectorCopy( in->mins, out->mins );
+		VectorCopy( in->maxs, out->maxs );
+	}
+
+	return true;
+}
+
+/*
+* CM_LoadCachedVisibility
+*/
+static bool CM_LoadCachedVisibility( cmodel_state_t *cms )
+{
+	dvis_t *vis;
+
+	vis = CM_CacheLump( cms, CMC_VISIBILITY, 1, &cms->map_visdatasize );
+	if( !vis )
+		return false;
+
+	if( !cms->map_visdatasize )
+	{
+		cms->map_pvs = NULL;
+		return true;
+	}
+
+	if( cms->map_visdatasize < (int)sizeof( *vis ) )
+		return false;
+
+	cms->map_pvs = vis;
+	return true;
+}
+
+/*
+* CM_LoadCachedEntityString
+*/
+static bool CM_LoadCachedEntityString( cmodel_state_t *cms )
+{
+	char *in;
+
+	in = CM_CacheLump( cms, CMC_ENTITIES, 1, &cms->numentitychars );
+	if( !in )
+		return false;
+
+	if( !cms->numentitychars )
+		return true;
+
+	cms->map_entitystring = Mem_Alloc( cms->mempool, cms->numentitychars );
+	memcpy( cms->map_entitystring, in, cms->numentitychars );
+	return true;
+}
+
+/*
+* CM_MapCacheFile
+*
+* Maps the opened cache file into memory, falls back to reading it when mapping isn't possible
+*/
+static bool CM_MapCacheFile( cmodel_state_t *cms, int file, int length )
+{
+	cms->map_cachesize = length;
+	cms->map_cachedata = FS_MMapBaseFile( file, length, 0 );
+	if( cms->map_cachedata )
+	{
+		// keep the file open for as long as the mapping is used
+		cms->map_cachefile = file;
+		return true;
+	}
+
+	cms->map_cachedata = Mem_Alloc( cms->mempool, length );
+	if( FS_Read( cms->map_cachedata, length, file ) != length )
+	{
+		FS_FCloseFile( file );
+		return false;
+	}
+
+	FS_FCloseFile( file );
+	return true;
+}
+
+/*
+* CM_FreeMapCache
+*/
+void CM_FreeMapCache( cmodel_state_t *cms )
+{
+	if( cms->map_cachefile )
+	{
+		FS_UnMMapBaseFile( cms->map_cachefile, cms->map_cachedata );
+		FS_FCloseFile( cms->map_cachefile );
+		cms->map_cachefile = 0;
+	}
+	else if( cms->map_cachedata )
+	{
+		Mem_Free( cms->map_cachedata );
+	}
+
+	cms->map_cachedata = NULL;
+	cms->map_cachesize = 0;
+}
+
+/*
+* CM_MapPakChecksum
+*
+* The timestamps of pk3 entries only have a 2 second resolution, so for a bsp in a pk3
+* the checksum of the pk3, made of the CRCs of its files, tells whether it's been replaced
+*/
+static unsigned int CM_MapPakChecksum( const char *name )
+{
+	const char *pakname = FS_PakNameForFile( name );
+
+	if( !pakname )
+		return 0;
+	return FS_ChecksumBaseFile( pakname, false );
+}
+
+/*
+* CM_LoadMapCache
+*
+* Loads the collision data of the map from the cache, bspheader receives the leading
+* bytes of the bsp. Returns false if there's no usable cache for the map, the partially
+* loaded state must then be cleared before loading the bsp
+*/
+bool CM_LoadMapCache( cmodel_state_t *cms, const char *name, uint8_t *bspheader )
+{
+	int file, length, bsplength;
+	cmcacheheader_t *header;
+
+	if( cm_noMapCache->integer || !cms->map_cachename[0] )
+		return false;
+
+	// the bsp is matched by its length, modification time and pk3, so that
+	// it doesn't have to be read to compute the checksum
+	bsplength = FS_FOpenFile( name, NULL, FS_READ );
+	if( bsplength <= 0 )
+		return false;
+
+	length = FS_FOpenFile( cms->map_cachename, &file, FS_READ|FS_CACHE );
+	if( length < 0 )
+		return false;
+	if( length < (int)sizeof( *header ) )
+	{
+		FS_FCloseFile( file );
+		return false;
+	}
+
+	if( !CM_MapCacheFile( cms, file, length ) )
+		return false;
+
+	header = ( cmcacheheader_t * )cms->map_cachedata;
+	if( memcmp( header->ident, CM_CACHE_IDENT, sizeof( header->ident ) ) || header->version != CM_CACHE_VERSION ||
+		header->layout != CM_CACHE_LAYOUT || header->bsplength != bsplength || header->bspmtime != (int64_t)FS_FileMTime( name ) ||
+		header->pakchecksum != CM_MapPakChecksum( name ) )
+	{
+		Com_DPrintf( "CM_LoadMapCache: %s is out of date\n", cms->map_cachename );
+		return false;
+	}
+
+	if( !CM_LoadCachedShaderrefs( cms ) ||
+		!CM_LoadCachedBrushes( cms ) ||
+		!CM_LoadCachedMarkBrushes( cms ) ||
+		!CM_LoadCachedFaces( cms, header->numfaces ) ||
+		!CM_LoadCachedMarkFaces( cms ) ||
+		!CM_LoadCachedLeafs( cms ) ||
+		!CM_LoadCachedNodes( cms ) ||
+		!CM_LoadCachedModels( cms ) ||
+		!CM_LoadCachedVisibility( cms ) ||
+		!CM_LoadCachedEntityString( cms ) )
+	{
+		Com_Printf( "CM_LoadMapCache: %s is corrupt, rebuilding\n", cms->map_cachename );
+		return false;
+	}
+
+	VectorCopy( header->world_mins, cms->world_mins );
+	VectorCopy( header->world_maxs, cms->world_maxs );
+	cms->checksum = header->checksum;
+	memcpy( bspheader, header->bspheader, CM_MAP_HEADER_SIZE );
+
+	return true;
+}
+
+/*
+===============================================================================
+
+CACHE WRITING
+
+===============================================================================
+*/
+
+/*
+* CM_CacheWrite
+*/
+static void CM_CacheWrite( cmcachewriter_t *writer, const void *data, size_t size )
+{
+	writer->pos += FS_Write( data, size, writer->file );
+}
+
+/*
+* CM_BeginCacheLump
+*/
+static void CM_BeginCacheLump( cmcachewriter_t *writer, int lump )
+{
+	static const uint8_t zeros[CMC_LUMP_ALIGN];
+
+	if( writer->pos & ( CMC_LUMP_ALIGN - 1 ) )
+		CM_CacheWrite( writer, zeros, CMC_LUMP_ALIGN - ( writer->pos & ( CMC_LUMP_ALIGN - 1 ) ) );
+	writer->header.lumps[lump].fileofs = writer->pos;
+}
+
+/*
+* CM_EndCacheLump
+*/
+static void CM_EndCacheLump( cmcachewriter_t *writer, int lump )
+{
+	writer->header.lumps[lump].filelen = writer->pos - writer->header.lumps[lump].fileofs;
+}
+
+/*
+* CM_WriteCacheLump
+*/
+static void CM_WriteCacheLump( cmcachewriter_t *writer, int lump, const void *data, size_t size )
+{
+	CM_BeginCacheLump( writer, lump );
+	if( size )
+		CM_CacheWrite( writer, data, size );
+	CM_EndCacheLump( writer, lump );
+}
+
+/*
+* CM_WriteCachedShaderrefs
+*/
+static void CM_WriteCachedShaderrefs( cmodel_state_t *cms, cmcachewriter_t *writer )
+{
+	int i, numchars;
+	cmcacheshaderref_t out;
+	cshaderref_t *in;
+
+	CM_BeginCacheLump( writer, CMC_SHADERREFS );
+	for( i = 0, numchars = 0, in = cms->map_shaderrefs; i < cms->numshaderrefs; i++, in++ )
+	{
+		out.contents = in->contents;
+		out.flags = in->flags;
+		out.name = numchars;
+		CM_CacheWrite( writer, &out, sizeof( out ) );
+		numchars += strlen( in->name ) + 1;
+	}
+	CM_EndCacheLump( writer, CMC_SHADERREFS );
+
+	CM_BeginCacheLump( writer, CMC_SHADERNAMES );
+	for( i = 0, in = cms->map_shaderrefs; i < cms->numshaderrefs; i++, in++ )
+		CM_CacheWrite( writer, in->name, strlen( in->name ) + 1 );
+	CM_EndCacheLump( writer, CMC_SHADERNAMES );
+}
+
+/*
+* CM_WriteCachedBrushes
+*/
+static void CM_WriteCachedBrushes( cmodel_state_t *cms, cmcachewriter_t *writer )
+{
+	int i, numquads;
+	cmcachebrushside_t outside;
+	cmcachebrush_t out;
+	cbrushside_t *side;
+	cbrush_t *brush;
+
+	CM_WriteCacheLump( writer, CMC_PLANES, cms->map_planes, cms->numplanes * sizeof( *cms->map_planes ) );
+
+	CM_BeginCacheLump( writer, CMC_BRUSHSIDES );
+	for( i = 0, side = cms->map_brushsides; i < cms->numbrushsides; i++, side++ )
+	{
+		outside.planenum = side->plane - cms->map_planes;
+		outside.surfFlags = side->surfFlags;
+		CM_CacheWrite( writer, &outside, sizeof( outside ) );
+	}
+	CM_EndCacheLump( writer, CMC_BRUSHSIDES );
+
+	CM_BeginCacheLump( writer, CMC_BRUSHES );
+	for( i = 0, numquads = 0, brush = cms->map_brushes; i < cms->numbrushes; i++, brush++ )
+	{
+		out.contents = brush->contents;
+		out.firstside = brush->brushsides - cms->map_brushsides;
+		out.numsides = brush->numsides;
+		CM_CacheWrite( writer, &out, sizeof( out ) );
+		numquads += CM_NumPlaneQuads( brush->numsides );
+	}
+	CM_EndCacheLump( writer, CMC_BRUSHES );
+
+	// CMod_LoadBrushes lays the quads out in brush order
+	CM_WriteCacheLump( writer, CMC_PLANEQUADS, cms->map_planequads, numquads * sizeof( *cms->map_planequads ) );
+}
+
+/*
+* CM_WriteCachedPatches
+*/
+static void CM_WriteCachedPatches( cmodel_state_t *cms, cmcachewriter_t *writer )
+{
+	int i, j, k;
+	cmcachepatch_t out;
+	cmcachefacet_t outfacet;
+	cface_t *patch;
+	cbrush_t *facet;
+	cbrushside_t *s;
+
+	CM_BeginCacheLump( writer, CMC_PATCHES );
+
+	for( i = 0, patch = cms->map_faces; i < cms->numfaces; i++, patch++ )
+	{
+		if( !patch->numfacets )
+			continue;
+
+		out.face = i;
+		out.contents = patch->contents;
+		VectorCopy( patch->mins, out.mins );
+		VectorCopy( patch->maxs, out.maxs );
+		out.numfacets = patch->numfacets;
+		out.numnodes = patch->numnodes;
+		for( j = 0, out.numsides = 0, facet = patch->facets; j < patch->numfacets; j++, facet++ )
+			out.numsides += facet->numsides;
+		CM_CacheWrite( writer, &out, sizeof( out ) );
+		CM_CacheWrite( writer, patch->nodes, patch->numnodes * sizeof( *patch->nodes ) );
+
+		for( j = 0, facet = patch->facets; j < patch->numfacets; j++, facet++ )
+		{
+			outfacet.contents = facet->contents;
+			outfacet.numsides = facet->numsides;
+			CM_CacheWrite( writer, &outfacet, sizeof( outfacet ) );
+		}
+
+		for( j = 0, facet = patch->facets; j < patch->numfacets; j++, facet++ )
+		{
+			for( k = 0, s = facet->brushsides; k < facet->numsides; k++, s++ )
+				CM_CacheWrite( writer, &s->surfFlags, sizeof( s->surfFlags ) );
+		}
+
+		for( j = 0, facet = patch->facets; j < patch->numfacets; j++, facet++ )
+		{
+			for( k = 0, s = facet->brushsides; k < facet->numsides; k++, s++ )
+				CM_CacheWrite( writer, s->plane, sizeof( *s->plane ) );
+		}
+
+		for( j = 0, facet = patch->facets; j < patch->numfacets; j++, facet++ )
+			CM_CacheWrite( writer, facet->planequads, CM_NumPlaneQuads( facet->numsides ) * sizeof( *facet->planequads ) );
+	}
+
+	CM_EndCacheLump( writer, CMC_PATCHES );
+}
+
+/*
+* CM_WriteCachedLeafs
+*/
+static void CM_WriteCachedLeafs( cmodel_state_t *cms, cmcachewriter_t *writer )
+{
+	int i, ref;
+	cmcacheleaf_t outleaf;
+	cmcachenode_t outnode;
+	cleaf_t *leaf;
+	cnode_t *node;
+
+	CM_BeginCacheLump( writer, CMC_MARKBRUSHES );
+	for( i = 0; i < cms->nummarkbrushes; i++ )
+	{
+		ref = cms->map_markbrushes[i] - cms->map_brushes;
+		CM_CacheWrite( writer, &ref, sizeof( ref ) );
+	}
+	CM_EndCacheLump( writer, CMC_MARKBRUSHES );
+
+	// written after CMod_LoadLeafs has dropped the faces without facets from the leafs
+	CM_BeginCacheLump( writer, CMC_MARKFACES );
+	for( i = 0; i < cms->nummarkfaces; i++ )
+	{
+		ref = cms->map_markfaces[i] - cms->map_faces;
+		CM_CacheWrite( writer, &ref, sizeof( ref ) );
+	}
+	CM_EndCacheLump( writer, CMC_MARKFACES );
+
+	CM_BeginCacheLump( writer, CMC_LEAFS );
+	for( i = 0, leaf = cms->map_leafs; i < cms->numleafs; i++, leaf++ )
+	{
+		outleaf.contents = leaf->contents;
+		outleaf.cluster = leaf->cluster;
+		outleaf.area = leaf->area;
+		outleaf.firstmarkbrush = leaf->markbrushes - cms->map_markbrushes;
+		outleaf.nummarkbrushes = leaf->nummarkbrushes;
+		outleaf.firstmarkface = leaf->markfaces - cms->map_markfaces;
+		outleaf.nummarkfaces = leaf->nummarkfaces;
+		CM_CacheWrite( writer, &outleaf, sizeof( outleaf ) );
+	}
+	CM_EndCacheLump( writer, CMC_LEAFS );
+
+	CM_BeginCacheLump( writer, CMC_NODES );
+	for( i = 0, node = cms->map_nodes; i < cms->numnodes; i++, node++ )
+	{
+		outnode.planenum = node->plane - cms->map_planes;
+		outnode.children[0] = node->children[0];
+		outnode.children[1] = node->children[1];
+		CM_CacheWrite( writer, &outnode, sizeof( outnode ) );
+	}
+	CM_EndCacheLump( writer, CMC_NODES );
+}
+
+/*
+* CM_WriteCachedModels
+*/
+static void CM_WriteCachedModels( cmodel_state_t *cms, cmcachewriter_t *writer )
+{
+	int i, j, ref;
+	cmcachemodel_t out;
+	cmodel_t *model;
+
+	CM_BeginCacheLump( writer, CMC_MODELS );
+	for( i = 0, model = cms->map_cmodels; i < cms->numcmodels; i++, model++ )
+	{
+		VectorCopy( model->mins, out.mins );
+		VectorCopy( model->maxs, out.maxs );
+		out.nummarkfaces = model->nummarkfaces;
+		out.nummarkbrushes = model->nummarkbrushes;
+		CM_CacheWrite( writer, &out, sizeof( out ) );
+	}
+	CM_EndCacheLump( writer, CMC_MODELS );
+
+	CM_BeginCacheLump( writer, CMC_MODELREFS );
+	for( i = 0, model = cms->map_cmodels; i < cms->numcmodels; i++, model++ )
+	{
+		for( j = 0; j < model->nummarkfaces; j++ )
+		{
+			ref = model->markfaces[j] - cms->map_faces;
+			CM_CacheWrite( writer, &ref, sizeof( ref ) );
+		}
+		for( j = 0; j < model->nummarkbrushes; j++ )
+		{
+			ref = model->markbrushes[j] - cms->map_brushes;
+			CM_CacheWrite( writer, &ref, sizeof( ref ) );
+		}
+	}
+	CM_EndCacheLump( writer, CMC_MODELREFS );
+}
+
+/*
+* CM_WriteMapCache
+*
+* Writes the collision data of the freshly loaded bsp to the cache
+*/
+void CM_WriteMapCache( cmodel_state_t *cms, const char *name, const uint8_t *bspheader )
+{
+	int bsplength;
+	char tempname[sizeof( cms->map_cachename ) + 4];
+	cmcachewriter_t writer;
+
+	if( cm_noMapCache->integer || !cms->map_cachename[0] )
+		return;
+
+	bsplength = FS_FOpenFile( name, NULL, FS_READ );
+	if( bsplength <= 0 )
+		return;
+
+	// another collision state may have the old cache mapped, so write
+	// to a temporary file and move it over the old cache when complete
+	Q_snprintfz( tempname, sizeof( tempname ), "%s.tmp", cms->map_cachename );
+	if( FS_FOpenFile( tempname, &writer.file, FS_WRITE|FS_CACHE ) == -1 )
+	{
+		Com_DPrintf( "CM_WriteMapCache: couldn't open %s for writing\n", tempname );
+		return;
+	}
+
+	memset( &writer.header, 0, sizeof( writer.header ) );
+	memcpy( writer.header.ident, CM_CACHE_IDENT, sizeof( writer.header.ident ) );
+	writer.header.version = CM_CACHE_VERSION;
+	writer.header.layout = CM_CACHE_LAYOUT;
+	writer.header.checksum = cms->checksum;
+	writer.header.bspmtime = FS_FileMTime( name );
+	writer.header.bsplength = bsplength;
+	writer.header.pakchecksum = CM_MapPakChecksum( name );
+	memcpy( writer.header.bspheader, bspheader, CM_MAP_HEADER_SIZE );
+	writer.header.numfaces = cms->numfaces;
+	VectorCopy( cms->world_mins, writer.header.world_mins );
+	VectorCopy( cms->world_maxs, writer.header.world_maxs );
+
+	// the header is rewritten once the lumps are in place
+	writer.pos = 0;
+	CM_CacheWrite( &writer, &writer.header, sizeof( writer.header ) );
+
+	CM_WriteCachedShaderrefs( cms, &writer );
+	CM_WriteCachedBrushes( cms, &writer );
+	CM_WriteCachedPatches( cms, &writer );
+	CM_WriteCachedLeafs( cms, &writer );
+	CM_WriteCachedModels( cms, &writer );
+	CM_WriteCacheLump( &writer, CMC_VISIBILITY, cms->map_pvs, cms->map_visdatasize );
+	CM_WriteCacheLump( &writer, CMC_ENTITIES, cms->map_entitystring, cms->numentitychars );
+
+	FS_Seek( writer.file, 0, FS_SEEK_SET );
+	FS_Write( &writer.header, sizeof( writer.header ), writer.file );
+	FS_FCloseFile( writer.file );
+
+	if( !FS_MoveCacheFile( tempname, cms->map_cachename ) )
+	{
+		// renaming over an existing file fails on some systems
+		FS_RemoveFile( cms->map_cachename );
+		if( !FS_MoveCacheFile( tempname, cms->map_cachename ) )
+			Com_DPrintf( "CM_WriteMapCache: couldn't move %s to %s\n", tempname, cms->map_cachename );
+	}
+}
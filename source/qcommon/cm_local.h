@@ -48,24 +48,49 @@ typedef struct
 	int surfFlags;
 } cbrushside_t;
 
+// brush planes in groups of four, laid out for the SIMD clipping kernels,
+// unused lanes have a zero normal and a huge distance so they never clip
+typedef struct
+{
+	float normal[3][4];
+	float dist[4];
+} cplanequad_t;
+
+#define CM_NumPlaneQuads( numsides ) ( ( ( numsides ) + 3 ) >> 2 )
+
 typedef struct
 {
 	int contents;
-	int checkcount;             // to avoid repeated testings
 
 	int numsides;
 	cbrushside_t *brushsides;
+	cplanequad_t *planequads;   // CM_NumPlaneQuads( numsides ) of them
 } cbrush_t;
 
+// AABB tree over the facets of a patch, stored depth-first so that the
+// subtree of a rejected node is passed over by jumping to its skip index
+typedef struct
+{
+	vec3_t mins, maxs;
+	int firstfacet;
+	int numfacets;              // 0 for inner nodes
+	int skip;
+} cfacetnode_t;
+
+#define MAX_FACET_PLANES	32
+#define CM_FACETS_PER_NODE	4
+
 typedef struct
 {
 	int contents;
-	int checkcount;             // to avoid repeated testings
 
 	vec3_t mins, maxs;
 
 	int numfacets;
 	cbrush_t *facets;
+
+	int numnodes;
+	cfacetnode_t *nodes;        // nodes[0] is the root
 } cface_t;
 
 typedef struct
@@ -105,17 +130,49 @@ typedef struct
 	int floodvalid;
 } carea_t;
 
+// per-trace state, one context may only be used by one thread at a time
+struct cmtrace_ctx_s
+{
+	struct cmodel_state_s *cms;
+
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	vec3_t startmins, endmins;
+	vec3_t startmaxs, endmaxs;
+	vec3_t absmins, absmaxs;
+	vec3_t extents;
+	vec3_t invdir;              // 1 / ( end - start ), 0 on axes without movement
+
+	trace_t *trace;
+	float realfraction;         // only used with TRACEVICFIX
+	int contents;
+	bool ispoint;               // optimized case
+	bool simd;                  // clip against the plane quads
+
+	// brushes and patches already checked by this trace are stamped with its generation
+	unsigned int generation;
+	int numbrushstamps;
+	unsigned int *brushstamps;
+	int numfacestamps;
+	unsigned int *facestamps;
+};
+
 struct cmodel_state_s
 {
-	int checkcount;
 	int refcount;
 	struct mempool_s *mempool;
 
 	const bspFormatDesc_t *cmap_bspFormat;
 
 	char map_name[MAX_CONFIGSTRING_CHARS];
+	char map_cachename[MAX_QPATH+16];
 	unsigned int checksum;
 
+	// collision cache the map was loaded from, see cm_cache.c
+	int map_cachefile;              // open while the cache is mapped
+	uint8_t *map_cachedata;
+	size_t map_cachesize;
+
 	int numbrushsides;
 	cbrushside_t *map_brushsides;
 
@@ -142,6 +199,7 @@ struct cmodel_state_s
 
 	int numbrushes;
 	cbrush_t *map_brushes;
+	cplanequad_t *map_planequads;
 
 	int numfaces;
 	cface_t	*map_faces;
@@ -176,20 +234,19 @@ struct cmodel_state_s
 	// cm_trace.c
 	cplane_t box_planes[6];
 	cbrushside_t box_brushsides[6];
+	cplanequad_t box_planequads[CM_NumPlaneQuads( 6 )];
 	cbrush_t box_brush[1];
 	cbrush_t *box_markbrushes[1];
 	cmodel_t box_cmodel[1];
 
 	cplane_t oct_planes[10];
 	cbrushside_t oct_brushsides[10];
+	cplanequad_t oct_planequads[CM_NumPlaneQuads( 10 )];
 	cbrush_t oct_brush[1];
 	cbrush_t *oct_markbrushes[1];
 	cmodel_t oct_cmodel[1];
 
-	int leaf_count, leaf_maxcount;
-	int *leaf_list;
-	float *leaf_mins, *leaf_maxs;
-	int leaf_topnode;
+	cmtrace_ctx_t trace_ctx;        // used when no context is passed
 
 	// optional special handling of line tracing and point contents
 	void ( *CM_TransformedBoxTrace )( struct cmodel_state_s *cms, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs, struct cmodel_s *cmodel, int brushmask, vec3_t origin, vec3_t angles );
@@ -202,4 +259,18 @@ struct cmodel_state_s
 void	CM_InitBoxHull( cmodel_state_t *cms );
 void	CM_InitOctagonHull( cmodel_state_t *cms );
 
+void	CM_ClearTraceContext( cmtrace_ctx_t *ctx );
+void	CM_InitTraceKernels( void );
+void	CM_BuildPlaneQuads( cbrush_t *brush, cplanequad_t *quads );
+
 void	CM_FloodAreaConnections( cmodel_state_t *cms );
+
+extern cvar_t *cm_noMapCache;
+
+// leading bytes of the bsp kept in the cache to identify its format
+#define CM_MAP_HEADER_SIZE	16
+
+bool	CM_LoadMapCache( cmodel_state_t *cms, const char *name, uint8_t *bspheader );
+void	CM_WriteMapCache( cmodel_state_t *cms, const char *name, const uint8_t *bspheader );
+void	CM_FreeMapCache( cmodel_state_t *cms );
+bool	CM_IsCachedData( cmodel_state_t *cms, const void *p );
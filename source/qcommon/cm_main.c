@@ -29,6 +29,7 @@ static mempool_t *cmap_mempool;
 
 static cvar_t *cm_noAreas;
 cvar_t *cm_noCurves;
+cvar_t *cm_noMapCache;
 
 void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buffer, bspFormatDesc_t *format );
 
@@ -121,7 +122,8 @@ static void CM_Clear( cmodel_state_t *cms )
 
 	if( cms->map_planes )
 	{
-		Mem_Free( cms->map_planes );
+		if( !CM_IsCachedData( cms, cms->map_planes ) )
+			Mem_Free( cms->map_planes );
 		cms->map_planes = NULL;
 		cms->numplanes = 0;
 	}
@@ -147,9 +149,17 @@ static void CM_Clear( cmodel_state_t *cms )
 		cms->numbrushes = 0;
 	}
 
+	if( cms->map_planequads )
+	{
+		if( !CM_IsCachedData( cms, cms->map_planequads ) )
+			Mem_Free( cms->map_planequads );
+		cms->map_planequads = NULL;
+	}
+
 	if( cms->map_pvs )
 	{
-		Mem_Free( cms->map_pvs );
+		if( !CM_IsCachedData( cms, cms->map_pvs ) )
+			Mem_Free( cms->map_pvs );
 		cms->map_pvs = NULL;
 	}
 
@@ -159,6 +169,10 @@ static void CM_Clear( cmodel_state_t *cms )
 		cms->map_entitystring = &cms->map_entitystring_empty;
 	}
 
+	CM_FreeMapCache( cms );
+
+	CM_ClearTraceContext( &cms->trace_ctx );
+
 	cms->map_name[0] = 0;
 
 	ClearBounds( cms->world_mins, cms->world_maxs );
@@ -188,6 +202,7 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 	int length;
 	unsigned *buf;
 	char *header;
+	uint8_t bspheader[CM_MAP_HEADER_SIZE];
 	const modelFormatDescr_t *descr;
 	bspFormatDesc_t *bspFormat = NULL;
 
@@ -218,18 +233,30 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 		return cms->map_cmodels;    // cinematic servers won't have anything at all
 	}
 
-	//
-	// load the file
-	//
-	length = FS_LoadFile( name, ( void ** )&buf, NULL, 0 );
-	if( !buf )
-		Com_Error( ERR_DROP, "Couldn't load %s", name );
+	Q_snprintfz( cms->map_cachename, sizeof( cms->map_cachename ), "cache/%s", name );
+	COM_ReplaceExtension( cms->map_cachename, ".cmc", sizeof( cms->map_cachename ) );
+
+	buf = NULL;
+	if( !CM_LoadMapCache( cms, name, bspheader ) )
+	{
+		CM_Clear( cms );
+
+		//
+		// load the file
+		//
+		length = FS_LoadFile( name, ( void ** )&buf, NULL, 0 );
+		if( !buf )
+			Com_Error( ERR_DROP, "Couldn't load %s", name );
+		if( length < CM_MAP_HEADER_SIZE )
+			Com_Error( ERR_DROP, "CM_LoadMap: %s is too short", name );
 
-	cms->checksum = md5_digest32( ( const uint8_t * )buf, length );
+		cms->checksum = md5_digest32( ( const uint8_t * )buf, length );
+		memcpy( bspheader, buf, CM_MAP_HEADER_SIZE );
+	}
 	*checksum = cms->checksum;
 
 	// call the apropriate loader
-	descr = Q_FindFormatDescriptor( cm_supportedformats, ( const uint8_t * )buf, (const bspFormatDesc_t **)&bspFormat );
+	descr = Q_FindFormatDescriptor( cm_supportedformats, bspheader, (const bspFormatDesc_t **)&bspFormat );
 	if( !descr )
 		Com_Error( ERR_DROP, "CM_LoadMap: unknown fileid for %s", name );
 
@@ -238,16 +265,24 @@ cmodel_t *CM_LoadMap( cmodel_state_t *cms, const char *name, bool clientload, un
 
 	// copy header into temp variable to be saveed in a cvar
 	header = Mem_TempMalloc( descr->headerLen + 1 );
-	memcpy( header, buf, descr->headerLen );
+	memcpy( header, bspheader, descr->headerLen );
 	header[descr->headerLen] = '\0';
 
 	// store map format description in cvars
 	Cvar_ForceSet( "cm_mapHeader", header );
-	Cvar_ForceSet( "cm_mapVersion", va( "%i", LittleLong( *((int *)((uint8_t *)buf + descr->headerLen)) ) ) );
+	Cvar_ForceSet( "cm_mapVersion", va( "%i", LittleLong( *((int *)(bspheader + descr->headerLen)) ) ) );
 
 	Mem_TempFree( header );
 
-	descr->loader( cms, NULL, buf, bspFormat );
+	if( buf )
+	{
+		descr->loader( cms, NULL, buf, bspFormat );
+		CM_WriteMapCache( cms, name, bspheader );
+	}
+	else
+	{
+		cms->cmap_bspFormat = bspFormat;
+	}
 
 	CM_InitBoxHull( cms );
 	CM_InitOctagonHull( cms );
@@ -877,6 +912,7 @@ cmodel_state_t *CM_New( void *mempool )
 	cms->map_leafs = &cms->map_leaf_empty;
 	cms->map_areas = &cms->map_area_empty;
 	cms->map_entitystring = &cms->map_entitystring_empty;
+	cms->trace_ctx.cms = cms;
 
 	return cms;
 }
@@ -930,6 +966,9 @@ void CM_Init( void )
 
 	cm_noAreas =	    Cvar_Get( "cm_noAreas", "0", CVAR_CHEAT );
 	cm_noCurves =	    Cvar_Get( "cm_noCurves", "0", CVAR_CHEAT );
+	cm_noMapCache =	    Cvar_Get( "cm_noMapCache", "0", 0 );
+
+	CM_InitTraceKernels();
 
 	cm_initialized = true;
 }
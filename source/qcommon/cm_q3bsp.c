@@ -23,16 +23,17 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "cm_local.h"
 #include "patch.h"
 
-#define MAX_FACET_PLANES 32
-
 /*
 * CM_CreateFacetFromPoints
+*
+* bounds receives the mins and maxs of the points
 */
-static int CM_CreateFacetFromPoints( cmodel_state_t *cms, cbrush_t *facet, vec3_t *verts, int numverts, cshaderref_t *shaderref, cplane_t *brushplanes )
+static int CM_CreateFacetFromPoints( cmodel_state_t *cms, cbrush_t *facet, vec3_t *verts, int numverts, cshaderref_t *shaderref, cplane_t *brushplanes, vec3_t *bounds )
 {
 	int i, j;
 	int axis, dir;
-	vec3_t normal, mins, maxs;
+	vec_t *mins = bounds[0], *maxs = bounds[1];
+	vec3_t normal;
 	float d, dist;
 	cplane_t mainplane;
 	vec3_t vec, vec2;
@@ -41,6 +42,7 @@ static int CM_CreateFacetFromPoints( cmodel_state_t *cms, cbrush_t *facet, vec3_
 	// set default values for brush
 	facet->numsides = 0;
 	facet->brushsides = NULL;
+	facet->planequads = NULL;
 	facet->contents = shaderref->contents;
 
 	// calculate plane for this triangle
@@ -177,6 +179,125 @@ static int CM_CreateFacetFromPoints( cmodel_state_t *cms, cbrush_t *facet, vec3_
 	return ( facet->numsides = numbrushplanes );
 }
 
+/*
+* CM_AllocPatchFacets
+*
+* Allocates the facets of a patch along with their brush sides, planes, plane quads
+* and tree nodes in a single block, which is freed with patch->facets
+*/
+static void CM_AllocPatchFacets( cmodel_state_t *cms, cface_t *patch, int numfacets, const int *numsides, int numnodes )
+{
+	int i, j;
+	int totalsides, totalquads;
+	uint8_t *data;
+	cbrush_t *facet;
+	cbrushside_t *sides;
+	cplane_t *planes;
+	cplanequad_t *quads;
+
+	for( i = 0, totalsides = 0, totalquads = 0; i < numfacets; i++ )
+	{
+		totalsides += numsides[i];
+		totalquads += CM_NumPlaneQuads( numsides[i] );
+	}
+
+	data = Mem_Alloc( cms->mempool, numfacets * sizeof( cbrush_t ) + totalsides * ( sizeof( cbrushside_t ) + sizeof( cplane_t ) ) + 
+		totalquads * sizeof( cplanequad_t ) + numnodes * sizeof( cfacetnode_t ) );
+
+	patch->numfacets = numfacets;
+	patch->facets = ( cbrush_t * )data; data += numfacets * sizeof( cbrush_t );
+	sides = ( cbrushside_t * )data; data += totalsides * sizeof( cbrushside_t );
+	planes = ( cplane_t * )data; data += totalsides * sizeof( cplane_t );
+	quads = ( cplanequad_t * )data; data += totalquads * sizeof( cplanequad_t );
+	patch->numnodes = numnodes;
+	patch->nodes = ( cfacetnode_t * )data;
+
+	for( i = 0, facet = patch->facets; i < numfacets; i++, facet++ )
+	{
+		facet->numsides = numsides[i];
+		facet->brushsides = sides; sides += numsides[i];
+		facet->planequads = quads; quads += CM_NumPlaneQuads( numsides[i] );
+
+		for( j = 0; j < numsides[i]; j++ )
+			facet->brushsides[j].plane = planes++;
+	}
+}
+
+/*
+* CM_BuildFacetTree_r
+*
+* Emits the nodes for facets order[first] to order[first+count-1] depth-first,
+* reordering them so that each leaf node covers a contiguous range
+*/
+static void CM_BuildFacetTree_r( cfacetnode_t *nodes, int *numnodes, int *order, vec3_t *facetbounds, int first, int count )
+{
+	int i, j, t;
+	int axis, mid;
+	float split;
+	vec3_t cmins, cmaxs, center;
+	cfacetnode_t *node;
+
+	node = &nodes[( *numnodes )++];
+
+	// node bounds and the bounds of the facet centers (doubled)
+	ClearBounds( node->mins, node->maxs );
+	ClearBounds( cmins, cmaxs );
+	for( i = first; i < first + count; i++ )
+	{
+		AddPointToBounds( facetbounds[order[i]*2+0], node->mins, node->maxs );
+		AddPointToBounds( facetbounds[order[i]*2+1], node->mins, node->maxs );
+		VectorAdd( facetbounds[order[i]*2+0], facetbounds[order[i]*2+1], center );
+		AddPointToBounds( center, cmins, cmaxs );
+	}
+
+	for( i = 0; i < 3; i++ )
+	{
+		// spread the mins / maxs by a pixel, same as the patch bounds
+		node->mins[i] -= 1;
+		node->maxs[i] += 1;
+	}
+
+	if( count <= CM_FACETS_PER_NODE )
+	{
+		node->firstfacet = first;
+		node->numfacets = count;
+		node->skip = *numnodes;
+		return;
+	}
+
+	// split at the middle of the longest axis of the facet centers
+	axis = 0;
+	for( i = 1; i < 3; i++ )
+	{
+		if( cmaxs[i] - cmins[i] > cmaxs[axis] - cmins[axis] )
+			axis = i;
+	}
+	split = ( cmins[axis] + cmaxs[axis] ) * 0.5f;
+
+	for( i = first, j = first + count - 1; i <= j; )
+	{
+		if( facetbounds[order[i]*2+0][axis] + facetbounds[order[i]*2+1][axis] < split )
+		{
+			i++;
+			continue;
+		}
+		t = order[i]; order[i] = order[j]; order[j] = t;
+		j--;
+	}
+
+	mid = i - first;
+	if( !mid || mid == count )
+		mid = count / 2; // all centers coincide
+
+	node->firstfacet = 0;
+	node->numfacets = 0;
+
+	CM_BuildFacetTree_r( nodes, numnodes, order, facetbounds, first, mid );
+	CM_BuildFacetTree_r( nodes, numnodes, order, facetbounds, first + mid, count - mid );
+
+	node->skip = *numnodes;
+}
+
 /*
 * CM_CreatePatch
 */
@@ -184,13 +305,17 @@ static void CM_CreatePatch( cmodel_state_t *cms, cface_t *patch, cshaderref_t *s
 {
 	int step[2], size[2], flat[2];
 	vec3_t *patchpoints;
-	int i, j, k ,u, v;
-	int numsides, totalsides;
-	cbrush_t *facets, *facet;
+	int i, j, u, v;
+	int numsides, totalsides, numfacets, maxfacets, numnodes;
+	cbrush_t *facets, *facet, *src;
 	vec3_t *points;
 	vec3_t tverts[4];
 	uint8_t *data;
 	cplane_t *brushplanes;
+	vec3_t *facetbounds;
+	cfacetnode_t *nodes;
+	int *order, *firstside, *facetsides;
+	cbrushside_t *s;
 
 	// find the degree of subdivision in the u and v directions
 	Patch_GetFlatness( CM_SUBDIV_LEVEL, ( vec_t * )verts[0], 3, patch_cp, flat );
@@ -206,20 +331,30 @@ static void CM_CreatePatch( cmodel_state_t *cms, cface_t *patch, cshaderref_t *s
 	Patch_Evaluate( vec_t, 3, verts[0], patch_cp, step, patchpoints[0], 0 );
 	Patch_RemoveLinearColumnsRows( patchpoints[0], 3, &size[0], &size[1], 0, NULL, NULL );
 
+	maxfacets = ( size[0]-1 ) * ( size[1]-1 ) * 2;
 	data = Mem_Alloc( cms->mempool, size[0] * size[1] * sizeof( vec3_t ) + 
-		( size[0]-1 ) * ( size[1]-1 ) * 2 * ( sizeof( cbrush_t ) + 32 * sizeof( cplane_t ) ) );
+		maxfacets * ( sizeof( cbrush_t ) + MAX_FACET_PLANES * sizeof( cplane_t ) + 2 * sizeof( vec3_t ) + 
+		2 * sizeof( cfacetnode_t ) + 3 * sizeof( int ) ) );
 
 	points = ( vec3_t * )data; data += size[0] * size[1] * sizeof( vec3_t );
-	facets = ( cbrush_t * )data; data += ( size[0]-1 ) * ( size[1]-1 ) * 2 * sizeof( cbrush_t );
-	brushplanes = ( cplane_t * )data; data += ( size[0]-1 ) * ( size[1]-1 ) * 2 * MAX_FACET_PLANES * sizeof( cplane_t );
+	facets = ( cbrush_t * )data; data += maxfacets * sizeof( cbrush_t );
+	brushplanes = ( cplane_t * )data; data += maxfacets * MAX_FACET_PLANES * sizeof( cplane_t );
+	facetbounds = ( vec3_t * )data; data += maxfacets * 2 * sizeof( vec3_t );
+	nodes = ( cfacetnode_t * )data; data += maxfacets * 2 * sizeof( cfacetnode_t );
+	order = ( int * )data; data += maxfacets * sizeof( int );
+	firstside = ( int * )data; data += maxfacets * sizeof( int );
+	facetsides = ( int * )data; data += maxfacets * sizeof( int );
 
 	// fill in
 	memcpy( points, patchpoints, size[0] * size[1] * sizeof( vec3_t ) );
 	Mem_TempFree( patchpoints );
 
 	totalsides = 0;
+	numfacets = 0;
 	patch->numfacets = 0;
 	patch->facets = NULL;
+	patch->numnodes = 0;
+	patch->nodes = NULL;
 	ClearBounds( patch->mins, patch->maxs );
 
 	// create a set of facets
@@ -237,55 +372,61 @@ static void CM_CreatePatch( cmodel_state_t *cms, cface_t *patch, cshaderref_t *s
 				AddPointToBounds( tverts[i], patch->mins, patch->maxs );
 
 			// try to create one facet from a quad
-			numsides = CM_CreateFacetFromPoints( cms, &facets[patch->numfacets], tverts, 4, shaderref, brushplanes + totalsides );
+			firstside[numfacets] = totalsides;
+			numsides = CM_CreateFacetFromPoints( cms, &facets[numfacets], tverts, 4, shaderref, brushplanes + totalsides, facetbounds + numfacets * 2 );
 			if( !numsides )
 			{	// create two facets from triangles
 				VectorCopy( tverts[3], tverts[2] );
-				numsides = CM_CreateFacetFromPoints( cms, &facets[patch->numfacets], tverts, 3, shaderref, brushplanes + totalsides );
+				numsides = CM_CreateFacetFromPoints( cms, &facets[numfacets], tverts, 3, shaderref, brushplanes + totalsides, facetbounds + numfacets * 2 );
 				if( numsides )
 				{
 					totalsides += numsides;
-					patch->numfacets++;
+					numfacets++;
 				}
 
 				VectorCopy( tverts[2], tverts[0] );
 				VectorCopy( points[v *size[0] + u + size[0] + 1], tverts[2] );
-				numsides = CM_CreateFacetFromPoints( cms, &facets[patch->numfacets], tverts, 3, shaderref, brushplanes + totalsides );
+				firstside[numfacets] = totalsides;
+				numsides = CM_CreateFacetFromPoints( cms, &facets[numfacets], tverts, 3, shaderref, brushplanes + totalsides, facetbounds + numfacets * 2 );
 			}
 
 			if( numsides )
 			{
 				totalsides += numsides;
-				patch->numfacets++;
+				numfacets++;
 			}
 		}
 	}
 
-	if( patch->numfacets )
+	if( numfacets )
 	{
-		uint8_t *data;
+		// build the facet tree, this also decides the order the facets are stored in
+		for( i = 0; i < numfacets; i++ )
+			order[i] = i;
 
-		data = Mem_Alloc( cms->mempool, patch->numfacets * sizeof( cbrush_t ) + totalsides * ( sizeof( cbrushside_t ) + sizeof( cplane_t ) ) );
+		numnodes = 0;
+		CM_BuildFacetTree_r( nodes, &numnodes, order, facetbounds, 0, numfacets );
 
-		patch->facets = ( cbrush_t * )data; data += patch->numfacets * sizeof( cbrush_t );
-		memcpy( patch->facets, facets, patch->numfacets * sizeof( cbrush_t ) );
-		for( i = 0, k = 0, facet = patch->facets; i < patch->numfacets; i++, facet++ )
-		{
-			cplane_t *planes;
-			cbrushside_t *s;
+		for( i = 0; i < numfacets; i++ )
+			facetsides[i] = facets[order[i]].numsides;
 
-			facet->brushsides = ( cbrushside_t * )data; data += facet->numsides * sizeof( cbrushside_t );
-			planes = ( cplane_t * )data; data += facet->numsides * sizeof( cplane_t );
+		CM_AllocPatchFacets( cms, patch, numfacets, facetsides, numnodes );
+		memcpy( patch->nodes, nodes, numnodes * sizeof( cfacetnode_t ) );
+
+		for( i = 0, facet = patch->facets; i < numfacets; i++, facet++ )
+		{
+			src = &facets[order[i]];
+			facet->contents = src->contents;
 
 			for( j = 0, s = facet->brushsides; j < facet->numsides; j++, s++ )
 			{
-				planes[j] = brushplanes[k++];
-
-				s->plane = &planes[j];
+				*s->plane = brushplanes[firstside[order[i]] + j];
 				SnapPlane( s->plane->normal, &s->plane->dist );
 				CategorizePlane( s->plane );
 				s->surfFlags = shaderref->flags;
 			}
+
+			CM_BuildPlaneQuads( facet, facet->planequads );
 		}
 
 		patch->contents = shaderref->contents;
@@ -471,6 +612,8 @@ static void CMod_LoadFaces( cmodel_state_t *cms, lump_t *l )
 		out->contents = 0;
 		out->numfacets = 0;
 		out->facets = NULL;
+		out->numnodes = 0;
+		out->nodes = NULL;
 		if( LittleLong( in->facetype ) != FACETYPE_PATCH )
 			continue;
 		CMod_LoadFace( cms, out, in->shadernum, in->firstvert, in->numverts, in->patch_cp );
@@ -501,6 +644,8 @@ static void CMod_LoadFaces_RBSP( cmodel_state_t *cms, lump_t *l )
 		out->contents = 0;
 		out->numfacets = 0;
 		out->facets = NULL;
+		out->numnodes = 0;
+		out->nodes = NULL;
 		if( LittleLong( in->facetype ) != FACETYPE_PATCH )
 			continue;
 		CMod_LoadFace( cms, out, in->shadernum, in->firstvert, in->numverts, in->patch_cp );
@@ -798,9 +943,10 @@ static void CMod_LoadBrushSides_RBSP( cmodel_state_t *cms, lump_t *l )
 static void CMod_LoadBrushes( cmodel_state_t *cms, lump_t *l )
 {
 	int i;
-	int count;
+	int count, numquads;
 	dbrush_t *in;
 	cbrush_t *out;
+	cplanequad_t *quads;
 	int shaderref;
 
 	in = ( void * )( cms->cmod_base + l->fileofs );
@@ -813,12 +959,22 @@ static void CMod_LoadBrushes( cmodel_state_t *cms, lump_t *l )
 	out = cms->map_brushes = Mem_Alloc( cms->mempool, count * sizeof( *out ) );
 	cms->numbrushes = count;
 
-	for( i = 0; i < count; i++, out++, in++ )
+	for( i = 0, numquads = 0; i < count; i++, out++, in++ )
 	{
 		shaderref = LittleLong( in->shadernum );
 		out->contents = cms->map_shaderrefs[shaderref].contents;
 		out->numsides = LittleLong( in->numsides );
 		out->brushsides = cms->map_brushsides + LittleLong( in->firstside );
+		numquads += CM_NumPlaneQuads( out->numsides );
+	}
+
+	// planes for the SIMD clipping kernels
+	quads = cms->map_planequads = Mem_Alloc( cms->mempool, numquads * sizeof( *quads ) );
+	for( i = 0, out = cms->map_brushes; i < count; i++, out++ )
+	{
+		out->planequads = quads;
+		CM_BuildPlaneQuads( out, quads );
+		quads += CM_NumPlaneQuads( out->numsides );
 	}
 }
 
@@ -898,5 +1054,9 @@ void CM_LoadQ3BrushModel( cmodel_state_t *cms, void *parent, void *buf, bspForma
 	FS_FreeFile( buf );
 
 	if( cms->numvertexes )
+	{
 		Mem_Free( cms->map_verts );
+		cms->map_verts = NULL;
+		cms->numvertexes = 0;
+	}
 }
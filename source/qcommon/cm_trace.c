@@ -37,6 +37,7 @@ void CM_InitBoxHull( cmodel_state_t *cms )
 	cms->box_brush->numsides = 6;
 	cms->box_brush->brushsides = cms->box_brushsides;
 	cms->box_brush->contents = CONTENTS_BODY;
+	cms->box_brush->planequads = cms->box_planequads;
 
 	cms->box_markbrushes[0] = cms->box_brush;
 
@@ -70,6 +71,8 @@ void CM_InitBoxHull( cmodel_state_t *cms )
 			p->signbits = 0;
 		}
 	}
+
+	CM_BuildPlaneQuads( cms->box_brush, cms->box_planequads );
 }
 
 /*
@@ -93,6 +96,7 @@ void CM_InitOctagonHull( cmodel_state_t *cms )
 	cms->oct_brush->numsides = 10;
 	cms->oct_brush->brushsides = cms->oct_brushsides;
 	cms->oct_brush->contents = CONTENTS_BODY;
+	cms->oct_brush->planequads = cms->oct_planequads;
 
 	cms->oct_markbrushes[0] = cms->oct_brush;
 
@@ -142,6 +146,8 @@ void CM_InitOctagonHull( cmodel_state_t *cms )
 		p->type = PLANE_NONAXIAL;
 		p->signbits = SignbitsForPlane( p );
 	}
+
+	CM_BuildPlaneQuads( cms->oct_brush, cms->oct_planequads );
 }
 
 /*
@@ -157,6 +163,7 @@ cmodel_t *CM_ModelForBBox( cmodel_state_t *cms, vec3_t mins, vec3_t maxs )
 	cms->box_planes[3].dist = -mins[1];
 	cms->box_planes[4].dist = maxs[2];
 	cms->box_planes[5].dist = -mins[2];
+	CM_BuildPlaneQuads( cms->box_brush, cms->box_planequads );
 
 	VectorCopy( mins, cms->box_cmodel->mins );
 	VectorCopy( maxs, cms->box_cmodel->maxs );
@@ -224,6 +231,8 @@ cmodel_t *CM_OctagonModelForBBox( cmodel_state_t *cms, vec3_t mins, vec3_t maxs
 	VectorSet( cms->oct_planes[9].normal, cosa, -sina, 0 );
 	cms->oct_planes[9].dist = d;
 
+	CM_BuildPlaneQuads( cms->oct_brush, cms->oct_planequads );
+
 	return cms->oct_cmodel;
 }
 
@@ -253,7 +262,15 @@ int CM_PointLeafnum( cmodel_state_t *cms, const vec3_t p )
 *
 * Fills in a list of all the leafs touched
 */
-static void CM_BoxLeafnums_r( cmodel_state_t *cms, int nodenum )
+typedef struct
+{
+	int count, maxcount;
+	int *list;
+	float *mins, *maxs;
+	int topnode;
+} cm_boxleafs_t;
+
+static void CM_BoxLeafnums_r( cmodel_state_t *cms, cm_boxleafs_t *bl, int nodenum )
 {
 	int s;
 	cnode_t	*node;
@@ -261,7 +278,7 @@ static void CM_BoxLeafnums_r( cmodel_state_t *cms, int nodenum )
 	while( nodenum >= 0 )
 	{
 		node = &cms->map_nodes[nodenum];
-		s = BOX_ON_PLANE_SIDE( cms->leaf_mins, cms->leaf_maxs, node->plane ) - 1;
+		s = BOX_ON_PLANE_SIDE( bl->mins, bl->maxs, node->plane ) - 1;
 
 		if( s < 2 )
 		{
@@ -270,35 +287,39 @@ static void CM_BoxLeafnums_r( cmodel_state_t *cms, int nodenum )
 		}
 
 		// go down both sides
-		if( cms->leaf_topnode == -1 )
-			cms->leaf_topnode = nodenum;
-		CM_BoxLeafnums_r( cms, node->children[0] );
+		if( bl->topnode == -1 )
+			bl->topnode = nodenum;
+		CM_BoxLeafnums_r( cms, bl, node->children[0] );
 		nodenum = node->children[1];
 	}
 
-	if( cms->leaf_count < cms->leaf_maxcount )
-		cms->leaf_list[cms->leaf_count++] = -1 - nodenum;
+	if( bl->count < bl->maxcount )
+		bl->list[bl->count++] = -1 - nodenum;
 }
 
 /*
 * CM_BoxLeafnums
+*
+* The walk state lives on the stack so this can be called from several threads at once
 */
 int CM_BoxLeafnums( cmodel_state_t *cms, vec3_t mins, vec3_t maxs, int *list, int listsize, int *topnode )
 {
-	cms->leaf_list = list;
-	cms->leaf_count = 0;
-	cms->leaf_maxcount = listsize;
-	cms->leaf_mins = mins;
-	cms->leaf_maxs = maxs;
+	cm_boxleafs_t bl;
 
-	cms->leaf_topnode = -1;
+	bl.list = list;
+	bl.count = 0;
+	bl.maxcount = listsize;
+	bl.mins = mins;
+	bl.maxs = maxs;
 
-	CM_BoxLeafnums_r( cms, 0 );
+	bl.topnode = -1;
+
+	CM_BoxLeafnums_r( cms, &bl, 0 );
 
 	if( topnode )
-		*topnode = cms->leaf_topnode;
+		*topnode = bl.topnode;
 
-	return cms->leaf_count;
+	return bl.count;
 }
 
 /*
@@ -337,12 +358,24 @@ static inline int CM_BrushContents( cbrush_t *brush, vec3_t p )
 */
 static inline int CM_PatchContents( cface_t *patch, vec3_t p )
 {
-	int i, c;
+	int i, j, c;
+	cfacetnode_t *node;
 	cbrush_t *facet;
 
-	for( i = 0, facet = patch->facets; i < patch->numfacets; i++, patch++ )
-		if( ( c = CM_BrushContents( facet, p ) ) )
-			return c;
+	for( i = 0; i < patch->numnodes; )
+	{
+		node = &patch->nodes[i];
+		if( !BoundsIntersect( node->mins, node->maxs, p, p ) )
+		{
+			i = node->skip;
+			continue;
+		}
+
+		for( j = 0, facet = patch->facets + node->firstfacet; j < node->numfacets; j++, facet++ )
+			if( ( c = CM_BrushContents( facet, p ) ) )
+				return c;
+		i++;
+	}
 
 	return 0;
 }
@@ -483,52 +516,254 @@ BOX TRACING
 
 // 1/32 epsilon to keep floating point happy
 #define	DIST_EPSILON	( 1.0f / 32.0f )
-#ifdef TRACEVICFIX
 #define FRAC_EPSILON    ( 1.0f / 1024.0f )
-#endif
 #define RADIUS_EPSILON		1.0f
 
-static vec3_t trace_start, trace_end;
-static vec3_t trace_mins, trace_maxs;
-static vec3_t trace_startmins, trace_endmins;
-static vec3_t trace_startmaxs, trace_endmaxs;
-static vec3_t trace_absmins, trace_absmaxs;
-static vec3_t trace_extents;
+/*
+* CM_NewTraceContext
+*
+* Traces running at the same time, from different threads, need contexts of their own.
+* The context must be freed before the collision model state.
+*/
+cmtrace_ctx_t *CM_NewTraceContext( cmodel_state_t *cms )
+{
+	cmtrace_ctx_t *ctx;
+
+	ctx = ( cmtrace_ctx_t * )Mem_Alloc( cms->mempool, sizeof( *ctx ) );
+	ctx->cms = cms;
+	return ctx;
+}
+
+/*
+* CM_ClearTraceContext
+*/
+void CM_ClearTraceContext( cmtrace_ctx_t *ctx )
+{
+	if( ctx->brushstamps )
+		Mem_Free( ctx->brushstamps );
+	if( ctx->facestamps )
+		Mem_Free( ctx->facestamps );
+	ctx->brushstamps = ctx->facestamps = NULL;
+	ctx->numbrushstamps = ctx->numfacestamps = 0;
+	ctx->generation = 0;
+}
+
+/*
+* CM_FreeTraceContext
+*/
+void CM_FreeTraceContext( cmtrace_ctx_t *ctx )
+{
+	if( !ctx )
+		return;
+
+	CM_ClearTraceContext( ctx );
+	Mem_Free( ctx );
+}
 
-static trace_t	*trace_trace;
+/*
+* CM_BeginTrace
+*
+* Starts a new generation of the visited sets, sizing them for the loaded map
+*/
+static void CM_BeginTrace( cmtrace_ctx_t *ctx )
+{
+	cmodel_state_t *cms = ctx->cms;
+
+	if( ctx->numbrushstamps != cms->numbrushes || ctx->numfacestamps != cms->numfaces )
+	{
+		CM_ClearTraceContext( ctx );
+		if( cms->numbrushes )
+			ctx->brushstamps = ( unsigned int * )Mem_Alloc( cms->mempool, sizeof( *ctx->brushstamps ) * cms->numbrushes );
+		if( cms->numfaces )
+			ctx->facestamps = ( unsigned int * )Mem_Alloc( cms->mempool, sizeof( *ctx->facestamps ) * cms->numfaces );
+		ctx->numbrushstamps = cms->numbrushes;
+		ctx->numfacestamps = cms->numfaces;
+	}
+
+	if( !++ctx->generation )
+	{
+		// wrapped around, the old stamps could match again
+		if( ctx->brushstamps )
+			memset( ctx->brushstamps, 0, sizeof( *ctx->brushstamps ) * ctx->numbrushstamps );
+		if( ctx->facestamps )
+			memset( ctx->facestamps, 0, sizeof( *ctx->facestamps ) * ctx->numfacestamps );
+		ctx->generation = 1;
+	}
+}
+
+/*
+* CM_Visited
+*
+* Marks the brush or patch as checked by this trace, returns true if it already was.
+* Builtin hulls are outside the map arrays, and have a single brush each. The range
+* check is done on the byte offset because subtracting pointers into different
+* objects is undefined, and the optimizer is free to produce any index from it.
+*/
+static inline bool CM_Visited( unsigned int *stamps, int numstamps, const void *base, const void *p, size_t size,
+							  unsigned int generation )
+{
+	size_t offset = (uintptr_t)p - (uintptr_t)base;
+	size_t index;
+
+	if( offset >= (size_t)numstamps * size )
+		return false;
+
+	index = offset / size;
+	if( stamps[index] == generation )
+		return true;
+	stamps[index] = generation;
+	return false;
+}
+
+/*
+* brush clipping state shared by the scalar and SIMD kernels
+*/
+typedef struct
+{
+	float enterfrac, leavefrac;
 #ifdef TRACEVICFIX
-static float trace_realfraction;
+	float enterdist, move;
 #endif
-static int trace_contents;
-static bool trace_ispoint;      // optimized case
+	cplane_t *clipplane;
+	cbrushside_t *leadside;
+} cm_brushclip_t;
 
 /*
-* CM_ClipBoxToBrush
+* CM_BeginBrushClip
 */
-static void CM_ClipBoxToBrush( cmodel_state_t *cms, cbrush_t *brush )
+static inline void CM_BeginBrushClip( cm_brushclip_t *clip )
 {
-	int i;
-	cplane_t *p, *clipplane;
-	float enterfrac, leavefrac;
+	clip->enterfrac = -1;
+	clip->leavefrac = 1;
 #ifdef TRACEVICFIX
-	float enterdist = 0, move = 1;
+	clip->enterdist = 0;
+	clip->move = 1;
 #endif
-	float d1, d2, f;
+	clip->clipplane = NULL;
+	clip->leadside = NULL;
+}
+
+/*
+* CM_ClipBoxToSide
+*
+* Moves the enter and leave fractions for a side the box crosses
+*/
+static inline void CM_ClipBoxToSide( cm_brushclip_t *clip, cbrushside_t *side, float d1, float d2 )
+{
+	float f;
+
+#ifdef TRACEVICFIX
+	// crosses face
+	f = d1 - d2;
+	if( f > 0 )
+	{                   // enter
+		f = d1 / f;
+		if( f > clip->enterfrac )
+		{
+			clip->enterdist = d1;
+			clip->move = d1 - d2;
+			clip->enterfrac = f;
+			clip->clipplane = side->plane;
+			clip->leadside = side;
+		}
+	}
+	else if( f < 0 )
+	{                   // leave
+		f = d1 / f;
+		if( f < clip->leavefrac )
+			clip->leavefrac = f;
+	}
+#else
+	// crosses face
+	f = d1 - d2;
+	if( f > 0 )
+	{               // enter
+		f = ( d1 - DIST_EPSILON ) / f;
+		if( f > clip->enterfrac )
+		{
+			clip->enterfrac = f;
+			clip->clipplane = side->plane;
+			clip->leadside = side;
+		}
+	}
+	else if( f < 0 )
+	{               // leave
+		f = ( d1 + DIST_EPSILON ) / f;
+		if( f < clip->leavefrac )
+			clip->leavefrac = f;
+	}
+#endif
+}
+
+/*
+* CM_EndBrushClip
+*/
+static inline void CM_EndBrushClip( cmtrace_ctx_t *ctx, cbrush_t *brush, cm_brushclip_t *clip, bool startout, bool getout )
+{
+	if( !startout )
+	{
+		// original point was inside brush
+		ctx->trace->startsolid = true;
+		ctx->trace->contents = brush->contents;
+		if( !getout )
+		{
+			ctx->trace->allsolid = true;
+			ctx->trace->fraction = 0;
+		}
+		return;
+	}
+#ifdef TRACEVICFIX
+	if( clip->enterfrac - FRAC_EPSILON <= clip->leavefrac )
+	{
+		if( clip->enterfrac > -1 && clip->enterfrac < ctx->realfraction )
+		{
+			if( clip->enterfrac < 0 )
+				clip->enterfrac = 0;
+			ctx->realfraction = clip->enterfrac;
+			ctx->trace->plane = *clip->clipplane;
+			ctx->trace->surfFlags = clip->leadside->surfFlags;
+			ctx->trace->contents = brush->contents;
+			ctx->trace->fraction = ( clip->enterdist - DIST_EPSILON ) / clip->move;
+			if( ctx->trace->fraction < 0 )
+				ctx->trace->fraction = 0;
+		}
+	}
+#else
+	if( clip->enterfrac - FRAC_EPSILON <= clip->leavefrac )
+	{
+		if( clip->enterfrac > -1 && clip->enterfrac < ctx->trace->fraction )
+		{
+			if( clip->enterfrac < 0 )
+				clip->enterfrac = 0;
+			ctx->trace->fraction = clip->enterfrac;
+			ctx->trace->plane = *clip->clipplane;
+			ctx->trace->surfFlags = clip->leadside->surfFlags;
+			ctx->trace->contents = brush->contents;
+		}
+	}
+#endif
+}
+
+/*
+* CM_ClipBoxToBrush
+*/
+static void CM_ClipBoxToBrush( cmtrace_ctx_t *ctx, cbrush_t *brush )
+{
+	int i;
+	cplane_t *p;
+	float d1, d2;
 	bool getout, startout;
-	cbrushside_t *side, *leadside;
+	cbrushside_t *side;
+	cm_brushclip_t clip;
 
 	if( !brush->numsides )
 		return;
 
-	enterfrac = -1;
-	leavefrac = 1;
-	clipplane = NULL;
-
 	c_brush_traces++;
 
+	CM_BeginBrushClip( &clip );
 	getout = false;
 	startout = false;
-	leadside = NULL;
 	side = brush->brushsides;
 
 	for( i = 0; i < brush->numsides; i++, side++ )
@@ -538,44 +773,44 @@ static void CM_ClipBoxToBrush( cmodel_state_t *cms, cbrush_t *brush )
 		// push the plane out apropriately for mins/maxs
 		if( p->type < 3 )
 		{
-			d1 = trace_startmins[p->type] - p->dist;
-			d2 = trace_endmins[p->type] - p->dist;
+			d1 = ctx->startmins[p->type] - p->dist;
+			d2 = ctx->endmins[p->type] - p->dist;
 		}
 		else
 		{
 			switch( p->signbits )
 			{
 			case 0:
-				d1 = p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmins[2] - p->dist;
-				d2 = p->normal[0]*trace_endmins[0] + p->normal[1]*trace_endmins[1] + p->normal[2]*trace_endmins[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmins[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmins[0] + p->normal[1]*ctx->endmins[1] + p->normal[2]*ctx->endmins[2] - p->dist;
 				break;
 			case 1:
-				d1 = p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmins[2] - p->dist;
-				d2 = p->normal[0]*trace_endmaxs[0] + p->normal[1]*trace_endmins[1] + p->normal[2]*trace_endmins[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmins[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmaxs[0] + p->normal[1]*ctx->endmins[1] + p->normal[2]*ctx->endmins[2] - p->dist;
 				break;
 			case 2:
-				d1 = p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmins[2] - p->dist;
-				d2 = p->normal[0]*trace_endmins[0] + p->normal[1]*trace_endmaxs[1] + p->normal[2]*trace_endmins[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmins[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmins[0] + p->normal[1]*ctx->endmaxs[1] + p->normal[2]*ctx->endmins[2] - p->dist;
 				break;
 			case 3:
-				d1 = p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmins[2] - p->dist;
-				d2 = p->normal[0]*trace_endmaxs[0] + p->normal[1]*trace_endmaxs[1] + p->normal[2]*trace_endmins[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmins[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmaxs[0] + p->normal[1]*ctx->endmaxs[1] + p->normal[2]*ctx->endmins[2] - p->dist;
 				break;
 			case 4:
-				d1 = p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmaxs[2] - p->dist;
-				d2 = p->normal[0]*trace_endmins[0] + p->normal[1]*trace_endmins[1] + p->normal[2]*trace_endmaxs[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmaxs[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmins[0] + p->normal[1]*ctx->endmins[1] + p->normal[2]*ctx->endmaxs[2] - p->dist;
 				break;
 			case 5:
-				d1 = p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmaxs[2] - p->dist;
-				d2 = p->normal[0]*trace_endmaxs[0] + p->normal[1]*trace_endmins[1] + p->normal[2]*trace_endmaxs[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmaxs[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmaxs[0] + p->normal[1]*ctx->endmins[1] + p->normal[2]*ctx->endmaxs[2] - p->dist;
 				break;
 			case 6:
-				d1 = p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmaxs[2] - p->dist;
-				d2 = p->normal[0]*trace_endmins[0] + p->normal[1]*trace_endmaxs[1] + p->normal[2]*trace_endmaxs[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmaxs[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmins[0] + p->normal[1]*ctx->endmaxs[1] + p->normal[2]*ctx->endmaxs[2] - p->dist;
 				break;
 			case 7:
-				d1 = p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmaxs[2] - p->dist;
-				d2 = p->normal[0]*trace_endmaxs[0] + p->normal[1]*trace_endmaxs[1] + p->normal[2]*trace_endmaxs[2] - p->dist;
+				d1 = p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmaxs[2] - p->dist;
+				d2 = p->normal[0]*ctx->endmaxs[0] + p->normal[1]*ctx->endmaxs[1] + p->normal[2]*ctx->endmaxs[2] - p->dist;
 				break;
 			default:
 				d1 = d2 = 0; // shut up compiler
@@ -594,97 +829,16 @@ static void CM_ClipBoxToBrush( cmodel_state_t *cms, cbrush_t *brush )
 			return;
 		if( d1 <= 0 && d2 <= 0 )
 			continue;
-#ifdef TRACEVICFIX
-		// crosses face
-		f = d1 - d2;
-		if( f > 0 )
-		{                   // enter
-			f = d1 / f;
-			if( f > enterfrac )
-			{
-				enterdist = d1;
-				move = d1 - d2;
-				enterfrac = f;
-				clipplane = p;
-				leadside = side;
-			}
-		}
-		else if( f < 0 )
-		{                   // leave
-			f = d1 / f;
-			if( f < leavefrac )
-				leavefrac = f;
-		}
-#else
-		// crosses face
-		f = d1 - d2;
-		if( f > 0 )
-		{               // enter
-			f = ( d1 - DIST_EPSILON ) / f;
-			if( f > enterfrac )
-			{
-				enterfrac = f;
-				clipplane = p;
-				leadside = side;
-			}
-		}
-		else if( f < 0 )
-		{               // leave
-			f = ( d1 + DIST_EPSILON ) / f;
-			if( f < leavefrac )
-				leavefrac = f;
-		}
-#endif
+		CM_ClipBoxToSide( &clip, side, d1, d2 );
 	}
 
-	if( !startout )
-	{
-		// original point was inside brush
-		trace_trace->startsolid = true;
-		trace_trace->contents = brush->contents;
-		if( !getout )
-		{
-			trace_trace->allsolid = true;
-			trace_trace->fraction = 0;
-		}
-		return;
-	}
-#ifdef TRACEVICFIX
-	if( enterfrac - FRAC_EPSILON <= leavefrac )
-	{
-		if( enterfrac > -1 && enterfrac < trace_realfraction )
-		{
-			if( enterfrac < 0 )
-				enterfrac = 0;
-			trace_realfraction = enterfrac;
-			trace_trace->plane = *clipplane;
-			trace_trace->surfFlags = leadside->surfFlags;
-			trace_trace->contents = brush->contents;
-			trace_trace->fraction = ( enterdist - DIST_EPSILON ) / move;
-			if( trace_trace->fraction < 0 )
-				trace_trace->fraction = 0;
-		}
-	}
-#else
-	if( enterfrac - ( 1.0f / 1024.0f ) <= leavefrac )
-	{
-		if( enterfrac > -1 && enterfrac < trace_trace->fraction )
-		{
-			if( enterfrac < 0 )
-				enterfrac = 0;
-			trace_trace->fraction = enterfrac;
-			trace_trace->plane = *clipplane;
-			trace_trace->surfFlags = leadside->surfFlags;
-			trace_trace->contents = brush->contents;
-		}
-	}
-#endif
+	CM_EndBrushClip( ctx, brush, &clip, startout, getout );
 }
 
 /*
 * CM_TestBoxInBrush
 */
-static void CM_TestBoxInBrush( cmodel_state_t *cms, cbrush_t *brush )
+static void CM_TestBoxInBrush( cmtrace_ctx_t *ctx, cbrush_t *brush )
 {
 	int i;
 	cplane_t *p;
@@ -702,7 +856,7 @@ static void CM_TestBoxInBrush( cmodel_state_t *cms, cbrush_t *brush )
 		// if completely in front of face, no intersection
 		if( p->type < 3 )
 		{
-			if( trace_startmins[p->type] > p->dist )
+			if( ctx->startmins[p->type] > p->dist )
 				return;
 		}
 		else
@@ -710,35 +864,35 @@ static void CM_TestBoxInBrush( cmodel_state_t *cms, cbrush_t *brush )
 			switch( p->signbits )
 			{
 			case 0:
-				if( p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmins[2] > p->dist )
+				if( p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmins[2] > p->dist )
 					return;
 				break;
 			case 1:
-				if( p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmins[2] > p->dist )
+				if( p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmins[2] > p->dist )
 					return;
 				break;
 			case 2:
-				if( p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmins[2] > p->dist )
+				if( p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmins[2] > p->dist )
 					return;
 				break;
 			case 3:
-				if( p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmins[2] > p->dist )
+				if( p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmins[2] > p->dist )
 					return;
 				break;
 			case 4:
-				if( p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmaxs[2] > p->dist )
+				if( p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmaxs[2] > p->dist )
 					return;
 				break;
 			case 5:
-				if( p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmins[1] + p->normal[2]*trace_startmaxs[2] > p->dist )
+				if( p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmins[1] + p->normal[2]*ctx->startmaxs[2] > p->dist )
 					return;
 				break;
 			case 6:
-				if( p->normal[0]*trace_startmins[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmaxs[2] > p->dist )
+				if( p->normal[0]*ctx->startmins[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmaxs[2] > p->dist )
 					return;
 				break;
 			case 7:
-				if( p->normal[0]*trace_startmaxs[0] + p->normal[1]*trace_startmaxs[1] + p->normal[2]*trace_startmaxs[2] > p->dist )
+				if( p->normal[0]*ctx->startmaxs[0] + p->normal[1]*ctx->startmaxs[1] + p->normal[2]*ctx->startmaxs[2] > p->dist )
 					return;
 				break;
 			default:
@@ -749,33 +903,317 @@ static void CM_TestBoxInBrush( cmodel_state_t *cms, cbrush_t *brush )
 	}
 
 	// inside this brush
-	trace_trace->startsolid = trace_trace->allsolid = true;
-	trace_trace->fraction = 0;
-	trace_trace->contents = brush->contents;
+	ctx->trace->startsolid = ctx->trace->allsolid = true;
+	ctx->trace->fraction = 0;
+	ctx->trace->contents = brush->contents;
 }
 
 /*
-* CM_CollideBox
+===============================================================================
+
+SIMD BRUSH CLIPPING
+
+Brush planes are also stored as quads, four planes per group, so that
+the box can be pushed against four planes at once. The distances are summed
+in the same order as in the scalar kernels, the per side bookkeeping is shared.
+
+===============================================================================
 */
-static void CM_CollideBox( cmodel_state_t *cms, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
-						  int nummarkfaces, void ( *func )( cmodel_state_t *cms, cbrush_t *b ) )
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define CM_SIMD_SSE
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define CM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+static cvar_t *cm_noSIMD;
+static bool cm_simdAvailable;
+
+/*
+* CM_BuildPlaneQuads
+*/
+void CM_BuildPlaneQuads( cbrush_t *brush, cplanequad_t *quads )
 {
 	int i, j;
+	cplane_t *p;
+
+	for( i = 0; i < CM_NumPlaneQuads( brush->numsides ) * 4; i++ )
+	{
+		cplanequad_t *q = &quads[i >> 2];
+
+		if( i >= brush->numsides )
+		{
+			for( j = 0; j < 3; j++ )
+				q->normal[j][i & 3] = 0;
+			q->dist[i & 3] = 1.0e30f;
+			continue;
+		}
+
+		p = brush->brushsides[i].plane;
+		for( j = 0; j < 3; j++ )
+			q->normal[j][i & 3] = p->normal[j];
+		q->dist[i & 3] = p->dist;
+	}
+}
+
+#if defined( CM_SIMD_SSE ) || defined( CM_SIMD_NEON )
+
+#ifdef CM_SIMD_SSE
+typedef __m128 cm_simd_t;
+
+#define CM_SIMD_Load( p )			_mm_loadu_ps( p )
+#define CM_SIMD_Set( f )			_mm_set1_ps( f )
+#define CM_SIMD_Zero()				_mm_setzero_ps()
+#define CM_SIMD_Add( a, b )			_mm_add_ps( a, b )
+#define CM_SIMD_Sub( a, b )			_mm_sub_ps( a, b )
+#define CM_SIMD_Mul( a, b )			_mm_mul_ps( a, b )
+#define CM_SIMD_Store( p, a )		_mm_storeu_ps( p, a )
+#define CM_SIMD_Greater( a, b )		_mm_movemask_ps( _mm_cmpgt_ps( a, b ) )
+#define CM_SIMD_GreaterEqual( a, b ) _mm_movemask_ps( _mm_cmpge_ps( a, b ) )
+
+static inline cm_simd_t CM_SIMD_Select( cm_simd_t n, cm_simd_t neg, cm_simd_t pos )
+{
+	cm_simd_t mask = _mm_cmplt_ps( n, _mm_setzero_ps() );
+	return _mm_or_ps( _mm_and_ps( mask, neg ), _mm_andnot_ps( mask, pos ) );
+}
+#else
+typedef float32x4_t cm_simd_t;
+
+#define CM_SIMD_Load( p )			vld1q_f32( p )
+#define CM_SIMD_Set( f )			vdupq_n_f32( f )
+#define CM_SIMD_Zero()				vdupq_n_f32( 0 )
+#define CM_SIMD_Add( a, b )			vaddq_f32( a, b )
+#define CM_SIMD_Sub( a, b )			vsubq_f32( a, b )
+#define CM_SIMD_Mul( a, b )			vmulq_f32( a, b )
+#define CM_SIMD_Store( p, a )		vst1q_f32( p, a )
+#define CM_SIMD_Greater( a, b )		CM_SIMD_MoveMask( vcgtq_f32( a, b ) )
+#define CM_SIMD_GreaterEqual( a, b ) CM_SIMD_MoveMask( vcgeq_f32( a, b ) )
+
+static inline int CM_SIMD_MoveMask( uint32x4_t mask )
+{
+	static const uint32_t bits[4] = { 1, 2, 4, 8 };
+	uint32x4_t m = vandq_u32( mask, vld1q_u32( bits ) );
+	uint32x2_t t = vorr_u32( vget_low_u32( m ), vget_high_u32( m ) );
+	return vget_lane_u32( t, 0 ) | vget_lane_u32( t, 1 );
+}
+
+static inline cm_simd_t CM_SIMD_Select( cm_simd_t n, cm_simd_t neg, cm_simd_t pos )
+{
+	return vbslq_f32( vcltq_f32( n, vdupq_n_f32( 0 ) ), neg, pos );
+}
+#endif
+
+// box corners, broadcast per axis
+typedef struct
+{
+	cm_simd_t mins[3], maxs[3];
+} cm_simdbox_t;
+
+/*
+* CM_SIMD_SetBox
+*/
+static inline void CM_SIMD_SetBox( cm_simdbox_t *box, const vec3_t mins, const vec3_t maxs )
+{
+	int i;
+
+	for( i = 0; i < 3; i++ )
+	{
+		box->mins[i] = CM_SIMD_Set( mins[i] );
+		box->maxs[i] = CM_SIMD_Set( maxs[i] );
+	}
+}
+
+/*
+* CM_SIMD_PlaneQuadDot
+*
+* Dot products of the plane normals with the box corner nearest to each plane
+*/
+static inline cm_simd_t CM_SIMD_PlaneQuadDot( const cplanequad_t *q, const cm_simdbox_t *box )
+{
+	cm_simd_t n0, n1, n2;
+
+	n0 = CM_SIMD_Load( q->normal[0] );
+	n1 = CM_SIMD_Load( q->normal[1] );
+	n2 = CM_SIMD_Load( q->normal[2] );
+
+	return CM_SIMD_Add( CM_SIMD_Add(
+		CM_SIMD_Mul( n0, CM_SIMD_Select( n0, box->maxs[0], box->mins[0] ) ),
+		CM_SIMD_Mul( n1, CM_SIMD_Select( n1, box->maxs[1], box->mins[1] ) ) ),
+		CM_SIMD_Mul( n2, CM_SIMD_Select( n2, box->maxs[2], box->mins[2] ) ) );
+}
+
+/*
+* CM_ClipBoxToBrush_SIMD
+*/
+static void CM_ClipBoxToBrush_SIMD( cmtrace_ctx_t *ctx, cbrush_t *brush )
+{
+	int i, j, out1, out2, cross;
+	bool getout, startout;
+	float d1[4], d2[4];
+	cm_simd_t v1, v2, dist;
+	cm_simdbox_t startbox, endbox;
+	const cplanequad_t *q;
+	cm_brushclip_t clip;
+
+	if( !brush->numsides )
+		return;
+
+	c_brush_traces++;
+
+	CM_SIMD_SetBox( &startbox, ctx->startmins, ctx->startmaxs );
+	CM_SIMD_SetBox( &endbox, ctx->endmins, ctx->endmaxs );
+
+	CM_BeginBrushClip( &clip );
+	getout = false;
+	startout = false;
+
+	for( i = 0, q = brush->planequads; i < brush->numsides; i += 4, q++ )
+	{
+		dist = CM_SIMD_Load( q->dist );
+		v1 = CM_SIMD_Sub( CM_SIMD_PlaneQuadDot( q, &startbox ), dist );
+		v2 = CM_SIMD_Sub( CM_SIMD_PlaneQuadDot( q, &endbox ), dist );
+
+		out1 = CM_SIMD_Greater( v1, CM_SIMD_Zero() );
+		out2 = CM_SIMD_Greater( v2, CM_SIMD_Zero() );
+
+		// if completely in front of any face, no intersection
+		if( out1 & CM_SIMD_GreaterEqual( v2, v1 ) )
+			return;
+
+		if( out2 )
+			getout = true; // endpoint is not in solid
+		if( out1 )
+			startout = true;
+
+		cross = out1 | out2;
+		if( !cross )
+			continue;
+
+		CM_SIMD_Store( d1, v1 );
+		CM_SIMD_Store( d2, v2 );
+		for( j = 0; j < 4; j++ )
+		{
+			if( cross & ( 1 << j ) )
+				CM_ClipBoxToSide( &clip, brush->brushsides + i + j, d1[j], d2[j] );
+		}
+	}
+
+	CM_EndBrushClip( ctx, brush, &clip, startout, getout );
+}
+
+/*
+* CM_TestBoxInBrush_SIMD
+*/
+static void CM_TestBoxInBrush_SIMD( cmtrace_ctx_t *ctx, cbrush_t *brush )
+{
+	int i;
+	cm_simdbox_t startbox;
+	const cplanequad_t *q;
+
+	if( !brush->numsides )
+		return;
+
+	CM_SIMD_SetBox( &startbox, ctx->startmins, ctx->startmaxs );
+
+	// if completely in front of any face, no intersection
+	for( i = 0, q = brush->planequads; i < brush->numsides; i += 4, q++ )
+	{
+		if( CM_SIMD_Greater( CM_SIMD_PlaneQuadDot( q, &startbox ), CM_SIMD_Load( q->dist ) ) )
+			return;
+	}
+
+	// inside this brush
+	ctx->trace->startsolid = ctx->trace->allsolid = true;
+	ctx->trace->fraction = 0;
+	ctx->trace->contents = brush->contents;
+}
+
+#endif
+
+/*
+* CM_InitTraceKernels
+*/
+void CM_InitTraceKernels( void )
+{
+	cm_noSIMD = Cvar_Get( "cm_noSIMD", "0", 0 );
+
+#if defined( CM_SIMD_SSE )
+	cm_simdAvailable = ( COM_CPUFeatures() & QCPU_HAS_SSE ) ? true : false;
+#elif defined( CM_SIMD_NEON )
+	cm_simdAvailable = true;
+#else
+	cm_simdAvailable = false;
+#endif
+}
+
+/*
+* CM_TraceCrossesBounds
+*
+* Tests whether the box sweeping from start to end touches the bounds anywhere
+* along the way, which is much tighter than checking the bounds of the whole move.
+* Brush clipping accepts an enter fraction up to FRAC_EPSILON past the leave
+* fraction, so the same slack is allowed here
+*/
+static inline bool CM_TraceCrossesBounds( cmtrace_ctx_t *ctx, const vec3_t mins, const vec3_t maxs )
+{
+	int i;
+	float lo, hi, t1, t2, tmin = 0, tmax = 1;
+
+	for( i = 0; i < 3; i++ )
+	{
+		lo = mins[i] - ctx->maxs[i];
+		hi = maxs[i] - ctx->mins[i];
+
+		if( !ctx->invdir[i] )
+		{
+			if( ctx->start[i] < lo || ctx->start[i] > hi )
+				return false;
+			continue;
+		}
+
+		t1 = ( lo - ctx->start[i] ) * ctx->invdir[i];
+		t2 = ( hi - ctx->start[i] ) * ctx->invdir[i];
+		if( t1 > t2 )
+		{
+			float t = t1; t1 = t2; t2 = t;
+		}
+
+		if( t1 > tmin )
+			tmin = t1;
+		if( t2 < tmax )
+			tmax = t2;
+		if( tmin - FRAC_EPSILON > tmax )
+			return false;
+	}
+
+	return true;
+}
+
+/*
+* CM_CollideBox
+*/
+static void CM_CollideBox( cmtrace_ctx_t *ctx, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
+						  int nummarkfaces, void ( *func )( cmtrace_ctx_t *ctx, cbrush_t *b ) )
+{
+	int i, j, k;
+	cmodel_state_t *cms = ctx->cms;
 	cbrush_t *b;
 	cface_t	*patch;
+	cfacetnode_t *node;
 	cbrush_t *facet;
 
 	// trace line against all brushes
 	for( i = 0; i < nummarkbrushes; i++ )
 	{
 		b = markbrushes[i];
-		if( b->checkcount == cms->checkcount )
+		if( CM_Visited( ctx->brushstamps, ctx->numbrushstamps, cms->map_brushes, b, sizeof( *b ), ctx->generation ) )
 			continue; // already checked this brush
-		b->checkcount = cms->checkcount;
-		if( !( b->contents & trace_contents ) )
+		if( !( b->contents & ctx->contents ) )
 			continue;
-		func( cms, b );
-		if( !trace_trace->fraction )
+		func( ctx, b );
+		if( !ctx->trace->fraction )
 			return;
 	}
 
@@ -786,19 +1224,30 @@ static void CM_CollideBox( cmodel_state_t *cms, cbrush_t **markbrushes, int numm
 	for( i = 0; i < nummarkfaces; i++ )
 	{
 		patch = markfaces[i];
-		if( patch->checkcount == cms->checkcount )
+		if( CM_Visited( ctx->facestamps, ctx->numfacestamps, cms->map_faces, patch, sizeof( *patch ), ctx->generation ) )
 			continue; // already checked this patch
-		patch->checkcount = cms->checkcount;
-		if( !( patch->contents & trace_contents ) )
+		if( !( patch->contents & ctx->contents ) )
 			continue;
-		if( !BoundsIntersect( patch->mins, patch->maxs, trace_absmins, trace_absmaxs ) )
+		if( !BoundsIntersect( patch->mins, patch->maxs, ctx->absmins, ctx->absmaxs ) )
 			continue;
-		facet = patch->facets;
-		for( j = 0; j < patch->numfacets; j++, facet++ )
+
+		// walk the facet tree, only testing facets whose node is crossed by the move
+		for( j = 0; j < patch->numnodes; )
 		{
-			func( cms, facet );
-			if( !trace_trace->fraction )
-				return;
+			node = &patch->nodes[j];
+			if( !CM_TraceCrossesBounds( ctx, node->mins, node->maxs ) )
+			{
+				j = node->skip;
+				continue;
+			}
+
+			for( k = 0, facet = patch->facets + node->firstfacet; k < node->numfacets; k++, facet++ )
+			{
+				func( ctx, facet );
+				if( !ctx->trace->fraction )
+					return;
+			}
+			j++;
 		}
 	}
 }
@@ -806,26 +1255,41 @@ static void CM_CollideBox( cmodel_state_t *cms, cbrush_t **markbrushes, int numm
 /*
 * CM_ClipBox
 */
-static inline void CM_ClipBox( cmodel_state_t *cms, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
+static inline void CM_ClipBox( cmtrace_ctx_t *ctx, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
 							  int nummarkfaces )
 {
-	CM_CollideBox( cms, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_ClipBoxToBrush );
+#if defined( CM_SIMD_SSE ) || defined( CM_SIMD_NEON )
+	if( ctx->simd )
+	{
+		CM_CollideBox( ctx, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_ClipBoxToBrush_SIMD );
+		return;
+	}
+#endif
+	CM_CollideBox( ctx, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_ClipBoxToBrush );
 }
 
 /*
 * CM_TestBox
 */
-static inline void CM_TestBox( cmodel_state_t *cms, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
+static inline void CM_TestBox( cmtrace_ctx_t *ctx, cbrush_t **markbrushes, int nummarkbrushes, cface_t **markfaces,
 							  int nummarkfaces )
 {
-	CM_CollideBox( cms, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_TestBoxInBrush );
+#if defined( CM_SIMD_SSE ) || defined( CM_SIMD_NEON )
+	if( ctx->simd )
+	{
+		CM_CollideBox( ctx, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_TestBoxInBrush_SIMD );
+		return;
+	}
+#endif
+	CM_CollideBox( ctx, markbrushes, nummarkbrushes, markfaces, nummarkfaces, CM_TestBoxInBrush );
 }
 
 /*
 * CM_RecursiveHullCheck
 */
-static void CM_RecursiveHullCheck( cmodel_state_t *cms, int num, float p1f, float p2f, vec3_t p1, vec3_t p2 )
+static void CM_RecursiveHullCheck( cmtrace_ctx_t *ctx, int num, float p1f, float p2f, vec3_t p1, vec3_t p2 )
 {
+	cmodel_state_t *cms = ctx->cms;
 	cnode_t	*node;
 	cplane_t *plane;
 	int side;
@@ -836,10 +1300,10 @@ static void CM_RecursiveHullCheck( cmodel_state_t *cms, int num, float p1f, floa
 
 loc0:
 #ifdef TRACEVICFIX
-	if( trace_realfraction <= p1f )
+	if( ctx->realfraction <= p1f )
 		return; // already hit something nearer
 #else
-	if( trace_trace->fraction <= p1f )
+	if( ctx->trace->fraction <= p1f )
 		return; // already hit something nearer
 #endif
 	// if < 0, we are in a leaf node
@@ -848,8 +1312,8 @@ loc0:
 		cleaf_t	*leaf;
 
 		leaf = &cms->map_leafs[-1 - num];
-		if( leaf->contents & trace_contents )
-			CM_ClipBox( cms, leaf->markbrushes, leaf->nummarkbrushes, leaf->markfaces, leaf->nummarkfaces );
+		if( leaf->contents & ctx->contents )
+			CM_ClipBox( ctx, leaf->markbrushes, leaf->nummarkbrushes, leaf->markfaces, leaf->nummarkfaces );
 		return;
 	}
 
@@ -864,18 +1328,18 @@ loc0:
 	{
 		t1 = p1[plane->type] - plane->dist;
 		t2 = p2[plane->type] - plane->dist;
-		offset = trace_extents[plane->type];
+		offset = ctx->extents[plane->type];
 	}
 	else
 	{
 		t1 = DotProduct( plane->normal, p1 ) - plane->dist;
 		t2 = DotProduct( plane->normal, p2 ) - plane->dist;
-		if( trace_ispoint )
+		if( ctx->ispoint )
 			offset = 0;
 		else
-			offset = fabs( trace_extents[0] * plane->normal[0] ) +
-			fabs( trace_extents[1] * plane->normal[1] ) +
-			fabs( trace_extents[2] * plane->normal[2] );
+			offset = fabs( ctx->extents[0] * plane->normal[0] ) +
+			fabs( ctx->extents[1] * plane->normal[1] ) +
+			fabs( ctx->extents[2] * plane->normal[2] );
 	}
 
 	// see which sides we need to consider
@@ -927,14 +1391,14 @@ loc0:
 	midf = p1f + ( p2f - p1f ) * frac;
 	VectorLerp( p1, frac, p2, mid );
 
-	CM_RecursiveHullCheck( cms, node->children[side], p1f, midf, p1, mid );
+	CM_RecursiveHullCheck( ctx, node->children[side], p1f, midf, p1, mid );
 
 	// go past the node
 	clamp( frac2, 0, 1 );
 	midf = p1f + ( p2f - p1f ) * frac2;
 	VectorLerp( p1, frac2, p2, mid );
 
-	CM_RecursiveHullCheck( cms, node->children[side^1], midf, p2f, mid, p2 );
+	CM_RecursiveHullCheck( ctx, node->children[side^1], midf, p2f, mid, p2 );
 }
 
 //======================================================================
@@ -942,47 +1406,54 @@ loc0:
 /*
 * CM_BoxTrace
 */
-static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
+static void CM_BoxTrace( cmtrace_ctx_t *ctx, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
 						cmodel_t *cmodel, vec3_t origin, int brushmask )
 {
+	int i;
 	bool notworld;
+	cmodel_state_t *cms = ctx->cms;
 
 	notworld = ( cmodel != cms->map_cmodels ? true : false );
 
-	cms->checkcount++;  // for multi-check avoidance
 	c_traces++;     // for statistics, may be zeroed
 
 	// fill in a default trace
 	memset( tr, 0, sizeof( *tr ) );
 #ifdef TRACEVICFIX
-	tr->fraction = trace_realfraction = 1;
+	tr->fraction = ctx->realfraction = 1;
 #else
 	tr->fraction = 1;
 #endif
 	if( !cms->numnodes )  // map not loaded
 		return;
 
-	trace_trace = tr;
-	trace_contents = brushmask;
-	VectorCopy( start, trace_start );
-	VectorCopy( end, trace_end );
-	VectorCopy( mins, trace_mins );
-	VectorCopy( maxs, trace_maxs );
+	CM_BeginTrace( ctx );  // for multi-check avoidance
+	ctx->simd = cm_simdAvailable && !cm_noSIMD->integer;
+
+	ctx->trace = tr;
+	ctx->contents = brushmask;
+	VectorCopy( start, ctx->start );
+	VectorCopy( end, ctx->end );
+	VectorCopy( mins, ctx->mins );
+	VectorCopy( maxs, ctx->maxs );
+
+	for( i = 0; i < 3; i++ )
+		ctx->invdir[i] = ( end[i] != start[i] ) ? 1.0f / ( end[i] - start[i] ) : 0;
 
 	// build a bounding box of the entire move
-	ClearBounds( trace_absmins, trace_absmaxs );
+	ClearBounds( ctx->absmins, ctx->absmaxs );
 
-	VectorAdd( start, trace_mins, trace_startmins );
-	AddPointToBounds( trace_startmins, trace_absmins, trace_absmaxs );
+	VectorAdd( start, ctx->mins, ctx->startmins );
+	AddPointToBounds( ctx->startmins, ctx->absmins, ctx->absmaxs );
 
-	VectorAdd( start, trace_maxs, trace_startmaxs );
-	AddPointToBounds( trace_startmaxs, trace_absmins, trace_absmaxs );
+	VectorAdd( start, ctx->maxs, ctx->startmaxs );
+	AddPointToBounds( ctx->startmaxs, ctx->absmins, ctx->absmaxs );
 
-	VectorAdd( end, trace_mins, trace_endmins );
-	AddPointToBounds( trace_endmins, trace_absmins, trace_absmaxs );
+	VectorAdd( end, ctx->mins, ctx->endmins );
+	AddPointToBounds( ctx->endmins, ctx->absmins, ctx->absmaxs );
 
-	VectorAdd( end, trace_maxs, trace_endmaxs );
-	AddPointToBounds( trace_endmaxs, trace_absmins, trace_absmaxs );
+	VectorAdd( end, ctx->maxs, ctx->endmaxs );
+	AddPointToBounds( ctx->endmaxs, ctx->absmins, ctx->absmaxs );
 
 	//
 	// check for position test special case
@@ -997,9 +1468,9 @@ static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t
 
 		if( notworld )
 		{
-			if( BoundsIntersect( cmodel->mins, cmodel->maxs, trace_absmins, trace_absmaxs ) )
+			if( BoundsIntersect( cmodel->mins, cmodel->maxs, ctx->absmins, ctx->absmaxs ) )
 			{
-				CM_TestBox( cms, cmodel->markbrushes, cmodel->nummarkbrushes, cmodel->markfaces, cmodel->nummarkfaces );
+				CM_TestBox( ctx, cmodel->markbrushes, cmodel->nummarkbrushes, cmodel->markfaces, cmodel->nummarkfaces );
 			}
 		}
 		else
@@ -1015,9 +1486,9 @@ static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t
 			{
 				leaf = &cms->map_leafs[leafs[i]];
 
-				if( leaf->contents & trace_contents )
+				if( leaf->contents & ctx->contents )
 				{
-					CM_TestBox( cms, leaf->markbrushes, leaf->nummarkbrushes, leaf->markfaces, leaf->nummarkfaces );
+					CM_TestBox( ctx, leaf->markbrushes, leaf->nummarkbrushes, leaf->markfaces, leaf->nummarkfaces );
 					if( tr->allsolid )
 						break;
 				}
@@ -1033,13 +1504,13 @@ static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t
 	//
 	if( VectorCompare( mins, vec3_origin ) && VectorCompare( maxs, vec3_origin ) )
 	{
-		trace_ispoint = true;
-		VectorClear( trace_extents );
+		ctx->ispoint = true;
+		VectorClear( ctx->extents );
 	}
 	else
 	{
-		trace_ispoint = false;
-		VectorSet( trace_extents,
+		ctx->ispoint = false;
+		VectorSet( ctx->extents,
 			-mins[0] > maxs[0] ? -mins[0] : maxs[0],
 			-mins[1] > maxs[1] ? -mins[1] : maxs[1],
 			-mins[2] > maxs[2] ? -mins[2] : maxs[2] );
@@ -1049,9 +1520,9 @@ static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t
 	// general sweeping through world
 	//
 	if( !notworld )
-		CM_RecursiveHullCheck( cms, 0, 0, 1, start, end );
-	else if( BoundsIntersect( cmodel->mins, cmodel->maxs, trace_absmins, trace_absmaxs ) )
-		CM_ClipBox( cms, cmodel->markbrushes, cmodel->nummarkbrushes, cmodel->markfaces, cmodel->nummarkfaces );
+		CM_RecursiveHullCheck( ctx, 0, 0, 1, start, end );
+	else if( BoundsIntersect( cmodel->mins, cmodel->maxs, ctx->absmins, ctx->absmaxs ) )
+		CM_ClipBox( ctx, cmodel->markbrushes, cmodel->nummarkbrushes, cmodel->markfaces, cmodel->nummarkfaces );
 
 #ifdef TRACEVICFIX
 	clamp( tr->fraction, 0, 1 );
@@ -1076,7 +1547,7 @@ static void CM_BoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t
 * Handles offseting and rotation of the end points for moving and
 * rotating entities
 */
-void CM_TransformedBoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
+void CM_TransformedBoxTrace( cmodel_state_t *cms, cmtrace_ctx_t *ctx, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
 							cmodel_t *cmodel, int brushmask, vec3_t origin, vec3_t angles )
 {
 	vec3_t start_l, end_l;
@@ -1150,7 +1621,7 @@ void CM_TransformedBoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec
 	}
 
 	// sweep the box through the model
-	CM_BoxTrace( cms, tr, start_l, end_l, mins, maxs, cmodel, origin, brushmask );
+	CM_BoxTrace( ctx ? ctx : &cms->trace_ctx, tr, start_l, end_l, mins, maxs, cmodel, origin, brushmask );
 
 	if( rotated && tr->fraction != 1.0 )
 	{
@@ -1174,3 +1645,180 @@ void CM_TransformedBoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec
 #endif
 	}
 }
+
+/*
+===============================================================================
+
+TRACE BENCHMARK
+
+===============================================================================
+*/
+
+#define TRACEBENCH_MAX_THREADS	32
+
+typedef struct
+{
+	vec3_t start, end;
+	vec3_t mins, maxs;
+} tracebench_trace_t;
+
+typedef struct
+{
+	cmodel_state_t *cms;
+	cmtrace_ctx_t *ctx;
+	const tracebench_trace_t *traces;
+	trace_t *results;
+	int numTraces;
+} tracebench_job_t;
+
+/*
+* CM_TraceBench_Job
+*/
+static void *CM_TraceBench_Job( void *param )
+{
+	int i;
+	tracebench_job_t *job = ( tracebench_job_t * )param;
+	const tracebench_trace_t *t;
+
+	for( i = 0, t = job->traces; i < job->numTraces; i++, t++ )
+		CM_TransformedBoxTrace( job->cms, job->ctx, &job->results[i], ( float * )t->start, ( float * )t->end,
+			( float * )t->mins, ( float * )t->maxs, NULL, MASK_PLAYERSOLID, NULL, NULL );
+
+	return NULL;
+}
+
+/*
+* CM_TraceBench_Compare
+*
+* Kernels built with different floating point rounding may differ in the last bits,
+* epsilon is the distance the end positions may be apart
+*/
+static int CM_TraceBench_Compare( const trace_t *res, const trace_t *reference, int numTraces, float epsilon )
+{
+	int i, mismatches;
+
+	for( i = 0, mismatches = 0; i < numTraces; i++, res++, reference++ )
+	{
+		if( res->allsolid != reference->allsolid || res->startsolid != reference->startsolid )
+			mismatches++;
+		else if( epsilon ? DistanceSquared( res->endpos, reference->endpos ) > epsilon * epsilon :
+			( res->fraction != reference->fraction || !VectorCompare( res->endpos, reference->endpos ) ) )
+			mismatches++;
+	}
+
+	return mismatches;
+}
+
+/*
+* CM_TraceBench
+*
+* The scalar clipping kernel on the main context gives the reference results.
+* The SIMD kernel must match them up to rounding. Every thread then runs the
+* same set of traces with a context of its own and the selected kernel,
+* and must match the main context exactly.
+*/
+void CM_TraceBench( cmodel_state_t *cms, int numThreads, int numTraces )
+{
+	int i, j, mismatches;
+	unsigned int seed;
+	uint64_t time;
+	tracebench_trace_t *traces, *t;
+	int noSIMD;
+	trace_t *reference, *results;
+	qthread_t *threads[TRACEBENCH_MAX_THREADS];
+	tracebench_job_t jobs[TRACEBENCH_MAX_THREADS];
+
+	clamp( numThreads, 1, TRACEBENCH_MAX_THREADS );
+	clamp_low( numTraces, 1 );
+
+	if( !cms->numnodes )
+	{
+		Com_Printf( "tracebench: no map loaded\n" );
+		return;
+	}
+
+	// random segments across the world, half of them points and half player sized boxes
+	traces = ( tracebench_trace_t * )Mem_Alloc( cms->mempool, sizeof( *traces ) * numTraces );
+	for( i = 0, t = traces, seed = 1; i < numTraces; i++, t++ )
+	{
+		for( j = 0; j < 3; j++ )
+		{
+			seed = seed * 1103515245 + 12345;
+			t->start[j] = cms->world_mins[j] + ( cms->world_maxs[j] - cms->world_mins[j] ) * ( ( seed >> 16 ) & 0x7fff ) / 32767.0f;
+			seed = seed * 1103515245 + 12345;
+			t->end[j] = cms->world_mins[j] + ( cms->world_maxs[j] - cms->world_mins[j] ) * ( ( seed >> 16 ) & 0x7fff ) / 32767.0f;
+		}
+		if( i & 1 )
+		{
+			VectorSet( t->mins, -16, -16, -24 );
+			VectorSet( t->maxs, 16, 16, 40 );
+		}
+	}
+
+	Com_Printf( "tracebench: %i threads, %i traces each\n", numThreads, numTraces );
+
+	// reference results from the main context
+	reference = ( trace_t * )Mem_Alloc( cms->mempool, sizeof( trace_t ) * numTraces );
+	results = ( trace_t * )Mem_Alloc( cms->mempool, sizeof( trace_t ) * numTraces );
+	jobs[0].cms = cms;
+	jobs[0].ctx = NULL;
+	jobs[0].traces = traces;
+	jobs[0].results = reference;
+	jobs[0].numTraces = numTraces;
+
+	noSIMD = cm_noSIMD->integer;
+	Cvar_ForceSet( cm_noSIMD->name, "1" );
+
+	time = Sys_Microseconds();
+	CM_TraceBench_Job( &jobs[0] );
+	time = Sys_Microseconds() - time;
+	Com_Printf( "%-30s %8.2fms, %6.1fns per trace\n", "scalar", time / 1000.0, time * 1000.0 / numTraces );
+
+	if( cm_simdAvailable )
+	{
+		Cvar_ForceSet( cm_noSIMD->name, "0" );
+		jobs[0].results = results;
+
+		time = Sys_Microseconds();
+		CM_TraceBench_Job( &jobs[0] );
+		time = Sys_Microseconds() - time;
+		Com_Printf( "%-30s %8.2fms, %6.1fns per trace, %i mismatches\n", "simd", time / 1000.0, time * 1000.0 / numTraces,
+			CM_TraceBench_Compare( results, reference, numTraces, 0.01f ) );
+	}
+
+	Cvar_ForceSet( cm_noSIMD->name, va( "%i", noSIMD ) );
+
+	for( i = 0; i < numThreads; i++ )
+	{
+		jobs[i] = jobs[0];
+		jobs[i].ctx = CM_NewTraceContext( cms );
+		jobs[i].results = ( trace_t * )Mem_Alloc( cms->mempool, sizeof( trace_t ) * numTraces );
+	}
+
+	time = Sys_Microseconds();
+
+	for( i = 1; i < numThreads; i++ )
+		threads[i] = QThread_Create( CM_TraceBench_Job, &jobs[i] );
+
+	CM_TraceBench_Job( &jobs[0] );
+	for( i = 1; i < numThreads; i++ )
+		QThread_Join( threads[i] );
+
+	time = Sys_Microseconds() - time;
+	Com_Printf( "%-30s %8.2fms, %6.1fns per trace\n", va( "%i threads", numThreads ), time / 1000.0,
+		time * 1000.0 / ( (double)numTraces * numThreads ) );
+
+	mismatches = 0;
+	for( i = 0; i < numThreads; i++ )
+	{
+		mismatches += CM_TraceBench_Compare( jobs[i].results, ( cm_simdAvailable && !noSIMD ) ? results : reference, numTraces, 0 );
+		Mem_Free( jobs[i].results );
+		CM_FreeTraceContext( jobs[i].ctx );
+	}
+
+	Com_Printf( "%i mismatches\n", mismatches );
+
+	Mem_Free( results );
+	Mem_Free( reference );
+	Mem_Free( traces );
+}
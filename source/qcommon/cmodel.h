@@ -19,6 +19,7 @@
  */
 
 typedef struct cmodel_state_s cmodel_state_t;
+typedef struct cmtrace_ctx_s cmtrace_ctx_t;
 
 extern cvar_t *cm_noCurves;
 
@@ -47,9 +48,16 @@ void CM_InlineModelBounds( cmodel_state_t *cms, struct cmodel_s *cmodel, vec3_t
 // returns an ORed contents mask
 int CM_TransformedPointContents( cmodel_state_t *cms, vec3_t p, struct cmodel_s *cmodel, vec3_t origin, vec3_t angles );
 
-void CM_TransformedBoxTrace( cmodel_state_t *cms, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
+// ctx may be NULL for traces from the main thread, other threads need a context of their own
+void CM_TransformedBoxTrace( cmodel_state_t *cms, cmtrace_ctx_t *ctx, trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
                              struct cmodel_s *cmodel, int brushmask, vec3_t origin, vec3_t angles );
 
+cmtrace_ctx_t *CM_NewTraceContext( cmodel_state_t *cms );
+void CM_FreeTraceContext( cmtrace_ctx_t *ctx );
+
+// traces random boxes through the map from several threads and checks the results against a single thread
+void CM_TraceBench( cmodel_state_t *cms, int numThreads, int numTraces );
+
 void CM_RoundUpToHullSize( cmodel_state_t *cms, vec3_t mins, vec3_t maxs, struct cmodel_s *cmodel );
 
 int CM_ClusterRowSize( cmodel_state_t *cms );
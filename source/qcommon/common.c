@@ -73,6 +73,8 @@ unsigned server_map_checksum = 0;
 // host_speeds times
 unsigned int time_before_game;
 unsigned int time_after_game;
+unsigned int time_before_snap;
+unsigned int time_after_snap;
 unsigned int time_before_ref;
 unsigned int time_after_ref;
 
@@ -304,6 +306,10 @@ void Com_Error( com_error_code_t code, const char *format, ... )
 	Q_vsnprintfz( msg, sizeof_msg, format, argptr );
 	va_end( argptr );
 
+	// we may be in the middle of a server frame, send what it queued so far
+	// and make sure the shutdown messages aren't left in the queue
+	NET_FlushSendQueue();
+
 	if( code == ERR_DROP )
 	{
 		Com_Printf( "********************\nERROR: %s\n********************\n", msg );
@@ -737,6 +743,11 @@ unsigned int COM_CPUFeatures( void )
 			if( CPUIDFeatures & 0x04000000 )
 				com_CPUFeatures |= QCPU_HAS_SSE2;
 		}
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+		// the CPUID code above is 32-bit only, SSE2 is part of the 64-bit instruction set
+		com_CPUFeatures |= QCPU_HAS_SSE|QCPU_HAS_SSE2;
+#endif
 	}
 
 	return com_CPUFeatures;
@@ -956,6 +967,8 @@ void Qcommon_Init( int argc, char **argv )
 
 	Qcommon_InitCommands();
 
+	Prof_Init();
+
 	host_speeds =	    Cvar_Get( "host_speeds", "0", 0 );
 	developer =	    Cvar_Get( "developer", "0", 0 );
 	timescale =	    Cvar_Get( "timescale", "1.0", CVAR_CHEAT );
@@ -1125,17 +1138,18 @@ void Qcommon_Frame( unsigned int realmsec )
 
 	if( host_speeds->integer )
 	{
-		int all, sv, gm, cl, rf;
+		int all, sv, gm, sn, cl, rf;
 
 		all = time_after - time_before;
 		sv = time_between - time_before;
 		cl = time_after - time_between;
 		gm = time_after_game - time_before_game;
+		sn = time_after_snap - time_before_snap;
 		rf = time_after_ref - time_before_ref;
-		sv -= gm;
+		sv -= gm + sn;
 		cl -= rf;
-		Com_Printf( "all:%3i sv:%3i gm:%3i cl:%3i rf:%3i\n",
-			all, sv, gm, cl, rf );
+		Com_Printf( "all:%3i sv:%3i gm:%3i sn:%3i cl:%3i rf:%3i\n",
+			all, sv, gm, sn, cl, rf );
 	}
 
 	MM_Frame( realmsec );
@@ -1145,6 +1159,10 @@ void Qcommon_Frame( unsigned int realmsec )
 		frametick = Dynvar_Lookup( "frametick" );
 	Dynvar_CallListeners( frametick, &fc );
 	++fc;
+
+	Prof_Frame();
+
+	Mem_ClearFrameArena();
 }
 
 /*
@@ -1171,6 +1189,7 @@ void Qcommon_Shutdown( void )
 
 	Com_Autoupdate_Shutdown();
 
+	Prof_Shutdown();
 	Qcommon_ShutdownCommands();
 	Memory_ShutdownCommands();
 
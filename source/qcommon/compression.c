@@ -110,3 +110,740 @@ void Com_UnloadCompressionLibraries( void )
 {
 	ZLib_UnloadLibrary();
 }
+
+/*
+=============================================================================
+
+NETWORK MESSAGE CODECS
+
+=============================================================================
+*/
+
+#include "../qalgo/md5.h"
+
+// LZ is the LZ4 block format: a token byte with the literal and match lengths,
+// the literals, a 16-bit little-endian offset and extra length bytes of 255s.
+// With a dictionary the window starts with it, so messages can refer to
+// snapshot and configstring data both sides have seen before they were sent.
+
+#define LZ_HASHLOG				12
+#define LZ_HASHSIZE				( 1<<LZ_HASHLOG )
+#define LZ_MINMATCH				4
+#define LZ_LASTLITERALS			5
+#define LZ_MFLIMIT				12
+#define LZ_MAXOFFSET			65535
+
+#define NETCODEC_DICT_FILE		"netcodec.dict"
+#define NETCODEC_DICT_MAXSIZE	0x8000
+
+static const char *netcodecNames[NETCODEC_TOTAL] = { "zlib", "lz", "lzdict" };
+
+static uint8_t *netcodecDict;
+static size_t netcodecDictSize;
+static unsigned int netcodecDictChecksum;
+static uint32_t *netcodecDictTable;				// [LZ_HASHSIZE] hash of the dictionary positions, 0 is empty
+
+// only used from the thread sending the messages, like the rest of the netchan
+static uint8_t lz_window[NETCODEC_DICT_MAXSIZE + MAX_MSGLEN];
+static uint32_t lz_table[LZ_HASHSIZE];
+static uint32_t lz_tableBase;
+
+static void Com_CodecBench_f( void );
+static void Com_CodecTrain_f( void );
+
+#define LZ_Read32(p) ( (uint32_t)(p)[0] | ( (uint32_t)(p)[1]<<8 ) | ( (uint32_t)(p)[2]<<16 ) | ( (uint32_t)(p)[3]<<24 ) )
+#define LZ_Hash(p) ( ( LZ_Read32( p ) * 2654435761u ) >> ( 32 - LZ_HASHLOG ) )
+
+/*
+* LZ_WriteLength
+*/
+static uint8_t *LZ_WriteLength( uint8_t *op, size_t length )
+{
+	for( ; length >= 255; length -= 255 )
+		*op++ = 255;
+	*op++ = (uint8_t)length;
+	return op;
+}
+
+/*
+* LZ_WriteSequence
+*
+* Returns NULL if the sequence doesn't fit
+*/
+static uint8_t *LZ_WriteSequence( uint8_t *op, const uint8_t *oend, const uint8_t *literals, size_t numLiterals,
+	size_t offset, size_t matchLength )
+{
+	uint8_t *token;
+
+	if( op + 1 + numLiterals + numLiterals / 255 + 1 + 2 + matchLength / 255 + 1 > oend )
+		return NULL;
+
+	token = op++;
+	*token = ( numLiterals >= 15 ? 15 : numLiterals ) << 4;
+	if( numLiterals >= 15 )
+		op = LZ_WriteLength( op, numLiterals - 15 );
+	memcpy( op, literals, numLiterals );
+	op += numLiterals;
+
+	if( !matchLength )
+		return op;
+
+	*op++ = offset & 0xff;
+	*op++ = ( offset >> 8 ) & 0xff;
+
+	matchLength -= LZ_MINMATCH;
+	*token |= matchLength >= 15 ? 15 : matchLength;
+	if( matchLength >= 15 )
+		op = LZ_WriteLength( op, matchLength - 15 );
+
+	return op;
+}
+
+/*
+* LZ_FindMatch
+*
+* Returns the position of an earlier occurence of the 4 bytes at ip or -1
+*/
+static int LZ_FindMatch( const uint8_t *base, size_t ip, uint32_t candidate )
+{
+	size_t ref;
+
+	if( !candidate )
+		return -1;
+	ref = candidate - 1;
+	if( ref >= ip || ip - ref > LZ_MAXOFFSET || LZ_Read32( base + ref ) != LZ_Read32( base + ip ) )
+		return -1;
+	return ref;
+}
+
+/*
+* LZ_Compress
+*
+* base[0..start) is the dictionary, base[start..end) the data to compress.
+* Instead of clearing the hash table for each message, its positions are
+* stamped with a base which grows with each call, so the ones left over
+* from previous messages are recognized as stale. The dictionary positions
+* are looked up in their own precomputed table.
+*/
+static int LZ_Compress( const uint8_t *base, size_t start, size_t end, const uint32_t *dictTable, uint8_t *dst, size_t dstLen )
+{
+	size_t ip, anchor, length, step;
+	const size_t matchlimit = end - LZ_LASTLITERALS, mflimit = end - LZ_MFLIMIT;
+	int ref;
+	uint32_t h, candidate;
+	uint8_t *op = dst;
+	const uint8_t *oend = dst + dstLen;
+
+	if( lz_tableBase > 0xffffffffu - end - 1 )
+	{
+		memset( lz_table, 0, sizeof( lz_table ) );
+		lz_tableBase = 0;
+	}
+
+	ip = anchor = start;
+	if( end - start > LZ_MFLIMIT )
+	{
+		while( ip < mflimit )
+		{
+			h = LZ_Hash( base + ip );
+			candidate = lz_table[h];
+			lz_table[h] = lz_tableBase + ip + 1;
+
+			ref = candidate > lz_tableBase ? LZ_FindMatch( base, ip, candidate - lz_tableBase ) : -1;
+			if( ref < 0 && dictTable )
+				ref = LZ_FindMatch( base, ip, dictTable[h] );
+			if( ref < 0 )
+			{
+				// skip faster through incompressible data
+				step = 1 + ( ( ip - anchor ) >> 6 );
+				ip += step;
+				continue;
+			}
+
+			// extend the match both ways
+			while( ip > anchor && ref > 0 && base[ip-1] == base[ref-1] )
+			{
+				ip--;
+				ref--;
+			}
+			for( length = LZ_MINMATCH; ip + length < matchlimit && base[ref+length] == base[ip+length]; length++ );
+
+			op = LZ_WriteSequence( op, oend, base + anchor, ip - anchor, ip - ref, length );
+			if( !op )
+				break;
+
+			ip += length;
+			anchor = ip;
+			lz_table[LZ_Hash( base + ip - 2 )] = lz_tableBase + ip - 2 + 1;
+		}
+	}
+
+	lz_tableBase += end + 1;
+
+	// the rest goes as literals
+	if( op )
+		op = LZ_WriteSequence( op, oend, base + anchor, end - anchor, 0, 0 );
+	if( !op )
+		return -1;
+
+	return op - dst;
+}
+
+/*
+* LZ_ReadLength
+*/
+static bool LZ_ReadLength( const uint8_t **pip, const uint8_t *iend, size_t *length )
+{
+	const uint8_t *ip = *pip;
+	uint8_t b;
+
+	do {
+		if( ip >= iend )
+			return false;
+		b = *ip++;
+		*length += b;
+	} while( b == 255 );
+
+	*pip = ip;
+	return true;
+}
+
+/*
+* LZ_Decompress
+*/
+static int LZ_Decompress( const uint8_t *dict, size_t dictLen, const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen )
+{
+	const uint8_t *ip = src, *iend = src + srcLen;
+	uint8_t *op = dst, *oend = dst + dstLen;
+	size_t literals, length, offset, fromDict;
+	unsigned token;
+
+	while( ip < iend )
+	{
+		token = *ip++;
+
+		literals = token >> 4;
+		if( literals == 15 && !LZ_ReadLength( &ip, iend, &literals ) )
+			return -1;
+		if( literals > (size_t)( iend - ip ) || literals > (size_t)( oend - op ) )
+			return -1;
+		memcpy( op, ip, literals );
+		ip += literals;
+		op += literals;
+
+		// the last sequence only has literals
+		if( ip == iend )
+			break;
+
+		if( iend - ip < 2 )
+			return -1;
+		offset = ip[0] | ( ip[1] << 8 );
+		ip += 2;
+
+		length = token & 15;
+		if( length == 15 && !LZ_ReadLength( &ip, iend, &length ) )
+			return -1;
+		length += LZ_MINMATCH;
+
+		if( !offset || offset > (size_t)( op - dst ) + dictLen || length > (size_t)( oend - op ) )
+			return -1;
+
+		// the match may start in the dictionary
+		if( offset > (size_t)( op - dst ) )
+		{
+			fromDict = offset - ( op - dst );
+			if( fromDict > length )
+				fromDict = length;
+			memcpy( op, dict + dictLen - ( offset - ( op - dst ) ), fromDict );
+			op += fromDict;
+			length -= fromDict;
+		}
+
+		// byte by byte, the match may overlap the output
+		for( ; length; length--, op++ )
+			*op = *( op - offset );
+	}
+
+	return op - dst;
+}
+
+/*
+* Com_NetCodecCompress
+*
+* Returns the compressed length, or -1 if it doesn't fit or on error
+*/
+int Com_NetCodecCompress( int codec, const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen )
+{
+	int zlerror;
+	uLongf zlen;
+
+	switch( codec )
+	{
+	case NETCODEC_ZLIB:
+		zlen = dstLen;
+		zlerror = qzcompress2( dst, &zlen, src, srcLen, Z_BEST_COMPRESSION );
+		if( zlerror != Z_OK )
+		{
+			if( zlerror != Z_BUF_ERROR )
+				Com_DPrintf( "ZLib data error! Error code %i on compress.\n", zlerror );
+			return -1;
+		}
+		return zlen;
+
+	case NETCODEC_LZ:
+		return LZ_Compress( src, 0, srcLen, NULL, dst, dstLen );
+
+	case NETCODEC_LZDICT:
+		if( !netcodecDict || srcLen > MAX_MSGLEN )
+			return -1;
+		memcpy( lz_window + netcodecDictSize, src, srcLen );
+		return LZ_Compress( lz_window, netcodecDictSize, netcodecDictSize + srcLen, netcodecDictTable, dst, dstLen );
+
+	default:
+		return -1;
+	}
+}
+
+/*
+* Com_NetCodecDecompress
+*
+* Returns the decompressed length or -1 on error
+*/
+int Com_NetCodecDecompress( int codec, const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen )
+{
+	int zlerror;
+	uLongf zlen;
+
+	switch( codec )
+	{
+	case NETCODEC_ZLIB:
+		zlen = dstLen;
+		zlerror = qzuncompress( dst, &zlen, src, srcLen );
+		if( zlerror != Z_OK )
+		{
+			Com_DPrintf( "ZLib data error! Error code %i on decompress.\n", zlerror );
+			return -1;
+		}
+		return zlen;
+
+	case NETCODEC_LZ:
+		return LZ_Decompress( NULL, 0, src, srcLen, dst, dstLen );
+
+	case NETCODEC_LZDICT:
+		if( !netcodecDict )
+			return -1;
+		return LZ_Decompress( netcodecDict, netcodecDictSize, src, srcLen, dst, dstLen );
+
+	default:
+		return -1;
+	}
+}
+
+/*
+* Com_NetCodecName
+*/
+const char *Com_NetCodecName( int codec )
+{
+	if( codec < 0 || codec >= NETCODEC_TOTAL )
+		return "unknown";
+	return netcodecNames[codec];
+}
+
+/*
+* Com_NetCodecOffer
+*
+* The list of codecs we can receive, sent when connecting. The dictionary
+* is only usable if both sides have the same one.
+*/
+const char *Com_NetCodecOffer( void )
+{
+	static char offer[64];
+
+	if( netcodecDict )
+		Q_snprintfz( offer, sizeof( offer ), "%s,%s:%08x", netcodecNames[NETCODEC_LZ], netcodecNames[NETCODEC_LZDICT], netcodecDictChecksum );
+	else
+		Q_strncpyz( offer, netcodecNames[NETCODEC_LZ], sizeof( offer ) );
+	return offer;
+}
+
+/*
+* Com_NetCodecFromOffer
+*
+* Picks the best codec from the peer's offer, zlib for peers which didn't send one
+*/
+int Com_NetCodecFromOffer( const char *offer )
+{
+	int best = NETCODEC_ZLIB;
+	size_t len;
+	const char *sep;
+	char token[64], dictname[64];
+
+	if( !offer )
+		return best;
+
+	Q_snprintfz( dictname, sizeof( dictname ), "%s:%08x", netcodecNames[NETCODEC_LZDICT], netcodecDictChecksum );
+
+	while( *offer )
+	{
+		sep = strchr( offer, ',' );
+		len = sep ? (size_t)( sep - offer ) : strlen( offer );
+		Q_strncpyz( token, offer, min( len + 1, sizeof( token ) ) );
+		offer += sep ? len + 1 : len;
+
+		if( !Q_stricmp( token, netcodecNames[NETCODEC_LZ] ) && best < NETCODEC_LZ )
+			best = NETCODEC_LZ;
+		else if( netcodecDict && !Q_stricmp( token, dictname ) )
+			best = NETCODEC_LZDICT;
+	}
+
+	return best;
+}
+
+/*
+* Com_NetCodecForName
+*/
+int Com_NetCodecForName( const char *name )
+{
+	int i;
+
+	for( i = 0; i < NETCODEC_TOTAL; i++ )
+	{
+		if( !Q_stricmp( name, netcodecNames[i] ) )
+			return i;
+	}
+	return -1;
+}
+
+/*
+* Com_LoadNetCodecDictionary
+*/
+static void Com_LoadNetCodecDictionary( void )
+{
+	int length;
+	size_t i;
+	uint8_t *buffer;
+
+	length = FS_LoadFile( NETCODEC_DICT_FILE, (void **)&buffer, NULL, 0 );
+	if( !buffer )
+		return;
+
+	if( length < LZ_MINMATCH || length > NETCODEC_DICT_MAXSIZE )
+	{
+		Com_Printf( S_COLOR_YELLOW "Ignoring %s: invalid size %i\n", NETCODEC_DICT_FILE, length );
+		FS_FreeFile( buffer );
+		return;
+	}
+
+	netcodecDict = lz_window;
+	netcodecDictSize = length;
+	netcodecDictChecksum = md5_digest32( buffer, length );
+	memcpy( netcodecDict, buffer, length );
+	FS_FreeFile( buffer );
+
+	netcodecDictTable = Mem_ZoneMalloc( sizeof( *netcodecDictTable ) * LZ_HASHSIZE );
+	for( i = 0; i + LZ_MINMATCH <= netcodecDictSize; i++ )
+		netcodecDictTable[LZ_Hash( netcodecDict + i )] = i + 1;
+
+	Com_DPrintf( "Loaded %s, %i bytes, checksum %08x\n", NETCODEC_DICT_FILE, length, netcodecDictChecksum );
+}
+
+/*
+* Com_InitNetCodecs
+*/
+void Com_InitNetCodecs( void )
+{
+	Com_LoadNetCodecDictionary();
+
+	Cmd_AddCommand( "codecbench", Com_CodecBench_f );
+	Cmd_AddCommand( "codectrain", Com_CodecTrain_f );
+}
+
+/*
+* Com_ShutdownNetCodecs
+*/
+void Com_ShutdownNetCodecs( void )
+{
+	Cmd_RemoveCommand( "codecbench" );
+	Cmd_RemoveCommand( "codectrain" );
+
+	if( netcodecDictTable )
+		Mem_ZoneFree( netcodecDictTable );
+	netcodecDictTable = NULL;
+	netcodecDict = NULL;
+	netcodecDictSize = 0;
+	netcodecDictChecksum = 0;
+}
+
+/*
+* Com_LoadDemoMessages
+*
+* Reads all messages of a demo into a single buffer, for training and benchmarking
+*/
+static uint8_t *Com_LoadDemoMessages( const char *demoname, uint8_t *data, size_t *datasize, int **lengths, int *numlengths )
+{
+	int demofile, maxlengths;
+	size_t maxdatasize;
+	char filename[MAX_QPATH];
+	msg_t msg;
+	uint8_t msgbuf[MAX_MSGLEN];
+
+	Q_snprintfz( filename, sizeof( filename ), "demos/%s", demoname );
+	COM_DefaultExtension( filename, APP_DEMO_EXTENSION_STR, sizeof( filename ) );
+
+	if( FS_FOpenFile( filename, &demofile, FS_READ|SNAP_DEMO_GZ ) == -1 || !demofile )
+	{
+		Com_Printf( "Couldn't open %s\n", filename );
+		return data;
+	}
+
+	maxdatasize = *datasize;
+	maxlengths = *numlengths;
+
+	MSG_Init( &msg, msgbuf, sizeof( msgbuf ) );
+	while( SNAP_ReadDemoMessage( demofile, &msg ) > 0 )
+	{
+		if( *datasize + msg.cursize > maxdatasize )
+		{
+			maxdatasize = max( maxdatasize * 2, *datasize + msg.cursize + 0x10000 );
+			data = data ? Mem_Realloc( data, maxdatasize ) : Mem_ZoneMalloc( maxdatasize );
+		}
+		if( *numlengths == maxlengths )
+		{
+			maxlengths = max( maxlengths * 2, 1024 );
+			*lengths = *lengths ? Mem_Realloc( *lengths, maxlengths * sizeof( int ) ) : Mem_ZoneMalloc( maxlengths * sizeof( int ) );
+		}
+
+		memcpy( data + *datasize, msg.data, msg.cursize );
+		*datasize += msg.cursize;
+		( *lengths )[( *numlengths )++] = msg.cursize;
+	}
+
+	FS_FCloseFile( demofile );
+	return data;
+}
+
+/*
+* Com_CodecBench_f
+*
+* Compresses and decompresses every message of the given demos with each codec
+*/
+static void Com_CodecBench_f( void )
+{
+	int i, codec, numlengths, errors;
+	size_t datasize, offset, coffset;
+	uint64_t ctime, dtime;
+	uint8_t *data, *cdata, *ddata;
+	int *lengths, *clengths;
+
+	if( Cmd_Argc() < 2 )
+	{
+		Com_Printf( "Usage: %s <demo> [demo2...]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	data = NULL;
+	lengths = NULL;
+	datasize = 0;
+	numlengths = 0;
+	for( i = 1; i < Cmd_Argc(); i++ )
+		data = Com_LoadDemoMessages( Cmd_Argv( i ), data, &datasize, &lengths, &numlengths );
+
+	if( !numlengths )
+	{
+		Com_Printf( "No messages to compress\n" );
+		if( data )
+			Mem_ZoneFree( data );
+		return;
+	}
+
+	// worst case for LZ is a few bytes over the message size, give it some room
+	cdata = Mem_ZoneMalloc( datasize + numlengths * 64 );
+	ddata = Mem_ZoneMalloc( datasize );
+	clengths = Mem_ZoneMalloc( sizeof( *clengths ) * numlengths );
+
+	Com_Printf( "codecbench: %i messages, %i bytes\n", numlengths, (int)datasize );
+
+	for( codec = 0; codec < NETCODEC_TOTAL; codec++ )
+	{
+		if( codec == NETCODEC_LZDICT && !netcodecDict )
+		{
+			Com_Printf( "%-8s no %s loaded\n", netcodecNames[codec], NETCODEC_DICT_FILE );
+			continue;
+		}
+
+		ctime = Sys_Microseconds();
+		for( i = 0, offset = 0, coffset = 0; i < numlengths; offset += lengths[i], i++ )
+		{
+			clengths[i] = Com_NetCodecCompress( codec, data + offset, lengths[i], cdata + coffset, lengths[i] + 64 );
+			if( clengths[i] > 0 )
+				coffset += clengths[i];
+		}
+		ctime = Sys_Microseconds() - ctime;
+
+		errors = 0;
+		dtime = Sys_Microseconds();
+		for( i = 0, offset = 0, coffset = 0; i < numlengths; offset += lengths[i], i++ )
+		{
+			if( clengths[i] < 0 )
+			{
+				errors++;
+				continue;
+			}
+			if( Com_NetCodecDecompress( codec, cdata + coffset, clengths[i], ddata + offset, lengths[i] ) != lengths[i] )
+				errors++;
+			coffset += clengths[i];
+		}
+		dtime = Sys_Microseconds() - dtime;
+
+		if( memcmp( data, ddata, datasize ) )
+			errors++;
+
+		// the netchan sends messages uncompressed when it doesn't pay off
+		for( i = 0, coffset = 0; i < numlengths; i++ )
+			coffset += clengths[i] < 0 || clengths[i] > lengths[i] ? lengths[i] : clengths[i];
+
+		Com_Printf( "%-8s ratio %5.3f, compress %6.2fns/byte, decompress %6.2fns/byte\n", netcodecNames[codec],
+			(double)coffset / datasize, ctime * 1000.0 / datasize, dtime * 1000.0 / datasize );
+		if( errors )
+			Com_Printf( S_COLOR_RED "%s: %i messages didn't survive the roundtrip\n", netcodecNames[codec], errors );
+	}
+
+	Mem_ZoneFree( clengths );
+	Mem_ZoneFree( ddata );
+	Mem_ZoneFree( cdata );
+	Mem_ZoneFree( data );
+	Mem_ZoneFree( lengths );
+}
+
+#define TRAIN_KMER				8
+#define TRAIN_SEGMENT			64
+#define TRAIN_HASHLOG			20
+#define TRAIN_DEFAULT_SIZE		0x4000
+
+typedef struct
+{
+	size_t offset;
+	uint64_t score;
+} trainsegment_t;
+
+#define TRAIN_Hash(p) ( (uint32_t)( ( ( (uint64_t)LZ_Read32( p ) << 32 | LZ_Read32( (p) + 4 ) ) * 0xcf1bbcdcb7a56463ULL ) >> ( 64 - TRAIN_HASHLOG ) ) )
+
+/*
+* Com_CompareTrainSegments
+*/
+static int Com_CompareTrainSegments( const void *a, const void *b )
+{
+	const trainsegment_t *sa = a, *sb = b;
+	return sa->score < sb->score ? -1 : ( sa->score > sb->score ? 1 : 0 );
+}
+
+/*
+* Com_CodecTrain_f
+*
+* Builds a dictionary out of the demos' messages: the samples are split into
+* as many epochs as the dictionary has segments, the segment with the most
+* frequent k-mers of each epoch is picked and its k-mers don't count anymore
+* for the next epochs. The best segments go to the end of the dictionary,
+* where the offsets to them are the shortest.
+*/
+static void Com_CodecTrain_f( void )
+{
+	int i, numlengths, file;
+	size_t datasize, dictsize, epochsize, epoch, numsegments, pos, end, best;
+	uint64_t score, bestscore;
+	uint8_t *data, *dict;
+	int *lengths;
+	uint32_t *counts;
+	trainsegment_t *segments;
+	const char *filename;
+
+	if( Cmd_Argc() < 3 )
+	{
+		Com_Printf( "Usage: %s <output> <demo> [demo2...]\n", Cmd_Argv( 0 ) );
+		return;
+	}
+
+	filename = Cmd_Argv( 1 );
+
+	data = NULL;
+	lengths = NULL;
+	datasize = 0;
+	numlengths = 0;
+	for( i = 2; i < Cmd_Argc(); i++ )
+		data = Com_LoadDemoMessages( Cmd_Argv( i ), data, &datasize, &lengths, &numlengths );
+
+	if( datasize < TRAIN_SEGMENT * 4 )
+	{
+		Com_Printf( "Not enough samples to train a dictionary\n" );
+		if( data )
+			Mem_ZoneFree( data );
+		if( lengths )
+			Mem_ZoneFree( lengths );
+		return;
+	}
+
+	dictsize = min( TRAIN_DEFAULT_SIZE, datasize / 4 );
+	numsegments = dictsize / TRAIN_SEGMENT;
+	dictsize = numsegments * TRAIN_SEGMENT;
+	epochsize = datasize / numsegments;
+
+	counts = Mem_ZoneMalloc( sizeof( *counts ) << TRAIN_HASHLOG );
+	segments = Mem_ZoneMalloc( sizeof( *segments ) * numsegments );
+	dict = Mem_ZoneMalloc( dictsize );
+
+	for( pos = 0; pos + TRAIN_KMER <= datasize; pos++ )
+		counts[TRAIN_Hash( data + pos )]++;
+
+	for( epoch = 0; epoch < numsegments; epoch++ )
+	{
+		pos = epoch * epochsize;
+		end = min( pos + epochsize, datasize - TRAIN_KMER + 1 );
+
+		// slide a segment through the epoch, summing the counts of its k-mers
+		best = pos;
+		bestscore = score = 0;
+		for( i = 0; i < TRAIN_SEGMENT - TRAIN_KMER + 1 && pos + i < end; i++ )
+			score += counts[TRAIN_Hash( data + pos + i )];
+		bestscore = score;
+		for( ; pos + TRAIN_SEGMENT - TRAIN_KMER + 1 < end; pos++ )
+		{
+			score -= counts[TRAIN_Hash( data + pos )];
+			score += counts[TRAIN_Hash( data + pos + TRAIN_SEGMENT - TRAIN_KMER + 1 )];
+			if( score > bestscore )
+			{
+				bestscore = score;
+				best = pos + 1;
+			}
+		}
+
+		best = min( best, datasize - TRAIN_SEGMENT );
+		segments[epoch].offset = best;
+		segments[epoch].score = bestscore;
+
+		// the picked k-mers are covered now
+		for( i = 0; i < TRAIN_SEGMENT - TRAIN_KMER + 1; i++ )
+			counts[TRAIN_Hash( data + best + i )] = 0;
+	}
+
+	qsort( segments, numsegments, sizeof( *segments ), Com_CompareTrainSegments );
+	for( epoch = 0; epoch < numsegments; epoch++ )
+		memcpy( dict + epoch * TRAIN_SEGMENT, data + segments[epoch].offset, TRAIN_SEGMENT );
+
+	if( FS_FOpenFile( filename, &file, FS_WRITE ) == -1 )
+	{
+		Com_Printf( "Couldn't open %s for writing\n", filename );
+	}
+	else
+	{
+		FS_Write( dict, dictsize, file );
+		FS_FCloseFile( file );
+		Com_Printf( "Wrote %s: %i bytes from %i messages, %i bytes, checksum %08x\n", filename,
+			(int)dictsize, numlengths, (int)datasize, md5_digest32( dict, dictsize ) );
+	}
+
+	Mem_ZoneFree( dict );
+	Mem_ZoneFree( segments );
+	Mem_ZoneFree( counts );
+	Mem_ZoneFree( data );
+	Mem_ZoneFree( lengths );
+}
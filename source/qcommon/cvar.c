@@ -185,6 +185,8 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 
 		if( Cvar_FlagIsSet( flags, CVAR_USERINFO ) && !Cvar_FlagIsSet( var->flags, CVAR_USERINFO ) )
 			userinfo_modified = true; // transmit at next oportunity
+		if( Cvar_FlagIsSet( flags, CVAR_SERVERINFO ) && ( reset || !Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) ) )
+			serverinfo_modcount++;
 
 		Cvar_FlagSet( &var->flags, flags );
 		return var;
@@ -208,6 +210,8 @@ cvar_t *Cvar_Get( const char *var_name, const char *var_value, cvar_flag_t flags
 	var->integer = Q_rint( var->value );
 	var->flags = flags;
 	Cvar_SetModified( var );
+	if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) )
+		serverinfo_modcount++;
 
 	QMutex_Lock( cvar_mutex );
 	Trie_Insert( cvar_trie, var_name, var );
@@ -306,6 +310,8 @@ static cvar_t *Cvar_Set2( const char *var_name, const char *value, bool force )
 					var->value = atof( var->string );
 					var->integer = Q_rint( var->value );
 					Cvar_SetModified( var );
+					if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) )
+						serverinfo_modcount++;
 				}
 			}
 			return var;
@@ -325,6 +331,8 @@ static cvar_t *Cvar_Set2( const char *var_name, const char *value, bool force )
 
 	if( Cvar_FlagIsSet( var->flags, CVAR_USERINFO ) )
 		userinfo_modified = true; // transmit at next oportunity
+	if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) )
+		serverinfo_modcount++;
 
 	Mem_ZoneFree( var->string ); // free the old value string
 
@@ -428,6 +436,8 @@ void Cvar_GetLatchedVars( cvar_flag_t flags )
 		var->latched_string = NULL;
 		var->value = atof( var->string );
 		var->integer = Q_rint( var->value );
+		if( Cvar_FlagIsSet( var->flags, CVAR_SERVERINFO ) )
+			serverinfo_modcount++;
 	}
 	Trie_FreeDump( dump );
 }
@@ -722,6 +732,7 @@ static void Cvar_ArchiveList_f( void )
 #endif
 
 bool userinfo_modified;
+unsigned int serverinfo_modcount;
 
 static char *Cvar_BitInfo( int bit )
 {
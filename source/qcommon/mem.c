@@ -30,6 +30,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define MEMALIGNMENT_DEFAULT		16
 
+// small blocks come from per size class slabs, which are handed out to
+// per-thread caches in batches so that most allocations don't take any lock
+#define MEMSLAB_CHUNKSIZE			0x10000		// carved into blocks of a single size class
+#define MEMSLAB_MAXBLOCKSIZE		8192		// larger blocks go straight to malloc
+#define MEMSLAB_CACHEBATCH			16			// blocks moved at once between a thread cache and the slab
+
+#define MEMARENA_BLOCKSIZE			0x40000		// initial size of the frame arena
+
 typedef struct memheader_s
 {
 	// address returned by malloc (may be significantly before this header to satisify alignment)
@@ -48,6 +56,9 @@ typedef struct memheader_s
 	// size of the memory including the header, alignment and sentinel2
 	size_t realsize;
 
+	// slab size class the block was taken from, or -1 for malloc
+	int sizeclass;
+
 	// file name and line where Mem_Alloc was called
 	const char *filename;
 	int fileline;
@@ -62,6 +73,9 @@ struct mempool_s
 	// should always be MEMHEADER_SENTINEL1
 	unsigned int sentinel1;
 
+	// protects the chain and the counters below
+	qmutex_t *mutex;
+
 	// chain of individual memory allocations
 	struct memheader_s *chain;
 
@@ -113,6 +127,53 @@ mempool_t *zoneMemPool;
 
 static qmutex_t *memMutex;
 
+typedef struct
+{
+	qmutex_t *mutex;
+	void *freeBlocks;		// linked through the first bytes of each block
+	void *chunks;			// linked through the first bytes of each chunk
+	size_t chunkUsed;		// of the most recent chunk
+} memslabclass_t;
+
+typedef struct
+{
+	void *blocks;
+	int numBlocks;
+} memthreadcache_t;
+
+static const int memSlabSizes[] =
+{
+	96, 128, 160, 192, 256, 320, 384, 512, 640, 768, 1024, 1280,
+	1536, 2048, 2560, 3072, 4096, 5120, 6144, MEMSLAB_MAXBLOCKSIZE
+};
+
+#define MEMSLAB_NUMCLASSES ( sizeof( memSlabSizes ) / sizeof( memSlabSizes[0] ) )
+
+static memslabclass_t memSlabClasses[MEMSLAB_NUMCLASSES];
+static uint8_t memSlabClassForSize[MEMSLAB_MAXBLOCKSIZE / 16 + 1];
+static Q_THREADLOCAL memthreadcache_t memThreadCache[MEMSLAB_NUMCLASSES];
+
+// frame arena, a bump allocator which is emptied at the end of every frame.
+// it only grows by chaining new blocks, which are merged into a single one on reset.
+typedef struct memarenablock_s
+{
+	struct memarenablock_s *next;
+	int size;
+	volatile int used;
+	// immediately followed by data
+} memarenablock_t;
+
+typedef struct
+{
+	qmutex_t *mutex;
+	memarenablock_t * volatile current;
+	int numBlocks;
+	int totalsize;
+	int peaksize;		// bytes requested in the most demanding frame so far
+} memarena_t;
+
+static memarena_t memArena;
+
 static bool memory_initialized = false;
 static bool commands_initialized = false;
 
@@ -128,10 +189,186 @@ static void _Mem_Error( const char *format, ... )
 	Sys_Error( msg );
 }
 
+/*
+* Mem_InitSlabs
+*/
+static void Mem_InitSlabs( void )
+{
+	unsigned int i, sizeclass;
+
+	for( i = 0, sizeclass = 0; i < sizeof( memSlabClassForSize ); i++ )
+	{
+		while( (int)i * 16 > memSlabSizes[sizeclass] )
+			sizeclass++;
+		memSlabClassForSize[i] = sizeclass;
+	}
+
+	for( i = 0; i < MEMSLAB_NUMCLASSES; i++ )
+	{
+		memset( &memSlabClasses[i], 0, sizeof( memslabclass_t ) );
+		memSlabClasses[i].mutex = QMutex_Create();
+	}
+}
+
+/*
+* Mem_ShutdownSlabs
+*/
+static void Mem_ShutdownSlabs( void )
+{
+	unsigned int i;
+	void *chunk, *next;
+
+	for( i = 0; i < MEMSLAB_NUMCLASSES; i++ )
+	{
+		for( chunk = memSlabClasses[i].chunks; chunk; chunk = next )
+		{
+			next = *( void ** )chunk;
+			free( chunk );
+		}
+
+		QMutex_Destroy( &memSlabClasses[i].mutex );
+		memset( &memSlabClasses[i], 0, sizeof( memslabclass_t ) );
+	}
+
+	// only the calling thread's cache can be reset, others are expected to be gone by now
+	memset( memThreadCache, 0, sizeof( memThreadCache ) );
+}
+
+/*
+* Mem_SlabRefill
+*
+* Moves a batch of free blocks from the slab to the thread cache, carving new chunks as needed
+*/
+static void Mem_SlabRefill( int sizeclass, memthreadcache_t *cache )
+{
+	int i;
+	uint8_t *block;
+	memslabclass_t *slab = &memSlabClasses[sizeclass];
+	const size_t blocksize = memSlabSizes[sizeclass];
+
+	QMutex_Lock( slab->mutex );
+
+	for( i = 0; i < MEMSLAB_CACHEBATCH; i++ )
+	{
+		if( slab->freeBlocks )
+		{
+			block = ( uint8_t * )slab->freeBlocks;
+			slab->freeBlocks = *( void ** )block;
+		}
+		else
+		{
+			if( !slab->chunks || slab->chunkUsed + blocksize > MEMSLAB_CHUNKSIZE )
+			{
+				block = ( uint8_t * )malloc( MEMSLAB_CHUNKSIZE );
+				if( block == NULL )
+				{
+					QMutex_Unlock( slab->mutex );
+					_Mem_Error( "Mem_Alloc: out of memory (slab of %i bytes blocks)", (int)blocksize );
+				}
+
+				*( void ** )block = slab->chunks;
+				slab->chunks = block;
+				slab->chunkUsed = MEMALIGNMENT_DEFAULT;
+			}
+
+			block = ( uint8_t * )slab->chunks + slab->chunkUsed;
+			slab->chunkUsed += blocksize;
+		}
+
+		*( void ** )block = cache->blocks;
+		cache->blocks = block;
+		cache->numBlocks++;
+	}
+
+	QMutex_Unlock( slab->mutex );
+}
+
+/*
+* Mem_SlabAlloc
+*/
+static void *Mem_SlabAlloc( int sizeclass )
+{
+	void *block;
+	memthreadcache_t *cache = &memThreadCache[sizeclass];
+
+	if( !cache->blocks )
+		Mem_SlabRefill( sizeclass, cache );
+
+	block = cache->blocks;
+	cache->blocks = *( void ** )block;
+	cache->numBlocks--;
+	return block;
+}
+
+/*
+* Mem_SlabFree
+*
+* Blocks go to the freeing thread's cache, which returns a batch to the slab when it grows too big
+*/
+static void Mem_SlabFree( void *block, int sizeclass )
+{
+	int i;
+	void *last;
+	memthreadcache_t *cache = &memThreadCache[sizeclass];
+	memslabclass_t *slab = &memSlabClasses[sizeclass];
+
+	*( void ** )block = cache->blocks;
+	cache->blocks = block;
+	cache->numBlocks++;
+
+	if( cache->numBlocks < MEMSLAB_CACHEBATCH * 2 )
+		return;
+
+	// detach a batch from the cache
+	block = cache->blocks;
+	for( i = 1, last = block; i < MEMSLAB_CACHEBATCH; i++ )
+		last = *( void ** )last;
+	cache->blocks = *( void ** )last;
+	cache->numBlocks -= MEMSLAB_CACHEBATCH;
+
+	QMutex_Lock( slab->mutex );
+	*( void ** )last = slab->freeBlocks;
+	slab->freeBlocks = block;
+	QMutex_Unlock( slab->mutex );
+}
+
+/*
+* Mem_ThreadShutdown
+*
+* Returns the blocks cached by the calling thread to the slabs, so they aren't
+* stranded when the thread exits. Called by QThread_Create'd threads on return.
+*/
+void Mem_ThreadShutdown( void )
+{
+	unsigned int i;
+	void *last;
+	memthreadcache_t *cache;
+	memslabclass_t *slab;
+
+	for( i = 0; i < MEMSLAB_NUMCLASSES; i++ )
+	{
+		cache = &memThreadCache[i];
+		slab = &memSlabClasses[i];
+		if( !cache->blocks || !slab->mutex )
+			continue;
+
+		for( last = cache->blocks; *( void ** )last; last = *( void ** )last );
+
+		QMutex_Lock( slab->mutex );
+		*( void ** )last = slab->freeBlocks;
+		slab->freeBlocks = cache->blocks;
+		QMutex_Unlock( slab->mutex );
+
+		cache->blocks = NULL;
+		cache->numBlocks = 0;
+	}
+}
+
 void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int musthave, int canthave, const char *filename, int fileline )
 {
 	void *base;
 	size_t realsize;
+	int sizeclass;
 	memheader_t *mem;
 
 	if( size <= 0 )
@@ -153,16 +390,21 @@ void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int
 	if( developerMemory && developerMemory->integer )
 		Com_DPrintf( "Mem_Alloc: pool %s, file %s:%i, size %i bytes\n", pool->name, filename, fileline, size );
 
-	QMutex_Lock( memMutex );
-
-	pool->totalsize += size;
 	realsize = sizeof( memheader_t ) + size + alignment + sizeof( int );
 
-	pool->realsize += realsize;
-
-	base = malloc( realsize );
-	if( base == NULL )
-		_Mem_Error( "Mem_Alloc: out of memory (alloc at %s:%i)", filename, fileline );
+	if( realsize <= MEMSLAB_MAXBLOCKSIZE )
+	{
+		sizeclass = memSlabClassForSize[( realsize + 15 ) >> 4];
+		realsize = memSlabSizes[sizeclass];
+		base = Mem_SlabAlloc( sizeclass );
+	}
+	else
+	{
+		sizeclass = -1;
+		base = malloc( realsize );
+		if( base == NULL )
+			_Mem_Error( "Mem_Alloc: out of memory (alloc at %s:%i)", filename, fileline );
+	}
 
 	// calculate address that aligns the end of the memheader_t to the specified alignment
 	mem = ( memheader_t * )((((size_t)base + sizeof( memheader_t ) + (alignment-1)) & ~(alignment-1)) - sizeof( memheader_t ));
@@ -171,12 +413,18 @@ void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int
 	mem->fileline = fileline;
 	mem->size = size;
 	mem->realsize = realsize;
+	mem->sizeclass = sizeclass;
 	mem->pool = pool;
 	mem->sentinel1 = MEMHEADER_SENTINEL1;
 
 	// we have to use only a single byte for this sentinel, because it may not be aligned, and some platforms can't use unaligned accesses
 	*( (uint8_t *) mem + sizeof( memheader_t ) + mem->size ) = MEMHEADER_SENTINEL2;
 
+	QMutex_Lock( pool->mutex );
+
+	pool->totalsize += size;
+	pool->realsize += realsize;
+
 	// append to head of list
 	mem->next = pool->chain;
 	mem->prev = NULL;
@@ -184,7 +432,7 @@ void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int
 	if( mem->next )
 		mem->next->prev = mem;
 
-	QMutex_Unlock( memMutex );
+	QMutex_Unlock( pool->mutex );
 
 	if( z )
 		memset( (void *)( (uint8_t *) mem + sizeof( memheader_t ) ), 0, mem->size );
@@ -192,6 +440,124 @@ void *_Mem_AllocExt( mempool_t *pool, size_t size, size_t alignment, int z, int
 	return (void *)( (uint8_t *) mem + sizeof( memheader_t ) );
 }
 
+/*
+* _Mem_FrameAllocExt
+*
+* Returns memory which is valid until the end of the current frame, there's no need to free it.
+* Can be called from any thread as long as the memory isn't used past Mem_ClearFrameArena.
+*/
+void *_Mem_FrameAllocExt( size_t size, size_t alignment, int z, const char *filename, int fileline )
+{
+	int offset, reserved;
+	uint8_t *data;
+	memarenablock_t *block, *newblock;
+
+	if( size <= 0 )
+		return NULL;
+
+	if( !alignment )
+		alignment = MEMALIGNMENT_DEFAULT;
+
+	// keep the offsets aligned for the next allocation as well
+	reserved = ( size + alignment - 1 + MEMALIGNMENT_DEFAULT - 1 ) & ~( MEMALIGNMENT_DEFAULT - 1 );
+
+	while( 1 )
+	{
+		block = memArena.current;
+		if( block )
+		{
+			offset = QAtomic_Add( &block->used, reserved, NULL );
+			if( offset + reserved <= block->size )
+				break;
+		}
+
+		// out of space, chain a new block unless another thread already did it
+		QMutex_Lock( memArena.mutex );
+		if( memArena.current == block )
+		{
+			int blocksize = max( MEMARENA_BLOCKSIZE, reserved );
+
+			newblock = ( memarenablock_t * )malloc( sizeof( memarenablock_t ) + MEMALIGNMENT_DEFAULT + blocksize );
+			if( newblock == NULL )
+			{
+				QMutex_Unlock( memArena.mutex );
+				_Mem_Error( "Mem_FrameAlloc: out of memory (alloc at %s:%i)", filename, fileline );
+			}
+
+			newblock->size = blocksize;
+			newblock->used = 0;
+			newblock->next = block;
+			memArena.current = newblock;
+			memArena.numBlocks++;
+			memArena.totalsize += blocksize;
+		}
+		QMutex_Unlock( memArena.mutex );
+	}
+
+	data = ( uint8_t * )block + ( ( sizeof( memarenablock_t ) + MEMALIGNMENT_DEFAULT - 1 ) & ~( MEMALIGNMENT_DEFAULT - 1 ) ) + offset;
+	data = ( uint8_t * )( ( (size_t)data + alignment - 1 ) & ~( alignment - 1 ) );
+
+	if( z )
+		memset( data, 0, size );
+
+	return data;
+}
+
+/*
+* Mem_ClearFrameArena
+*
+* Releases all the frame memory at once. If the frame needed more than one block,
+* they are replaced by a single one big enough so the next frames don't need to malloc.
+* The chain is swapped under the arena mutex, like when an allocation grows it, but
+* frame allocations still running in other threads must be finished by now.
+*/
+void Mem_ClearFrameArena( void )
+{
+	int used;
+	memarenablock_t *block, *next;
+
+	QMutex_Lock( memArena.mutex );
+
+	used = 0;
+	for( block = memArena.current; block; block = block->next )
+		used += min( block->used, block->size );
+	memArena.peaksize = max( memArena.peaksize, used );
+
+	if( memArena.numBlocks <= 1 )
+	{
+		if( memArena.current )
+			memArena.current->used = 0;
+		QMutex_Unlock( memArena.mutex );
+		return;
+	}
+
+	for( block = memArena.current; block; block = next )
+	{
+		next = block->next;
+		free( block );
+	}
+
+	memArena.current = NULL;
+	memArena.numBlocks = 0;
+	memArena.totalsize = 0;
+
+	block = ( memarenablock_t * )malloc( sizeof( memarenablock_t ) + MEMALIGNMENT_DEFAULT + memArena.peaksize );
+	if( block == NULL )
+	{
+		QMutex_Unlock( memArena.mutex );
+		return;		// try again on next allocation
+	}
+
+	block->size = memArena.peaksize;
+	block->used = 0;
+	block->next = NULL;
+	memArena.current = block;
+	memArena.numBlocks = 1;
+	memArena.totalsize = memArena.peaksize;
+
+	QMutex_Unlock( memArena.mutex );
+}
+
 void *_Mem_Alloc( mempool_t *pool, size_t size, int musthave, int canthave, const char *filename, int fileline )
 {
 	return _Mem_AllocExt( pool, size, 0, 1, musthave, canthave, filename, fileline );
@@ -238,6 +604,7 @@ char *_Mem_CopyString( mempool_t *pool, const char *in, const char *filename, in
 void _Mem_Free( void *data, int musthave, int canthave, const char *filename, int fileline )
 {
 	void *base;
+	int sizeclass;
 	memheader_t *mem;
 	mempool_t *pool;
 
@@ -264,11 +631,14 @@ void _Mem_Free( void *data, int musthave, int canthave, const char *filename, in
 	if( developerMemory && developerMemory->integer )
 		Com_DPrintf( "Mem_Free: pool %s, alloc %s:%i, free %s:%i, size %i bytes\n", pool->name, mem->filename, mem->fileline, filename, fileline, mem->size );
 
-	QMutex_Lock( memMutex );
+	QMutex_Lock( pool->mutex );
 
 	// unlink memheader from doubly linked list
 	if( ( mem->prev ? mem->prev->next != mem : pool->chain != mem ) || ( mem->next && mem->next->prev != mem ) )
+	{
+		QMutex_Unlock( pool->mutex );
 		_Mem_Error( "Mem_Free: not allocated or double freed (free at %s:%i)", filename, fileline );
+	}
 
 	if( mem->prev )
 		mem->prev->next = mem->next;
@@ -281,15 +651,19 @@ void _Mem_Free( void *data, int musthave, int canthave, const char *filename, in
 	pool->totalsize -= mem->size;
 
 	base = mem->baseaddress;
+	sizeclass = mem->sizeclass;
 	pool->realsize -= mem->realsize;
 
-	QMutex_Unlock( memMutex );
+	QMutex_Unlock( pool->mutex );
 
 #ifdef MEMTRASH
 	memset( mem, 0xBF, sizeof( memheader_t ) + mem->size + sizeof( int ) );
 #endif
 
-	free( base );
+	if( sizeclass >= 0 )
+		Mem_SlabFree( base, sizeclass );
+	else
+		free( base );
 }
 
 mempool_t *_Mem_AllocPool( mempool_t *parent, const char *name, int flags, const char *filename, int fileline )
@@ -316,8 +690,11 @@ mempool_t *_Mem_AllocPool( mempool_t *parent, const char *name, int flags, const
 	pool->child = NULL;
 	pool->totalsize = 0;
 	pool->realsize = sizeof( mempool_t );
+	pool->mutex = QMutex_Create();
 	Q_strncpyz( pool->name, name, sizeof( pool->name ) );
 
+	QMutex_Lock( memMutex );
+
 	if( parent )
 	{
 		pool->next = parent->child;
@@ -329,6 +706,8 @@ mempool_t *_Mem_AllocPool( mempool_t *parent, const char *name, int flags, const
 		poolChain = pool;
 	}
 
+	QMutex_Unlock( memMutex );
+
 	return pool;
 }
 
@@ -381,6 +760,8 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 	}
 #endif
 
+	QMutex_Lock( memMutex );
+
 	// unlink pool from chain
 	if( ( *pool )->parent )
 		for( chainAddress = &( *pool )->parent->child; *chainAddress && *chainAddress != *pool; chainAddress = &( ( *chainAddress )->next ) ) ;
@@ -388,12 +769,19 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 		for( chainAddress = &poolChain; *chainAddress && *chainAddress != *pool; chainAddress = &( ( *chainAddress )->next ) ) ;
 
 	if( *chainAddress != *pool )
+	{
+		QMutex_Unlock( memMutex );
 		_Mem_Error( "Mem_FreePool: pool already free (freepool at %s:%i)", filename, fileline );
+	}
+
+	*chainAddress = ( *pool )->next;
+
+	QMutex_Unlock( memMutex );
 
 	while( ( *pool )->chain )  // free memory owned by the pool
 		Mem_Free( (void *)( (uint8_t *)( *pool )->chain + sizeof( memheader_t ) ) );
 
-	*chainAddress = ( *pool )->next;
+	QMutex_Destroy( &( *pool )->mutex );
 
 	// free the pool itself
 #ifdef MEMTRASH
@@ -542,6 +930,9 @@ static void Mem_PrintStats( void )
 	Com_Printf( "%i memory pools, totalling %i bytes (%.3fMB), %i bytes (%.3fMB) actual\n", total, totalsize, totalsize / 1048576.0,
 		realsize, realsize / 1048576.0 );
 
+	Com_Printf( "frame arena: %i bytes (%.3fMB) in %i blocks, %i bytes (%.3fMB) peak per frame\n", memArena.totalsize,
+		memArena.totalsize / 1048576.0, memArena.numBlocks, memArena.peaksize, memArena.peaksize / 1048576.0 );
+
 	// temporary pools are not nested
 	for( pool = poolChain; pool; pool = pool->next )
 	{
@@ -654,6 +1045,135 @@ static void MemStats_f( void )
 	Mem_PrintStats();
 }
 
+//===========================================================================
+
+#define MEMBENCH_MAX_THREADS	32
+#define MEMBENCH_LIVE_BLOCKS	256
+
+typedef struct
+{
+	int mode;
+	int iterations;
+	mempool_t *pool;
+	unsigned int seed;
+} membench_job_t;
+
+enum
+{
+	MEMBENCH_MALLOC,
+	MEMBENCH_OWNPOOL,
+	MEMBENCH_SHAREDPOOL,
+
+	MEMBENCH_NUMMODES
+};
+
+static const char *membench_modeNames[MEMBENCH_NUMMODES] =
+{
+	"malloc", "Mem_Alloc (pool per thread)", "Mem_Alloc (shared pool)"
+};
+
+/*
+* MemBench_Job
+*
+* Allocates and frees blocks of random sizes keeping a fixed number of them alive
+*/
+static void *MemBench_Job( void *param )
+{
+	int i, slot;
+	size_t size;
+	membench_job_t *job = ( membench_job_t * )param;
+	unsigned int seed = job->seed;
+	mempool_t *pool = job->pool;
+	void *live[MEMBENCH_LIVE_BLOCKS];
+
+	memset( live, 0, sizeof( live ) );
+
+	if( job->mode == MEMBENCH_OWNPOOL )
+		pool = Mem_AllocPool( NULL, "Membench" );
+
+	for( i = 0; i < job->iterations; i++ )
+	{
+		seed = seed * 1103515245 + 12345;
+		slot = ( seed >> 16 ) % MEMBENCH_LIVE_BLOCKS;
+
+		// mostly small blocks, as the engine does
+		seed = seed * 1103515245 + 12345;
+		size = 8 + ( ( seed >> 16 ) & 255 );
+		if( !( i & 15 ) )
+			size <<= 4;
+
+		if( job->mode == MEMBENCH_MALLOC )
+		{
+			free( live[slot] );
+			live[slot] = malloc( size );
+		}
+		else
+		{
+			if( live[slot] )
+				Mem_Free( live[slot] );
+			live[slot] = Mem_Alloc( pool, size );
+		}
+	}
+
+	for( i = 0; i < MEMBENCH_LIVE_BLOCKS; i++ )
+	{
+		if( job->mode == MEMBENCH_MALLOC )
+			free( live[i] );
+		else if( live[i] )
+			Mem_Free( live[i] );
+	}
+
+	if( job->mode == MEMBENCH_OWNPOOL )
+		Mem_FreePool( &pool );
+
+	return NULL;
+}
+
+/*
+* MemBench_f
+*/
+static void MemBench_f( void )
+{
+	int i, mode, numThreads, iterations;
+	uint64_t time;
+	mempool_t *sharedPool;
+	qthread_t *threads[MEMBENCH_MAX_THREADS];
+	membench_job_t jobs[MEMBENCH_MAX_THREADS];
+
+	numThreads = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 4;
+	iterations = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1000000;
+	clamp( numThreads, 1, MEMBENCH_MAX_THREADS );
+	clamp_low( iterations, 1 );
+
+	Com_Printf( "membench: %i threads, %i allocations each\n", numThreads, iterations );
+
+	sharedPool = Mem_AllocPool( NULL, "Membench" );
+
+	for( mode = 0; mode < MEMBENCH_NUMMODES; mode++ )
+	{
+		time = Sys_Microseconds();
+
+		for( i = 0; i < numThreads; i++ )
+		{
+			jobs[i].mode = mode;
+			jobs[i].iterations = iterations;
+			jobs[i].pool = sharedPool;
+			jobs[i].seed = i + 1;
+			threads[i] = i ? QThread_Create( MemBench_Job, &jobs[i] ) : NULL;
+		}
+
+		MemBench_Job( &jobs[0] );
+		for( i = 1; i < numThreads; i++ )
+			QThread_Join( threads[i] );
+
+		time = Sys_Microseconds() - time;
+		Com_Printf( "%-30s %8.2fms, %6.1fns per allocation\n", membench_modeNames[mode], time / 1000.0,
+			time * 1000.0 / ( (double)iterations * numThreads ) );
+	}
+
+	Mem_FreePool( &sharedPool );
+}
+
 
 /*
 * Memory_Init
@@ -664,6 +1184,11 @@ void Memory_Init( void )
 
 	memMutex = QMutex_Create();
 
+	Mem_InitSlabs();
+
+	memset( &memArena, 0, sizeof( memArena ) );
+	memArena.mutex = QMutex_Create();
+
 	zoneMemPool = Mem_AllocPool( NULL, "Zone" );
 	tempMemPool = Mem_AllocTempPool( "Temporary Memory" );
 
@@ -681,6 +1206,7 @@ void Memory_InitCommands( void )
 
 	Cmd_AddCommand( "memlist", MemList_f );
 	Cmd_AddCommand( "memstats", MemStats_f );
+	Cmd_AddCommand( "membench", MemBench_f );
 
 	commands_initialized = true;
 }
@@ -716,6 +1242,15 @@ void Memory_Shutdown( void )
 		Mem_FreePool( &pool );
 	}
 
+	Mem_ShutdownSlabs();
+
+	// the arena only keeps a single block after being cleared
+	Mem_ClearFrameArena();
+	if( memArena.current )
+		free( memArena.current );
+	QMutex_Destroy( &memArena.mutex );
+	memset( &memArena, 0, sizeof( memArena ) );
+
 	QMutex_Destroy( &memMutex );
 
 	memory_initialized = false;
@@ -731,4 +1266,5 @@ void Memory_ShutdownCommands( void )
 
 	Cmd_RemoveCommand( "memlist" );
 	Cmd_RemoveCommand( "memstats" );
+	Cmd_RemoveCommand( "membench" );
 }
@@ -18,6 +18,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+#	define _GNU_SOURCE // recvmmsg, sendmmsg
+#endif
+
 #include "qcommon.h"
 
 #include "sys_net.h"
@@ -49,6 +53,20 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #	define MSG_NOSIGNAL 0
 #endif
 
+#if defined( __linux__ ) && defined( MSG_WAITFORONE )
+#	define USE_UDP_MMSG
+#endif
+
+#if defined( __linux__ )
+#	define USE_EPOLL
+#	include <errno.h>
+#	include <sys/epoll.h>
+#endif
+
+#define NET_SENDQUEUE_PACKETS	512
+#define NET_SENDQUEUE_SIZE		0x40000
+#define NET_SENDERROR_SIZE		80
+
 
 typedef struct
 {
@@ -67,6 +85,49 @@ static loopback_t loopbacks[2];
 static char errorstring[MAX_PRINTMSG];
 static bool	net_initialized = false;
 
+typedef struct
+{
+	const socket_t *socket;
+	netadr_t address;
+	size_t offset;
+	size_t length;
+	bool sent;
+} queuedpacket_t;
+
+typedef struct
+{
+	bool active;
+	void ( *senderror )( const socket_t *socket, const netadr_t *address, const char *error );
+	int numpackets;
+	size_t datasize;
+	queuedpacket_t packets[NET_SENDQUEUE_PACKETS];
+	char errors[NET_SENDQUEUE_PACKETS][NET_SENDERROR_SIZE];	// empty unless the packet failed
+	uint8_t data[NET_SENDQUEUE_SIZE];
+} sendqueue_t;
+
+static sendqueue_t sendqueue;
+
+// set in the thread between NET_BeginSendQueue and NET_FlushSendQueue, the
+// queue is never touched from any other thread
+static Q_THREADLOCAL bool sendqueueowner;
+
+struct netpoll_s
+{
+#ifdef USE_EPOLL
+	int fd;
+#else
+	int numsockets;
+	struct {
+		socket_handle_t handle;
+		int events;
+		void *data;
+	} sockets[FD_SETSIZE];
+#endif
+};
+
+static bool NET_QueuePacket( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
+static void NET_SendQueuedPackets( const socket_t *only );
+
 #define MAX_IPS 16
 static int numIP;
 static uint8_t localIP[MAX_IPS][4];
@@ -408,6 +469,165 @@ static bool NET_UDP_SendPacket( const socket_t *socket, const void *data, size_t
 	return true;
 }
 
+#ifdef USE_UDP_MMSG
+
+/*
+* NET_UDP_GetPackets
+*
+* Reads up to maxpackets datagrams with a single recvmmsg call. Datagrams we
+* can't use are dropped and the good ones are moved to the front of the arrays.
+*/
+static int NET_UDP_GetPackets( const socket_t *socket, netadr_t *addresses, msg_t *messages, int maxpackets )
+{
+	struct mmsghdr msgvec[MAX_PACKET_BATCH];
+	struct iovec iov[MAX_PACKET_BATCH];
+	struct sockaddr_storage from[MAX_PACKET_BATCH];
+	msg_t tmp;
+	int i, ret, numpackets;
+
+	assert( socket && socket->open && socket->type == SOCKET_UDP );
+	assert( addresses );
+	assert( messages );
+
+	if( maxpackets > MAX_PACKET_BATCH )
+		maxpackets = MAX_PACKET_BATCH;
+
+	memset( msgvec, 0, sizeof( *msgvec ) * maxpackets );
+	for( i = 0; i < maxpackets; i++ )
+	{
+		assert( messages[i].data );
+		assert( messages[i].maxsize > 0 );
+
+		iov[i].iov_base = messages[i].data;
+		iov[i].iov_len = messages[i].maxsize;
+		msgvec[i].msg_hdr.msg_name = &from[i];
+		msgvec[i].msg_hdr.msg_namelen = sizeof( from[i] );
+		msgvec[i].msg_hdr.msg_iov = &iov[i];
+		msgvec[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	ret = recvmmsg( socket->handle, msgvec, maxpackets, MSG_DONTWAIT, NULL );
+	if( ret == SOCKET_ERROR )
+	{
+		net_error_t err;
+
+		NET_SetErrorStringFromLastError( "recvmmsg" );
+
+		err = Sys_NET_GetLastError();
+		if( err == NET_ERR_WOULDBLOCK || err == NET_ERR_CONNRESET )  // would block
+			return 0;
+
+		return -1;
+	}
+
+	numpackets = 0;
+	for( i = 0; i < ret; i++ )
+	{
+		if( !SockaddressToAddress( (struct sockaddr*)&from[i], &addresses[numpackets] ) )
+			continue;
+
+		if( msgvec[i].msg_len >= messages[i].maxsize || ( msgvec[i].msg_hdr.msg_flags & MSG_TRUNC ) )
+		{
+			NET_SetErrorString( "Oversized packet" );
+			Com_DPrintf( "NET_GetPackets: Dropped packet from %s: %s\n", NET_AddressToString( &addresses[numpackets] ), errorstring );
+			continue;
+		}
+
+		// swap the buffers so the received data doesn't have to be copied
+		if( i != numpackets )
+		{
+			tmp = messages[numpackets];
+			messages[numpackets] = messages[i];
+			messages[i] = tmp;
+		}
+
+		messages[numpackets].readcount = 0;
+		messages[numpackets].cursize = msgvec[i].msg_len;
+		numpackets++;
+	}
+
+	if( ret > 0 && !numpackets )
+		return -1;
+
+	return numpackets;
+}
+
+/*
+* NET_UDP_SendPackets
+*/
+static int NET_UDP_SendPackets( const socket_t *socket, const msg_t *messages, const netadr_t *addresses, int numpackets, bool *failed,
+							   char (*errors)[NET_SENDERROR_SIZE] )
+{
+	struct mmsghdr msgvec[MAX_PACKET_BATCH];
+	struct iovec iov[MAX_PACKET_BATCH];
+	struct sockaddr_storage addr[MAX_PACKET_BATCH];
+	int index[MAX_PACKET_BATCH];
+	int i, ret, count, sent, next;
+
+	assert( socket && socket->open && socket->type == SOCKET_UDP );
+	assert( messages );
+	assert( addresses );
+
+	sent = 0;
+	next = 0;
+	while( next < numpackets )
+	{
+		memset( msgvec, 0, sizeof( msgvec ) );
+
+		for( count = 0; next < numpackets && count < MAX_PACKET_BATCH; next++ )
+		{
+			if( addresses[next].type == NA_NOTRANSMIT )
+			{
+				sent++;
+				continue;
+			}
+			if( !AddressToSockaddress( &addresses[next], &addr[count] ) )
+			{
+				NET_SetErrorString( "Invalid address" );
+				if( failed )
+					failed[next] = true;
+				if( errors )
+					Q_strncpyz( errors[next], errorstring, sizeof( errors[next] ) );
+				continue;
+			}
+
+			assert( messages[next].cursize > 0 );
+
+			index[count] = next;
+			iov[count].iov_base = messages[next].data;
+			iov[count].iov_len = messages[next].cursize;
+			msgvec[count].msg_hdr.msg_name = &addr[count];
+			msgvec[count].msg_hdr.msg_namelen = ( addr[count].ss_family == AF_INET6 ? sizeof( struct sockaddr_in6 ) : sizeof( struct sockaddr_in ) );
+			msgvec[count].msg_hdr.msg_iov = &iov[count];
+			msgvec[count].msg_hdr.msg_iovlen = 1;
+			count++;
+		}
+
+		for( i = 0; i < count; )
+		{
+			ret = sendmmsg( socket->handle, msgvec + i, count - i, 0 );
+			if( ret == SOCKET_ERROR )
+			{
+				// skip the datagram that failed and carry on with the rest
+				NET_SetErrorStringFromLastError( "sendmmsg" );
+				if( failed )
+					failed[index[i]] = true;
+				if( errors )
+					Q_strncpyz( errors[index[i]], errorstring, sizeof( errors[index[i]] ) );
+				i++;
+				continue;
+			}
+
+			i += ret;
+			sent += ret;
+		}
+	}
+
+	return sent;
+}
+
+#endif // USE_UDP_MMSG
+
 /*
 * NET_IP_OpenSocket
 */
@@ -649,7 +869,7 @@ static bool NET_TCP_Listen( const socket_t *socket )
 {
 	assert( socket && socket->open && socket->type == SOCKET_TCP && socket->handle );
 
-	if( listen( socket->handle, 8 ) == -1 )
+	if( listen( socket->handle, SOMAXCONN ) == -1 )
 	{
 		NET_SetErrorStringFromLastError( "listen" );
 		return false;
@@ -1063,6 +1283,8 @@ bool NET_SendPacket( const socket_t *socket, const void *data, size_t length, co
 		return NET_Loopback_SendPacket( socket, data, length, address );
 
 	case SOCKET_UDP:
+		if( sendqueue.active && sendqueueowner )
+			return NET_QueuePacket( socket, data, length, address );
 		return NET_UDP_SendPacket( socket, data, length, address );
 
 #ifdef TCP_SUPPORT
@@ -1077,6 +1299,259 @@ bool NET_SendPacket( const socket_t *socket, const void *data, size_t length, co
 	}
 }
 
+/*
+* NET_GetPackets
+* 
+* Reads up to maxpackets datagrams into the given messages, with a single
+* system call where the platform supports it. Packets that couldn't be
+* received properly are skipped, so the messages may be reordered.
+* 
+* >0	number of packets received
+* 0	not ready
+* -1	error
+*/
+int NET_GetPackets( const socket_t *socket, netadr_t *addresses, msg_t *messages, int maxpackets )
+{
+	int i, ret;
+
+	assert( socket->open );
+
+	if( !socket->open )
+		return -1;
+
+#ifdef USE_UDP_MMSG
+	if( socket->type == SOCKET_UDP )
+		return NET_UDP_GetPackets( socket, addresses, messages, maxpackets );
+#endif
+
+	for( i = 0; i < maxpackets; i++ )
+	{
+		ret = NET_GetPacket( socket, &addresses[i], &messages[i] );
+		if( ret == 0 )
+			break;
+		if( ret == -1 )
+			return i ? i : -1;
+	}
+
+	return i;
+}
+
+/*
+* NET_SendPackets
+* 
+* Returns the number of packets sent, the error string is set for the ones that failed.
+* If failed is not NULL, it must hold numpackets flags, which are set for the packets
+* that couldn't be sent and left untouched for the others.
+*/
+int NET_SendPackets( const socket_t *socket, const msg_t *messages, const netadr_t *addresses, int numpackets, bool *failed )
+{
+	int i, sent;
+	bool ok;
+
+	assert( socket->open );
+
+	if( !socket->open )
+		return 0;
+
+#ifdef USE_UDP_MMSG
+	if( socket->type == SOCKET_UDP )
+		return NET_UDP_SendPackets( socket, messages, addresses, numpackets, failed, NULL );
+#endif
+
+	sent = 0;
+	for( i = 0; i < numpackets; i++ )
+	{
+		if( socket->type == SOCKET_UDP && addresses[i].type != NA_NOTRANSMIT )
+			ok = NET_UDP_SendPacket( socket, messages[i].data, messages[i].cursize, &addresses[i] );
+		else
+			ok = NET_SendPacket( socket, messages[i].data, messages[i].cursize, &addresses[i] );
+
+		if( ok )
+			sent++;
+		else if( failed )
+			failed[i] = true;
+	}
+
+	return sent;
+}
+
+/*
+* NET_QueuePacket
+* 
+* Copies an outgoing UDP packet to the send queue, flushing the queue first if it doesn't fit
+*/
+static bool NET_QueuePacket( const socket_t *socket, const void *data, size_t length, const netadr_t *address )
+{
+	queuedpacket_t *packet;
+
+	if( length > NET_SENDQUEUE_SIZE )
+		return NET_UDP_SendPacket( socket, data, length, address );
+
+	if( sendqueue.numpackets == NET_SENDQUEUE_PACKETS || sendqueue.datasize + length > NET_SENDQUEUE_SIZE )
+		NET_SendQueuedPackets( NULL );
+
+	packet = &sendqueue.packets[sendqueue.numpackets++];
+	packet->socket = socket;
+	packet->address = *address;
+	packet->offset = sendqueue.datasize;
+	packet->length = length;
+	packet->sent = false;
+
+	memcpy( sendqueue.data + sendqueue.datasize, data, length );
+	sendqueue.datasize += length;
+
+	return true;
+}
+
+/*
+* NET_SendQueuedBatch
+* 
+* Sends consecutive queued packets for the same socket, the error of each one
+* that fails is recorded with it
+*/
+static void NET_SendQueuedBatch( const socket_t *socket, int first, int count )
+{
+	msg_t messages[MAX_PACKET_BATCH];
+	netadr_t addresses[MAX_PACKET_BATCH];
+	queuedpacket_t *packet;
+	int i;
+
+	for( i = 0; i < count; i++ )
+	{
+		packet = &sendqueue.packets[first + i];
+		packet->sent = true;
+		sendqueue.errors[first + i][0] = '\0';
+
+		MSG_Init( &messages[i], sendqueue.data + packet->offset, packet->length );
+		messages[i].cursize = packet->length;
+		addresses[i] = packet->address;
+	}
+
+	if( !socket->open )
+		return;
+
+#ifdef USE_UDP_MMSG
+	NET_UDP_SendPackets( socket, messages, addresses, count, NULL, sendqueue.errors + first );
+#else
+	for( i = 0; i < count; i++ )
+	{
+		if( !NET_UDP_SendPacket( socket, messages[i].data, messages[i].cursize, &addresses[i] ) )
+			Q_strncpyz( sendqueue.errors[first + i], errorstring, sizeof( sendqueue.errors[first + i] ) );
+	}
+#endif
+}
+
+/*
+* NET_SendQueuedPackets
+* 
+* Sends the queued packets in batches of consecutive packets for the same socket,
+* or only the ones for the given socket, which are then left in the queue as sent.
+* Packets that couldn't be sent are reported with their own error to the senderror
+* callback given to NET_BeginSendQueue, once they are all out.
+*/
+static void NET_SendQueuedPackets( const socket_t *only )
+{
+	const queuedpacket_t *packet;
+	const socket_t *socket;
+	int i, first, count, numpackets;
+	bool active, failed;
+	char error[NET_SENDERROR_SIZE];
+
+	if( !sendqueue.numpackets )
+		return;
+
+	numpackets = sendqueue.numpackets;
+	failed = false;
+
+	for( i = 0; i < numpackets; )
+	{
+		packet = &sendqueue.packets[i];
+		socket = packet->socket;
+		if( packet->sent || ( only && socket != only ) )
+		{
+			i++;
+			continue;
+		}
+
+		for( first = i, count = 0; i < numpackets && count < MAX_PACKET_BATCH; i++, count++ )
+		{
+			packet = &sendqueue.packets[i];
+			if( packet->socket != socket || packet->sent )
+				break;
+		}
+
+		NET_SendQueuedBatch( socket, first, count );
+
+		for( ; first < i; first++ )
+			failed = failed || sendqueue.errors[first][0];
+	}
+
+	if( !only )
+	{
+		sendqueue.numpackets = 0;
+		sendqueue.datasize = 0;
+	}
+
+	if( !failed )
+		return;
+
+	// the packet headers stay valid as nothing can be queued while the callback runs,
+	// whatever it sends in reply goes out directly
+	active = sendqueue.active;
+	sendqueue.active = false;
+	for( i = 0; i < numpackets; i++ )
+	{
+		packet = &sendqueue.packets[i];
+		if( !sendqueue.errors[i][0] || ( only && packet->socket != only ) )
+			continue;
+
+		// clear it first, the callback may close a socket and get back here
+		Q_strncpyz( error, sendqueue.errors[i], sizeof( error ) );
+		sendqueue.errors[i][0] = '\0';
+
+		if( sendqueue.senderror )
+			sendqueue.senderror( packet->socket, &packet->address, error );
+		else
+			Com_Printf( "Error sending packet to %s: %s\n", NET_AddressToString( &packet->address ), error );
+	}
+	sendqueue.active = active;
+}
+
+/*
+* NET_BeginSendQueue
+* 
+* Until NET_FlushSendQueue is called, UDP packets passed to NET_SendPacket by
+* the calling thread are queued and sent together, other threads send directly.
+* Must only be used from the main thread.
+* As NET_SendPacket can't report failures of queued packets, senderror is called
+* for each of them when the queue is flushed. If NULL, the error is only printed.
+*/
+void NET_BeginSendQueue( void ( *senderror )( const socket_t *socket, const netadr_t *address, const char *error ) )
+{
+	assert( sendqueueowner || !sendqueue.active );
+
+	NET_SendQueuedPackets( NULL );
+	sendqueue.active = true;
+	sendqueue.senderror = senderror;
+	sendqueueowner = true;
+}
+
+/*
+* NET_FlushSendQueue
+* 
+* Also called by Com_Error, so an error in the middle of a frame doesn't leave the queue active
+*/
+void NET_FlushSendQueue( void )
+{
+	if( !sendqueueowner )
+		return;
+
+	NET_SendQueuedPackets( NULL );
+	sendqueue.active = false;
+	sendqueue.senderror = NULL;
+	sendqueueowner = false;
+}
+
 /*
 * NET_Send
 */
@@ -1746,6 +2221,11 @@ void NET_CloseSocket( socket_t *socket )
 	if( !socket->open )
 		return;
 
+	// don't leave queued packets pointing at a closed socket, only the
+	// thread that queued them may send them
+	if( socket->type == SOCKET_UDP && sendqueueowner )
+		NET_SendQueuedPackets( socket );
+
 	switch( socket->type )
 	{
 	case SOCKET_LOOPBACK:
@@ -1919,6 +2399,227 @@ int NET_Monitor( int msec, socket_t *sockets[], void (*read_cb)(socket_t *, void
 	return ret;
 }
 
+/*
+* NET_CreatePoll
+*
+* A poll set keeps the sockets and the events we are interested in between
+* waits, so waiting doesn't cost more with the number of idle sockets. It is
+* level-triggered: a socket is reported for as long as it is ready.
+*/
+netpoll_t *NET_CreatePoll( void )
+{
+	netpoll_t *poll;
+
+	poll = Mem_ZoneMalloc( sizeof( *poll ) );
+#ifdef USE_EPOLL
+	poll->fd = epoll_create1( EPOLL_CLOEXEC );
+	if( poll->fd == -1 )
+	{
+		NET_SetErrorStringFromLastError( "epoll_create1" );
+		Mem_ZoneFree( poll );
+		return NULL;
+	}
+#endif
+	return poll;
+}
+
+/*
+* NET_DestroyPoll
+*/
+void NET_DestroyPoll( netpoll_t **ppoll )
+{
+	netpoll_t *poll = *ppoll;
+
+	if( !poll )
+		return;
+
+#ifdef USE_EPOLL
+	close( poll->fd );
+#endif
+	Mem_ZoneFree( poll );
+	*ppoll = NULL;
+}
+
+/*
+* NET_PollSet
+*
+* Adds the socket to the poll set or changes the events it's waited for.
+* Errors and hangups are always reported, even with no events.
+*/
+bool NET_PollSet( netpoll_t *poll, const socket_t *socket, int events, void *data )
+{
+#ifdef USE_EPOLL
+	struct epoll_event ev;
+
+	memset( &ev, 0, sizeof( ev ) );
+	ev.events = ( ( events & NET_POLL_READ ) ? EPOLLIN : 0 ) | ( ( events & NET_POLL_WRITE ) ? EPOLLOUT : 0 );
+	ev.data.ptr = data;
+
+	if( epoll_ctl( poll->fd, EPOLL_CTL_MOD, socket->handle, &ev ) == -1 )
+	{
+		if( errno != ENOENT || epoll_ctl( poll->fd, EPOLL_CTL_ADD, socket->handle, &ev ) == -1 )
+		{
+			NET_SetErrorStringFromLastError( "epoll_ctl" );
+			return false;
+		}
+	}
+	return true;
+#else
+	int i;
+
+	for( i = 0; i < poll->numsockets; i++ )
+	{
+		if( poll->sockets[i].handle == socket->handle )
+			break;
+	}
+	if( i == poll->numsockets )
+	{
+#ifndef _WIN32
+		// fd_set is a bitmask indexed by the handle outside of Windows
+		if( socket->handle >= FD_SETSIZE )
+		{
+			NET_SetErrorString( "Socket handle exceeds FD_SETSIZE" );
+			return false;
+		}
+#endif
+		if( poll->numsockets == FD_SETSIZE )
+		{
+			NET_SetErrorString( "Too many sockets in the poll set" );
+			return false;
+		}
+		poll->numsockets++;
+	}
+
+	poll->sockets[i].handle = socket->handle;
+	poll->sockets[i].events = events;
+	poll->sockets[i].data = data;
+	return true;
+#endif
+}
+
+/*
+* NET_PollMaxSockets
+*
+* Returns how many sockets a poll set can hold, or 0 if only the system limits apply
+*/
+int NET_PollMaxSockets( void )
+{
+#ifdef USE_EPOLL
+	return 0;
+#else
+	return FD_SETSIZE;
+#endif
+}
+
+/*
+* NET_PollRemove
+*
+* Must be called before the socket is closed.
+*/
+void NET_PollRemove( netpoll_t *poll, const socket_t *socket )
+{
+#ifdef USE_EPOLL
+	struct epoll_event ev;
+
+	epoll_ctl( poll->fd, EPOLL_CTL_DEL, socket->handle, &ev );
+#else
+	int i;
+
+	for( i = 0; i < poll->numsockets; i++ )
+	{
+		if( poll->sockets[i].handle == socket->handle )
+		{
+			poll->sockets[i] = poll->sockets[--poll->numsockets];
+			break;
+		}
+	}
+#endif
+}
+
+/*
+* NET_PollWait
+*
+* Waits up to msec milliseconds for any of the sockets to get ready and
+* returns the number of events stored, or -1 on error.
+*/
+int NET_PollWait( netpoll_t *poll, int msec, netpollevent_t *events, int maxevents )
+{
+#ifdef USE_EPOLL
+	struct epoll_event evs[NET_POLL_MAX_EVENTS];
+	int i, ret;
+
+	ret = epoll_wait( poll->fd, evs, min( maxevents, NET_POLL_MAX_EVENTS ), msec );
+	if( ret == -1 )
+	{
+		if( errno == EINTR )
+			return 0;
+		NET_SetErrorStringFromLastError( "epoll_wait" );
+		return -1;
+	}
+
+	for( i = 0; i < ret; i++ )
+	{
+		events[i].data = evs[i].data.ptr;
+		events[i].events = 0;
+		if( evs[i].events & EPOLLIN )
+			events[i].events |= NET_POLL_READ;
+		if( evs[i].events & EPOLLOUT )
+			events[i].events |= NET_POLL_WRITE;
+		if( evs[i].events & ( EPOLLERR|EPOLLHUP ) )
+			events[i].events |= NET_POLL_ERROR;
+	}
+	return ret;
+#else
+	struct timeval timeout;
+	fd_set fdsetr, fdsetw, fdsete;
+	int i, ret, numevents;
+	int fdmax = 0;
+
+	FD_ZERO( &fdsetr );
+	FD_ZERO( &fdsetw );
+	FD_ZERO( &fdsete );
+
+	for( i = 0; i < poll->numsockets; i++ )
+	{
+		fdmax = max( (int)poll->sockets[i].handle, fdmax );
+		if( poll->sockets[i].events & NET_POLL_READ )
+			FD_SET( poll->sockets[i].handle, &fdsetr );
+		if( poll->sockets[i].events & NET_POLL_WRITE )
+			FD_SET( poll->sockets[i].handle, &fdsetw );
+		FD_SET( poll->sockets[i].handle, &fdsete );
+	}
+
+	timeout.tv_sec = msec / 1000;
+	timeout.tv_usec = ( msec % 1000 ) * 1000;
+	ret = select( fdmax+1, &fdsetr, &fdsetw, &fdsete, &timeout );
+	if( ret == SOCKET_ERROR )
+	{
+		NET_SetErrorStringFromLastError( "select" );
+		return -1;
+	}
+
+	numevents = 0;
+	for( i = 0; i < poll->numsockets && ret > 0 && numevents < maxevents; i++ )
+	{
+		int ev = 0;
+
+		if( FD_ISSET( poll->sockets[i].handle, &fdsetr ) )
+			ev |= NET_POLL_READ;
+		if( FD_ISSET( poll->sockets[i].handle, &fdsetw ) )
+			ev |= NET_POLL_WRITE;
+		if( FD_ISSET( poll->sockets[i].handle, &fdsete ) )
+			ev |= NET_POLL_ERROR;
+		if( !ev )
+			continue;
+
+		events[numevents].data = poll->sockets[i].data;
+		events[numevents].events = ev;
+		numevents++;
+	}
+	return numevents;
+#endif
+}
+
 /*
 * NET_SendFile
 */
@@ -1967,6 +2668,8 @@ void NET_Init( void )
 
 	GetLocalAddress();
 
+	Cmd_AddCommand( "addrhashbench", NET_AddrHashBench_f );
+
 	net_initialized = true;
 }
 
@@ -1980,6 +2683,10 @@ void NET_Shutdown( void )
 
 	errorstring[0] = '\0';
 
+	NET_FlushSendQueue();
+
+	Cmd_RemoveCommand( "addrhashbench" );
+
 	Sys_NET_Shutdown();
 
 	net_initialized = false;
@@ -0,0 +1,289 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+
+/*
+* Maps a base address (without the port) plus the game port sent in the
+* packet header to a client slot, so incoming packets can be dispatched
+* without scanning the whole client list. The port isn't part of the key
+* because address translating routers may change it.
+*/
+
+struct netaddrhash_s
+{
+	struct mempool_s *pool;
+	int numslots;
+	int hashmask;
+	int *heads;
+	int *next;
+	int *bucket;            // -1 if the slot isn't linked
+	netadr_t *addresses;
+	int *game_ports;
+};
+
+/*
+* NET_AddrHashKey
+*/
+static unsigned int NET_AddrHashKey( const netadr_t *address, int game_port )
+{
+	const uint8_t *ip;
+	size_t i, iplen;
+	unsigned int hash = 2166136261u;
+
+	switch( address->type )
+	{
+	case NA_IP:
+		ip = address->address.ipv4.ip;
+		iplen = sizeof( address->address.ipv4.ip );
+		break;
+	case NA_IP6:
+		ip = address->address.ipv6.ip;
+		iplen = sizeof( address->address.ipv6.ip );
+		break;
+	default:
+		ip = NULL;
+		iplen = 0;
+		break;
+	}
+
+	for( i = 0; i < iplen; i++ )
+		hash = ( hash ^ ip[i] ) * 16777619u;
+	hash = ( hash ^ ( game_port & 0xff ) ) * 16777619u;
+	hash = ( hash ^ ( ( game_port >> 8 ) & 0xff ) ) * 16777619u;
+	hash = ( hash ^ address->type ) * 16777619u;
+
+	return hash;
+}
+
+/*
+* NET_CreateAddrHash
+*/
+netaddrhash_t *NET_CreateAddrHash( struct mempool_s *pool, int numslots )
+{
+	int i, hashsize;
+	netaddrhash_t *hash;
+
+	assert( numslots > 0 );
+
+	for( hashsize = 16; hashsize < numslots * 2; hashsize <<= 1 );
+
+	hash = Mem_Alloc( pool, sizeof( *hash ) );
+	hash->pool = pool;
+	hash->numslots = numslots;
+	hash->hashmask = hashsize - 1;
+	hash->heads = Mem_Alloc( pool, sizeof( *hash->heads ) * hashsize );
+	hash->next = Mem_Alloc( pool, sizeof( *hash->next ) * numslots );
+	hash->bucket = Mem_Alloc( pool, sizeof( *hash->bucket ) * numslots );
+	hash->addresses = Mem_Alloc( pool, sizeof( *hash->addresses ) * numslots );
+	hash->game_ports = Mem_Alloc( pool, sizeof( *hash->game_ports ) * numslots );
+
+	for( i = 0; i < hashsize; i++ )
+		hash->heads[i] = -1;
+	for( i = 0; i < numslots; i++ )
+		hash->next[i] = hash->bucket[i] = -1;
+
+	return hash;
+}
+
+/*
+* NET_FreeAddrHash
+*/
+void NET_FreeAddrHash( netaddrhash_t **phash )
+{
+	netaddrhash_t *hash = *phash;
+
+	if( !hash )
+		return;
+
+	Mem_Free( hash->heads );
+	Mem_Free( hash->next );
+	Mem_Free( hash->bucket );
+	Mem_Free( hash->addresses );
+	Mem_Free( hash->game_ports );
+	Mem_Free( hash );
+
+	*phash = NULL;
+}
+
+/*
+* NET_AddrHashUnlink
+*/
+void NET_AddrHashUnlink( netaddrhash_t *hash, int slot )
+{
+	int *link;
+
+	assert( slot >= 0 && slot < hash->numslots );
+
+	if( hash->bucket[slot] < 0 )
+		return;
+
+	for( link = &hash->heads[hash->bucket[slot]]; *link >= 0; link = &hash->next[*link] )
+	{
+		if( *link == slot )
+		{
+			*link = hash->next[slot];
+			break;
+		}
+	}
+
+	hash->next[slot] = -1;
+	hash->bucket[slot] = -1;
+}
+
+/*
+* NET_AddrHashLink
+*
+* Links the slot under the given address, replacing its previous one if any
+*/
+void NET_AddrHashLink( netaddrhash_t *hash, int slot, const netadr_t *address, int game_port )
+{
+	int bucket;
+
+	assert( slot >= 0 && slot < hash->numslots );
+
+	NET_AddrHashUnlink( hash, slot );
+
+	bucket = NET_AddrHashKey( address, game_port ) & hash->hashmask;
+	hash->addresses[slot] = *address;
+	hash->game_ports[slot] = game_port;
+	hash->bucket[slot] = bucket;
+	hash->next[slot] = hash->heads[bucket];
+	hash->heads[bucket] = slot;
+}
+
+/*
+* NET_AddrHashFind
+*
+* Returns the slot linked under the base address and game port or -1
+*/
+int NET_AddrHashFind( const netaddrhash_t *hash, const netadr_t *address, int game_port )
+{
+	int slot;
+
+	slot = hash->heads[NET_AddrHashKey( address, game_port ) & hash->hashmask];
+	for( ; slot >= 0; slot = hash->next[slot] )
+	{
+		if( hash->game_ports[slot] == game_port && NET_CompareBaseAddress( address, &hash->addresses[slot] ) )
+			return slot;
+	}
+
+	return -1;
+}
+
+/*
+* NET_AddrHashBench_f
+*
+* Replays a synthetic capture of incoming packets, mostly from connected
+* clients with some strays, against a linear scan of the client list
+* and against the hash.
+*/
+void NET_AddrHashBench_f( void )
+{
+	int i, j, found, misses, numclients, numpackets;
+	uint64_t time, linearTime, hashTime;
+	netadr_t *addresses, *capture;
+	int *game_ports, *captureGamePorts, *linearResults;
+	netaddrhash_t *hash;
+
+	numclients = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 256;
+	numpackets = Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 1000000;
+	clamp( numclients, 1, 4096 );
+	clamp_low( numpackets, 1 );
+
+	addresses = Mem_ZoneMalloc( sizeof( *addresses ) * numclients );
+	game_ports = Mem_ZoneMalloc( sizeof( *game_ports ) * numclients );
+	capture = Mem_ZoneMalloc( sizeof( *capture ) * numpackets );
+	captureGamePorts = Mem_ZoneMalloc( sizeof( *captureGamePorts ) * numpackets );
+	linearResults = Mem_ZoneMalloc( sizeof( *linearResults ) * numpackets );
+
+	hash = NET_CreateAddrHash( zoneMemPool, numclients );
+
+	// every fourth client shares its address with the previous one, as if behind the same NAT
+	for( i = 0; i < numclients; i++ )
+	{
+		if( i & 3 )
+		{
+			addresses[i] = addresses[i-1];
+		}
+		else
+		{
+			NET_InitAddress( &addresses[i], NA_IP );
+			addresses[i].address.ipv4.ip[0] = 10;
+			addresses[i].address.ipv4.ip[1] = ( i >> 16 ) & 0xff;
+			addresses[i].address.ipv4.ip[2] = ( i >> 8 ) & 0xff;
+			addresses[i].address.ipv4.ip[3] = i & 0xff;
+		}
+		NET_SetAddressPort( &addresses[i], 1024 + ( rand() & 0x7fff ) );
+		game_ports[i] = i;
+		NET_AddrHashLink( hash, i, &addresses[i], game_ports[i] );
+	}
+
+	for( i = 0; i < numpackets; i++ )
+	{
+		j = rand() % numclients;
+		capture[i] = addresses[j];
+		captureGamePorts[i] = game_ports[j];
+
+		// one in ten packets comes from nobody we know
+		if( !( rand() % 10 ) )
+			capture[i].address.ipv4.ip[0] = 192;
+	}
+
+	Com_Printf( "addrhashbench: %i clients, %i packets\n", numclients, numpackets );
+
+	time = Sys_Microseconds();
+	for( i = 0; i < numpackets; i++ )
+	{
+		found = -1;
+		for( j = 0; j < numclients; j++ )
+		{
+			if( !NET_CompareBaseAddress( &capture[i], &addresses[j] ) )
+				continue;
+			if( game_ports[j] != captureGamePorts[i] )
+				continue;
+			found = j;
+			break;
+		}
+		linearResults[i] = found;
+	}
+	linearTime = Sys_Microseconds() - time;
+
+	misses = 0;
+	time = Sys_Microseconds();
+	for( i = 0; i < numpackets; i++ )
+	{
+		if( NET_AddrHashFind( hash, &capture[i], captureGamePorts[i] ) != linearResults[i] )
+			misses++;
+	}
+	hashTime = Sys_Microseconds() - time;
+
+	Com_Printf( "%-10s %8.2fms, %6.1fns per packet\n", "linear", linearTime / 1000.0, linearTime * 1000.0 / numpackets );
+	Com_Printf( "%-10s %8.2fms, %6.1fns per packet\n", "hashed", hashTime / 1000.0, hashTime * 1000.0 / numpackets );
+	if( misses )
+		Com_Printf( S_COLOR_RED "%i lookups didn't match the linear scan\n", misses );
+
+	NET_FreeAddrHash( &hash );
+	Mem_ZoneFree( addresses );
+	Mem_ZoneFree( game_ports );
+	Mem_ZoneFree( capture );
+	Mem_ZoneFree( captureGamePorts );
+	Mem_ZoneFree( linearResults );
+}
@@ -0,0 +1,426 @@
+/*
+Copyright (C) 2026 Chasseur de bots
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "qcommon.h"
+
+/*
+* Per-stage timing histograms of the server frame. Samples are counted with
+* atomic increments, so stages that run on the snapshot job pool can be timed
+* too and the web thread can read them without stopping the frame. Besides
+* the totals since startup or the last reset, each stage keeps the histogram
+* of the last complete window of host_profile_window seconds.
+*
+* Buckets are linear below PROF_LINEAR_BUCKETS microseconds and then split
+* every power of two in 8, so any percentile is within 12.5% of the real value.
+*/
+
+#define PROF_MAX_NAME			32
+
+#define PROF_LINEAR_BUCKETS		16
+#define PROF_SUBBUCKET_BITS		3
+#define PROF_SUBBUCKETS			( 1 << PROF_SUBBUCKET_BITS )
+#define PROF_MIN_EXPONENT		4       // log2( PROF_LINEAR_BUCKETS )
+#define PROF_MAX_EXPONENT		30
+#define PROF_NUM_BUCKETS		( PROF_LINEAR_BUCKETS + ( PROF_MAX_EXPONENT - PROF_MIN_EXPONENT + 1 ) * PROF_SUBBUCKETS )
+
+#define PROF_NUM_PERCENTILES	4
+
+typedef struct
+{
+	volatile int counts[PROF_NUM_BUCKETS];
+	volatile int max;
+} prof_histogram_t;
+
+typedef struct
+{
+	char name[PROF_MAX_NAME];
+	prof_histogram_t total;
+	prof_histogram_t windows[2];
+} prof_stage_t;
+
+typedef struct
+{
+	int count;
+	int percentiles[PROF_NUM_PERCENTILES];
+	int max;
+} prof_summary_t;
+
+static const float prof_percentiles[PROF_NUM_PERCENTILES] = { 0.5f, 0.9f, 0.99f, 0.999f };
+static const char *prof_percentileNames[PROF_NUM_PERCENTILES] = { "p50", "p90", "p99", "p99.9" };
+
+static int prof_numStages;
+static prof_stage_t prof_stages[PROF_MAX_STAGES];
+
+static volatile int prof_window;        // index of the window being filled
+static unsigned int prof_windowStart;
+static unsigned int prof_totalStart;
+
+static bool prof_initialized = false;
+
+static cvar_t *host_profile;
+static cvar_t *host_profile_window;
+
+/*
+* Prof_Bucket
+*/
+static int Prof_Bucket( uint64_t usec )
+{
+	int e;
+
+	if( usec < PROF_LINEAR_BUCKETS )
+		return (int)usec;
+	if( usec >> ( PROF_MAX_EXPONENT + 1 ) )
+		return PROF_NUM_BUCKETS - 1;
+
+	e = Q_log2( (int)usec );
+	return PROF_LINEAR_BUCKETS + ( e - PROF_MIN_EXPONENT ) * PROF_SUBBUCKETS
+		+ (int)( ( usec >> ( e - PROF_SUBBUCKET_BITS ) ) & ( PROF_SUBBUCKETS - 1 ) );
+}
+
+/*
+* Prof_BucketValue
+*
+* Returns the largest value that falls into the bucket
+*/
+static int Prof_BucketValue( int bucket )
+{
+	int e, sub;
+
+	if( bucket < PROF_LINEAR_BUCKETS )
+		return bucket;
+
+	e = ( bucket - PROF_LINEAR_BUCKETS ) / PROF_SUBBUCKETS + PROF_MIN_EXPONENT;
+	sub = ( bucket - PROF_LINEAR_BUCKETS ) % PROF_SUBBUCKETS;
+	return (int)( ( (uint64_t)( PROF_SUBBUCKETS + sub + 1 ) << ( e - PROF_SUBBUCKET_BITS ) ) - 1 );
+}
+
+/*
+* Prof_AddToHistogram
+*/
+static void Prof_AddToHistogram( prof_histogram_t *hist, int bucket, int usec )
+{
+	int max;
+
+	QAtomic_Add( &hist->counts[bucket], 1, NULL );
+
+	do
+	{
+		max = hist->max;
+		if( usec <= max )
+			break;
+	}
+	while( !QAtomic_CAS( &hist->max, max, usec, NULL ) );
+}
+
+/*
+* Prof_Summarize
+*/
+static void Prof_Summarize( const prof_histogram_t *hist, prof_summary_t *summary )
+{
+	int i, p, bucket, count, target;
+	int counts[PROF_NUM_BUCKETS];
+
+	// take a copy so the percentiles agree with the sample count
+	// while the frame keeps adding to the histogram
+	count = 0;
+	for( bucket = 0; bucket < PROF_NUM_BUCKETS; bucket++ )
+	{
+		counts[bucket] = hist->counts[bucket];
+		count += counts[bucket];
+	}
+
+	memset( summary, 0, sizeof( *summary ) );
+	summary->count = count;
+	summary->max = hist->max;
+	if( !count )
+		return;
+
+	for( i = 0, p = 0, bucket = 0; i < PROF_NUM_PERCENTILES; i++ )
+	{
+		target = (int)ceil( count * prof_percentiles[i] );
+		for( ; bucket < PROF_NUM_BUCKETS; bucket++ )
+		{
+			if( p + counts[bucket] >= target )
+				break;
+			p += counts[bucket];
+		}
+		summary->percentiles[i] = min( Prof_BucketValue( min( bucket, PROF_NUM_BUCKETS - 1 ) ), summary->max );
+	}
+}
+
+/*
+* Prof_RegisterStage
+*
+* Returns the index of the stage with this name, creating it if needed.
+* Registering the same name again, as the game module does on every map,
+* hands back the same stage. Returns -1 when all stages are in use.
+*/
+int Prof_RegisterStage( const char *name )
+{
+	int i;
+
+	for( i = 0; i < prof_numStages; i++ )
+	{
+		if( !Q_stricmp( prof_stages[i].name, name ) )
+			return i;
+	}
+
+	if( prof_numStages == PROF_MAX_STAGES )
+	{
+		Com_DPrintf( "Prof_RegisterStage: too many stages, not timing %s\n", name );
+		return -1;
+	}
+
+	Q_strncpyz( prof_stages[prof_numStages].name, name, sizeof( prof_stages[0].name ) );
+	return prof_numStages++;
+}
+
+/*
+* Prof_Begin
+*
+* Returns the start time to pass to Prof_End, or 0 when profiling is off
+*/
+uint64_t Prof_Begin( void )
+{
+	if( !prof_initialized || !host_profile->integer )
+		return 0;
+	return Sys_Microseconds();
+}
+
+/*
+* Prof_End
+*/
+void Prof_End( int stage, uint64_t start )
+{
+	if( !start )
+		return;
+	Prof_AddSample( stage, Sys_Microseconds() - start );
+}
+
+/*
+* Prof_AddSample
+*/
+void Prof_AddSample( int stage, uint64_t usec )
+{
+	int bucket;
+	prof_stage_t *s;
+
+	if( stage < 0 || stage >= prof_numStages )
+		return;
+	if( !prof_initialized || !host_profile->integer )
+		return;
+
+	s = &prof_stages[stage];
+	bucket = Prof_Bucket( usec );
+	if( usec > INT_MAX )
+		usec = INT_MAX;
+
+	Prof_AddToHistogram( &s->total, bucket, (int)usec );
+	Prof_AddToHistogram( &s->windows[prof_window], bucket, (int)usec );
+}
+
+/*
+* Prof_Reset
+*/
+static void Prof_Reset( void )
+{
+	int i;
+
+	for( i = 0; i < prof_numStages; i++ )
+		memset( (void *)&prof_stages[i].total, 0, sizeof( prof_stages[i].total ) );
+	prof_totalStart = Sys_Milliseconds();
+}
+
+/*
+* Prof_Frame
+*
+* Starts a new window when the current one is complete
+*/
+void Prof_Frame( void )
+{
+	int i, next;
+	unsigned int now;
+
+	if( !prof_initialized || !host_profile->integer )
+		return;
+
+	now = Sys_Milliseconds();
+	if( now - prof_windowStart < (unsigned int)max( host_profile_window->integer, 1 ) * 1000 )
+		return;
+
+	next = prof_window ^ 1;
+	for( i = 0; i < prof_numStages; i++ )
+		memset( (void *)&prof_stages[i].windows[next], 0, sizeof( prof_stages[i].windows[next] ) );
+
+	prof_window = next;
+	prof_windowStart = now;
+}
+
+/*
+* Prof_PrintStages
+*/
+static void Prof_PrintStages( bool window )
+{
+	int i, j;
+	prof_stage_t *s;
+	prof_summary_t summary;
+
+	Com_Printf( "%-24s %8s", "ms", "samples" );
+	for( j = 0; j < PROF_NUM_PERCENTILES; j++ )
+		Com_Printf( " %8s", prof_percentileNames[j] );
+	Com_Printf( " %8s\n", "max" );
+
+	for( i = 0, s = prof_stages; i < prof_numStages; i++, s++ )
+	{
+		Prof_Summarize( window ? &s->windows[prof_window ^ 1] : &s->total, &summary );
+
+		Com_Printf( "%-24s %8i", s->name, summary.count );
+		for( j = 0; j < PROF_NUM_PERCENTILES; j++ )
+			Com_Printf( " %8.2f", summary.percentiles[j] * 0.001f );
+		Com_Printf( " %8.2f\n", summary.max * 0.001f );
+	}
+}
+
+/*
+* Prof_Profile_f
+*/
+static void Prof_Profile_f( void )
+{
+	const char *arg = Cmd_Argv( 1 );
+
+	if( !Q_stricmp( arg, "reset" ) )
+	{
+		Prof_Reset();
+		Com_Printf( "Profile reset\n" );
+		return;
+	}
+
+	if( !host_profile->integer )
+		Com_Printf( "host_profile is off, showing what was recorded before\n" );
+
+	if( !Q_stricmp( arg, "window" ) )
+	{
+		Com_Printf( "Last %i seconds:\n", max( host_profile_window->integer, 1 ) );
+		Prof_PrintStages( true );
+	}
+	else if( !arg[0] )
+	{
+		Com_Printf( "Since startup or reset, %u seconds:\n", ( Sys_Milliseconds() - prof_totalStart ) / 1000 );
+		Prof_PrintStages( false );
+	}
+	else
+	{
+		Com_Printf( "Usage: %s [window|reset]\n", Cmd_Argv( 0 ) );
+	}
+}
+
+/*
+* Prof_WriteSummaryJSON
+*/
+static size_t Prof_WriteSummaryJSON( char *buf, size_t size, const char *name, const prof_histogram_t *hist )
+{
+	int j;
+	size_t len;
+	prof_summary_t summary;
+
+	Prof_Summarize( hist, &summary );
+
+	Q_snprintfz( buf, size, "\"%s\":{\"samples\":%i", name, summary.count );
+	len = strlen( buf );
+	for( j = 0; j < PROF_NUM_PERCENTILES; j++ )
+	{
+		Q_snprintfz( buf + len, size - len, ",\"%s\":%i", prof_percentileNames[j], summary.percentiles[j] );
+		len += strlen( buf + len );
+	}
+	Q_snprintfz( buf + len, size - len, ",\"max\":%i}", summary.max );
+	return len + strlen( buf + len );
+}
+
+/*
+* Prof_WriteJSON
+*
+* Returns a zone allocated JSON document with the summaries of all stages,
+* in microseconds. Safe to call from any thread.
+*/
+char *Prof_WriteJSON( size_t *length )
+{
+	int i, numStages = prof_numStages;
+	size_t len, size;
+	char *buf;
+
+	size = 128 + numStages * ( PROF_MAX_NAME + 480 );
+	buf = Mem_ZoneMalloc( size );
+
+	Q_snprintfz( buf, size, "{\"enabled\":%i,\"unit\":\"usec\",\"window\":%i,\"uptime\":%u,\"stages\":[",
+		host_profile->integer ? 1 : 0, max( host_profile_window->integer, 1 ),
+		( Sys_Milliseconds() - prof_totalStart ) / 1000 );
+	len = strlen( buf );
+
+	for( i = 0; i < numStages; i++ )
+	{
+		Q_snprintfz( buf + len, size - len, "%s{\"name\":\"%s\",", i ? "," : "", prof_stages[i].name );
+		len += strlen( buf + len );
+		len += Prof_WriteSummaryJSON( buf + len, size - len, "total", &prof_stages[i].total );
+		Q_strncatz( buf + len, ",", size - len );
+		len++;
+		len += Prof_WriteSummaryJSON( buf + len, size - len, "window", &prof_stages[i].windows[prof_window ^ 1] );
+		Q_strncatz( buf + len, "}", size - len );
+		len++;
+	}
+
+	Q_strncatz( buf + len, "]}\n", size - len );
+	len += strlen( buf + len );
+
+	*length = len;
+	return buf;
+}
+
+/*
+* Prof_Init
+*/
+void Prof_Init( void )
+{
+	assert( !prof_initialized );
+
+	host_profile = Cvar_Get( "host_profile", "1", 0 );
+	host_profile_window = Cvar_Get( "host_profile_window", "10", CVAR_ARCHIVE );
+
+	prof_numStages = 0;
+	memset( (void *)prof_stages, 0, sizeof( prof_stages ) );
+	prof_window = 0;
+	prof_windowStart = prof_totalStart = Sys_Milliseconds();
+
+	Cmd_AddCommand( "profile", Prof_Profile_f );
+
+	prof_initialized = true;
+}
+
+/*
+* Prof_Shutdown
+*/
+void Prof_Shutdown( void )
+{
+	if( !prof_initialized )
+		return;
+
+	Cmd_RemoveCommand( "profile" );
+
+	prof_initialized = false;
+}
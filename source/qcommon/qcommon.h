@@ -152,7 +152,46 @@ void SNAP_BuildClientFrameSnap( struct cmodel_state_s *cms, struct ginfo_s *gi,
 
 void SNAP_FreeClientFrames( struct client_s *client );
 
+struct snapvis_cache_s *SNAP_CreateVisCache( struct mempool_s *mempool );
+void SNAP_FreeVisCache( struct snapvis_cache_s **pcache );
+
+struct snapdelta_cache_s *SNAP_CreateDeltaCache( struct mempool_s *mempool );
+void SNAP_FreeDeltaCache( struct snapdelta_cache_s **pcache );
+
+typedef struct
+{
+	unsigned int frames;
+	unsigned int builtFrames;			// built for a view
+	unsigned int sharedFrames;			// copied from the view
+	unsigned int reusedBodies;			// had their encoding copied from another client
+} snapfanoutstats_t;
+
+struct snapfanout_cache_s *SNAP_CreateFanoutCache( struct mempool_s *mempool );
+void SNAP_FreeFanoutCache( struct snapfanout_cache_s **pcache );
+void SNAP_FanoutCacheStats( const struct snapfanout_cache_s *cache, snapfanoutstats_t *stats );
+
 void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset );
+
+#define SNAP_DEMO_WRITER_BUFSIZE		0x100000
+
+typedef struct snapdemowriter_s snapdemowriter_t;
+
+typedef struct
+{
+	unsigned int messages;
+	uint64_t bytes;
+	int queued;						// bytes waiting to be written
+	int peakQueued;
+	unsigned int stalls;			// times the pipe was full
+	uint64_t stallTime;				// microseconds spent waiting on a full pipe
+	unsigned int errors;
+} snapdemowriterstats_t;
+
+snapdemowriter_t *SNAP_CreateDemoWriter( int demofile, size_t bufSize );
+void SNAP_DemoWriterRecordMessage( snapdemowriter_t *writer, msg_t *msg, int offset );
+int SNAP_DemoWriterOffset( const snapdemowriter_t *writer );
+void SNAP_DemoWriterStats( const snapdemowriter_t *writer, snapdemowriterstats_t *stats );
+void SNAP_DestroyDemoWriter( snapdemowriter_t **pwriter, snapdemowriterstats_t *stats );
 int SNAP_ReadDemoMessage( int demofile, msg_t *msg );
 void SNAP_BeginDemoRecording( int demofile, unsigned int spawncount, unsigned int snapFrameTime, 
 								const char *sv_name, unsigned int sv_bitflags, purelist_t *purelist, 
@@ -163,6 +202,24 @@ size_t SNAP_ClearDemoMeta( char *meta_data, size_t meta_data_max_size );
 size_t SNAP_SetDemoMetaKeyValue( char *meta_data, size_t meta_data_max_size, size_t meta_data_realsize,
 							  const char *key, const char *value );
 size_t SNAP_ReadDemoMetaData( int demofile, char *meta_data, size_t meta_data_size );
+const char *SNAP_GetDemoMetaKeyValue( const char *meta_data, size_t meta_data_realsize, const char *key );
+
+#define SNAP_DEMO_KEYFRAME_INTERVAL		10000	// milliseconds between non-delta frames in server demos
+#define SNAP_MAX_DEMO_KEYFRAMES			1024
+
+typedef struct
+{
+	unsigned int serverTime;
+	int offset;						// of the frame's message in the uncompressed demo
+} snapdemokeyframe_t;
+
+size_t SNAP_SetDemoKeyframes( char *meta_data, size_t meta_data_max_size, size_t meta_data_realsize,
+							 const snapdemokeyframe_t *keyframes, int numKeyframes );
+int SNAP_GetDemoKeyframes( const char *meta_data, size_t meta_data_realsize, snapdemokeyframe_t *keyframes, int maxKeyframes );
+int SNAP_BuildDemoKeyframes( int demofile, snapdemokeyframe_t *keyframes, int maxKeyframes );
+int SNAP_LoadDemoKeyframesCache( const char *demoname, int demolength, snapdemokeyframe_t *keyframes, int maxKeyframes );
+void SNAP_SaveDemoKeyframesCache( const char *demoname, int demolength, const snapdemokeyframe_t *keyframes, int numKeyframes );
+const snapdemokeyframe_t *SNAP_FindDemoKeyframe( const snapdemokeyframe_t *keyframes, int numKeyframes, unsigned int serverTime );
 
 //============================================================================
 
@@ -533,6 +590,7 @@ NET
 #define	MAX_RELIABLE_COMMANDS	64          // max string commands buffered for restransmit
 #define	MAX_PACKETLEN			1400        // max size of a network packet
 #define	MAX_MSGLEN				32768       // max length of a message, which may be fragmented into multiple packets
+#define	MAX_PACKET_BATCH		16          // max packets read or written by a single NET_GetPackets/NET_SendPackets call
 
 // wsw: Medar: doubled the MSGLEN as a temporary solution for multiview on bigger servers
 #define	FRAGMENT_SIZE			( MAX_PACKETLEN - 96 )
@@ -629,6 +687,10 @@ int			NET_Accept( const socket_t *socket, socket_t *newsocket, netadr_t *address
 
 int			NET_GetPacket( const socket_t *socket, netadr_t *address, msg_t *message );
 bool		NET_SendPacket( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
+int			NET_GetPackets( const socket_t *socket, netadr_t *addresses, msg_t *messages, int maxpackets );
+int			NET_SendPackets( const socket_t *socket, const msg_t *messages, const netadr_t *addresses, int numpackets, bool *failed );
+void		NET_BeginSendQueue( void ( *senderror )( const socket_t *socket, const netadr_t *address, const char *error ) );
+void		NET_FlushSendQueue( void );
 
 int			NET_Get( const socket_t *socket, netadr_t *address, void *data, size_t length );
 int         NET_Send( const socket_t *socket, const void *data, size_t length, const netadr_t *address );
@@ -639,6 +701,27 @@ int         NET_Monitor( int msec, socket_t *sockets[],
 				void (*read_cb)(socket_t *socket, void*), 
 				void (*write_cb)(socket_t *socket, void*), 
 				void (*exception_cb)(socket_t *socket, void*), void *privatep[] );
+#define NET_POLL_READ		1
+#define NET_POLL_WRITE		2
+#define NET_POLL_ERROR		4
+
+#define NET_POLL_MAX_EVENTS	256
+
+typedef struct netpoll_s netpoll_t;
+
+typedef struct
+{
+	void *data;
+	int events;
+} netpollevent_t;
+
+netpoll_t  *NET_CreatePoll( void );
+void		NET_DestroyPoll( netpoll_t **poll );
+bool		NET_PollSet( netpoll_t *poll, const socket_t *socket, int events, void *data );
+void		NET_PollRemove( netpoll_t *poll, const socket_t *socket );
+int			NET_PollMaxSockets( void );
+int			NET_PollWait( netpoll_t *poll, int msec, netpollevent_t *events, int maxevents );
+
 const char *NET_ErrorString( void );
 void	    NET_SetErrorString( const char *format, ... );
 void		NET_SetErrorStringFromLastError( const char *function );
@@ -661,6 +744,15 @@ bool    NET_IsAnyAddress( const netadr_t *address );
 void	NET_InitAddress( netadr_t *address, netadrtype_t type );
 void	NET_BroadcastAddress( netadr_t *address, int port );
 
+typedef struct netaddrhash_s netaddrhash_t;
+
+netaddrhash_t *NET_CreateAddrHash( struct mempool_s *pool, int numslots );
+void	NET_FreeAddrHash( netaddrhash_t **hash );
+void	NET_AddrHashLink( netaddrhash_t *hash, int slot, const netadr_t *address, int game_port );
+void	NET_AddrHashUnlink( netaddrhash_t *hash, int slot );
+int		NET_AddrHashFind( const netaddrhash_t *hash, const netadr_t *address, int game_port );
+void	NET_AddrHashBench_f( void );
+
 //============================================================================
 
 typedef struct
@@ -691,6 +783,8 @@ typedef struct
 	bool unsentIsCompressed;
 
 	bool fatal_error;
+
+	int codec;                  // netcodec_t used for compressed messages, negotiated on connect
 } netchan_t;
 
 extern netadr_t	net_from;
@@ -703,12 +797,31 @@ bool Netchan_Process( netchan_t *chan, msg_t *msg );
 bool Netchan_Transmit( netchan_t *chan, msg_t *msg );
 bool Netchan_PushAllFragments( netchan_t *chan );
 bool Netchan_TransmitNextFragment( netchan_t *chan );
-int Netchan_CompressMessage( msg_t *msg );
-int Netchan_DecompressMessage( msg_t *msg );
+int Netchan_CompressMessage( netchan_t *chan, msg_t *msg );
+int Netchan_DecompressMessage( netchan_t *chan, msg_t *msg );
 void Netchan_OutOfBand( const socket_t *socket, const netadr_t *address, size_t length, const uint8_t *data );
 void Netchan_OutOfBandPrint( const socket_t *socket, const netadr_t *address, const char *format, ... );
 int Netchan_GamePort( void );
 
+// compressed messages codecs, the best one both sides support is picked on connect
+typedef enum
+{
+	NETCODEC_ZLIB,              // the default, for peers which don't negotiate
+	NETCODEC_LZ,
+	NETCODEC_LZDICT,            // LZ with a window primed from netcodec.dict
+
+	NETCODEC_TOTAL
+} netcodec_t;
+
+void Com_InitNetCodecs( void );
+void Com_ShutdownNetCodecs( void );
+const char *Com_NetCodecName( int codec );
+int Com_NetCodecForName( const char *name );
+const char *Com_NetCodecOffer( void );
+int Com_NetCodecFromOffer( const char *offer );
+int Com_NetCodecCompress( int codec, const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen );
+int Com_NetCodecDecompress( int codec, const uint8_t *src, size_t srcLen, uint8_t *dst, size_t dstLen );
+
 /*
 ==============================================================
 
@@ -868,12 +981,33 @@ extern cvar_t *revisioncvar;
 // host_speeds times
 extern unsigned int time_before_game;
 extern unsigned int time_after_game;
+extern unsigned int time_before_snap;
+extern unsigned int time_after_snap;
 extern unsigned int time_before_ref;
 extern unsigned int time_after_ref;
 
 /*
 ==============================================================
 
+FRAME PROFILER
+
+==============================================================
+*/
+
+#define PROF_MAX_STAGES		32
+
+void	    Prof_Init( void );
+void	    Prof_Shutdown( void );
+void	    Prof_Frame( void );
+int		    Prof_RegisterStage( const char *name );
+uint64_t    Prof_Begin( void );
+void	    Prof_End( int stage, uint64_t start );
+void	    Prof_AddSample( int stage, uint64_t usec );
+char	    *Prof_WriteJSON( size_t *length );
+
+/*
+==============================================================
+
 MEMORY MANAGEMENT
 
 ==============================================================
@@ -907,6 +1041,11 @@ void _Mem_FreePool( mempool_t **pool, int musthave, int canthave, const char *fi
 void _Mem_EmptyPool( mempool_t *pool, int musthave, int canthave, const char *filename, int fileline );
 char *_Mem_CopyString( mempool_t *pool, const char *in, const char *filename, int fileline );
 
+void *_Mem_FrameAllocExt( size_t size, size_t alignment, int z, const char *filename, int fileline );
+void Mem_ClearFrameArena( void );
+
+void Mem_ThreadShutdown( void );
+
 void _Mem_CheckSentinels( void *data, const char *filename, int fileline );
 void _Mem_CheckSentinelsGlobal( const char *filename, int fileline );
 
@@ -922,6 +1061,10 @@ size_t Mem_PoolTotalSize( mempool_t *pool );
 #define Mem_EmptyPool( pool ) _Mem_EmptyPool( pool, 0, 0, __FILE__, __LINE__ )
 #define Mem_CopyString( pool, str ) _Mem_CopyString( pool, str, __FILE__, __LINE__ )
 
+// frame memory, valid until the end of the current frame and never freed individually
+#define Mem_FrameAllocExt( size, z ) _Mem_FrameAllocExt( size, 0, z, __FILE__, __LINE__ )
+#define Mem_FrameAlloc( size ) _Mem_FrameAllocExt( size, 0, 1, __FILE__, __LINE__ )
+
 #define Mem_CheckSentinels( data ) _Mem_CheckSentinels( data, __FILE__, __LINE__ )
 #define Mem_CheckSentinelsGlobal() _Mem_CheckSentinelsGlobal( __FILE__, __LINE__ )
 #ifdef NDEBUG
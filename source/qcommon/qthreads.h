@@ -23,6 +23,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 //#define Q_THREADS_HAVE_CANCEL
 
+// storage class for variables which get a separate instance in each thread
+#ifdef _MSC_VER
+#define Q_THREADLOCAL __declspec( thread )
+#else
+#define Q_THREADLOCAL __thread
+#endif
+
 struct qmutex_s;
 typedef struct qmutex_s qmutex_t;
 
@@ -35,6 +42,9 @@ typedef struct qcondvar_s qcondvar_t;
 struct qbufPipe_s;
 typedef struct qbufPipe_s qbufPipe_t;
 
+struct qjobpool_s;
+typedef struct qjobpool_s qjobpool_t;
+
 qmutex_t *QMutex_Create( void );
 void QMutex_Destroy( qmutex_t **pmutex );
 void QMutex_Lock( qmutex_t *mutex );
@@ -50,6 +60,9 @@ void QThread_Join( qthread_t *thread );
 int QThread_Cancel( qthread_t *thread );
 void QThread_Yield( void );
 
+int QAtomic_Add( volatile int *value, int add, qmutex_t *mutex );
+bool QAtomic_CAS( volatile int *value, int oldval, int newval, qmutex_t *mutex );
+
 void QThreads_Init( void );
 void QThreads_Shutdown( void );
 
@@ -61,4 +74,9 @@ int QBufPipe_ReadCmds( qbufPipe_t *queue, unsigned( **cmdHandlers )(const void *
 void QBufPipe_Wait( qbufPipe_t *queue, int (*read)( qbufPipe_t *, unsigned( ** )(const void *), bool ), 
 	unsigned (**cmdHandlers)( const void * ), unsigned timeout_msec );
 
+qjobpool_t *QJobPool_Create( int numWorkers );
+void QJobPool_Destroy( qjobpool_t **ppool );
+int QJobPool_NumWorkers( qjobpool_t *pool );
+void QJobPool_Run( qjobpool_t *pool, void (*job)( void *param, int item, int worker ), void *param, int numItems );
+
 #endif // Q_THREADS_H
@@ -50,6 +50,225 @@ void SNAP_RecordDemoMessage( int demofile, msg_t *msg, int offset )
 	FS_Write( msg->data + offset, len, demofile );
 }
 
+/*
+=============================================================================
+
+ASYNCHRONOUS DEMO WRITER
+
+Demo messages are handed over to a dedicated thread through a pipe of
+bounded size, so the disk and the gzip compression of demo files never
+stall the frame. When the pipe is full the writer blocks, which is
+recorded in the stats.
+
+=============================================================================
+*/
+
+enum
+{
+	DEMOWRITER_CMD_WRITE,
+	DEMOWRITER_CMD_SHUTDOWN,
+
+	DEMOWRITER_NUM_CMDS
+};
+
+typedef struct
+{
+	int id;
+	struct snapdemowriter_s *writer;
+	int length;
+	// followed by the message data, padded to 4 bytes
+} demoWriterCmd_t;
+
+struct snapdemowriter_s
+{
+	int demofile;
+	size_t bufSize;
+	qbufPipe_t *pipe;
+	qthread_t *thread;
+	qmutex_t *mutex;
+	uint8_t *cmdbuf;				// the command to be written to the pipe
+	int offset;						// where the next message goes in the uncompressed file
+
+	volatile int queued;			// bytes in the pipe
+	snapdemowriterstats_t stats;
+};
+
+#define DEMOWRITER_CMD_SIZE(length) ( sizeof( demoWriterCmd_t ) + ( ( (length) + 3 ) & ~3 ) )
+
+/*
+* SNAP_DemoWriter_HandleWriteCmd
+*/
+static unsigned SNAP_DemoWriter_HandleWriteCmd( const void *pcmd )
+{
+	const demoWriterCmd_t *cmd = pcmd;
+	struct snapdemowriter_s *writer = cmd->writer;
+	int len;
+
+	len = LittleLong( cmd->length );
+	if( FS_Write( &len, 4, writer->demofile ) != 4 || FS_Write( cmd + 1, cmd->length, writer->demofile ) != cmd->length )
+		writer->stats.errors++;
+
+	QAtomic_Add( &writer->queued, -(int)DEMOWRITER_CMD_SIZE( cmd->length ), writer->mutex );
+
+	return DEMOWRITER_CMD_SIZE( cmd->length );
+}
+
+/*
+* SNAP_DemoWriter_HandleShutdownCmd
+*/
+static unsigned SNAP_DemoWriter_HandleShutdownCmd( const void *pcmd )
+{
+	return 0;
+}
+
+/*
+* SNAP_DemoWriter_CmdsWaiter
+*/
+static int SNAP_DemoWriter_CmdsWaiter( qbufPipe_t *queue, unsigned( **cmdHandlers )( const void * ), bool timeout )
+{
+	return QBufPipe_ReadCmds( queue, cmdHandlers );
+}
+
+/*
+* SNAP_DemoWriter_ThreadProc
+*/
+static void *SNAP_DemoWriter_ThreadProc( void *param )
+{
+	struct snapdemowriter_s *writer = param;
+	unsigned( *cmdHandlers[DEMOWRITER_NUM_CMDS] )( const void * ) =
+	{
+		SNAP_DemoWriter_HandleWriteCmd,
+		SNAP_DemoWriter_HandleShutdownCmd,
+	};
+
+	QBufPipe_Wait( writer->pipe, SNAP_DemoWriter_CmdsWaiter, cmdHandlers, Q_THREADS_WAIT_INFINITE );
+
+	return NULL;
+}
+
+/*
+* SNAP_CreateDemoWriter
+*
+* Messages recorded through the writer go to the demo file in the same order,
+* after anything written to it directly before the writer was created.
+*/
+snapdemowriter_t *SNAP_CreateDemoWriter( int demofile, size_t bufSize )
+{
+	struct snapdemowriter_s *writer;
+
+	// leave room for a full message plus the padding when the pipe wraps
+	if( bufSize < 4 * DEMOWRITER_CMD_SIZE( MAX_MSGLEN ) )
+		bufSize = 4 * DEMOWRITER_CMD_SIZE( MAX_MSGLEN );
+
+	writer = Mem_ZoneMalloc( sizeof( *writer ) );
+	writer->demofile = demofile;
+	writer->offset = FS_Tell( demofile );
+	writer->bufSize = bufSize;
+	writer->cmdbuf = Mem_ZoneMalloc( DEMOWRITER_CMD_SIZE( MAX_MSGLEN ) );
+	writer->mutex = QMutex_Create();
+	writer->pipe = QBufPipe_Create( bufSize, 1 );
+	writer->thread = QThread_Create( SNAP_DemoWriter_ThreadProc, writer );
+
+	return writer;
+}
+
+/*
+* SNAP_DemoWriterRecordMessage
+*
+* Same as SNAP_RecordDemoMessage, but the write happens on the writer's thread
+*/
+void SNAP_DemoWriterRecordMessage( snapdemowriter_t *writer, msg_t *msg, int offset )
+{
+	int length, queued;
+	unsigned cmdSize;
+	uint64_t time;
+	demoWriterCmd_t *cmd;
+
+	if( !writer )
+		return;
+
+	length = (int)msg->cursize - offset;
+	if( length <= 0 )
+		return;
+
+	cmd = ( demoWriterCmd_t * )writer->cmdbuf;
+	cmd->id = DEMOWRITER_CMD_WRITE;
+	cmd->writer = writer;
+	cmd->length = length;
+	memcpy( cmd + 1, msg->data + offset, length );
+	cmdSize = DEMOWRITER_CMD_SIZE( length );
+
+	queued = QAtomic_Add( &writer->queued, cmdSize, writer->mutex ) + cmdSize;
+	if( queued > writer->stats.peakQueued )
+		writer->stats.peakQueued = queued;
+
+	writer->stats.messages++;
+	writer->stats.bytes += length;
+	writer->offset += 4 + length;
+
+	if( (size_t)queued <= writer->bufSize )
+	{
+		QBufPipe_WriteCmd( writer->pipe, cmd, cmdSize );
+		return;
+	}
+
+	// the thread is falling behind, we have to wait for it
+	time = Sys_Microseconds();
+	QBufPipe_WriteCmd( writer->pipe, cmd, cmdSize );
+	writer->stats.stalls++;
+	writer->stats.stallTime += Sys_Microseconds() - time;
+}
+
+/*
+* SNAP_DemoWriterOffset
+*
+* Returns the offset of the next recorded message in the uncompressed demo
+*/
+int SNAP_DemoWriterOffset( const snapdemowriter_t *writer )
+{
+	return writer->offset;
+}
+
+/*
+* SNAP_DemoWriterStats
+*/
+void SNAP_DemoWriterStats( const snapdemowriter_t *writer, snapdemowriterstats_t *stats )
+{
+	*stats = writer->stats;
+	stats->queued = writer->queued;
+}
+
+/*
+* SNAP_DestroyDemoWriter
+*
+* Waits for all pending messages to be written. The demo file is left open.
+* If stats is not NULL, it receives the final counters, including the errors
+* of the messages that were still queued, or zeroes if there was no writer.
+*/
+void SNAP_DestroyDemoWriter( snapdemowriter_t **pwriter, snapdemowriterstats_t *stats )
+{
+	struct snapdemowriter_s *writer = *pwriter;
+	int cmd = DEMOWRITER_CMD_SHUTDOWN;
+
+	if( stats )
+		memset( stats, 0, sizeof( *stats ) );
+	if( !writer )
+		return;
+
+	QBufPipe_WriteCmd( writer->pipe, &cmd, sizeof( cmd ) );
+	QThread_Join( writer->thread );
+
+	if( stats )
+		SNAP_DemoWriterStats( writer, stats );
+
+	QBufPipe_Destroy( &writer->pipe );
+	QMutex_Destroy( &writer->mutex );
+	Mem_ZoneFree( writer->cmdbuf );
+	Mem_ZoneFree( writer );
+
+	*pwriter = NULL;
+}
+
 /*
 * SNAP_ReadDemoMessage
 */
@@ -416,3 +635,209 @@ size_t SNAP_ReadDemoMetaData( int demofile, char *meta_data, size_t meta_data_si
 
 	return meta_data_realsize;
 }
+
+/*
+* SNAP_GetDemoMetaKeyValue
+*
+* Returns the value stored for the key in the meta data buffer or NULL
+*/
+const char *SNAP_GetDemoMetaKeyValue( const char *meta_data, size_t meta_data_realsize, const char *key )
+{
+	const char *s, *value;
+	const char *end = meta_data + meta_data_realsize;
+
+	for( s = meta_data; s < end && *s; ) {
+		value = s + strlen( s ) + 1;
+		if( value >= end ) {
+			break;
+		}
+		if( !Q_stricmp( s, key ) ) {
+			return value;
+		}
+		s = value + strlen( value ) + 1;
+	}
+
+	return NULL;
+}
+
+/*
+=============================================================================
+
+KEYFRAMES
+
+Keyframes are non-delta snapshots a demo can be started from, the index
+maps their server time to the offset of their message in the uncompressed
+demo. Server demos store it in the meta data, other demos get it built by
+scanning the file, see SNAP_BuildDemoKeyframes.
+
+=============================================================================
+*/
+
+#define SNAP_DEMO_KEYFRAMES_KEY			"keyframes"
+#define SNAP_DEMO_KEYFRAMES_MAXLEN		0x2000
+
+#define SNAP_DEMO_KEYFRAMES_CACHE_EXT	".idx"
+#define SNAP_DEMO_KEYFRAMES_CACHE_ID	( 'K' | ( 'F' << 8 ) | ( 'I' << 16 ) | ( '1' << 24 ) )
+
+/*
+* SNAP_SetDemoKeyframes
+*
+* Stores the keyframe index in the meta data as "time:offset" pairs. Long
+* demos only keep every n-th keyframe so the index fits.
+*/
+size_t SNAP_SetDemoKeyframes( char *meta_data, size_t meta_data_max_size, size_t meta_data_realsize,
+	const snapdemokeyframe_t *keyframes, int numKeyframes )
+{
+	int i, step;
+	size_t len;
+	char *value;
+
+	if( numKeyframes <= 0 ) {
+		return meta_data_realsize;
+	}
+
+	value = Mem_TempMalloc( SNAP_DEMO_KEYFRAMES_MAXLEN );
+
+	for( step = 1; ; step *= 2 ) {
+		len = 0;
+		value[0] = '\0';
+
+		for( i = 0; i < numKeyframes; i += step ) {
+			len += Q_snprintfz( value + len, SNAP_DEMO_KEYFRAMES_MAXLEN - len, "%s%u:%i", len ? " " : "",
+				keyframes[i].serverTime, keyframes[i].offset );
+			if( len >= SNAP_DEMO_KEYFRAMES_MAXLEN - 1 ) {
+				break;
+			}
+		}
+
+		if( i >= numKeyframes ) {
+			break;
+		}
+	}
+
+	meta_data_realsize = SNAP_SetDemoMetaKeyValue( meta_data, meta_data_max_size, meta_data_realsize,
+		SNAP_DEMO_KEYFRAMES_KEY, value );
+
+	Mem_TempFree( value );
+
+	return meta_data_realsize;
+}
+
+/*
+* SNAP_GetDemoKeyframes
+*
+* Returns the number of keyframes read from the meta data
+*/
+int SNAP_GetDemoKeyframes( const char *meta_data, size_t meta_data_realsize, snapdemokeyframe_t *keyframes, int maxKeyframes )
+{
+	int numKeyframes;
+	unsigned int serverTime;
+	int offset, chars;
+	const char *value;
+
+	value = SNAP_GetDemoMetaKeyValue( meta_data, meta_data_realsize, SNAP_DEMO_KEYFRAMES_KEY );
+	if( !value ) {
+		return 0;
+	}
+
+	numKeyframes = 0;
+	while( numKeyframes < maxKeyframes && sscanf( value, " %u:%i%n", &serverTime, &offset, &chars ) == 2 ) {
+		// the index is sorted, ignore anything that would break that
+		if( offset > 0 && ( !numKeyframes || ( offset > keyframes[numKeyframes-1].offset
+			&& serverTime >= keyframes[numKeyframes-1].serverTime ) ) ) {
+			keyframes[numKeyframes].serverTime = serverTime;
+			keyframes[numKeyframes].offset = offset;
+			numKeyframes++;
+		}
+		value += chars;
+	}
+
+	return numKeyframes;
+}
+
+/*
+* SNAP_LoadDemoKeyframesCache
+*
+* The cache of a built index is only used if the demo has the same size
+*/
+int SNAP_LoadDemoKeyframesCache( const char *demoname, int demolength, snapdemokeyframe_t *keyframes, int maxKeyframes )
+{
+	int i, file, header[3];
+	int numKeyframes;
+
+	if( FS_FOpenFile( va( "%s%s", demoname, SNAP_DEMO_KEYFRAMES_CACHE_EXT ), &file, FS_READ ) == -1 ) {
+		return 0;
+	}
+
+	numKeyframes = 0;
+	if( FS_Read( header, sizeof( header ), file ) == sizeof( header ) && LittleLong( header[0] ) == SNAP_DEMO_KEYFRAMES_CACHE_ID
+		&& LittleLong( header[1] ) == demolength ) {
+		numKeyframes = min( LittleLong( header[2] ), maxKeyframes );
+		if( numKeyframes < 0 || FS_Read( keyframes, numKeyframes * sizeof( *keyframes ), file ) != (int)( numKeyframes * sizeof( *keyframes ) ) ) {
+			numKeyframes = 0;
+		}
+
+		for( i = 0; i < numKeyframes; i++ ) {
+			keyframes[i].serverTime = LittleLong( keyframes[i].serverTime );
+			keyframes[i].offset = LittleLong( keyframes[i].offset );
+		}
+	}
+
+	FS_FCloseFile( file );
+
+	return numKeyframes;
+}
+
+/*
+* SNAP_SaveDemoKeyframesCache
+*/
+void SNAP_SaveDemoKeyframesCache( const char *demoname, int demolength, const snapdemokeyframe_t *keyframes, int numKeyframes )
+{
+	int i, file, header[3];
+	snapdemokeyframe_t keyframe;
+
+	if( FS_FOpenFile( va( "%s%s", demoname, SNAP_DEMO_KEYFRAMES_CACHE_EXT ), &file, FS_WRITE ) == -1 ) {
+		return;
+	}
+
+	header[0] = LittleLong( SNAP_DEMO_KEYFRAMES_CACHE_ID );
+	header[1] = LittleLong( demolength );
+	header[2] = LittleLong( numKeyframes );
+	FS_Write( header, sizeof( header ), file );
+
+	for( i = 0; i < numKeyframes; i++ ) {
+		keyframe.serverTime = LittleLong( keyframes[i].serverTime );
+		keyframe.offset = LittleLong( keyframes[i].offset );
+		FS_Write( &keyframe, sizeof( keyframe ), file );
+	}
+
+	FS_FCloseFile( file );
+}
+
+/*
+* SNAP_FindDemoKeyframe
+*
+* Returns the last keyframe at or before the given server time or NULL
+*/
+const snapdemokeyframe_t *SNAP_FindDemoKeyframe( const snapdemokeyframe_t *keyframes, int numKeyframes, unsigned int serverTime )
+{
+	int lo, hi, mid;
+
+	if( numKeyframes <= 0 || keyframes[0].serverTime > serverTime ) {
+		return NULL;
+	}
+
+	// binary search for the last one not past the time
+	lo = 0;
+	hi = numKeyframes - 1;
+	while( lo < hi ) {
+		mid = ( lo + hi + 1 ) / 2;
+		if( keyframes[mid].serverTime <= serverTime ) {
+			lo = mid;
+		} else {
+			hi = mid - 1;
+		}
+	}
+
+	return &keyframes[lo];
+}
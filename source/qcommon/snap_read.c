@@ -676,3 +676,95 @@ snapshot_t *SNAP_ParseFrame( msg_t *msg, snapshot_t *lastFrame, int *suppressCou
 
 	return newframe;
 }
+
+/*
+* SNAP_BuildDemoKeyframes
+*
+* Scans the whole demo for nodelta frames, for demos recorded without
+* the keyframe index. The file position is restored afterwards.
+*/
+int SNAP_BuildDemoKeyframes( int demofile, snapdemokeyframe_t *keyframes, int maxKeyframes )
+{
+	int cmd, offset, start, numKeyframes, msglen;
+	bool reliable;
+	msg_t msg;
+	snapshot_t frame;
+	uint8_t *msgbuf;
+
+	start = FS_Tell( demofile );
+	if( FS_Seek( demofile, 0, FS_SEEK_SET ) < 0 )
+		return 0;
+
+	msgbuf = Mem_TempMalloc( MAX_MSGLEN );
+	MSG_Init( &msg, msgbuf, MAX_MSGLEN );
+
+	reliable = true;
+	numKeyframes = 0;
+	offset = 0;
+	while( numKeyframes < maxKeyframes )
+	{
+		// not SNAP_ReadDemoMessage, a truncated demo only ends the scan
+		if( FS_Read( &msglen, 4, demofile ) != 4 )
+			break;
+		msglen = LittleLong( msglen );
+		if( msglen < 0 || msglen > MAX_MSGLEN || FS_Read( msgbuf, msglen, demofile ) != msglen )
+			break;
+		msg.cursize = msglen;
+		msg.readcount = 0;
+
+		// walk the commands which can precede a frame
+		while( msg.readcount < msg.cursize )
+		{
+			cmd = MSG_ReadByte( &msg );
+
+			if( cmd == svc_nop )
+				continue;
+
+			if( cmd == svc_servercmd || cmd == svc_servercs )
+			{
+				if( cmd == svc_servercmd && !reliable )
+					MSG_ReadLong( &msg );
+				MSG_ReadString( &msg );
+				continue;
+			}
+
+			if( cmd == svc_clcack )
+			{
+				MSG_ReadLong( &msg );
+				MSG_ReadLong( &msg );
+				continue;
+			}
+
+			if( cmd == svc_serverdata )
+			{
+				MSG_ReadLong( &msg );		// protocol
+				MSG_ReadLong( &msg );		// spawncount
+				MSG_ReadShort( &msg );		// snapFrameTime
+				MSG_ReadString( &msg );		// base game
+				MSG_ReadString( &msg );		// game
+				MSG_ReadShort( &msg );		// playernum
+				MSG_ReadString( &msg );		// level name
+				reliable = ( MSG_ReadByte( &msg ) & SV_BITFLAGS_RELIABLE ) ? true : false;
+			}
+			else if( cmd == svc_frame )
+			{
+				SNAP_SkipFrame( &msg, &frame );
+				if( !frame.delta && ( !numKeyframes || frame.serverTime > keyframes[numKeyframes-1].serverTime ) )
+				{
+					keyframes[numKeyframes].serverTime = frame.serverTime;
+					keyframes[numKeyframes].offset = offset;
+					numKeyframes++;
+				}
+			}
+			break;
+		}
+
+		offset += 4 + msglen;
+	}
+
+	Mem_TempFree( msgbuf );
+
+	FS_Seek( demofile, start, FS_SEEK_SET );
+
+	return numKeyframes;
+}
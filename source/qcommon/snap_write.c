@@ -30,12 +30,470 @@ Encode a client frame onto the network channel
 =========================================================================
 */
 
+#define SNAP_DELTACACHE_WAYS		4
+#define SNAP_DELTACACHE_DATASIZE	0x40000
+#define SNAP_DELTACACHE_BASELINE	0xFFFFFFFF	// fromFrameNum of deltas from the baseline
+
+// an entity delta is the same for every client which acked the same frame,
+// since entity states are copied as is into all client frames
+typedef struct
+{
+	unsigned int fromFrameNum;
+	int offset;
+	int length;
+} snapdelta_entry_t;
+
+typedef struct snapdelta_cache_s
+{
+	qmutex_t *mutex;
+
+	// entries are only valid for a single frame
+	unsigned int frameNum;
+	unsigned int gameTime;
+
+	uint8_t numEntries[MAX_EDICTS];
+	snapdelta_entry_t entries[MAX_EDICTS][SNAP_DELTACACHE_WAYS];
+
+	int datasize;
+	uint8_t data[SNAP_DELTACACHE_DATASIZE];
+} snapdelta_cache_t;
+
+/*
+* SNAP_CreateDeltaCache
+*/
+snapdelta_cache_t *SNAP_CreateDeltaCache( mempool_t *mempool )
+{
+	snapdelta_cache_t *cache;
+
+	cache = ( snapdelta_cache_t * )Mem_Alloc( mempool, sizeof( *cache ) );
+	cache->mutex = QMutex_Create();
+	return cache;
+}
+
+/*
+* SNAP_FreeDeltaCache
+*/
+void SNAP_FreeDeltaCache( snapdelta_cache_t **pcache )
+{
+	snapdelta_cache_t *cache;
+
+	assert( pcache != NULL );
+	if( !*pcache )
+		return;
+
+	cache = *pcache;
+	*pcache = NULL;
+
+	QMutex_Destroy( &cache->mutex );
+	Mem_Free( cache );
+}
+
+/*
+* SNAP_WriteDeltaEntity
+*
+* Copies the encoded delta if another client has already had it written
+* this frame, otherwise encodes it and adds it to the cache.
+*/
+static void SNAP_WriteDeltaEntity( snapdelta_cache_t *cache, unsigned int frameNum, unsigned int gameTime, unsigned int fromFrameNum,
+	entity_state_t *from, entity_state_t *to, msg_t *msg, bool force, bool updateOtherOrigin )
+{
+	int i, num, start, length;
+	snapdelta_entry_t *entry;
+
+	num = to->number;
+	if( !cache || num <= 0 || num >= MAX_EDICTS )
+	{
+		MSG_WriteDeltaEntity( from, to, msg, force, updateOtherOrigin );
+		return;
+	}
+
+	QMutex_Lock( cache->mutex );
+
+	if( cache->frameNum != frameNum || cache->gameTime != gameTime )
+	{
+		cache->frameNum = frameNum;
+		cache->gameTime = gameTime;
+		cache->datasize = 0;
+		memset( cache->numEntries, 0, sizeof( cache->numEntries ) );
+	}
+
+	for( i = 0, entry = cache->entries[num]; i < cache->numEntries[num]; i++, entry++ )
+	{
+		if( entry->fromFrameNum == fromFrameNum )
+		{
+			MSG_WriteData( msg, cache->data + entry->offset, entry->length );
+			QMutex_Unlock( cache->mutex );
+			return;
+		}
+	}
+
+	QMutex_Unlock( cache->mutex );
+
+	start = msg->cursize;
+	MSG_WriteDeltaEntity( from, to, msg, force, updateOtherOrigin );
+	length = msg->cursize - start;
+
+	QMutex_Lock( cache->mutex );
+
+	// another thread may have added it meanwhile, or we may be out of space
+	if( cache->frameNum == frameNum && cache->gameTime == gameTime &&
+		cache->numEntries[num] < SNAP_DELTACACHE_WAYS && cache->datasize + length <= SNAP_DELTACACHE_DATASIZE )
+	{
+		for( i = 0, entry = cache->entries[num]; i < cache->numEntries[num]; i++, entry++ )
+		{
+			if( entry->fromFrameNum == fromFrameNum )
+				break;
+		}
+
+		if( i == cache->numEntries[num] )
+		{
+			entry->fromFrameNum = fromFrameNum;
+			entry->offset = cache->datasize;
+			entry->length = length;
+			memcpy( cache->data + cache->datasize, msg->data + start, length );
+			cache->datasize += length;
+			cache->numEntries[num]++;
+		}
+	}
+
+	QMutex_Unlock( cache->mutex );
+}
+
+#define SNAP_FANOUT_VIEWS			64
+#define SNAP_FANOUT_BASES			4
+#define SNAP_FANOUT_DATASIZE		0x80000
+
+// frames of viewers looking through the same eyes are the same, so a relay
+// builds them once per view and encodes them once per view and delta base
+typedef struct
+{
+	unsigned int baseViewId;			// view of the frame it's delta'd from, 0 if not delta'd
+	int offset;
+	int length;
+} snapfanout_body_t;
+
+typedef struct
+{
+	bool multipov;
+	edict_t *clent;
+	entity_state_t s;					// what the view was built from
+	player_state_t ps;
+	client_snapshot_t frame;			// a copy, the client may be dropped before the others are sent
+
+	int numBodies;
+	snapfanout_body_t bodies[SNAP_FANOUT_BASES];
+} snapfanout_view_t;
+
+typedef struct snapfanout_cache_s
+{
+	qmutex_t *mutex;
+	mempool_t *mempool;
+
+	// views are only valid for a single frame
+	unsigned int frameNum;
+	unsigned int gameTime;
+
+	unsigned int firstViewId;
+	int numViews;
+	snapfanout_view_t views[SNAP_FANOUT_VIEWS];
+
+	int datasize;
+	uint8_t data[SNAP_FANOUT_DATASIZE];
+
+	snapfanoutstats_t stats;
+} snapfanout_cache_t;
+
+// unique across all caches, so a client moved between relays can't mix them up
+static volatile int snap_fanoutViewIds;
+
+/*
+* SNAP_CreateFanoutCache
+*/
+snapfanout_cache_t *SNAP_CreateFanoutCache( mempool_t *mempool )
+{
+	snapfanout_cache_t *cache;
+
+	cache = ( snapfanout_cache_t * )Mem_Alloc( mempool, sizeof( *cache ) );
+	cache->mempool = mempool;
+	cache->mutex = QMutex_Create();
+	return cache;
+}
+
+/*
+* SNAP_FreeFanoutCache
+*/
+void SNAP_FreeFanoutCache( snapfanout_cache_t **pcache )
+{
+	int i;
+	snapfanout_cache_t *cache;
+
+	assert( pcache != NULL );
+	if( !*pcache )
+		return;
+
+	cache = *pcache;
+	*pcache = NULL;
+
+	for( i = 0; i < SNAP_FANOUT_VIEWS; i++ )
+	{
+		if( cache->views[i].frame.areabits )
+			Mem_Free( cache->views[i].frame.areabits );
+		if( cache->views[i].frame.ps )
+			Mem_Free( cache->views[i].frame.ps );
+	}
+
+	QMutex_Destroy( &cache->mutex );
+	Mem_Free( cache );
+}
+
+/*
+* SNAP_FanoutCacheStats
+*/
+void SNAP_FanoutCacheStats( const snapfanout_cache_t *cache, snapfanoutstats_t *stats )
+{
+	*stats = cache->stats;
+}
+
+/*
+* SNAP_FanoutSetFrame
+*
+* Must be called with the mutex locked
+*/
+static void SNAP_FanoutSetFrame( snapfanout_cache_t *cache, unsigned int frameNum, unsigned int gameTime )
+{
+	if( cache->frameNum == frameNum && cache->gameTime == gameTime )
+		return;
+
+	cache->frameNum = frameNum;
+	cache->gameTime = gameTime;
+	cache->numViews = 0;
+	cache->datasize = 0;
+	cache->stats.frames++;
+}
+
+/*
+* SNAP_FanoutFindView
+*
+* Returns the view built from the same viewer state this frame or NULL.
+* Must be called with the mutex locked.
+*/
+static snapfanout_view_t *SNAP_FanoutFindView( snapfanout_cache_t *cache, client_t *client )
+{
+	int i;
+	edict_t *clent = client->edict;
+	snapfanout_view_t *view;
+
+	for( i = 0, view = cache->views; i < cache->numViews; i++, view++ )
+	{
+		if( view->multipov != client->mv || view->clent != clent )
+			continue;
+		if( clent && ( memcmp( &view->s, &clent->s, sizeof( view->s ) ) ||
+			memcmp( &view->ps, &clent->r.client->ps, sizeof( view->ps ) ) ) )
+			continue;
+		return view;
+	}
+
+	return NULL;
+}
+
+/*
+* SNAP_FanoutCopyFrame
+*/
+static void SNAP_FanoutCopyFrame( cmodel_state_t *cms, const client_snapshot_t *from, client_snapshot_t *to, mempool_t *mempool )
+{
+	int numareas, ps_size;
+	uint8_t *areabits;
+	player_state_t *ps;
+
+	if( from == to )
+		return;
+
+	numareas = to->numareas;
+	areabits = to->areabits;
+	if( numareas < from->numareas )
+	{
+		numareas = from->numareas;
+		if( areabits )
+			Mem_Free( areabits );
+		areabits = ( uint8_t * )Mem_Alloc( mempool, numareas * CM_AreaRowSize( cms ) );
+	}
+
+	ps_size = to->ps_size;
+	ps = to->ps;
+	if( ps_size < from->numplayers )
+	{
+		ps_size = from->numplayers;
+		if( ps )
+			Mem_Free( ps );
+		ps = ( player_state_t * )Mem_Alloc( mempool, sizeof( player_state_t ) * ps_size );
+	}
+
+	*to = *from;
+	to->numareas = numareas;
+	to->areabits = areabits;
+	to->ps_size = ps_size;
+	to->ps = ps;
+
+	memcpy( to->areabits, from->areabits, from->areabytes );
+	memcpy( to->ps, from->ps, sizeof( player_state_t ) * from->numplayers );
+}
+
+/*
+* SNAP_FanoutShareFrame
+*
+* Copies the frame of a client which was looking through the same eyes
+* this frame, if there's one
+*/
+static bool SNAP_FanoutShareFrame( snapfanout_cache_t *cache, cmodel_state_t *cms, unsigned int frameNum, unsigned int timeStamp,
+	client_t *client, mempool_t *mempool )
+{
+	snapfanout_view_t *view;
+	client_snapshot_t *frame;
+
+	QMutex_Lock( cache->mutex );
+
+	SNAP_FanoutSetFrame( cache, frameNum, timeStamp );
+
+	view = SNAP_FanoutFindView( cache, client );
+	if( !view )
+	{
+		QMutex_Unlock( cache->mutex );
+		return false;
+	}
+
+	frame = &client->snapShots[frameNum & UPDATE_MASK];
+	SNAP_FanoutCopyFrame( cms, &view->frame, frame, mempool );
+	frame->UcmdExecuted = client->UcmdExecuted;
+	cache->stats.sharedFrames++;
+
+	QMutex_Unlock( cache->mutex );
+	return true;
+}
+
+/*
+* SNAP_FanoutAddView
+*
+* Makes the frame just built for the client available to others
+*/
+static void SNAP_FanoutAddView( snapfanout_cache_t *cache, cmodel_state_t *cms, unsigned int frameNum, unsigned int timeStamp, 
+	client_t *client )
+{
+	snapfanout_view_t *view;
+	client_snapshot_t *frame;
+
+	QMutex_Lock( cache->mutex );
+
+	SNAP_FanoutSetFrame( cache, frameNum, timeStamp );
+
+	if( cache->numViews < SNAP_FANOUT_VIEWS )
+	{
+		if( !cache->numViews )
+			cache->firstViewId = (unsigned)QAtomic_Add( &snap_fanoutViewIds, SNAP_FANOUT_VIEWS, NULL ) + 1;
+
+		frame = &client->snapShots[frameNum & UPDATE_MASK];
+		frame->viewId = cache->firstViewId + cache->numViews;
+
+		view = &cache->views[cache->numViews++];
+		view->multipov = client->mv;
+		view->clent = client->edict;
+		if( view->clent )
+		{
+			view->s = view->clent->s;
+			view->ps = view->clent->r.client->ps;
+		}
+		SNAP_FanoutCopyFrame( cms, frame, &view->frame, cache->mempool );
+		view->numBodies = 0;
+	}
+
+	cache->stats.builtFrames++;
+
+	QMutex_Unlock( cache->mutex );
+}
+
+/*
+* SNAP_FanoutFindBody
+*
+* Returns the stored encoding of the frame from the base, an empty slot for
+* it if it wasn't encoded yet (length -1), or NULL if it can't be shared.
+* The view ids tie the frames to the views built for this frame, so the time
+* isn't checked, the relay builds with its own clock but sends the server's.
+*/
+static snapfanout_body_t *SNAP_FanoutFindBody( snapfanout_cache_t *cache, unsigned int frameNum,
+	const client_snapshot_t *frame, const client_snapshot_t *oldframe )
+{
+	int i;
+	unsigned int baseViewId;
+	snapfanout_view_t *view;
+	snapfanout_body_t *body;
+
+	if( !frame->viewId || ( oldframe && !oldframe->viewId ) )
+		return NULL;
+	baseViewId = oldframe ? oldframe->viewId : 0;
+
+	QMutex_Lock( cache->mutex );
+
+	if( cache->frameNum != frameNum || frame->viewId - cache->firstViewId >= (unsigned)cache->numViews )
+	{
+		QMutex_Unlock( cache->mutex );
+		return NULL;
+	}
+
+	view = &cache->views[frame->viewId - cache->firstViewId];
+	for( i = 0, body = view->bodies; i < view->numBodies; i++, body++ )
+	{
+		if( body->baseViewId == baseViewId )
+			break;
+	}
+
+	if( i == view->numBodies )
+	{
+		if( view->numBodies == SNAP_FANOUT_BASES )
+		{
+			QMutex_Unlock( cache->mutex );
+			return NULL;
+		}
+
+		body->baseViewId = baseViewId;
+		body->offset = 0;
+		body->length = -1;
+		view->numBodies++;
+	}
+	else if( body->length >= 0 )
+	{
+		cache->stats.reusedBodies++;
+	}
+
+	QMutex_Unlock( cache->mutex );
+	return body;
+}
+
+/*
+* SNAP_FanoutStoreBody
+*/
+static void SNAP_FanoutStoreBody( snapfanout_cache_t *cache, snapfanout_body_t *body, const uint8_t *data, int length )
+{
+	QMutex_Lock( cache->mutex );
+
+	// another thread may have stored it meanwhile, or we may be out of space
+	if( body->length < 0 && cache->datasize + length <= SNAP_FANOUT_DATASIZE )
+	{
+		body->offset = cache->datasize;
+		memcpy( cache->data + cache->datasize, data, length );
+		cache->datasize += length;
+		body->length = length;
+	}
+
+	QMutex_Unlock( cache->mutex );
+}
+
 /*
 * SNAP_EmitPacketEntities
 *
 * Writes a delta update of an entity_state_t list to the message.
 */
-static void SNAP_EmitPacketEntities( ginfo_t *gi, client_snapshot_t *from, client_snapshot_t *to, msg_t *msg, entity_state_t *baselines, entity_state_t *client_entities, int num_client_entities )
+static void SNAP_EmitPacketEntities( ginfo_t *gi, client_snapshot_t *from, client_snapshot_t *to, msg_t *msg, entity_state_t *baselines, 
+	entity_state_t *client_entities, int num_client_entities, snapdelta_cache_t *deltacache, unsigned int frameNum, unsigned int gameTime, 
+	unsigned int fromFrameNum )
 {
 	entity_state_t *oldent, *newent;
 	int oldindex, newindex;
@@ -83,7 +541,8 @@ static void SNAP_EmitPacketEntities( ginfo_t *gi, client_snapshot_t *from, clien
 			// in any bytes being emited if the entity has not changed at all
 			// note that players are always 'newentities', this updates their oldorigin always
 			// and prevents warping ( wsw : jal : I removed it from the players )
-			MSG_WriteDeltaEntity( oldent, newent, msg, false, ( ( EDICT_NUM( newent->number ) )->r.svflags & SVF_TRANSMITORIGIN2 ) ? true : false );
+			SNAP_WriteDeltaEntity( deltacache, frameNum, gameTime, fromFrameNum, oldent, newent, msg, false, 
+				( ( EDICT_NUM( newent->number ) )->r.svflags & SVF_TRANSMITORIGIN2 ) ? true : false );
 			oldindex++;
 			newindex++;
 			continue;
@@ -92,7 +551,8 @@ static void SNAP_EmitPacketEntities( ginfo_t *gi, client_snapshot_t *from, clien
 		if( newnum < oldnum )
 		{
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity( &baselines[newnum], newent, msg, true, ( ( EDICT_NUM( newent->number ) )->r.svflags & SVF_TRANSMITORIGIN2 ) ? true : false );
+			SNAP_WriteDeltaEntity( deltacache, frameNum, gameTime, SNAP_DELTACACHE_BASELINE, &baselines[newnum], newent, msg, true, 
+				( ( EDICT_NUM( newent->number ) )->r.svflags & SVF_TRANSMITORIGIN2 ) ? true : false );
 			newindex++;
 			continue;
 		}
@@ -626,7 +1086,8 @@ void SNAP_WriteFrameSnapToClient( ginfo_t *gi, client_t *client, msg_t *msg, uns
 								 int numcmds, gcommand_t *commands, const char *commandsData )
 {
 	client_snapshot_t *frame, *oldframe;
-	int flags, i, index, pos, length, supcnt;
+	int flags, i, index, pos, start, length, supcnt;
+	snapfanout_body_t *body;
 
 	// this is the frame we are creating
 	frame = &client->snapShots[frameNum & UPDATE_MASK];
@@ -721,24 +1182,43 @@ void SNAP_WriteFrameSnapToClient( ginfo_t *gi, client_t *client, msg_t *msg, uns
 	}
 	MSG_WriteShort( msg, -1 );
 
-	// send over the areabits
-	MSG_WriteByte( msg, frame->areabytes );
-	MSG_WriteData( msg, frame->areabits, frame->areabytes );
-
-	SNAP_WriteDeltaGameStateToClient( oldframe, frame, msg );
+	// the rest only depends on the frame and the one it's delta'd from
+	body = NULL;
+	if( client_entities && client_entities->fanout )
+		body = SNAP_FanoutFindBody( client_entities->fanout, frameNum, frame, oldframe );
 
-	// delta encode the playerstate
-	for( i = 0; i < frame->numplayers; i++ )
+	if( body && body->length >= 0 )
 	{
-		if( oldframe && oldframe->numplayers > i )
-			SNAP_WritePlayerstateToClient( &oldframe->ps[i], &frame->ps[i], msg );
-		else
-			SNAP_WritePlayerstateToClient( NULL, &frame->ps[i], msg );
+		MSG_WriteData( msg, client_entities->fanout->data + body->offset, body->length );
 	}
-	MSG_WriteByte( msg, 0 );
+	else
+	{
+		start = msg->cursize;
+
+		// send over the areabits
+		MSG_WriteByte( msg, frame->areabytes );
+		MSG_WriteData( msg, frame->areabits, frame->areabytes );
+
+		SNAP_WriteDeltaGameStateToClient( oldframe, frame, msg );
+
+		// delta encode the playerstate
+		for( i = 0; i < frame->numplayers; i++ )
+		{
+			if( oldframe && oldframe->numplayers > i )
+				SNAP_WritePlayerstateToClient( &oldframe->ps[i], &frame->ps[i], msg );
+			else
+				SNAP_WritePlayerstateToClient( NULL, &frame->ps[i], msg );
+		}
+		MSG_WriteByte( msg, 0 );
 
-	// delta encode the entities
-	SNAP_EmitPacketEntities( gi, oldframe, frame, msg, baselines, client_entities ? client_entities->entities : NULL, client_entities ? client_entities->num_entities : 0 );
+		// delta encode the entities
+		SNAP_EmitPacketEntities( gi, oldframe, frame, msg, baselines, client_entities ? client_entities->entities : NULL, 
+			client_entities ? client_entities->num_entities : 0, client_entities ? client_entities->deltacache : NULL, 
+			frameNum, gameTime, oldframe ? (unsigned)client->lastframe : 0 );
+
+		if( body )
+			SNAP_FanoutStoreBody( client_entities->fanout, body, msg->data + start, msg->cursize - start );
+	}
 
 	// write length into reserved space
 	length = msg->cursize - pos - 2;
@@ -892,10 +1372,196 @@ static bool SNAP_SnapCullSoundEntity( cmodel_state_t *cms, edict_t *ent, vec3_t
 	return true;
 }
 
+//=====================================================================
+
+#define SNAP_VISCACHE_SIZE	32
+
+// the part of entity culling which only depends on the merged PVS and areabits,
+// for all entities at once
+typedef struct
+{
+	unsigned hash;
+	int clientarea;
+	uint8_t *key;                       // [keysize] fat PVS row followed by the client area row
+	uint8_t areaculled[MAX_EDICTS/8];
+	uint8_t pvsculled[MAX_EDICTS/8];
+} snapvis_entry_t;
+
+typedef struct snapvis_cache_s
+{
+	qmutex_t *mutex;
+	mempool_t *mempool;
+
+	// entries are only valid for a single frame of a single map
+	cmodel_state_t *cms;
+	unsigned int frameNum;
+
+	int rowsize, arearowsize;
+	int numEntries;
+	uint8_t *keys;                      // [SNAP_VISCACHE_SIZE * keysize]
+	snapvis_entry_t entries[SNAP_VISCACHE_SIZE];
+} snapvis_cache_t;
+
+#define SNAP_VisBit(bits,num) ( (bits)[(num)>>3] & ( 1<<( (num)&7 ) ) )
+
+/*
+* SNAP_CreateVisCache
+*/
+snapvis_cache_t *SNAP_CreateVisCache( mempool_t *mempool )
+{
+	snapvis_cache_t *cache;
+
+	cache = ( snapvis_cache_t * )Mem_Alloc( mempool, sizeof( *cache ) );
+	cache->mempool = mempool;
+	cache->mutex = QMutex_Create();
+	return cache;
+}
+
+/*
+* SNAP_FreeVisCache
+*/
+void SNAP_FreeVisCache( snapvis_cache_t **pcache )
+{
+	snapvis_cache_t *cache;
+
+	assert( pcache != NULL );
+	if( !*pcache )
+		return;
+
+	cache = *pcache;
+	*pcache = NULL;
+
+	QMutex_Destroy( &cache->mutex );
+	if( cache->keys )
+		Mem_Free( cache->keys );
+	Mem_Free( cache );
+}
+
+/*
+* SNAP_BuildVisEntry
+*/
+static void SNAP_BuildVisEntry( cmodel_state_t *cms, ginfo_t *gi, int clientarea, uint8_t *fatpvs, uint8_t *areabits, snapvis_entry_t *vis )
+{
+	int entNum;
+	edict_t *ent;
+
+	memset( vis->areaculled, 0, sizeof( vis->areaculled ) );
+	memset( vis->pvsculled, 0, sizeof( vis->pvsculled ) );
+
+	for( entNum = 1; entNum < gi->num_edicts; entNum++ )
+	{
+		ent = EDICT_NUM( entNum );
+		if( ( ent->r.svflags & SVF_NOCLIENT ) || ent->r.areanum < 0 )
+			continue;
+
+		if( clientarea >= 0 )
+		{
+			// this is the same as CM_AreasConnected but portal's visibility included
+			if( !SNAP_VisBit( areabits, ent->r.areanum ) )
+			{
+				// doors can legally straddle two areas, so we may need to check another one
+				if( ent->r.areanum2 < 0 || !SNAP_VisBit( areabits, ent->r.areanum2 ) )
+				{
+					vis->areaculled[entNum>>3] |= 1<<( entNum&7 );
+					continue;
+				}
+			}
+		}
+
+		if( SNAP_PVSCullEntity( cms, fatpvs, ent ) )
+			vis->pvsculled[entNum>>3] |= 1<<( entNum&7 );
+	}
+}
+
+/*
+* SNAP_GetVisEntry
+*
+* Fills vis with the culling bits for given fat PVS and client area, computing
+* them only if no other client has had the same visibility this frame.
+*/
+static void SNAP_GetVisEntry( snapvis_cache_t *cache, cmodel_state_t *cms, ginfo_t *gi, unsigned int frameNum, 
+	client_snapshot_t *frame, uint8_t *fatpvs, snapvis_entry_t *vis )
+{
+	int i, rowsize, arearowsize;
+	unsigned hash;
+	uint8_t *areabits;
+	snapvis_entry_t *entry;
+
+	rowsize = CM_ClusterRowSize( cms );
+	arearowsize = CM_AreaRowSize( cms );
+	areabits = frame->clientarea >= 0 ? frame->areabits + frame->clientarea * arearowsize : NULL;
+
+	hash = 2166136261u ^ (unsigned)frame->clientarea;
+	for( i = 0; i < rowsize; i++ )
+		hash = ( hash ^ fatpvs[i] ) * 16777619u;
+	for( i = 0; areabits && i < arearowsize; i++ )
+		hash = ( hash ^ areabits[i] ) * 16777619u;
+
+	QMutex_Lock( cache->mutex );
+
+	if( cache->cms != cms || cache->frameNum != frameNum )
+	{
+		cache->cms = cms;
+		cache->frameNum = frameNum;
+		cache->numEntries = 0;
+
+		if( cache->rowsize != rowsize || cache->arearowsize != arearowsize )
+		{
+			if( cache->keys )
+				Mem_Free( cache->keys );
+			cache->rowsize = rowsize;
+			cache->arearowsize = arearowsize;
+			cache->keys = ( uint8_t * )Mem_Alloc( cache->mempool, SNAP_VISCACHE_SIZE * ( rowsize + arearowsize ) );
+			for( i = 0; i < SNAP_VISCACHE_SIZE; i++ )
+				cache->entries[i].key = cache->keys + i * ( rowsize + arearowsize );
+		}
+	}
+
+	for( i = 0, entry = cache->entries; i < cache->numEntries; i++, entry++ )
+	{
+		if( entry->hash != hash || entry->clientarea != frame->clientarea )
+			continue;
+		if( memcmp( entry->key, fatpvs, rowsize ) )
+			continue;
+		if( areabits && memcmp( entry->key + rowsize, areabits, arearowsize ) )
+			continue;
+
+		memcpy( vis->areaculled, entry->areaculled, sizeof( vis->areaculled ) );
+		memcpy( vis->pvsculled, entry->pvsculled, sizeof( vis->pvsculled ) );
+		QMutex_Unlock( cache->mutex );
+		return;
+	}
+
+	QMutex_Unlock( cache->mutex );
+
+	// not cached yet, other threads may build their own entries meanwhile
+	SNAP_BuildVisEntry( cms, gi, frame->clientarea, fatpvs, areabits, vis );
+
+	QMutex_Lock( cache->mutex );
+
+	if( cache->cms == cms && cache->frameNum == frameNum && cache->numEntries < SNAP_VISCACHE_SIZE )
+	{
+		entry = &cache->entries[cache->numEntries++];
+		entry->hash = hash;
+		entry->clientarea = frame->clientarea;
+		memcpy( entry->key, fatpvs, rowsize );
+		if( areabits )
+			memcpy( entry->key + rowsize, areabits, arearowsize );
+		memcpy( entry->areaculled, vis->areaculled, sizeof( entry->areaculled ) );
+		memcpy( entry->pvsculled, vis->pvsculled, sizeof( entry->pvsculled ) );
+	}
+
+	QMutex_Unlock( cache->mutex );
+}
+
+//=====================================================================
+
 /*
 * SNAP_SnapCullEntity
+*
+* vis holds the precomputed area and PVS culling bits, if available
 */
-static bool SNAP_SnapCullEntity( cmodel_state_t *cms, edict_t *ent, edict_t *clent, client_snapshot_t *frame, vec3_t vieworg, uint8_t *fatpvs )
+static bool SNAP_SnapCullEntity( cmodel_state_t *cms, edict_t *ent, edict_t *clent, client_snapshot_t *frame, vec3_t vieworg, uint8_t *fatpvs, const snapvis_entry_t *vis )
 {
 	uint8_t *areabits;
 	bool snd_cull_only;
@@ -926,7 +1592,12 @@ static bool SNAP_SnapCullEntity( cmodel_state_t *cms, edict_t *ent, edict_t *cle
 
 	if( ent->r.areanum < 0 )
 		return true;
-	if( frame->clientarea >= 0 )
+	if( vis )
+	{
+		if( SNAP_VisBit( vis->areaculled, ent->s.number ) )
+			return true; // blocked by a door
+	}
+	else if( frame->clientarea >= 0 )
 	{
 		// this is the same as CM_AreasConnected but portal's visibility included
 		areabits = frame->areabits + frame->clientarea * CM_AreaRowSize( cms );
@@ -956,17 +1627,25 @@ static bool SNAP_SnapCullEntity( cmodel_state_t *cms, edict_t *ent, edict_t *cle
 	// pure sound emitters don't use PVS culling at all
 	if( snd_cull_only && snd_culled )
 		return true;
-	return snd_culled && SNAP_PVSCullEntity( cms, fatpvs, ent );	// cull by PVS
+	if( !snd_culled )
+		return false;
+
+	// cull by PVS
+	if( vis )
+		return SNAP_VisBit( vis->pvsculled, ent->s.number ) ? true : false;
+	return SNAP_PVSCullEntity( cms, fatpvs, ent );
 }
 
 /*
 * SNAP_BuildSnapEntitiesList
 */
-static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, edict_t *clent, vec3_t vieworg, vec3_t skyorg, uint8_t *fatpvs, client_snapshot_t *frame, snapshotEntityNumbers_t *entsList )
+static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, unsigned int frameNum, edict_t *clent, vec3_t vieworg, vec3_t skyorg, 
+	uint8_t *fatpvs, snapvis_cache_t *viscache, client_snapshot_t *frame, snapshotEntityNumbers_t *entsList )
 {
 	int leafnum = -1, clusternum = -1, clientarea = -1;
 	int entNum;
 	edict_t	*ent;
+	snapvis_entry_t visEntry, *vis = NULL;
 
 	// find the client's PVS
 	if( frame->allentities )
@@ -1016,7 +1695,7 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, edict_
 			if( ent->r.svflags & SVF_PORTAL )
 			{
 				// merge visibility sets if portal
-				if( SNAP_SnapCullEntity( cms, ent, clent, frame, vieworg, fatpvs ) )
+				if( SNAP_SnapCullEntity( cms, ent, clent, frame, vieworg, fatpvs, NULL ) )
 					continue;
 
 				if( !VectorCompare( ent->s.origin, ent->s.origin2 ) )
@@ -1025,6 +1704,13 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, edict_
 		}
 	}
 
+	// clients sharing the same visibility share the culling work
+	if( viscache && clent && !frame->allentities )
+	{
+		SNAP_GetVisEntry( viscache, cms, gi, frameNum, frame, fatpvs, &visEntry );
+		vis = &visEntry;
+	}
+
 	// add the entities to the list
 	for( entNum = 1; entNum < gi->num_edicts; entNum++ )
 	{
@@ -1038,7 +1724,7 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, edict_
 		}
 
 		// always add the client entity, even if SVF_NOCLIENT
-		if( ( ent != clent ) && SNAP_SnapCullEntity( cms, ent, clent, frame, vieworg, fatpvs ) )
+		if( ( ent != clent ) && SNAP_SnapCullEntity( cms, ent, clent, frame, vieworg, fatpvs, vis ) )
 			continue;
 
 		// add it
@@ -1067,6 +1753,9 @@ static void SNAP_BuildSnapEntitiesList( cmodel_state_t *cms, ginfo_t *gi, edict_
 *
 * Decides which entities are going to be visible to the client, and
 * copies off the playerstat and areabits.
+*
+* May be called for different clients from several threads at once as long
+* as each call is given its own fatvis scratch space.
 */
 void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int frameNum, unsigned int timeStamp,
 							   fatvis_t *fatvis, client_t *client,
@@ -1098,8 +1787,13 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 		VectorClear( org );
 	}
 
+	// another client may have had the same frame built already
+	if( client_entities->fanout && SNAP_FanoutShareFrame( client_entities->fanout, cms, frameNum, timeStamp, client, mempool ) )
+		return;
+
 	// this is the frame we are creating
 	frame = &client->snapShots[frameNum & UPDATE_MASK];
+	frame->viewId = 0;
 	frame->sentTimeStamp = timeStamp;
 	frame->UcmdExecuted = client->UcmdExecuted;
 	frame->relay = relay;
@@ -1182,7 +1876,7 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 	//=============================
 	entsList.numSnapshotEntities = 0;
 	memset( entsList.entityAddedToSnapList, 0, sizeof( entsList.entityAddedToSnapList ) );
-	SNAP_BuildSnapEntitiesList( cms, gi, clent, org, fatvis->skyorg, fatvis->pvs, frame, &entsList );
+	SNAP_BuildSnapEntitiesList( cms, gi, frameNum, clent, org, fatvis->skyorg, fatvis->pvs, fatvis->viscache, frame, &entsList );
 
 	//Com_Printf( "Snap NumEntities:%i\n", entsList.numSnapshotEntities );
 
@@ -1203,7 +1897,8 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 	//=============================
 
 	// dump the entities list
-	ne = client_entities->next_entities;
+	// reserve the range atomically so several client frames can be built at once
+	ne = QAtomic_Add( (volatile int *)&client_entities->next_entities, entsList.numSnapshotEntities, NULL );
 	frame->num_entities = 0;
 	frame->first_entity = ne;
 
@@ -1224,7 +1919,8 @@ void SNAP_BuildClientFrameSnap( cmodel_state_t *cms, ginfo_t *gi, unsigned int f
 		ne++;
 	}
 
-	client_entities->next_entities = ne;
+	if( client_entities->fanout )
+		SNAP_FanoutAddView( client_entities->fanout, cms, frameNum, timeStamp, client );
 }
 
 /*
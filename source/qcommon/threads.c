@@ -109,6 +109,30 @@ void QCondVar_Wake( qcondvar_t *cond )
 	Sys_CondVar_Wake( cond );
 }
 
+typedef struct {
+	void *(*routine) (void*);
+	void *param;
+} qthreadstart_t;
+
+/*
+* QThread_Start
+*
+* Runs the thread routine, then releases the per-thread state of the memory manager.
+*/
+static void *QThread_Start( void *param )
+{
+	qthreadstart_t start = *( qthreadstart_t * )param;
+	void *ret;
+
+	free( param );
+
+	ret = start.routine( start.param );
+
+	Mem_ThreadShutdown();
+
+	return ret;
+}
+
 /*
 * QThread_Create
 */
@@ -116,8 +140,13 @@ qthread_t *QThread_Create( void *(*routine) (void*), void *param )
 {
 	int ret;
 	qthread_t *thread;
+	qthreadstart_t *start;
 
-	ret = Sys_Thread_Create( &thread, routine, param );
+	start = malloc( sizeof( *start ) );
+	start->routine = routine;
+	start->param = param;
+
+	ret = Sys_Thread_Create( &thread, QThread_Start, start );
 	if( ret != 0 ) {
 		Sys_Error( "QThread_Create: failed with code %i", ret );
 	}
@@ -140,6 +169,24 @@ void QThread_Yield( void )
 	Sys_Thread_Yield();
 }
 
+/*
+* QAtomic_Add
+*
+* Returns the value stored before the addition.
+*/
+int QAtomic_Add( volatile int *value, int add, qmutex_t *mutex )
+{
+	return Sys_Atomic_Add( value, add, mutex );
+}
+
+/*
+* QAtomic_CAS
+*/
+bool QAtomic_CAS( volatile int *value, int oldval, int newval, qmutex_t *mutex )
+{
+	return Sys_Atomic_CAS( value, oldval, newval, mutex );
+}
+
 /*
 * QThreads_Init
 */
@@ -246,9 +293,9 @@ static void *QBufPipe_AllocCmd( qbufPipe_t *pipe, unsigned cmd_size )
 /*
 * QBufPipe_BufLenAdd
 */
-static void QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val )
+static int QBufPipe_BufLenAdd( qbufPipe_t *pipe, int val )
 {
-	Sys_Atomic_Add( &pipe->cmdbuf_len, val, pipe->cmdbuf_mutex );
+	return Sys_Atomic_Add( &pipe->cmdbuf_len, val, pipe->cmdbuf_mutex );
 }
 
 /*
@@ -278,7 +325,7 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 		pipe->write_pos = 0;
 	}
 
-	was_empty = Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0, pipe->cmdbuf_mutex ) == true;
+	was_empty = false;
 	write_remains = pipe->bufSize - pipe->write_pos;
 
 	if( sizeof( int ) > write_remains ) {
@@ -291,7 +338,7 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 		}
 
 		// not enough space to enpipe even the reset cmd, rewind
-		QBufPipe_BufLenAdd( pipe, write_remains ); // atomic
+		was_empty |= QBufPipe_BufLenAdd( pipe, write_remains ) == 0; // atomic
 		pipe->write_pos = 0;
 	} else if( cmd_size > write_remains ) {
 		int *cmd;
@@ -308,7 +355,7 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 		cmd = QBufPipe_AllocCmd( pipe, sizeof( int ) );
 		*cmd = -1;
 
-		QBufPipe_BufLenAdd( pipe, sizeof( *cmd ) + write_remains ); // atomic
+		was_empty |= QBufPipe_BufLenAdd( pipe, sizeof( *cmd ) + write_remains ) == 0; // atomic
 		pipe->write_pos = 0;
 	}
 	else
@@ -324,9 +371,10 @@ void QBufPipe_WriteCmd( qbufPipe_t *pipe, const void *cmd, unsigned cmd_size )
 
 	buf = QBufPipe_AllocCmd( pipe, cmd_size );
 	memcpy( buf, cmd, cmd_size );
-	QBufPipe_BufLenAdd( pipe, cmd_size ); // atomic
+	was_empty |= QBufPipe_BufLenAdd( pipe, cmd_size ) == 0; // atomic
 
-	// wake the other thread waiting for signal
+	// wake the other thread waiting for signal, it only sleeps after
+	// seeing an empty buffer so whoever fills it up has to wake it
 	if( was_empty ) {
 		QMutex_Lock( pipe->nonempty_mutex );
 		QBufPipe_Wake( pipe );
@@ -405,7 +453,11 @@ void QBufPipe_Wait( qbufPipe_t *pipe, int (*read)( qbufPipe_t *, unsigned( ** )(
 		while( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0, pipe->cmdbuf_mutex ) == true ) {
 			QMutex_Lock( pipe->nonempty_mutex );
 
-			result = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec );
+			// check again under the mutex, otherwise the wake up may come
+			// between the check and the wait and we would sleep forever
+			if( Sys_Atomic_CAS( &pipe->cmdbuf_len, 0, 0, pipe->cmdbuf_mutex ) == true ) {
+				result = QCondVar_Wait( pipe->nonempty_condvar, pipe->nonempty_mutex, timeout_msec );
+			}
 
 			// don't hold the mutex, changes to cmdbuf_len are atomic anyway
 			QMutex_Unlock( pipe->nonempty_mutex );
@@ -421,3 +473,203 @@ void QBufPipe_Wait( qbufPipe_t *pipe, int (*read)( qbufPipe_t *, unsigned( ** )(
 		}
 	}
 }
+
+// ============================================================================
+
+#define QJOBPOOL_MAX_WORKERS	32
+
+typedef struct qjobpoolworker_s
+{
+	struct qjobpool_s *pool;
+	int index;                          // 1..numWorkers, 0 is the calling thread
+	qthread_t *thread;
+} qjobpoolworker_t;
+
+typedef struct qjobpool_s
+{
+	int numWorkers;
+	qjobpoolworker_t workers[QJOBPOOL_MAX_WORKERS];
+
+	qmutex_t *mutex;
+	qcondvar_t *start_condvar;          // signaled when a new batch is posted
+	qcondvar_t *done_condvar;           // signaled when the last item of a batch is done
+
+	volatile int terminated;
+	volatile int generation;            // incremented for every posted batch
+
+	// current batch
+	void (*job)( void *param, int item, int worker );
+	void *param;
+	int numItems;
+	volatile int nextItem;
+	volatile int itemsDone;
+} qjobpool_t;
+
+/*
+* QJobPool_RunItems
+*
+* Grabs items from the current batch until there are none left.
+*/
+static void QJobPool_RunItems( qjobpool_t *pool, int worker )
+{
+	int item, done;
+
+	while( 1 ) {
+		item = QAtomic_Add( &pool->nextItem, 1, pool->mutex );
+		if( item >= pool->numItems ) {
+			break;
+		}
+
+		pool->job( pool->param, item, worker );
+
+		done = QAtomic_Add( &pool->itemsDone, 1, pool->mutex ) + 1;
+		if( done == pool->numItems ) {
+			QMutex_Lock( pool->mutex );
+			QCondVar_Wake( pool->done_condvar );
+			QMutex_Unlock( pool->mutex );
+		}
+	}
+}
+
+/*
+* QJobPool_WorkerProc
+*/
+static void *QJobPool_WorkerProc( void *param )
+{
+	qjobpoolworker_t *worker = param;
+	qjobpool_t *pool = worker->pool;
+	int generation = 0;
+
+	while( 1 ) {
+		QMutex_Lock( pool->mutex );
+		while( !pool->terminated && pool->generation == generation ) {
+			QCondVar_Wait( pool->start_condvar, pool->mutex, Q_THREADS_WAIT_INFINITE );
+		}
+		generation = pool->generation;
+		QMutex_Unlock( pool->mutex );
+
+		if( pool->terminated ) {
+			break;
+		}
+
+		QJobPool_RunItems( pool, worker->index );
+	}
+
+	return NULL;
+}
+
+/*
+* QJobPool_Create
+*
+* Spawns numWorkers threads which will help the calling thread to 
+* process batches posted with QJobPool_Run.
+*/
+qjobpool_t *QJobPool_Create( int numWorkers )
+{
+	int i;
+	qjobpool_t *pool;
+
+	clamp( numWorkers, 0, QJOBPOOL_MAX_WORKERS );
+
+	pool = malloc( sizeof( *pool ) );
+	memset( pool, 0, sizeof( *pool ) );
+	pool->numWorkers = numWorkers;
+	pool->mutex = QMutex_Create();
+	pool->start_condvar = QCondVar_Create();
+	pool->done_condvar = QCondVar_Create();
+
+	for( i = 0; i < numWorkers; i++ ) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i + 1;
+		pool->workers[i].thread = QThread_Create( QJobPool_WorkerProc, &pool->workers[i] );
+	}
+
+	return pool;
+}
+
+/*
+* QJobPool_Destroy
+*/
+void QJobPool_Destroy( qjobpool_t **ppool )
+{
+	int i;
+	qjobpool_t *pool;
+
+	assert( ppool != NULL );
+	if( !ppool || !*ppool ) {
+		return;
+	}
+
+	pool = *ppool;
+	*ppool = NULL;
+
+	QMutex_Lock( pool->mutex );
+	pool->terminated = 1;
+	for( i = 0; i < pool->numWorkers; i++ ) {
+		QCondVar_Wake( pool->start_condvar );
+	}
+	QMutex_Unlock( pool->mutex );
+
+	for( i = 0; i < pool->numWorkers; i++ ) {
+		QThread_Join( pool->workers[i].thread );
+	}
+
+	QMutex_Destroy( &pool->mutex );
+	QCondVar_Destroy( &pool->start_condvar );
+	QCondVar_Destroy( &pool->done_condvar );
+	free( pool );
+}
+
+/*
+* QJobPool_NumWorkers
+*
+* Returns the number of distinct worker indices a job may be called with,
+* including the calling thread.
+*/
+int QJobPool_NumWorkers( qjobpool_t *pool )
+{
+	return pool ? pool->numWorkers + 1 : 1;
+}
+
+/*
+* QJobPool_Run
+*
+* Calls job( param, item, worker ) for every item in [0, numItems) and blocks
+* until all of them are done. The calling thread processes items as well, with
+* worker index 0. Batches must not be posted from within a job.
+*/
+void QJobPool_Run( qjobpool_t *pool, void (*job)( void *param, int item, int worker ), void *param, int numItems )
+{
+	int i;
+
+	if( numItems <= 0 ) {
+		return;
+	}
+
+	if( !pool || !pool->numWorkers || numItems == 1 ) {
+		for( i = 0; i < numItems; i++ ) {
+			job( param, i, 0 );
+		}
+		return;
+	}
+
+	QMutex_Lock( pool->mutex );
+	pool->job = job;
+	pool->param = param;
+	pool->numItems = numItems;
+	pool->nextItem = 0;
+	pool->itemsDone = 0;
+	pool->generation++;
+	for( i = 0; i < pool->numWorkers && i < numItems - 1; i++ ) {
+		QCondVar_Wake( pool->start_condvar );
+	}
+	QMutex_Unlock( pool->mutex );
+
+	QJobPool_RunItems( pool, 0 );
+
+	QMutex_Lock( pool->mutex );
+	while( pool->itemsDone < pool->numItems ) {
+		QCondVar_Wait( pool->done_condvar, pool->mutex, Q_THREADS_WAIT_INFINITE );
+	}
+	QMutex_Unlock( pool->mutex );
+}
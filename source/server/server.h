@@ -103,6 +103,7 @@ typedef struct
 	unsigned int sentTimeStamp;         // time at what this frame snap was sent to the clients
 	unsigned int UcmdExecuted;
 	game_state_t gameState;
+	unsigned int viewId;                // frames with the same nonzero view are identical
 } client_snapshot_t;
 
 typedef struct
@@ -202,6 +203,9 @@ typedef struct client_s
 // out before legitimate users connected
 #define	MAX_CHALLENGES	1024
 
+// maximum number of extra threads building client snapshots (sv_snapThreads)
+#define SV_MAX_SNAP_THREADS 16
+
 // MAX_SNAP_ENTITIES is the guess of what we consider maximum amount of entities
 // to be sent to a client into a snap. It's used for finding size of the backup storage
 #define MAX_SNAP_ENTITIES 64
@@ -217,6 +221,7 @@ typedef struct
 typedef struct
 {
 	int file;
+	snapdemowriter_t *writer;       // writes the snaps to file on its own thread
 	char *filename;
 	char *tempname;
 	time_t localtime;
@@ -224,6 +229,12 @@ typedef struct
 	client_t client;                // special client for writing the messages
 	char meta_data[SNAP_MAX_DEMO_META_DATA_SIZE];
 	size_t meta_data_realsize;
+
+	// nodelta frames the demo can be seeked to
+	snapdemokeyframe_t keyframes[SNAP_MAX_DEMO_KEYFRAMES];
+	int numKeyframes;
+	unsigned int keyframeInterval;
+	unsigned int lastKeyframeTime;
 } server_static_demo_t;
 
 typedef server_static_demo_t demorec_t;
@@ -246,11 +257,14 @@ typedef struct client_entities_s
 	unsigned num_entities;				// maxclients->integer*UPDATE_BACKUP*MAX_PACKET_ENTITIES
 	unsigned next_entities;				// next client_entity to use
 	entity_state_t *entities;			// [num_entities]
+	struct snapdelta_cache_s *deltacache;	// shared encoded entity deltas, may be NULL
+	struct snapfanout_cache_s *fanout;		// shared client frames, may be NULL
 } client_entities_t;
 
 typedef struct fatvis_s
 {
 	vec_t *skyorg;
+	struct snapvis_cache_s *viscache;	// shared culling results, may be NULL
 	uint8_t pvs[MAX_MAP_LEAFS/8];
 	uint8_t phs[MAX_MAP_LEAFS/8];
 } fatvis_t;
@@ -275,6 +289,7 @@ typedef struct
 	                                    // used to check late spawns
 
 	client_t *clients;                  // [sv_maxclients->integer];
+	netaddrhash_t *clientsAddrHash;     // base address and game port to client slot
 	client_entities_t client_entities;
 
 	challenge_t challenges[MAX_CHALLENGES]; // to prevent invalid IPs from connecting
@@ -304,6 +319,18 @@ typedef struct
 	bool autostarted;
 	unsigned int lastMasterResolve;
 	unsigned int autoUpdateMinute;	// the minute number we should run the autoupdate check, in the range 0 to 59
+
+	// frame profiler stages, see Prof_RegisterStage
+	struct
+	{
+		int tick;                   // whole frames that ran the game module
+		int readPackets;
+		int gameFrame;
+		int snapFrame;
+		int sendMessages;
+		int snapBuild;              // per client
+		int snapEncode;             // per client
+	} prof;
 } server_constant_t;
 
 //=============================================================================
@@ -334,6 +361,8 @@ extern cvar_t *sv_http_port;
 extern cvar_t *sv_http_upstream_baseurl;
 extern cvar_t *sv_http_upstream_ip;
 extern cvar_t *sv_http_upstream_realip_header;
+extern cvar_t *sv_http_maxrate;
+extern cvar_t *sv_http_localfiles;
 #endif
 
 extern cvar_t *sv_skilllevel;
@@ -344,11 +373,13 @@ extern cvar_t *sv_enforcetime;
 extern cvar_t *sv_showRcon;
 extern cvar_t *sv_showChallenge;
 extern cvar_t *sv_showInfoQueries;
+extern cvar_t *sv_maxInfoQueries;	// per second, 0 = unlimited
 extern cvar_t *sv_highchars;
 
 //wsw : jal
 extern cvar_t *sv_maxrate;
 extern cvar_t *sv_compresspackets;
+extern cvar_t *sv_snapThreads;
 extern cvar_t *sv_public;         // should heartbeats be sent
 
 // wsw : debug netcode
@@ -411,6 +442,7 @@ void SV_UpdateActivity( void );
 void SV_ConnectionlessPacket( const socket_t *socket, const netadr_t *address, msg_t *msg );
 void SV_InitMaster( void );
 void SV_UpdateMaster( void );
+void SV_InvalidateInfoCache( void );
 
 //
 // sv_init.c
@@ -462,6 +494,7 @@ typedef struct
 
 void SV_FlushRedirect( int sv_redirected, const char *outputbuf, const void *extra );
 void SV_SendClientMessages( void );
+void SV_ShutdownSnapJobs( void );
 
 void SV_Multicast( vec3_t origin, multicast_t to );
 void SV_BroadcastCommand( const char *format, ... );
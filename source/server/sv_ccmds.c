@@ -403,6 +403,21 @@ static void SV_CvarCheck_f( void )
 	SV_SendServerCommand( client, "cvarinfo \"%s\"", Cmd_Argv( 2 ) );
 }
 
+/*
+* SV_TraceBench_f
+* Sweep random traces through the current map from several threads
+*/
+static void SV_TraceBench_f( void )
+{
+	if( !svs.cms )
+	{
+		Com_Printf( "No map loaded\n" );
+		return;
+	}
+
+	CM_TraceBench( svs.cms, Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 4, Cmd_Argc() > 2 ? atoi( Cmd_Argv( 2 ) ) : 100000 );
+}
+
 //===========================================================
 
 /*
@@ -434,6 +449,7 @@ void SV_InitOperatorCommands( void )
 	}
 
 	Cmd_AddCommand( "cvarcheck", SV_CvarCheck_f );
+	Cmd_AddCommand( "tracebench", SV_TraceBench_f );
 
 	Cmd_SetCompletionFunc( "map", SV_MapComplete_f );
 	Cmd_SetCompletionFunc( "devmap", SV_MapComplete_f );
@@ -469,4 +485,5 @@ void SV_ShutdownOperatorCommands( void )
 	}
 
 	Cmd_RemoveCommand( "cvarcheck" );
+	Cmd_RemoveCommand( "tracebench" );
 }
@@ -142,6 +142,7 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address, client_t
 	if( fakeClient )
 	{
 		client->netchan.remoteAddress.type = NA_NOTRANSMIT; // fake-clients can't transmit
+		NET_AddrHashUnlink( svs.clientsAddrHash, client - svs.clients );
 		// TODO: if mm_debug_reportbots
 		Info_SetValueForKey( userinfo, "cl_mm_session", va("%d", client->mm_session) );
 	}
@@ -155,6 +156,7 @@ bool SV_ClientConnect( const socket_t *socket, const netadr_t *address, client_t
 		{
 			Netchan_Setup( &client->netchan, socket, address, game_port );
 		}
+		NET_AddrHashLink( svs.clientsAddrHash, client - svs.clients, address, game_port );
 	}
 
 	
@@ -255,6 +257,8 @@ void SV_DropClient( client_t *drop, int type, const char *format, ... )
 		drop->mv = false;
 	}
 
+	NET_AddrHashUnlink( svs.clientsAddrHash, drop - svs.clients );
+
 	drop->tvclient = false;
 	drop->state = CS_ZOMBIE;    // become free in a few seconds
 	drop->name[0] = 0;
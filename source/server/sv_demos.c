@@ -33,7 +33,10 @@ static void SV_Demo_WriteMessage( msg_t *msg )
 	if( !svs.demo.file )
 		return;
 
-	SNAP_RecordDemoMessage( svs.demo.file, msg, 0 );
+	if( svs.demo.writer )
+		SNAP_DemoWriterRecordMessage( svs.demo.writer, msg, 0 );
+	else
+		SNAP_RecordDemoMessage( svs.demo.file, msg, 0 );
 }
 
 /*
@@ -48,6 +51,32 @@ static void SV_Demo_WriteStartMessages( void )
 		svs.purelist, sv.configstrings[0], sv.baselines );
 }
 
+/*
+* SV_Demo_AddKeyframe
+* 
+* Makes the next snap a nodelta one and indexes it. When the index is full
+* every other keyframe is dropped and they're made half as often.
+*/
+static void SV_Demo_AddKeyframe( void )
+{
+	int i;
+
+	if( svs.demo.numKeyframes == SNAP_MAX_DEMO_KEYFRAMES )
+	{
+		for( i = 0; i < SNAP_MAX_DEMO_KEYFRAMES / 2; i++ )
+			svs.demo.keyframes[i] = svs.demo.keyframes[i * 2];
+		svs.demo.numKeyframes = SNAP_MAX_DEMO_KEYFRAMES / 2;
+		svs.demo.keyframeInterval *= 2;
+	}
+
+	svs.demo.keyframes[svs.demo.numKeyframes].serverTime = svs.gametime;
+	svs.demo.keyframes[svs.demo.numKeyframes].offset = SNAP_DemoWriterOffset( svs.demo.writer );
+	svs.demo.numKeyframes++;
+
+	svs.demo.lastKeyframeTime = svs.gametime;
+	svs.demo.client.nodelta = true;
+}
+
 /*
 * SV_Demo_WriteSnap
 */
@@ -75,6 +104,10 @@ void SV_Demo_WriteSnap( void )
 
 	MSG_Init( &msg, msg_buffer, sizeof( msg_buffer ) );
 
+	if( svs.demo.writer && ( svs.demo.client.nodelta || !svs.demo.numKeyframes ||
+		svs.gametime >= svs.demo.lastKeyframeTime + svs.demo.keyframeInterval ) )
+		SV_Demo_AddKeyframe();
+
 	SV_BuildClientFrameSnap( &svs.demo.client );
 
 	SV_WriteFrameSnapToClient( &svs.demo.client, &msg );
@@ -104,6 +137,10 @@ static void SV_Demo_InitClient( void )
 
 	svs.demo.client.lastframe = sv.framenum - 1;
 	svs.demo.client.nodelta = false;
+
+	svs.demo.numKeyframes = 0;
+	svs.demo.keyframeInterval = SNAP_DEMO_KEYFRAME_INTERVAL;
+	svs.demo.lastKeyframeTime = 0;
 }
 
 /*
@@ -194,6 +231,9 @@ void SV_Demo_Start_f( void )
 	svs.demo.localtime = time( NULL );
 	SV_Demo_WriteStartMessages();
 
+	// the snaps are written from now on by the writer thread
+	svs.demo.writer = SNAP_CreateDemoWriter( svs.demo.file, SNAP_DEMO_WRITER_BUFSIZE );
+
 	// write one nodelta frame
 	svs.demo.client.nodelta = true;
 	SV_Demo_WriteSnap();
@@ -205,6 +245,8 @@ void SV_Demo_Start_f( void )
 */
 static void SV_Demo_Stop( bool cancel, bool silent )
 {
+	snapdemowriterstats_t stats;
+
 	if( !svs.demo.file )
 	{
 		if( !silent ) {
@@ -213,6 +255,17 @@ static void SV_Demo_Stop( bool cancel, bool silent )
 		return;
 	}
 
+	// flush the pending snaps before the end of the file is written
+	if( svs.demo.writer )
+	{
+		SNAP_DestroyDemoWriter( &svs.demo.writer, &stats );
+
+		Com_DPrintf( "Server demo writer: %u messages, %u KB, peak queue %i KB, %u stalls (%.1fms)\n",
+			stats.messages, (unsigned)( stats.bytes >> 10 ), stats.peakQueued >> 10, stats.stalls, stats.stallTime / 1000.0 );
+		if( stats.errors )
+			Com_Printf( S_COLOR_YELLOW "Warning: %u server demo messages failed to write\n", stats.errors );
+	}
+
 	if( cancel )
 	{
 		Com_Printf( "Canceled server demo recording: %s\n", svs.demo.filename );
@@ -245,6 +298,8 @@ static void SV_Demo_Stop( bool cancel, bool silent )
 		SV_SetDemoMetaKeyValue( "matchname", sv.configstrings[CS_MATCHNAME] );
 		SV_SetDemoMetaKeyValue( "matchscore", sv.configstrings[CS_MATCHSCORE] );
 		SV_SetDemoMetaKeyValue( "matchuuid", sv.configstrings[CS_MATCHUUID] );
+		svs.demo.meta_data_realsize = SNAP_SetDemoKeyframes( svs.demo.meta_data, sizeof( svs.demo.meta_data ), 
+			svs.demo.meta_data_realsize, svs.demo.keyframes, svs.demo.numKeyframes );
 
 		SNAP_WriteDemoMetaData( svs.demo.tempname, svs.demo.meta_data, svs.demo.meta_data_realsize );
 
@@ -41,7 +41,7 @@ static inline int PF_CM_TransformedPointContents( vec3_t p, struct cmodel_s *cmo
 
 static inline void PF_CM_TransformedBoxTrace( trace_t *tr, vec3_t start, vec3_t end, vec3_t mins, vec3_t maxs,
 struct cmodel_s *cmodel, int brushmask, vec3_t origin, vec3_t angles ) {
-	CM_TransformedBoxTrace( svs.cms, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
+	CM_TransformedBoxTrace( svs.cms, NULL, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
 }
 
 static inline void PF_CM_RoundUpToHullSize( vec3_t mins, vec3_t maxs, struct cmodel_s *cmodel ) {
@@ -484,6 +484,11 @@ void SV_InitGameProgs( void )
 
 	import.Milliseconds = Sys_Milliseconds;
 
+	import.Prof_RegisterStage = Prof_RegisterStage;
+	import.Prof_Begin = Prof_Begin;
+	import.Prof_End = Prof_End;
+	import.Prof_AddSample = Prof_AddSample;
+
 	import.ModelIndex = SV_ModelIndex;
 	import.SoundIndex = SV_SoundIndex;
 	import.ImageIndex = SV_ImageIndex;
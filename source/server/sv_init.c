@@ -352,8 +352,11 @@ void SV_InitGame( void )
 
 	svs.spawncount = rand();
 	svs.clients = Mem_Alloc( sv_mempool, sizeof( client_t )*sv_maxclients->integer );
+	svs.clientsAddrHash = NET_CreateAddrHash( sv_mempool, sv_maxclients->integer );
 	svs.client_entities.num_entities = sv_maxclients->integer * UPDATE_BACKUP * MAX_SNAP_ENTITIES;
 	svs.client_entities.entities = Mem_Alloc( sv_mempool, sizeof( entity_state_t ) * svs.client_entities.num_entities );
+	svs.client_entities.deltacache = SNAP_CreateDeltaCache( sv_mempool );
+	svs.fatvis.viscache = SNAP_CreateVisCache( sv_mempool );
 
 	// init network stuff
 
@@ -537,18 +540,25 @@ void SV_ShutdownGame( const char *finalmsg, bool reconnect )
 	// get any latched variable changes (sv_maxclients, etc)
 	Cvar_GetLatchedVars( CVAR_LATCH );
 
+	SV_ShutdownSnapJobs();
+
 	if( svs.clients )
 	{
 		Mem_Free( svs.clients );
 		svs.clients = NULL;
 	}
 
+	NET_FreeAddrHash( &svs.clientsAddrHash );
+
 	if( svs.client_entities.entities )
 	{
 		Mem_Free( svs.client_entities.entities );
+		SNAP_FreeDeltaCache( &svs.client_entities.deltacache );
 		memset( &svs.client_entities, 0, sizeof( svs.client_entities ) );
 	}
 
+	SNAP_FreeVisCache( &svs.fatvis.viscache );
+
 	if( svs.cms )
 	{
 		// CM_ReleaseReference will take care of freeing up the memory
@@ -62,12 +62,15 @@ cvar_t *sv_http_port;
 cvar_t *sv_http_upstream_baseurl;
 cvar_t *sv_http_upstream_ip;
 cvar_t *sv_http_upstream_realip_header;
+cvar_t *sv_http_maxrate;
+cvar_t *sv_http_localfiles;
 #endif
 
 cvar_t *sv_showclamp;
 cvar_t *sv_showRcon;
 cvar_t *sv_showChallenge;
 cvar_t *sv_showInfoQueries;
+cvar_t *sv_maxInfoQueries;
 cvar_t *sv_highchars;
 
 cvar_t *sv_hostname;
@@ -82,6 +85,7 @@ cvar_t *sv_reconnectlimit; // minimum seconds between connect messages
 
 cvar_t *sv_maxrate;
 cvar_t *sv_compresspackets;
+cvar_t *sv_snapThreads;
 cvar_t *sv_masterservers;
 cvar_t *sv_masterservers_steam;
 cvar_t *sv_skilllevel;
@@ -165,7 +169,7 @@ static bool SV_ProcessPacket( netchan_t *netchan, msg_t *msg )
 	MSG_ReadShort( msg ); // game_port
 	if( msg->compressed )
 	{
-		zerror = Netchan_DecompressMessage( msg );
+		zerror = Netchan_DecompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{
 			// compression error. Drop the packet
@@ -177,6 +181,55 @@ static bool SV_ProcessPacket( netchan_t *netchan, msg_t *msg )
 	return true;
 }
 
+/*
+* SV_ReadPacket
+*/
+static void SV_ReadPacket( socket_t *socket, const netadr_t *address, msg_t *msg )
+{
+	int i, game_port;
+	unsigned short addr_port;
+	client_t *cl;
+
+	// check for connectionless packet (0xffffffff) first
+	if( *(int *)msg->data == -1 )
+	{
+		SV_ConnectionlessPacket( socket, address, msg );
+		return;
+	}
+
+	// read the game port out of the message so we can fix up
+	// stupid address translating routers
+	MSG_BeginReading( msg );
+	MSG_ReadLong( msg ); // sequence number
+	MSG_ReadLong( msg ); // sequence number
+	game_port = MSG_ReadShort( msg ) & 0xffff;
+	// data follows
+
+	// check for packets from connected clients
+	i = NET_AddrHashFind( svs.clientsAddrHash, address, game_port );
+	if( i < 0 )
+		return;
+
+	cl = &svs.clients[i];
+	if( cl->state == CS_FREE || cl->state == CS_ZOMBIE )
+		return;
+	if( cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) )
+		return;
+
+	addr_port = NET_GetAddressPort( address );
+	if( NET_GetAddressPort( &cl->netchan.remoteAddress ) != addr_port )
+	{
+		Com_Printf( "SV_ReadPackets: fixing up a translated port\n" );
+		NET_SetAddressPort( &cl->netchan.remoteAddress, addr_port );
+	}
+
+	if( SV_ProcessPacket( &cl->netchan, msg ) ) // this is a valid, sequenced packet, so process it
+	{
+		cl->lastPacketReceivedTime = svs.realtime;
+		SV_ParseClientMessage( cl, msg );
+	}
+}
+
 /*
 * SV_ReadPackets
 */
@@ -187,12 +240,14 @@ static void SV_ReadPackets( void )
 #ifdef TCP_ALLOW_CONNECT
 	socket_t newsocket;
 #endif
-	int game_port;
 	socket_t *socket;
 	netadr_t address;
 
 	static msg_t msg;
 	static uint8_t msgData[MAX_MSGLEN];
+	static netadr_t batchAddresses[MAX_PACKET_BATCH];
+	static msg_t batchMsgs[MAX_PACKET_BATCH];
+	static uint8_t batchMsgData[MAX_PACKET_BATCH][MAX_MSGLEN];
 
 #ifdef TCP_ALLOW_CONNECT
 	socket_t* tcpsockets [] =
@@ -210,6 +265,8 @@ static void SV_ReadPackets( void )
 	};
 
 	MSG_Init( &msg, msgData, sizeof( msgData ) );
+	for( i = 0; i < MAX_PACKET_BATCH; i++ )
+		MSG_Init( &batchMsgs[i], batchMsgData[i], sizeof( batchMsgData[i] ) );
 
 #ifdef TCP_ALLOW_CONNECT
 	for( socketind = 0; socketind < sizeof( tcpsockets ) / sizeof( tcpsockets[0] ); socketind++ )
@@ -283,57 +340,16 @@ static void SV_ReadPackets( void )
 		if( !socket->open )
 			continue;
 
-		while( ( ret = NET_GetPacket( socket, &address, &msg ) ) != 0 )
+		while( ( ret = NET_GetPackets( socket, batchAddresses, batchMsgs, MAX_PACKET_BATCH ) ) != 0 )
 		{
 			if( ret == -1 )
 			{
-				Com_Printf( "NET_GetPacket: Error: %s\n", NET_ErrorString() );
+				Com_Printf( "NET_GetPackets: Error: %s\n", NET_ErrorString() );
 				continue;
 			}
 
-			// check for connectionless packet (0xffffffff) first
-			if( *(int *)msg.data == -1 )
-			{
-				SV_ConnectionlessPacket( socket, &address, &msg );
-				continue;
-			}
-
-			// read the game port out of the message so we can fix up
-			// stupid address translating routers
-			MSG_BeginReading( &msg );
-			MSG_ReadLong( &msg ); // sequence number
-			MSG_ReadLong( &msg ); // sequence number
-			game_port = MSG_ReadShort( &msg ) & 0xffff;
-			// data follows
-
-			// check for packets from connected clients
-			for( i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++ )
-			{
-				unsigned short addr_port;
-
-				if( cl->state == CS_FREE || cl->state == CS_ZOMBIE )
-					continue;
-				if( cl->edict && ( cl->edict->r.svflags & SVF_FAKECLIENT ) )
-					continue;
-				if( !NET_CompareBaseAddress( &address, &cl->netchan.remoteAddress ) )
-					continue;
-				if( cl->netchan.game_port != game_port )
-					continue;
-
-				addr_port = NET_GetAddressPort( &address );
-				if( NET_GetAddressPort( &cl->netchan.remoteAddress ) != addr_port )
-				{
-					Com_Printf( "SV_ReadPackets: fixing up a translated port\n" );
-					NET_SetAddressPort( &cl->netchan.remoteAddress, addr_port );
-				}
-
-				if( SV_ProcessPacket( &cl->netchan, &msg ) ) // this is a valid, sequenced packet, so process it
-				{
-					cl->lastPacketReceivedTime = svs.realtime;
-					SV_ParseClientMessage( cl, &msg );
-				}
-				break;
-			}
+			for( i = 0; i < ret; i++ )
+				SV_ReadPacket( socket, &batchAddresses[i], &batchMsgs[i] );
 		}
 	}
 
@@ -472,8 +488,11 @@ static void SV_CheckLatchedUserinfoChanges( void )
 #define WORLDFRAMETIME 16 // 62.5fps
 /*
 * SV_RunGameFrame
+*
+* Sets ranGameModule when the game module was run, the server sleeps
+* in here otherwise.
 */
-static bool SV_RunGameFrame( int msec )
+static bool SV_RunGameFrame( int msec, bool *ranGameModule )
 {
 	static unsigned int accTime = 0;
 	bool refreshSnapshot;
@@ -484,6 +503,7 @@ static bool SV_RunGameFrame( int msec )
 
 	refreshSnapshot = false;
 	refreshGameModule = false;
+	*ranGameModule = false;
 
 	sentFragments = SV_SendClientsFragments();
 
@@ -529,6 +549,7 @@ static bool SV_RunGameFrame( int msec )
 	if( refreshGameModule )
 	{
 		unsigned int moduleTime;
+		uint64_t profStart;
 
 		// update ping based on the last known frame from all clients
 		SV_CalcPings();
@@ -548,21 +569,28 @@ static bool SV_RunGameFrame( int msec )
 
 		if( host_speeds->integer )
 			time_before_game = Sys_Milliseconds();
+		profStart = Prof_Begin();
 
 		ge->RunFrame( moduleTime, svs.gametime );
 
+		Prof_End( svc.prof.gameFrame, profStart );
 		if( host_speeds->integer )
 			time_after_game = Sys_Milliseconds();
+
+		*ranGameModule = true;
 	}
 
 	// if we don't have to send a snapshot we are done here
 	if( refreshSnapshot )
 	{
 		int extraSnapTime;
+		uint64_t profStart;
 
 		// set up for sending a snapshot
 		sv.framenum++;
+		profStart = Prof_Begin();
 		ge->SnapFrame();
+		Prof_End( svc.prof.snapFrame, profStart );
 
 		// set time for next snapshot
 		extraSnapTime = (int)( svs.gametime - sv.nextSnapTime );
@@ -743,14 +771,45 @@ static void SV_CheckMatchUUID( void )
 	SV_MM_GetMatchUUID( &SV_CheckMatchUUID_Callback );
 }
 
+/*
+* SV_SendError
+* 
+* Called by the network code for each queued datagram it failed to send
+*/
+static void SV_SendError( const socket_t *socket, const netadr_t *address, const char *error )
+{
+	int i;
+	client_t *client;
+
+	for( i = 0, client = svs.clients; i < sv_maxclients->integer; i++, client++ )
+	{
+		if( client->state == CS_FREE || client->state == CS_ZOMBIE )
+			continue;
+		if( client->netchan.socket != socket || !NET_CompareAddress( &client->netchan.remoteAddress, address ) )
+			continue;
+
+		Com_Printf( "Error sending message to %s: %s\n", client->name, error );
+		if( client->reliable )
+		{
+			SV_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n", error );
+		}
+		return;
+	}
+
+	Com_Printf( "Error sending packet to %s: %s\n", NET_AddressToString( address ), error );
+}
+
 /*
 * SV_Frame
 */
 void SV_Frame( int realmsec, int gamemsec )
 {
 	const unsigned int wrappingPoint = 0x70000000;
+	uint64_t tickStart, profStart;
+	bool ranGameModule;
 
 	time_before_game = time_after_game = 0;
+	time_before_snap = time_after_snap = 0;
 
 	// if server is not active, do nothing
 	if( !svs.initialized )
@@ -770,21 +829,36 @@ void SV_Frame( int realmsec, int gamemsec )
 		return;
 	}
 
+	tickStart = Prof_Begin();
+
+	// datagrams sent during the frame are pushed out together at the end of it
+	NET_BeginSendQueue( SV_SendError );
+
 	// check timeouts
 	SV_CheckTimeouts();
 
 	// get packets from clients
+	profStart = Prof_Begin();
 	SV_ReadPackets();
+	Prof_End( svc.prof.readPackets, profStart );
 
 	// apply latched userinfo changes
 	SV_CheckLatchedUserinfoChanges();
 
 	// let everything in the world think and move
-	if( SV_RunGameFrame( gamemsec ) )
+	if( SV_RunGameFrame( gamemsec, &ranGameModule ) )
 	{
+		if( host_speeds->integer )
+			time_before_snap = Sys_Milliseconds();
+		profStart = Prof_Begin();
+
 		// send messages back to the clients that had packets read this frame
 		SV_SendClientMessages();
 
+		Prof_End( svc.prof.sendMessages, profStart );
+		if( host_speeds->integer )
+			time_after_snap = Sys_Milliseconds();
+
 		// write snap to server demo file
 		SV_Demo_WriteSnap();
 
@@ -803,6 +877,12 @@ void SV_Frame( int realmsec, int gamemsec )
 	// handle HTTP connections
 	SV_Web_GameFrame( ge->WebRequest );
 
+	NET_FlushSendQueue();
+
+	// frames that only waited for packets would drown the ones doing the work
+	if( ranGameModule )
+		Prof_End( svc.prof.tick, tickStart );
+
 	SV_CheckAutoUpdate();
 
 	SV_CheckPostUpdateRestart();
@@ -873,6 +953,9 @@ void SV_UserinfoChanged( client_t *client )
 	}
 	Q_strncpyz( client->name, val, sizeof( client->name ) );
 
+	// the name is in the cached status responses
+	SV_InvalidateInfoCache();
+
 #ifndef RATEKILLED
 	// rate command
 	if( NET_IsLANAddress( &client->netchan.remoteAddress ) )
@@ -947,6 +1030,8 @@ void SV_Init( void )
 	sv_http_upstream_baseurl =	Cvar_Get( "sv_http_upstream_baseurl", "", CVAR_ARCHIVE | CVAR_LATCH );
 	sv_http_upstream_realip_header = Cvar_Get( "sv_http_upstream_realip_header", "", CVAR_ARCHIVE );
 	sv_http_upstream_ip = Cvar_Get( "sv_http_upstream_ip", "", CVAR_ARCHIVE );
+	sv_http_maxrate =	Cvar_Get( "sv_http_maxrate", "0", CVAR_ARCHIVE );	// KB/s per connection, 0 = unlimited
+	sv_http_localfiles =	Cvar_Get( "sv_http_localfiles", "0", 0 );	// let the server's own host download files without a session
 #endif
 
 	rcon_password =		    Cvar_Get( "rcon_password", "", 0 );
@@ -958,6 +1043,7 @@ void SV_Init( void )
 	sv_showRcon =		    Cvar_Get( "sv_showRcon", "1", 0 );
 	sv_showChallenge =	    Cvar_Get( "sv_showChallenge", "0", 0 );
 	sv_showInfoQueries =	Cvar_Get( "sv_showInfoQueries", "0", 0 );
+	sv_maxInfoQueries =		Cvar_Get( "sv_maxInfoQueries", "200", CVAR_ARCHIVE );
 	sv_highchars =			Cvar_Get( "sv_highchars", "1", 0 );
 
 	sv_uploads_http	=       Cvar_Get( "sv_uploads_http", "1", CVAR_READONLY );
@@ -1013,6 +1099,7 @@ void SV_Init( void )
 	// wsw : jal : cap client's exceding server rules
 	sv_maxrate =		    Cvar_Get( "sv_maxrate", "0", CVAR_DEVELOPER );
 	sv_compresspackets =	    Cvar_Get( "sv_compresspackets", "1", CVAR_DEVELOPER );
+	sv_snapThreads =	    Cvar_Get( "sv_snapThreads", "0", CVAR_ARCHIVE );
 	sv_skilllevel =		    Cvar_Get( "sv_skilllevel", "2", CVAR_SERVERINFO|CVAR_ARCHIVE|CVAR_LATCH );
 
 	if( sv_skilllevel->integer > 2 )
@@ -1060,6 +1147,14 @@ void SV_Init( void )
 
 	svc.autoUpdateMinute = rand() % 60;
 
+	svc.prof.tick = Prof_RegisterStage( "sv_tick" );
+	svc.prof.readPackets = Prof_RegisterStage( "sv_readpackets" );
+	svc.prof.gameFrame = Prof_RegisterStage( "game_runframe" );
+	svc.prof.snapFrame = Prof_RegisterStage( "game_snapframe" );
+	svc.prof.sendMessages = Prof_RegisterStage( "sv_sendmessages" );
+	svc.prof.snapBuild = Prof_RegisterStage( "snap_build" );
+	svc.prof.snapEncode = Prof_RegisterStage( "snap_encode" );
+
 	Com_Printf( "Game running at %i fps. Server transmit at %i pps\n", sv_fps->integer, sv_pps->integer );
 
 	//init the master servers list
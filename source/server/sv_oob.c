@@ -37,6 +37,49 @@ extern cvar_t *sv_reconnectlimit;     // minimum seconds between connect message
 extern cvar_t *rcon_password;         // password for remote server commands
 extern cvar_t *sv_iplimit;
 
+// info queries are answered from cached, pre-serialized packets which are rebuilt
+// when something they show changes, or when they get too old for the pings in them
+#define SV_INFOCACHE_MAXAGE			1000	// milliseconds
+#define SV_INFOCACHE_HEADROOM		128		// for the OOB header, response type and challenge
+
+typedef enum
+{
+	SV_INFOCACHE_SHORT,			// broadcast scan replies
+	SV_INFOCACHE_LONG,			// getinfo
+	SV_INFOCACHE_FULL,			// getstatus, with the player list
+
+	SV_INFOCACHE_TOTAL
+} sv_infocachetype_t;
+
+typedef struct
+{
+	bool valid;
+	unsigned int time;
+	size_t length;
+	uint8_t packet[SV_INFOCACHE_HEADROOM + MAX_PACKETLEN];	// the info string starts at the headroom
+} sv_infocache_t;
+
+static sv_infocache_t sv_infocache[SV_INFOCACHE_TOTAL];
+static bool sv_infocache_checked;			// sv_infocache_checktime is set
+static unsigned int sv_infocache_checktime;
+static unsigned int sv_infocache_fingerprint;
+static int sv_infocache_numclients;
+
+// token buckets limiting the info queries from a single address and for the whole server
+#define SV_QUERYLIMIT_HASHSIZE		1024
+#define SV_QUERYLIMIT_BURST			10
+#define SV_QUERYLIMIT_RATE			10		// per second
+
+typedef struct
+{
+	netadr_t address;
+	int tokens;
+	unsigned int time;
+} sv_querybucket_t;
+
+static sv_querybucket_t sv_querybuckets[SV_QUERYLIMIT_HASHSIZE];
+static sv_querybucket_t sv_queryglobalbucket;
+
 
 //==============================================================================
 //
@@ -442,6 +485,226 @@ static char *SV_ShortInfoString( void )
 
 
 
+/*
+* SV_InvalidateInfoCache
+*/
+void SV_InvalidateInfoCache( void )
+{
+	int i;
+
+	for( i = 0; i < SV_INFOCACHE_TOTAL; i++ )
+		sv_infocache[i].valid = false;
+}
+
+/*
+* SV_InfoCacheFingerprint
+* Hashes what the info strings show besides the client names and pings, these are
+* covered by SV_UserinfoChanged and the cache age. Also counts the connected clients.
+*/
+static unsigned int SV_InfoCacheFingerprint( void )
+{
+	int i;
+	unsigned int hash;
+	const char *str;
+	client_t *cl;
+
+#define SV_INFOCACHE_HASH( h, v ) ( ( ( h ) ^ (unsigned int)( v ) ) * 16777619u )
+
+	hash = 2166136261u;
+	hash = SV_INFOCACHE_HASH( hash, serverinfo_modcount );
+	hash = SV_INFOCACHE_HASH( hash, svs.spawncount );
+	hash = SV_INFOCACHE_HASH( hash, sv_skilllevel->integer );
+	hash = SV_INFOCACHE_HASH( hash, SV_MM_Initialized() );
+	hash = SV_INFOCACHE_HASH( hash, Cvar_Value( "g_instagib" ) != 0 );
+	hash = SV_INFOCACHE_HASH( hash, Cvar_Value( "g_race_gametype" ) != 0 );
+	for( str = Cvar_String( "password" ); *str; str++ )
+		hash = SV_INFOCACHE_HASH( hash, *str );
+
+	sv_infocache_numclients = 0;
+	for( i = 0; i < sv_maxclients->integer; i++ )
+	{
+		cl = &svs.clients[i];
+		if( cl->state < CS_CONNECTED )
+			continue;
+
+		hash = SV_INFOCACHE_HASH( hash, i );
+		hash = SV_INFOCACHE_HASH( hash, ( cl->edict->r.svflags & SVF_FAKECLIENT ) || cl->tvclient );
+		hash = SV_INFOCACHE_HASH( hash, cl->edict->r.client->r.frags );
+		hash = SV_INFOCACHE_HASH( hash, cl->edict->s.team );
+		sv_infocache_numclients++;
+	}
+
+#undef SV_INFOCACHE_HASH
+
+	return hash;
+}
+
+/*
+* SV_CheckInfoCache
+* Invalidates the cache if anything shown changed, at most once per frame
+*/
+static void SV_CheckInfoCache( void )
+{
+	unsigned int fingerprint;
+
+	if( sv_infocache_checked && sv_infocache_checktime == svs.realtime )
+		return;
+	sv_infocache_checked = true;
+	sv_infocache_checktime = svs.realtime;
+
+	fingerprint = SV_InfoCacheFingerprint();
+	if( fingerprint != sv_infocache_fingerprint )
+	{
+		sv_infocache_fingerprint = fingerprint;
+		SV_InvalidateInfoCache();
+	}
+}
+
+/*
+* SV_GetInfoCache
+*/
+static sv_infocache_t *SV_GetInfoCache( sv_infocachetype_t type )
+{
+	sv_infocache_t *cache = &sv_infocache[type];
+	const char *string;
+
+	SV_CheckInfoCache();
+
+	if( !cache->valid || svs.realtime - cache->time >= SV_INFOCACHE_MAXAGE )
+	{
+		if( type == SV_INFOCACHE_SHORT )
+			string = SV_ShortInfoString();
+		else
+			string = SV_LongInfoString( type == SV_INFOCACHE_FULL );
+
+		cache->length = min( strlen( string ), MAX_PACKETLEN );
+		memcpy( cache->packet + SV_INFOCACHE_HEADROOM, string, cache->length );
+		cache->time = svs.realtime;
+		cache->valid = true;
+	}
+
+	return cache;
+}
+
+/*
+* SV_SendInfoCache
+* Writes the OOB header and the response line right before the cached info string
+* and sends the packet from there, truncated to a single datagram
+*/
+static void SV_SendInfoCache( const socket_t *socket, const netadr_t *address, sv_infocache_t *cache, const char *format, ... )
+{
+	va_list argptr;
+	char head[SV_INFOCACHE_HEADROOM];
+	uint8_t *packet;
+	size_t headlen, length;
+
+	head[0] = head[1] = head[2] = head[3] = (char)0xff;
+	va_start( argptr, format );
+	Q_vsnprintfz( head + 4, sizeof( head ) - 4, format, argptr );
+	va_end( argptr );
+	headlen = 4 + strlen( head + 4 );
+
+	packet = cache->packet + SV_INFOCACHE_HEADROOM - headlen;
+	memcpy( packet, head, headlen );
+	length = min( headlen + cache->length, MAX_PACKETLEN );
+
+	if( !NET_SendPacket( socket, packet, length, address ) )
+		Com_Printf( "NET_SendPacket: Error: %s\n", NET_ErrorString() );
+}
+
+/*
+* SV_QueryBucketTake
+*/
+static bool SV_QueryBucketTake( sv_querybucket_t *bucket, int burst, int rate )
+{
+	int refill;
+
+	refill = ( svs.realtime - bucket->time ) * rate / 1000;
+	if( refill > 0 )
+	{
+		bucket->tokens += refill;
+		bucket->time += refill * 1000 / rate;
+		if( bucket->tokens >= burst )
+		{
+			bucket->tokens = burst;
+			bucket->time = svs.realtime;
+		}
+	}
+
+	if( bucket->tokens <= 0 )
+		return false;
+	bucket->tokens--;
+	return true;
+}
+
+/*
+* SV_IsMasterAddress
+*/
+static bool SV_IsMasterAddress( const netadr_t *address )
+{
+	int i;
+
+	for( i = 0; i < MAX_MASTERS; i++ )
+	{
+		if( sv_masters[i].address.type != NA_NOTRANSMIT && NET_CompareBaseAddress( &sv_masters[i].address, address ) )
+			return true;
+	}
+	return false;
+}
+
+/*
+* SV_QueryRateLimited
+* Returns true if the info query from this address should be dropped
+*
+* The master servers skip the global bucket so a flood can't get the server delisted,
+* they still have their own address bucket like everyone else.
+*/
+static bool SV_QueryRateLimited( const netadr_t *address )
+{
+	const uint8_t *ip;
+	size_t i, iplen;
+	unsigned int hash = 2166136261u;
+	sv_querybucket_t *bucket;
+
+	if( NET_IsLocalAddress( address ) )
+		return false;
+
+	if( sv_maxInfoQueries->integer > 0 && !SV_IsMasterAddress( address ) )
+	{
+		if( !SV_QueryBucketTake( &sv_queryglobalbucket, sv_maxInfoQueries->integer, sv_maxInfoQueries->integer ) )
+			return true;
+	}
+
+	switch( address->type )
+	{
+	case NA_IP:
+		ip = address->address.ipv4.ip;
+		iplen = sizeof( address->address.ipv4.ip );
+		break;
+	case NA_IP6:
+		ip = address->address.ipv6.ip;
+		iplen = sizeof( address->address.ipv6.ip );
+		break;
+	default:
+		return false;
+	}
+
+	for( i = 0; i < iplen; i++ )
+		hash = ( hash ^ ip[i] ) * 16777619u;
+
+	// a colliding address takes the bucket over with a full burst
+	bucket = &sv_querybuckets[hash & ( SV_QUERYLIMIT_HASHSIZE - 1 )];
+	if( !NET_CompareBaseAddress( &bucket->address, address ) )
+	{
+		bucket->address = *address;
+		bucket->tokens = SV_QUERYLIMIT_BURST;
+		bucket->time = svs.realtime;
+	}
+
+	return !SV_QueryBucketTake( bucket, SV_QUERYLIMIT_BURST, SV_QUERYLIMIT_RATE );
+}
+
+
 //==============================================================================
 //
 //OUT OF BAND COMMANDS
@@ -476,12 +739,14 @@ static void SVC_Ping( const socket_t *socket, const netadr_t *address )
 static void SVC_InfoResponse( const socket_t *socket, const netadr_t *address )
 {
 	int i, count;
-	char *string;
 	bool allow_empty = false, allow_full = false;
 
 	if( sv_showInfoQueries->integer )
 		Com_Printf( "Info Packet %s\n", NET_AddressToString( address ) );
 
+	if( SV_QueryRateLimited( address ) )
+		return;
+
 	// KoFFiE: When not public and coming from a LAN address
 	//         assume broadcast and respond anyway, otherwise ignore
 	if( ( ( !sv_public->integer ) && ( !NET_IsLANAddress( address ) ) ) ||
@@ -512,14 +777,8 @@ static void SVC_InfoResponse( const socket_t *socket, const netadr_t *address )
 			allow_empty = true;
 	}
 
-	count = 0;
-	for( i = 0; i < sv_maxclients->integer; i++ )
-	{
-		if( svs.clients[i].state >= CS_CONNECTED )
-		{
-			count++;
-		}
-	}
+	SV_CheckInfoCache();
+	count = sv_infocache_numclients;
 
 	if( ( count == sv_maxclients->integer ) && !allow_full )
 	{
@@ -531,9 +790,7 @@ static void SVC_InfoResponse( const socket_t *socket, const netadr_t *address )
 		return;
 	}
 
-	string = SV_ShortInfoString();
-	if( string )
-		Netchan_OutOfBandPrint( socket, address, "info\n%s", string );
+	SV_SendInfoCache( socket, address, SV_GetInfoCache( SV_INFOCACHE_SHORT ), "info\n" );
 }
 
 /*
@@ -541,11 +798,14 @@ static void SVC_InfoResponse( const socket_t *socket, const netadr_t *address )
 */
 static void SVC_SendInfoString( const socket_t *socket, const netadr_t *address, const char *requestType, const char *responseType, bool fullStatus )
 {
-	char *string;
+	char challenge[64];
 
 	if( sv_showInfoQueries->integer )
 		Com_Printf( "%s Packet %s\n", requestType, NET_AddressToString( address ) );
 
+	if( SV_QueryRateLimited( address ) )
+		return;
+
 	// KoFFiE: When not public and coming from a LAN address
 	//         assume broadcast and respond anyway, otherwise ignore
 	if( ( ( !sv_public->integer ) && ( !NET_IsLANAddress( address ) ) ) ||
@@ -563,9 +823,9 @@ static void SVC_SendInfoString( const socket_t *socket, const netadr_t *address,
 	//	return;
 
 	// send the same string that we would give for a status OOB command
-	string = SV_LongInfoString( fullStatus );
-	if( string )
-		Netchan_OutOfBandPrint( socket, address, "%s\n\\challenge\\%s%s", responseType, Cmd_Argv( 1 ), string );
+	Q_strncpyz( challenge, Cmd_Argv( 1 ), sizeof( challenge ) );
+	SV_SendInfoCache( socket, address, SV_GetInfoCache( fullStatus ? SV_INFOCACHE_FULL : SV_INFOCACHE_LONG ),
+		"%s\n\\challenge\\%s", responseType, challenge );
 }
 
 /*
@@ -698,7 +958,8 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 		return;
 	}
 
-	if( Cmd_Argc() >= 7 )
+	// clients without a matchmaker ticket send 0 when they need to pass the codec offer
+	if( Cmd_Argc() >= 7 && atoi( Cmd_Argv( 6 ) ) )
 	{
 		// we have extended information, ticket-id and session-id
 		Com_Printf("Extended information %s\n", Cmd_Argv(6) );
@@ -860,8 +1121,12 @@ static void SVC_DirectConnect( const socket_t *socket, const netadr_t *address )
 		return;
 	}
 
+	// pick the compression codec from the client's offer, old clients only know zlib
+	newcl->netchan.codec = Com_NetCodecFromOffer( Cmd_Argc() >= 8 ? Cmd_Argv( 7 ) : NULL );
+
 	// send the connect packet to the client
-	Netchan_OutOfBandPrint( socket, address, "client_connect\n%s", newcl->session );
+	Netchan_OutOfBandPrint( socket, address, "client_connect\n%s\n%s", newcl->session,
+		Com_NetCodecName( newcl->netchan.codec ) );
 
 	// free the incoming entry
 #ifdef TCP_ALLOW_CONNECT
@@ -299,7 +299,7 @@ bool SV_Netchan_Transmit( netchan_t *netchan, msg_t *msg )
 
 	if( sv_compresspackets->integer )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{          // it's compression error, just send uncompressed
 			Com_DPrintf( "SV_Netchan_Transmit (ignoring compression): Compression error %i\n", zerror );
@@ -374,12 +374,10 @@ void SV_WriteFrameSnapToClient( client_t *client, msg_t *msg )
 }
 
 /*
-* SV_BuildClientFrameSnap
+* SV_SkyPortalOrigin
 */
-void SV_BuildClientFrameSnap( client_t *client )
+static vec_t *SV_SkyPortalOrigin( vec3_t origin )
 {
-	vec_t *skyorg = NULL, origin[3];
-
 	if( sv.configstrings[CS_SKYBOX][0] != '\0' )
 	{
 		int noents = 0;
@@ -388,11 +386,21 @@ void SV_BuildClientFrameSnap( client_t *client )
 		if( sscanf( sv.configstrings[CS_SKYBOX], "%f %f %f %f %f %i", &origin[0], &origin[1], &origin[2], &f1, &f2, &noents ) >= 3 )
 		{
 			if( !noents )
-				skyorg = origin;
+				return origin;
 		}
 	}
 
-	svs.fatvis.skyorg = skyorg;		// HACK HACK HACK
+	return NULL;
+}
+
+/*
+* SV_BuildClientFrameSnap
+*/
+void SV_BuildClientFrameSnap( client_t *client )
+{
+	vec3_t origin;
+
+	svs.fatvis.skyorg = SV_SkyPortalOrigin( origin );		// HACK HACK HACK
 	SNAP_BuildClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime,
 		&svs.fatvis, client, ge->GetGameState(), 
 		&svs.client_entities,
@@ -405,6 +413,8 @@ void SV_BuildClientFrameSnap( client_t *client )
 */
 static bool SV_SendClientDatagram( client_t *client )
 {
+	uint64_t profStart;
+
 	if( client->edict && ( client->edict->r.svflags & SVF_FAKECLIENT ) )
 		return true;
 
@@ -414,13 +424,142 @@ static bool SV_SendClientDatagram( client_t *client )
 
 	// send over all the relevant entity_state_t
 	// and the player_state_t
+	profStart = Prof_Begin();
 	SV_BuildClientFrameSnap( client );
+	Prof_End( svc.prof.snapBuild, profStart );
 
+	profStart = Prof_Begin();
 	SV_WriteFrameSnapToClient( client, &tmpMessage );
+	Prof_End( svc.prof.snapEncode, profStart );
 
 	return SV_SendMessageToClient( client, &tmpMessage );
 }
 
+//===============================================================================
+//
+//THREADED SNAPSHOTS
+//
+//===============================================================================
+
+// with sv_snapThreads > 0 culling and delta encoding of the client datagrams
+// is spread over a job pool. The game state is only read during that phase
+// and every client gets its own message buffer from the frame arena, which is
+// transmitted back on the main thread since the netchan compression buffer is shared.
+
+typedef struct
+{
+	qjobpool_t *pool;
+	int numThreads;
+
+	int numWorkers;
+	fatvis_t *fatvis;                   // [numWorkers] culling scratch space
+
+	// per-frame data shared by the jobs
+	int numClients;
+	client_t *clients[MAX_CLIENTS];
+	msg_t *messages;                    // [numClients]
+	uint8_t *messageData;               // [numClients * MAX_MSGLEN]
+	vec_t *skyorg;
+	vec3_t skyorigin;
+	game_state_t *gameState;
+} sv_snapjobs_t;
+
+static sv_snapjobs_t snapjobs;
+
+/*
+* SV_ShutdownSnapJobs
+*/
+void SV_ShutdownSnapJobs( void )
+{
+	QJobPool_Destroy( &snapjobs.pool );
+
+	if( snapjobs.fatvis )
+		Mem_Free( snapjobs.fatvis );
+
+	memset( &snapjobs, 0, sizeof( snapjobs ) );
+}
+
+/*
+* SV_InitSnapJobs
+*
+* (Re)creates the job pool when sv_snapThreads has changed.
+*/
+static void SV_InitSnapJobs( void )
+{
+	int numThreads = sv_snapThreads->integer;
+
+	clamp( numThreads, 0, SV_MAX_SNAP_THREADS );
+	if( snapjobs.pool && snapjobs.numThreads == numThreads )
+		return;
+
+	SV_ShutdownSnapJobs();
+
+	snapjobs.pool = QJobPool_Create( numThreads );
+	snapjobs.numThreads = numThreads;
+	snapjobs.numWorkers = QJobPool_NumWorkers( snapjobs.pool );
+	snapjobs.fatvis = Mem_Alloc( sv_mempool, sizeof( *snapjobs.fatvis ) * snapjobs.numWorkers );
+}
+
+/*
+* SV_BuildClientDatagram_Job
+*/
+static void SV_BuildClientDatagram_Job( void *param, int item, int worker )
+{
+	client_t *client = snapjobs.clients[item];
+	msg_t *msg = &snapjobs.messages[item];
+	fatvis_t *fatvis = &snapjobs.fatvis[worker];
+	uint64_t profStart;
+
+	SV_InitClientMessage( client, msg, snapjobs.messageData + MAX_MSGLEN * item, MAX_MSGLEN );
+
+	SV_AddReliableCommandsToMessage( client, msg );
+
+	fatvis->skyorg = snapjobs.skyorg;
+	fatvis->viscache = svs.fatvis.viscache;
+	profStart = Prof_Begin();
+	SNAP_BuildClientFrameSnap( svs.cms, &sv.gi, sv.framenum, svs.gametime,
+		fatvis, client, snapjobs.gameState, 
+		&svs.client_entities,
+		false, sv_mempool );
+	Prof_End( svc.prof.snapBuild, profStart );
+
+	profStart = Prof_Begin();
+	SV_WriteFrameSnapToClient( client, msg );
+	Prof_End( svc.prof.snapEncode, profStart );
+}
+
+/*
+* SV_SendClientDatagrams_Threaded
+*/
+static void SV_SendClientDatagrams_Threaded( void )
+{
+	int i;
+	client_t *client;
+
+	SV_InitSnapJobs();
+
+	snapjobs.skyorg = SV_SkyPortalOrigin( snapjobs.skyorigin );
+	snapjobs.gameState = ge->GetGameState();
+
+	snapjobs.messages = Mem_FrameAllocExt( sizeof( *snapjobs.messages ) * snapjobs.numClients, 0 );
+	snapjobs.messageData = Mem_FrameAllocExt( MAX_MSGLEN * snapjobs.numClients, 0 );
+
+	QJobPool_Run( snapjobs.pool, SV_BuildClientDatagram_Job, NULL, snapjobs.numClients );
+
+	for( i = 0; i < snapjobs.numClients; i++ )
+	{
+		client = snapjobs.clients[i];
+		if( !SV_SendMessageToClient( client, &snapjobs.messages[i] ) )
+		{
+			Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
+			if( client->reliable )
+			{
+				SV_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n", NET_ErrorString() );
+			}
+		}
+	}
+}
+
 /*
 * SV_SendClientMessages
 */
@@ -428,6 +567,9 @@ void SV_SendClientMessages( void )
 {
 	int i;
 	client_t *client;
+	bool threaded = sv_snapThreads->integer > 0;
+
+	snapjobs.numClients = 0;
 
 	// send a message to each connected client
 	for( i = 0, client = svs.clients; i < sv_maxclients->integer; i++, client++ )
@@ -447,6 +589,13 @@ void SV_SendClientMessages( void )
 
 		if( client->state == CS_SPAWNED )
 		{
+			if( threaded )
+			{
+				// the datagram is built and sent below
+				snapjobs.clients[snapjobs.numClients++] = client;
+				continue;
+			}
+
 			if( !SV_SendClientDatagram( client ) )
 			{
 				Com_Printf( "Error sending message to %s: %s\n", client->name, NET_ErrorString() );
@@ -475,4 +624,7 @@ void SV_SendClientMessages( void )
 			}
 		}
 	}
+
+	if( threaded && snapjobs.numClients )
+		SV_SendClientDatagrams_Threaded();
 }
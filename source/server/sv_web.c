@@ -24,7 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #ifdef HTTP_SUPPORT
 
-#define MAX_INCOMING_HTTP_CONNECTIONS			48
+#define MAX_INCOMING_HTTP_CONNECTIONS			128
 #define MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR	3
 
 #define MAX_INCOMING_CONTENT_LENGTH				0x2800
@@ -34,6 +34,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define HTTP_SERVER_SLEEP_TIME					50 // milliseconds
 
+#define HTTP_RATE_BURST_TIME					250 // milliseconds worth of sv_http_maxrate a connection may send at once
+
 typedef enum
 {
 	HTTP_CONN_STATE_NONE = 0,
@@ -120,6 +122,14 @@ typedef struct sv_http_connection_s
 
 	bool is_upstream;
 
+	int poll_events;                // NET_POLL_* we are waiting for on the socket
+	size_t pipelined;               // bytes of the following requests already read into the request buffer
+
+	// bandwidth shaper
+	int64_t rate_tokens;            // bytes the connection may send
+	unsigned int rate_time;         // when the tokens were last refilled
+	unsigned int rate_resume;       // when a throttled connection may send again, 0 if not throttled
+
 	struct sv_http_connection_s *next, *prev;
 } sv_http_connection_t;
 
@@ -143,6 +153,8 @@ static socket_t sv_socket_http6;
 
 static netadr_t sv_web_upstream_addr;
 
+static netpoll_t *sv_http_poll;
+
 static uint64_t sv_http_request_autoicr;
 
 static trie_t *sv_http_clients = NULL;
@@ -278,6 +290,11 @@ static sv_http_connection_t *SV_Web_AllocConnection( void )
 	con->state = HTTP_CONN_STATE_NONE;
 	con->close_after_resp = false;
 	con->is_upstream = false;
+	con->poll_events = 0;
+	con->pipelined = 0;
+	con->rate_tokens = 0;
+	con->rate_time = Sys_Milliseconds();
+	con->rate_resume = 0;
 	return con;
 }
 
@@ -306,6 +323,13 @@ static void SV_Web_FreeConnection( sv_http_connection_t *con )
 static void SV_Web_InitConnections( void )
 {
 	unsigned int i;
+	unsigned int numconnections = MAX_INCOMING_HTTP_CONNECTIONS;
+	int maxsockets = NET_PollMaxSockets();
+
+	// the select() fallback has room for FD_SETSIZE sockets, the two listening ones included
+	if( maxsockets && (unsigned)maxsockets - 2 < numconnections ) {
+		numconnections = maxsockets - 2;
+	}
 
 	memset( sv_http_connections, 0, sizeof( sv_http_connections ) );
 
@@ -313,11 +337,21 @@ static void SV_Web_InitConnections( void )
 	sv_free_http_connections = sv_http_connections;
 	sv_http_connection_headnode.prev = &sv_http_connection_headnode;
 	sv_http_connection_headnode.next = &sv_http_connection_headnode;
-	for( i = 0; i < MAX_INCOMING_HTTP_CONNECTIONS - 2; i++ ) {
+	for( i = 0; i < numconnections - 1; i++ ) {
 		sv_http_connections[i].next = &sv_http_connections[i+1];
 	}
 }
 
+/*
+* SV_Web_CloseConnection
+*/
+static void SV_Web_CloseConnection( sv_http_connection_t *con )
+{
+	NET_PollRemove( sv_http_poll, &con->socket );
+	NET_CloseSocket( &con->socket );
+	SV_Web_FreeConnection( con );
+}
+
 /*
 * SV_Web_ShutdownConnections
 */
@@ -331,8 +365,7 @@ static void SV_Web_ShutdownConnections( void )
 	{
 		next = con->prev;
 		if( con->open ) {
-			NET_CloseSocket( &con->socket );
-			SV_Web_FreeConnection( con );
+			SV_Web_CloseConnection( con );
 		}
 	}
 }
@@ -451,6 +484,28 @@ static bool SV_Web_FindGameClientByAddress( const netadr_t *netadr )
 	return valid_address;
 }
 
+/*
+* SV_Web_IsLocalRequest
+*
+* The profiler may be queried by monitoring on the same host, which has no game session.
+* File downloads only skip the session check when sv_http_localfiles is set, for load tests.
+*/
+static bool SV_Web_IsLocalRequest( const sv_http_connection_t *con )
+{
+	const sv_http_request_t *request = &con->request;
+
+	if( con->is_upstream || !NET_IsLocalAddress( &con->address ) ) {
+		return false;
+	}
+	if( !request->resource ) {
+		return false;
+	}
+	if( !Q_stricmp( request->resource, "profile" ) ) {
+		return true;
+	}
+	return sv_http_localfiles->integer && !Q_strnicmp( request->resource, "files/", 6 );
+}
+
 /*
 * SV_Web_ConnectionLimitReached
 */
@@ -468,12 +523,11 @@ static unsigned SV_Web_ConnectionLimitReached( const netadr_t *addr )
 	for( con = hnode->prev; con != hnode; con = next )
 	{
 		next = con->prev;
-		if( NET_CompareAddress( addr, &con->address ) ) {
-			if( cnt >= MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR ) {
+		if( NET_CompareBaseAddress( addr, &con->address ) ) {
+			if( ++cnt >= MAX_INCOMING_HTTP_CONNECTIONS_PER_ADDR ) {
 				return true;
 			}
 		}
-		cnt++;
 	}
 	return false;
 }
@@ -513,7 +567,7 @@ static int SV_Web_Send( sv_http_connection_t *con, void *sendbuf, size_t sendbuf
 */
 static int64_t SV_Web_SendFile( sv_http_connection_t *con, int fileno, size_t fileOffset, size_t *pos, size_t count )
 {
-	int sent;
+	int64_t sent;
 
 	assert( pos != NULL );
 	if( !pos ) {
@@ -531,6 +585,39 @@ static int64_t SV_Web_SendFile( sv_http_connection_t *con, int fileno, size_t fi
 	return sent;
 }
 
+/*
+* SV_Web_RateAllowance
+*
+* Token bucket limiting the response body bandwidth of a connection to sv_http_maxrate.
+* Returns how many of the wanted bytes may be sent now. When none, the connection is
+* throttled until enough tokens are refilled for a reasonably sized write.
+*/
+static size_t SV_Web_RateAllowance( sv_http_connection_t *con, size_t wanted )
+{
+	int64_t rate, burst, need;
+	unsigned int now;
+
+	rate = (int64_t)sv_http_maxrate->integer * 1024;
+	if( rate <= 0 ) {
+		con->rate_resume = 0;
+		return wanted;
+	}
+
+	now = Sys_Milliseconds();
+	burst = max( rate * HTTP_RATE_BURST_TIME / 1000, 1 );
+	con->rate_tokens = min( con->rate_tokens + rate * (int)( now - con->rate_time ) / 1000, burst );
+	con->rate_time = now;
+
+	if( con->rate_tokens <= 0 ) {
+		need = min( burst, 0x4000 ) - con->rate_tokens;
+		con->rate_resume = now + max( need * 1000 / rate, 1 );
+		return 0;
+	}
+
+	con->rate_resume = 0;
+	return min( wanted, (size_t)con->rate_tokens );
+}
+
 // ============================================================================
 // Inter-threading communication
 // Passes queries and responses from the web thread to the main thread and back.
@@ -764,6 +851,69 @@ static void SV_Web_ParseStartLine( sv_http_request_t *request, char *line )
 	}
 }
 
+/*
+* SV_Web_ParseRange
+*
+* Parses a single byte range spec. A negative begin is the length of a suffix
+* range ("-500") and a negative end stands for the end of the resource ("500-").
+*/
+static bool SV_Web_ParseRange( const char *spec, sv_http_content_range_t *range )
+{
+	char *end;
+	const char *delim;
+
+	delim = strchr( spec, '-' );
+	if( !delim ) {
+		return false;
+	}
+
+	if( delim == spec ) {
+		// bytes=-500
+		range->begin = -strtol( delim + 1, &end, 10 );
+		range->end = -1;
+		return end != delim + 1 && !*end && range->begin < 0;
+	}
+
+	range->begin = strtol( spec, &end, 10 );
+	if( end != delim || range->begin < 0 ) {
+		return false;
+	}
+
+	if( !delim[1] ) {
+		// bytes=500-
+		range->end = -1;
+		return true;
+	}
+
+	// bytes=500-999
+	range->end = strtol( delim + 1, &end, 10 );
+	return !*end && range->end >= range->begin;
+}
+
+/*
+* SV_Web_ResolveRange
+*
+* Clamps the requested range to the resource length, the end of the result is inclusive.
+* Returns false if the range is not satisfiable.
+*/
+static bool SV_Web_ResolveRange( const sv_http_content_range_t *requested, size_t length, sv_http_content_range_t *range )
+{
+	if( !length ) {
+		return false;
+	}
+
+	if( requested->begin < 0 ) {
+		range->begin = max( (long)length + requested->begin, 0 );
+		range->end = length - 1;
+	}
+	else {
+		range->begin = requested->begin;
+		range->end = requested->end < 0 ? (long)length - 1 : min( requested->end, (long)length - 1 );
+	}
+
+	return range->begin < (long)length;
+}
+
 /*
 * SV_Web_AnalyzeHeader
 */
@@ -792,53 +942,12 @@ static void SV_Web_AnalyzeHeader( sv_http_request_t *request, const char *key, c
 	}
 	else if( !Q_stricmp( key, "Range" ) 
 		&& ( request->method == HTTP_METHOD_GET || request->method == HTTP_METHOD_HEAD ) ) {
-		const char *delim = strchr( value, '-' );
-
-		if( Q_strnicmp( value, "bytes=", 6 ) || !delim ) {
+		if( Q_strnicmp( value, "bytes=", 6 ) ) {
 			request->error = HTTP_RESP_BAD_REQUEST;
 		}
-		else {
-			bool neg_end = false;
-			const char *p = value;
-
-			// first byte pos
-			while( *p && p < delim ) {
-				if( *p >= '0' && *p <= '9' )
-					stream->content_range.begin = stream->content_range.begin*10 + *p - '0';
-				p++;
-			}
-			p++;
-
-			// last byte pos
-			if( *p == '-' ) {
-				if( value != delim ) {
-					request->error = HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE;
-					return;
-				}
-				neg_end = true;
-				p++;
-			}
-			while( *p ) {
-				if( *p >= '0' && *p <= '9' )
-				stream->content_range.end = stream->content_range.end*10 + *p++ - '0';
-			}
-
-			// partial content request
-			if( neg_end && stream->content_range.end ) {
-				// bytes=-100
-				request->partial = true;
-				stream->content_range.end = -stream->content_range.end;
-			} else if( stream->content_range.end >= stream->content_range.begin ) {
-				// bytes=200-300
-				request->partial = true;
-			} else if( stream->content_range.begin >= 0 && *(delim+1) == '\0' ) {
-				// bytes=200-
-				request->partial = true;
-			}
-
-			if( request->partial ) {
-				request->partial_content_range = stream->content_range;
-			}
+		else if( !strchr( value, ',' ) ) {
+			// multiple ranges are not supported, the whole resource is sent for them
+			request->partial = SV_Web_ParseRange( value + 6, &request->partial_content_range );
 		}
 	} else if( !Q_stricmp( key, "X-Client" ) ) {
 		request->clientNum = atoi( value );
@@ -915,7 +1024,7 @@ static size_t SV_Web_ParseHeaders( sv_http_request_t *request, char *data )
 /*
 * SV_Web_ReceiveRequest
 */
-static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
+static void SV_Web_ReceiveRequest( sv_http_connection_t *con )
 {
 	int ret = 0;
 	char *recvbuf;
@@ -939,10 +1048,17 @@ static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
 			break;
 		}
 
-		ret = SV_Web_Get( con, recvbuf, recvbuf_size - 1 );
+		if( con->pipelined ) {
+			// the next pipelined request, already read with the previous one
+			ret = con->pipelined;
+			con->pipelined = 0;
+		}
+		else {
+			ret = SV_Web_Get( con, recvbuf, recvbuf_size - 1 );
+		}
 		if( ret <= 0 ) {
 			if( total_received == 0 ) {
-				// no data on the socket after select() call, 
+				// no data on the socket after it's been polled readable, 
 				// the connection has probably been closed on the other end
 				con->open = false;
 				return;
@@ -976,7 +1092,8 @@ static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
 				(request->realAddr.type == NA_NOTRANSMIT || SV_Web_ConnectionLimitReached( &request->realAddr )) ) {
 				request->error = HTTP_RESP_SERVICE_UNAVAILABLE;
 			}
-			else if( !SV_Web_FindGameClientBySession( request->clientSession, request->clientNum ) ) {
+			else if( !SV_Web_FindGameClientBySession( request->clientSession, request->clientNum ) 
+				&& !SV_Web_IsLocalRequest( con ) ) {
 				request->error = HTTP_RESP_FORBIDDEN;
 			}
 		}
@@ -1018,7 +1135,10 @@ static void SV_Web_ReceiveRequest( socket_t *socket, sv_http_connection_t *con )
 		}
 		if( request->stream.content_p >= request->stream.content_length ) {
 			request->stream.content_p = request->stream.content_length;
-			request->stream.content[request->stream.content_p] = '\0';
+			if( request->stream.content != request->stream.header_buf ) {
+				// the header buffer may hold the pipelined requests past the content
+				request->stream.content[request->stream.content_p] = '\0';
+			}
 		}
 	}
 
@@ -1083,6 +1203,18 @@ static void SV_Web_RouteRequest( const sv_http_request_t *request, sv_http_respo
 	if( !resource ) {
 		response->code = HTTP_RESP_BAD_REQUEST;
 	}
+	else if( !Q_stricmp( resource, "profile" ) ) {
+		// frame profiler histograms, see Prof_WriteJSON
+		if( request->method == HTTP_METHOD_GET || request->method == HTTP_METHOD_HEAD ) {
+			*content = Prof_WriteJSON( content_length );
+			response->content = *content;
+			response->content_length = *content_length;
+			response->code = HTTP_RESP_OK;
+		}
+		else {
+			response->code = HTTP_RESP_BAD_REQUEST;
+		}
+	}
 	else if( !Q_strnicmp( resource, "game/", 5 ) ) {
 		// request to game module
 		response->content_state = CONTENT_STATE_AWAITING;
@@ -1140,6 +1272,7 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con )
 	char *content = NULL;
 	size_t header_length = 0;
 	size_t content_length = 0;
+	size_t resource_length = 0;
 	sv_http_request_t *request = &con->request;
 	sv_http_response_t *response = &con->response;
 	sv_http_stream_t *resp_stream = &response->stream;
@@ -1168,25 +1301,18 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con )
 		}
 
 		// serve range requests
+		resource_length = content_length;
 		if( request->partial && response->file ) {
-			// seek to first byte pos and clamp the last byte pos to content length
-			if( request->partial_content_range.begin > 0 ) { 
-				FS_Seek( response->file, request->partial_content_range.begin, FS_SEEK_SET );
-				// range.end may be set to 0 for 'bytes=100-' style requests
-				response->stream.content_range.end = request->partial_content_range.end 
-					? request->partial_content_range.end : content_length;
-
-			} else if( request->partial_content_range.end < 0 ) {
-				// seek to N last bytes in the file
-				FS_Seek( response->file, request->partial_content_range.end, FS_SEEK_END );
-				response->stream.content_range.end = -request->partial_content_range.end;
+			if( SV_Web_ResolveRange( &request->partial_content_range, content_length, &response->stream.content_range ) ) {
+				// the file is sent from its offset, so no need to seek
+				response->file_send_pos = response->stream.content_range.begin;
+				response->code = HTTP_RESP_PARTIAL_CONTENT;
+			}
+			else {
+				response->code = HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE;
+				FS_FCloseFile( response->file );
+				response->file = 0;
 			}
-
-			// Content-Range header values
-			response->file_send_pos = FS_Tell( response->file );
-			response->stream.content_range.begin = response->file_send_pos;
-			response->stream.content_range.end = min( (int)content_length, response->stream.content_range.end );
-			response->code = HTTP_RESP_PARTIAL_CONTENT;
 		}
 
 		if( request->method == HTTP_METHOD_HEAD && response->file ) {
@@ -1205,24 +1331,22 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con )
 			sizeof( resp_stream->header_buf ) );
 
 	if( response->code == HTTP_RESP_REQUESTED_RANGE_NOT_SATISFIABLE ) {
-		int file_length = FS_FOpenBaseFile( request->resource, NULL, FS_READ );
-
 		// in accordance with RFC 2616, send the Content-Range entity header,
 		// specifying the length of the resource
-		if( file_length < 0 ) {
+		if( !resource_length ) {
 			Q_strncatz( resp_stream->header_buf, "Content-Range: bytes */*\r\n",
 				sizeof( resp_stream->header_buf ) );
 		}
 		else {
-			Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes */%i\r\n", content_length );
+			Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes */%i\r\n", (int)resource_length );
 			Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
 		}
 	}
 	else if( response->code == HTTP_RESP_PARTIAL_CONTENT ) {
-		Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes %i-%i/%i\r\n", 
-			response->stream.content_range.begin, response->stream.content_range.end, content_length );
+		Q_snprintfz( vastr, sizeof( vastr ), "Content-Range: bytes %li-%li/%i\r\n", 
+			response->stream.content_range.begin, response->stream.content_range.end, (int)resource_length );
 		Q_strncatz( resp_stream->header_buf, vastr, sizeof( resp_stream->header_buf ) );
-		content_length = response->stream.content_range.end - response->stream.content_range.begin;
+		content_length = response->stream.content_range.end - response->stream.content_range.begin + 1;
 	}
 
 	if( response->code >= HTTP_RESP_BAD_REQUEST || !content_length ) {
@@ -1259,7 +1383,9 @@ static void SV_Web_RespondToQuery( sv_http_connection_t *con )
 		memcpy( resp_stream->content, content, content_length );
 	}
 	resp_stream->header_length = header_length;
-	resp_stream->content_length = content_length;
+
+	// HEAD responses only carry the headers of the would-be GET
+	resp_stream->content_length = request->method == HTTP_METHOD_HEAD ? 0 : content_length;
 }
 
 /*
@@ -1293,8 +1419,13 @@ static size_t SV_Web_SendResponse( sv_http_connection_t *con )
 
 	if( stream->header_done && stream->content_length ) {
 		while( stream->content_p < stream->content_length && sv_http_running ) {
+			sendbuf_size = SV_Web_RateAllowance( con, stream->content_length - stream->content_p );
+			if( !sendbuf_size ) {
+				break;
+			}
+
 			if( response->file ) {
-				sendbuf_size = stream->content_length - stream->content_p;
+				// zero-copy from the file straight to the socket
 				sent = SV_Web_SendFile( con, response->fileno, response->file_data_offset, &response->file_send_pos, sendbuf_size );
 			}
 			else {
@@ -1302,7 +1433,6 @@ static size_t SV_Web_SendResponse( sv_http_connection_t *con )
 					break;
 				}				
 				sendbuf = stream->content + stream->content_p;
-				sendbuf_size = stream->content_length - stream->content_p;
 				sent = SV_Web_Send( con, sendbuf, sendbuf_size );
 			}
 
@@ -1311,6 +1441,7 @@ static size_t SV_Web_SendResponse( sv_http_connection_t *con )
 			}
 
 			stream->content_p += sent;
+			con->rate_tokens -= sent;
 			total_sent += sent;
 		}
 	}
@@ -1328,10 +1459,34 @@ static size_t SV_Web_SendResponse( sv_http_connection_t *con )
 	return total_sent;
 }
 
+/*
+* SV_Web_NextRequest
+*
+* Resets the request of a kept-alive connection, keeping the bytes of the
+* requests the client has pipelined after the one we've just answered.
+*/
+static void SV_Web_NextRequest( sv_http_connection_t *con )
+{
+	sv_http_stream_t *stream = &con->request.stream;
+	size_t offset = stream->content_length;
+	size_t pipelined = 0;
+
+	if( stream->header_done && stream->header_buf_p > offset ) {
+		pipelined = stream->header_buf_p - offset;
+	}
+
+	SV_Web_ResetRequest( &con->request );
+
+	if( pipelined ) {
+		memmove( stream->header_buf, stream->header_buf + offset, pipelined );
+	}
+	con->pipelined = pipelined;
+}
+
 /*
 * SV_Web_WriteResponse
 */
-static void SV_Web_WriteResponse( socket_t *socket, sv_http_connection_t *con )
+static void SV_Web_WriteResponse( sv_http_connection_t *con )
 {
 	if( !sv_http_running ) {
 		return;
@@ -1355,7 +1510,7 @@ static void SV_Web_WriteResponse( socket_t *socket, sv_http_connection_t *con )
 					con->open = false;
 				}
 				else {
-					SV_Web_ResetRequest( &con->request );
+					SV_Web_NextRequest( con );
 				}
 			}
 			break;
@@ -1435,7 +1590,9 @@ static void SV_Web_Listen( socket_t *socket )
 			Com_DPrintf( "HTTP connection accepted from %s\n", NET_AddressToString( &newaddress ) );
 			con = SV_Web_AllocConnection();
 			if( !con ) {
-				break;
+				Com_DPrintf( "HTTP connection refused for %s: too many connections\n", NET_AddressToString( &newaddress ) );
+				NET_CloseSocket( &newsocket );
+				continue;
 			}
 			con->socket = newsocket;
 			con->address = newaddress;
@@ -1443,6 +1600,12 @@ static void SV_Web_Listen( socket_t *socket )
 			con->open = true;
 			con->state = HTTP_CONN_STATE_RECV;
 			con->is_upstream = is_upstream;
+			con->poll_events = NET_POLL_READ;
+			if( !NET_PollSet( sv_http_poll, &con->socket, con->poll_events, con ) ) {
+				Com_DPrintf( "HTTP connection refused for %s: %s\n", NET_AddressToString( &newaddress ), NET_ErrorString() );
+				NET_CloseSocket( &con->socket );
+				SV_Web_FreeConnection( con );
+			}
 			continue;
 		}
 
@@ -1475,6 +1638,21 @@ void SV_Web_Init( void )
 		return;
 	}
 
+	sv_http_poll = NET_CreatePoll();
+	if( !sv_http_poll ) {
+		Com_Printf( "Error: Couldn't create the web server poll: %s\n", NET_ErrorString() );
+		NET_CloseSocket( &sv_socket_http );
+		NET_CloseSocket( &sv_socket_http6 );
+		sv_http_initialized = false;
+		return;
+	}
+	if( sv_socket_http.address.type == NA_IP ) {
+		NET_PollSet( sv_http_poll, &sv_socket_http, NET_POLL_READ, &sv_socket_http );
+	}
+	if( sv_socket_http6.address.type == NA_IP6 ) {
+		NET_PollSet( sv_http_poll, &sv_socket_http6, NET_POLL_READ, &sv_socket_http6 );
+	}
+
 	sv_http_running = true;
 
 	SV_Web_InitQueues();
@@ -1484,15 +1662,81 @@ void SV_Web_Init( void )
 	sv_http_thread = QThread_Create( SV_Web_ThreadProc, NULL );
 }
 
+/*
+* SV_Web_UpdatePoll
+*
+* Waits for the socket events the connection can make progress on: requests are read
+* one at a time and the pipelined ones wait in the socket until the response is sent.
+*/
+static void SV_Web_UpdatePoll( sv_http_connection_t *con )
+{
+	int events = 0;
+
+	switch( con->state ) {
+		case HTTP_CONN_STATE_RECV:
+			events = NET_POLL_READ;
+			break;
+		case HTTP_CONN_STATE_SEND:
+			if( !con->rate_resume ) {
+				events = NET_POLL_WRITE;
+			}
+			break;
+		default:
+			// awaiting the response from the game module
+			break;
+	}
+
+	if( events == con->poll_events ) {
+		return;
+	}
+
+	con->poll_events = events;
+	if( !NET_PollSet( sv_http_poll, &con->socket, events, con ) ) {
+		Com_DPrintf( "HTTP poll error for %s: %s\n", NET_AddressToString( &con->address ), NET_ErrorString() );
+		con->open = false;
+	}
+}
+
+/*
+* SV_Web_ProcessConnection
+*/
+static void SV_Web_ProcessConnection( sv_http_connection_t *con, int events )
+{
+	if( events & NET_POLL_READ ) {
+		SV_Web_ReceiveRequest( con );
+	}
+	else if( events & NET_POLL_ERROR ) {
+		con->open = false;
+	}
+
+	// answer the requests as long as the responses go out without blocking
+	while( con->open && sv_http_running ) {
+		SV_Web_WriteResponse( con );
+		if( !con->open || con->state != HTTP_CONN_STATE_RECV || !con->pipelined ) {
+			break;
+		}
+
+		SV_Web_ReceiveRequest( con );
+		if( con->state != HTTP_CONN_STATE_RESP ) {
+			break;
+		}
+	}
+
+	if( con->open ) {
+		SV_Web_UpdatePoll( con );
+	}
+}
+
 /*
 * SV_Web_Frame
 */
 static void SV_Web_Frame( void )
 {
+	int i, num_events;
+	int timeout;
+	unsigned int now;
 	sv_http_connection_t *con, *next, *hnode = &sv_http_connection_headnode;
-	socket_t *sockets[MAX_INCOMING_HTTP_CONNECTIONS+1];
-	void *connections[MAX_INCOMING_HTTP_CONNECTIONS];
-	int num_sockets = 0;
+	netpollevent_t events[NET_POLL_MAX_EVENTS];
 	bool upstream_is_set;
 
 	if( !sv_http_initialized ) {
@@ -1514,52 +1758,52 @@ static void SV_Web_Frame( void )
 			NET_InitAddress( &sv_web_upstream_addr, NA_NOTRANSMIT );
 	}
 
-	// accept new connections
-	if( sv_socket_http.address.type == NA_IP ) {
-		SV_Web_Listen( &sv_socket_http );
-	}
-	if( sv_socket_http6.address.type == NA_IP6 ) {
-		SV_Web_Listen( &sv_socket_http6 );
-	}
+	// read query results from the game module
+	SV_Web_ReadOutgoingQueueCmds();
 
-	// handle incoming data
-	num_sockets = 0;
+	// connections which aren't waiting for the socket: answered by the game module
+	// or done being throttled by the bandwidth shaper
+	timeout = HTTP_SERVER_SLEEP_TIME;
+	now = Sys_Milliseconds();
 	for( con = hnode->prev; con != hnode; con = next )
 	{
 		next = con->prev;
-		switch( con->state ) {
-			case HTTP_CONN_STATE_RECV:
-			case HTTP_CONN_STATE_RESP:
-			case HTTP_CONN_STATE_SEND:
-				sockets[num_sockets] = &con->socket;
-				connections[num_sockets] = con;
-				num_sockets++;
-				break;
-			default:
-				break;
+		if( !con->open ) {
+			continue;
 		}
-	}
-	sockets[num_sockets] = NULL;
 
-	// read query results from the game module
-	SV_Web_ReadOutgoingQueueCmds();
+		if( con->state == HTTP_CONN_STATE_RESP && con->response.content_state != CONTENT_STATE_AWAITING ) {
+			SV_Web_ProcessConnection( con, 0 );
+		}
+		else if( con->state == HTTP_CONN_STATE_SEND && con->rate_resume ) {
+			if( (int)( con->rate_resume - now ) <= 0 ) {
+				SV_Web_ProcessConnection( con, 0 );
+			}
+			if( con->rate_resume ) {
+				timeout = max( min( timeout, (int)( con->rate_resume - now ) ), 0 );
+			}
+		}
+	}
 
-	if( num_sockets != 0 ) {
-		NET_Monitor( HTTP_SERVER_SLEEP_TIME, sockets,
-			(void (*)(socket_t *, void*))SV_Web_ReceiveRequest,
-			(void (*)(socket_t *, void*))SV_Web_WriteResponse,
-			NULL, connections );
+	num_events = NET_PollWait( sv_http_poll, timeout, events, NET_POLL_MAX_EVENTS );
+	if( num_events < 0 ) {
+		Com_DPrintf( "HTTP poll error: %s\n", NET_ErrorString() );
+		Sys_Sleep( HTTP_SERVER_SLEEP_TIME );
+		num_events = 0;
 	}
-	else {
-		// sleep on network sockets if got nothing else to do
-		if( sv_socket_http.address.type == NA_IP ) {
-			sockets[num_sockets++] = &sv_socket_http;
+
+	for( i = 0; i < num_events && sv_http_running; i++ )
+	{
+		if( events[i].data == &sv_socket_http || events[i].data == &sv_socket_http6 ) {
+			// accept new connections
+			SV_Web_Listen( events[i].data );
+			continue;
 		}
-		if( sv_socket_http6.address.type == NA_IP6 ) {
-			sockets[num_sockets++] = &sv_socket_http6;
+
+		con = events[i].data;
+		if( con->open ) {
+			SV_Web_ProcessConnection( con, events[i].events );
 		}
-		sockets[num_sockets] = NULL;
-		NET_Sleep( HTTP_SERVER_SLEEP_TIME, sockets );
 	}
 
 	// close dead connections
@@ -1592,8 +1836,7 @@ static void SV_Web_Frame( void )
 		}
 
 		if( !con->open ) {
-			NET_CloseSocket( &con->socket );
-			SV_Web_FreeConnection( con );
+			SV_Web_CloseConnection( con );
 		}
 	}
 }
@@ -1641,6 +1884,8 @@ void SV_Web_Shutdown( void )
 
 	SV_Web_DestroyQueues();
 
+	NET_DestroyPoll( &sv_http_poll );
+
 	NET_CloseSocket( &sv_socket_http );
 	NET_CloseSocket( &sv_socket_http6 );
 
@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "tv_upstream.h"
 #include "tv_upstream_demos.h"
+#include "tv_relay_client.h"
 
 static char *TV_ConnstateToString( connstate_t state )
 {
@@ -474,6 +475,40 @@ static void TV_Music_f( void )
 	TV_Upstream_SetAudioTrack( upstream, music );
 }
 
+/*
+* TV_LoadViewers_f
+*/
+static void TV_LoadViewers_f( void )
+{
+	const char *text;
+	bool res;
+	upstream_t *upstream;
+
+	if( Cmd_Argc() < 3 )
+	{
+		Com_Printf( "%s <upstream> <viewers> [multiview viewers]\n", Cmd_Argv( 0 ) );
+		Com_Printf( "Adds synthetic viewers to the relay, 0 removes them and reports their cost\n" );
+		return;
+	}
+
+	text = Cmd_Argv( 1 );
+
+	res = TV_UpstreamForText( text, &upstream );
+	if( !res || !upstream )
+	{
+		Com_Printf( "No such upstream: %s\n", text );
+		return;
+	}
+
+	if( upstream->relay.state != CA_ACTIVE )
+	{
+		Com_Printf( "%s" S_COLOR_WHITE ": Relay not active\n", upstream->name );
+		return;
+	}
+
+	TV_Relay_StartViewerLoad( &upstream->relay, bound( 0, atoi( Cmd_Argv( 2 ) ), 1024 ), max( atoi( Cmd_Argv( 3 ) ), 0 ) );
+}
+
 // List of commands
 typedef struct
 {
@@ -502,6 +537,8 @@ static cmd_function_t cmdlist[] =
 
 	{ "music", TV_Music_f },
 
+	{ "loadviewers", TV_LoadViewers_f },
+
 	{ NULL, NULL }
 };
 
@@ -308,7 +308,7 @@ static bool TV_Downstream_Netchan_Transmit( netchan_t *netchan, msg_t *msg )
 
 	if( tv_compresspackets->integer )
 	{
-		zerror = Netchan_CompressMessage( msg );
+		zerror = Netchan_CompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{
 			// it's compression error, just send uncompressed
@@ -537,6 +537,8 @@ void TV_Downstream_DropClient( client_t *drop, int type, const char *format, ...
 
 	memset( &drop->flood, 0, sizeof( drop->flood ) );
 
+	NET_AddrHashUnlink( tvs.clientsAddrHash, drop - tvs.clients );
+
 	drop->edict = NULL;
 	drop->relay = NULL;
 	drop->tv = false;
@@ -607,7 +609,7 @@ static bool TV_Downstream_ProcessPacket( netchan_t *netchan, msg_t *msg )
 	/*game_port = */MSG_ReadShort( msg );
 	if( msg->compressed )
 	{
-		zerror = Netchan_DecompressMessage( msg );
+		zerror = Netchan_DecompressMessage( netchan, msg );
 		if( zerror < 0 )
 		{          // compression error. Drop the packet
 			Com_DPrintf( "TV_Downstream_ProcessPacket: Compression error %i. Dropping packet\n", zerror );
@@ -618,12 +620,63 @@ static bool TV_Downstream_ProcessPacket( netchan_t *netchan, msg_t *msg )
 	return true;
 }
 
+/*
+* TV_Downstream_ReadPacket
+*/
+static void TV_Downstream_ReadPacket( socket_t *socket, const netadr_t *address, msg_t *msg )
+{
+	int i, game_port;
+	unsigned short remoteaddr_port, addr_port;
+	client_t *cl;
+
+	// check for upstreamless packet (0xffffffff) first
+	if( *(int *)msg->data == -1 )
+	{
+		TV_Downstream_UpstreamlessPacket( socket, address, msg );
+		return;
+	}
+
+	// read the game port out of the message so we can fix up
+	// stupid address translating routers
+	MSG_BeginReading( msg );
+	MSG_ReadLong( msg ); // sequence number
+	MSG_ReadLong( msg ); // sequence number
+	game_port = MSG_ReadShort( msg ) & 0xffff;
+	// data follows
+
+	// check for packets from connected clients
+	if( !tvs.clientsAddrHash )
+		return;
+	i = NET_AddrHashFind( tvs.clientsAddrHash, address, game_port );
+	if( i < 0 )
+		return;
+
+	cl = &tvs.clients[i];
+	if( cl->state == CS_FREE || cl->state == CS_ZOMBIE )
+		return;
+
+	remoteaddr_port = NET_GetAddressPort( &cl->netchan.remoteAddress );
+	addr_port = NET_GetAddressPort( address );
+	if( remoteaddr_port != addr_port )
+	{
+		Com_DPrintf( "%s" S_COLOR_WHITE ": Fixing up a translated port from %i to %i\n", cl->name,
+			remoteaddr_port, addr_port );
+		NET_SetAddressPort( &cl->netchan.remoteAddress, addr_port );
+	}
+
+	if( TV_Downstream_ProcessPacket( &cl->netchan, msg ) )
+	{                                           // this is a valid, sequenced packet, so process it
+		cl->lastPacketReceivedTime = tvs.realtime;
+		TV_Downstream_ParseClientMessage( cl, msg );
+	}
+}
+
 /*
 * TV_Downstream_ReadPackets
 */
 void TV_Downstream_ReadPackets( void )
 {
-	int i, socketind, ret, game_port;
+	int i, socketind, ret;
 	client_t *cl;
 #ifdef TCP_ALLOW_TVCONNECT
 	socket_t newsocket;
@@ -632,6 +685,9 @@ void TV_Downstream_ReadPackets( void )
 	netadr_t address;
 	msg_t msg;
 	uint8_t msgData[MAX_MSGLEN];
+	static netadr_t batchAddresses[MAX_PACKET_BATCH];
+	static msg_t batchMsgs[MAX_PACKET_BATCH];
+	static uint8_t batchMsgData[MAX_PACKET_BATCH][MAX_MSGLEN];
 
 #ifdef TCP_ALLOW_TVCONNECT
 	socket_t* tcpsockets [] =
@@ -648,6 +704,8 @@ void TV_Downstream_ReadPackets( void )
 	};
 
 	MSG_Init( &msg, msgData, sizeof( msgData ) );
+	for( i = 0; i < MAX_PACKET_BATCH; i++ )
+		MSG_Init( &batchMsgs[i], batchMsgData[i], sizeof( batchMsgData[i] ) );
 
 #ifdef TCP_ALLOW_TVCONNECT
 	for( socketind = 0; socketind < sizeof( tcpsockets ) / sizeof( tcpsockets[0] ); socketind++ )
@@ -713,57 +771,16 @@ void TV_Downstream_ReadPackets( void )
 	{
 		socket = sockets[socketind];
 
-		while( socket->open && ( ret = NET_GetPacket( socket, &address, &msg ) ) != 0 )
+		while( socket->open && ( ret = NET_GetPackets( socket, batchAddresses, batchMsgs, MAX_PACKET_BATCH ) ) != 0 )
 		{
 			if( ret == -1 )
 			{
-				Com_Printf( "NET_GetPacket: Error: %s\n", NET_ErrorString() );
+				Com_Printf( "NET_GetPackets: Error: %s\n", NET_ErrorString() );
 				continue;
 			}
 
-			// check for upstreamless packet (0xffffffff) first
-			if( *(int *)msg.data == -1 )
-			{
-				TV_Downstream_UpstreamlessPacket( socket, &address, &msg );
-				continue;
-			}
-
-			// read the game port out of the message so we can fix up
-			// stupid address translating routers
-			MSG_BeginReading( &msg );
-			MSG_ReadLong( &msg ); // sequence number
-			MSG_ReadLong( &msg ); // sequence number
-			game_port = MSG_ReadShort( &msg ) & 0xffff;
-			// data follows
-
-			// check for packets from connected clients
-			for( i = 0, cl = tvs.clients; i < tv_maxclients->integer; i++, cl++ )
-			{
-				unsigned short remoteaddr_port, addr_port;
-
-				if( cl->state == CS_FREE || cl->state == CS_ZOMBIE )
-					continue;
-				if( !NET_CompareBaseAddress( &address, &cl->netchan.remoteAddress ) )
-					continue;
-				if( cl->netchan.game_port != game_port )
-					continue;
-
-				remoteaddr_port = NET_GetAddressPort( &cl->netchan.remoteAddress );
-				addr_port = NET_GetAddressPort( &address );
-				if( remoteaddr_port != addr_port )
-				{
-					Com_DPrintf( "%s" S_COLOR_WHITE ": Fixing up a translated port from %i to %i\n", cl->name,
-						remoteaddr_port, addr_port );
-					NET_SetAddressPort( &cl->netchan.remoteAddress, addr_port );
-				}
-
-				if( TV_Downstream_ProcessPacket( &cl->netchan, &msg ) )
-				{                                           // this is a valid, sequenced packet, so process it
-					cl->lastPacketReceivedTime = tvs.realtime;
-					TV_Downstream_ParseClientMessage( cl, &msg );
-				}
-				break;
-			}
+			for( i = 0; i < ret; i++ )
+				TV_Downstream_ReadPacket( socket, &batchAddresses[i], &batchMsgs[i] );
 		}
 	}
 
@@ -953,6 +970,34 @@ void TV_Downstream_SendClientMessages( void )
 	}
 }
 
+/*
+* TV_Downstream_SendError
+* 
+* Called by the network code for each queued datagram it failed to send
+*/
+void TV_Downstream_SendError( const socket_t *socket, const netadr_t *address, const char *error )
+{
+	int i;
+	client_t *client;
+
+	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
+	{
+		if( client->state == CS_FREE || client->state == CS_ZOMBIE )
+			continue;
+		if( client->netchan.socket != socket || !NET_CompareAddress( &client->netchan.remoteAddress, address ) )
+			continue;
+
+		Com_Printf( "%s" S_COLOR_WHITE ": Error sending message: %s\n", client->name, error );
+		if( client->reliable )
+		{
+			TV_Downstream_DropClient( client, DROP_TYPE_GENERAL, "Error sending message: %s\n", error );
+		}
+		return;
+	}
+
+	Com_Printf( "Error sending packet to %s: %s\n", NET_AddressToString( address ), error );
+}
+
 /*
 * TV_Downstream_FindNextUserCommand - Returns the next valid usercmd_t in execution list
 */
@@ -42,6 +42,7 @@ void TV_Downstream_ReadPackets( void );
 void TV_Downstream_CheckTimeouts( void );
 bool TV_Downstream_SendClientsFragments( void );
 void TV_Downstream_SendClientMessages( void );
+void TV_Downstream_SendError( const socket_t *socket, const netadr_t *address, const char *error );
 void TV_Downstream_ExecuteClientThinks( relay_t *relay, client_t *client );
 void TV_Downstream_InitMaster( void );
 void TV_Downstream_MasterHeartbeat( void );
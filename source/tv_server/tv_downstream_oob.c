@@ -331,6 +331,7 @@ static bool TV_Downstream_ClientConnect( const socket_t *socket, const netadr_t
 		Netchan_Setup( &client->netchan, &client->socket, address, game_port );
 	else
 		Netchan_Setup( &client->netchan, socket, address, game_port );
+	NET_AddrHashLink( tvs.clientsAddrHash, client - tvs.clients, address, game_port );
 
 	// parse some info from the info strings
 	Q_strncpyz( client->userinfo, userinfo, sizeof( client->userinfo ) );
@@ -508,8 +509,11 @@ static void TV_Downstream_DirectConnect( const socket_t *socket, const netadr_t
 		return;
 	}
 
-	// send the connect packet to the client
-	Netchan_OutOfBandPrint( socket, address, "client_connect" );
+	// pick the compression codec from the client's offer, old clients only know zlib
+	newcl->netchan.codec = Com_NetCodecFromOffer( Cmd_Argc() >= 8 ? Cmd_Argv( 7 ) : NULL );
+
+	// send the connect packet to the client, we have no session to give
+	Netchan_OutOfBandPrint( socket, address, "client_connect\n\n%s", Com_NetCodecName( newcl->netchan.codec ) );
 
 	// free the incoming entry
 #ifdef TCP_ALLOW_TVCONNECT
@@ -103,6 +103,7 @@ typedef struct
 	unsigned int sentTimeStamp;         // time at what this frame snap was sent to the clients
 	unsigned int UcmdExecuted;
 	game_state_t gameState;
+	unsigned int viewId;                // frames with the same nonzero view are identical
 } client_snapshot_t;
 
 typedef enum { RD_NONE, RD_PACKET } redirect_t;
@@ -226,6 +227,7 @@ typedef struct
 #endif
 
 	client_t *clients;    // [tv_maxclients->integer];
+	netaddrhash_t *clientsAddrHash; // base address and game port to client slot
 	int nummvclients;
 
 	// relay
@@ -250,6 +252,7 @@ extern cvar_t *tv_zombietime;
 extern cvar_t *tv_maxclients;
 extern cvar_t *tv_maxmvclients;
 extern cvar_t *tv_compresspackets;
+extern cvar_t *tv_snapfanout;
 extern cvar_t *tv_reconnectlimit;
 extern cvar_t *tv_public;
 extern cvar_t *tv_autorecord;
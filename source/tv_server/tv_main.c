@@ -53,6 +53,7 @@ cvar_t *tv_zombietime;
 cvar_t *tv_maxclients;
 cvar_t *tv_maxmvclients;
 cvar_t *tv_compresspackets;
+cvar_t *tv_snapfanout;
 cvar_t *tv_name;
 cvar_t *tv_reconnectlimit; // minimum seconds between connect messages
 
@@ -101,6 +102,7 @@ void TV_Init( void )
 	tv_zombietime = Cvar_Get( "tv_zombietime", "2", 0 );
 	tv_name = Cvar_Get( "tv_name", APPLICATION "[TV]", CVAR_SERVERINFO | CVAR_ARCHIVE );
 	tv_compresspackets = Cvar_Get( "tv_compresspackets", "1", 0 );
+	tv_snapfanout = Cvar_Get( "tv_snapfanout", "1", 0 );
 	tv_maxclients = Cvar_Get( "tv_maxclients", "64", CVAR_ARCHIVE | CVAR_SERVERINFO | CVAR_NOSET );
 	tv_maxmvclients = Cvar_Get( "tv_maxmvclients", "4", CVAR_ARCHIVE | CVAR_SERVERINFO | CVAR_NOSET );
 	tv_public = Cvar_Get( "tv_public", "1", CVAR_ARCHIVE | CVAR_SERVERINFO );
@@ -125,10 +127,12 @@ void TV_Init( void )
 	if( tv_maxclients->integer )
 	{
 		tvs.clients = ( client_t * )Mem_Alloc( tv_mempool, sizeof( client_t ) * tv_maxclients->integer );
+		tvs.clientsAddrHash = NET_CreateAddrHash( tv_mempool, tv_maxclients->integer );
 	}
 	else
 	{
 		tvs.clients = NULL;
+		tvs.clientsAddrHash = NULL;
 	}
 	tvs.lobby.spawncount = rand();
 	tvs.lobby.snapFrameTime = 100;
@@ -220,6 +224,9 @@ void TV_Frame( int realmsec, int gamemsec )
 
 	tvs.realtime += realmsec;
 
+	// datagrams sent during the frame are pushed out together at the end of it
+	NET_BeginSendQueue( TV_Downstream_SendError );
+
 	TV_Lobby_Run();
 
 	for( i = 0; i < tvs.numupstreams; i++ )
@@ -243,6 +250,8 @@ void TV_Frame( int realmsec, int gamemsec )
 
 	TV_Downstream_MasterHeartbeat();
 
+	NET_FlushSendQueue();
+
 	Sys_Sleep( 5 );
 }
 
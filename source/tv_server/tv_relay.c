@@ -225,6 +225,8 @@ void TV_Relay_Shutdown( relay_t *relay, const char *format, ... )
 		}
 	}
 
+	TV_Relay_StopViewerLoad( relay );
+
 	if( relay->module_export )
 		TV_Relay_ShutdownModule( relay );
 
@@ -233,9 +235,14 @@ void TV_Relay_Shutdown( relay_t *relay, const char *format, ... )
 	if( relay->client_entities.entities )
 	{
 		Mem_Free( relay->client_entities.entities );
+		SNAP_FreeDeltaCache( &relay->client_entities.deltacache );
 		memset( &relay->client_entities, 0, sizeof( relay->client_entities ) );
 	}
 
+	SNAP_FreeFanoutCache( &relay->fanout );
+
+	SNAP_FreeVisCache( &relay->fatvis.viscache );
+
 	CM_ReleaseReference( relay->cms );
 	relay->cms = NULL;
 
@@ -442,6 +449,9 @@ void TV_Relay_Init( relay_t *relay, upstream_t *upstream, int delay )
 
 	relay->client_entities.num_entities = tv_maxclients->integer * UPDATE_BACKUP * MAX_SNAP_ENTITIES;
 	relay->client_entities.entities = Mem_Alloc( upstream->mempool, sizeof( entity_state_t ) * relay->client_entities.num_entities );
+	relay->client_entities.deltacache = SNAP_CreateDeltaCache( upstream->mempool );
+	relay->fanout = SNAP_CreateFanoutCache( upstream->mempool );
+	relay->fatvis.viscache = SNAP_CreateVisCache( upstream->mempool );
 
 	relay->cms = CM_New( upstream->mempool );
 	CM_AddReference( relay->cms );
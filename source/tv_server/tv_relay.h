@@ -52,6 +52,7 @@ struct packet_s
 typedef struct fatvis_s
 {
 	vec_t *skyorg;
+	struct snapvis_cache_s *viscache;	// shared culling results, may be NULL
 	uint8_t pvs[MAX_MAP_LEAFS/8];
 	uint8_t phs[MAX_MAP_LEAFS/8];
 } fatvis_t;
@@ -61,8 +62,27 @@ typedef struct client_entities_s
 	unsigned num_entities;				// maxclients->integer*UPDATE_BACKUP*MAX_PACKET_ENTITIES
 	unsigned next_entities;				// next client_entity to use
 	entity_state_t *entities;			// [num_entities]
+	struct snapdelta_cache_s *deltacache;	// shared encoded entity deltas, may be NULL
+	struct snapfanout_cache_s *fanout;		// shared client frames, may be NULL
 } client_entities_t;
 
+// synthetic viewers which get snapshots built and encoded but not sent,
+// for measuring how many viewers a relay can take
+typedef struct
+{
+	int numViewers;
+	int numMultiview;
+	client_t *viewers;
+	edict_t *edicts;					// what the viewers see through, like the module's spectators
+	gclient_t *gclients;
+	client_entities_t client_entities;
+	struct snapfanout_cache_s *fanout;
+
+	unsigned int frames;
+	uint64_t time;
+	uint64_t bytes;
+} viewerload_t;
+
 struct relay_s
 {
 	connstate_t state;
@@ -104,6 +124,8 @@ struct relay_s
 	unsigned int framenum;
 
 	client_entities_t client_entities;
+	struct snapfanout_cache_s *fanout;	// client_entities.fanout unless tv_snapfanout is 0
+	viewerload_t viewerload;
 
 	// serverdata
 	int playernum;
@@ -23,18 +23,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "tv_relay_client.h"
 
 #include "tv_relay.h"
+#include "tv_upstream.h"
 #include "tv_downstream.h"
 
 /*
-* TV_Relay_BuildClientFrameSnap
+* TV_Relay_SkyPortalOrigin
 */
-void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
+static vec_t *TV_Relay_SkyPortalOrigin( relay_t *relay, vec3_t origin )
 {
-	edict_t *clent;
-	entity_state_t backup_state = { 0 };
-	entity_shared_t backup_shared = { 0 };
-	vec_t *skyorg = NULL, origin[3];
-
 	if( relay->configstrings[CS_SKYBOX][0] != '\0' )
 	{
 		int noents = 0;
@@ -43,9 +39,23 @@ void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
 		if( sscanf( relay->configstrings[CS_SKYBOX], "%f %f %f %f %f %i", &origin[0], &origin[1], &origin[2], &f1, &f2, &noents ) >= 3 )
 		{
 			if( !noents )
-				skyorg = origin;
+				return origin;
 		}
 	}
+	return NULL;
+}
+
+/*
+* TV_Relay_BuildClientFrameSnap
+*/
+void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client, client_entities_t *client_entities, mempool_t *mempool )
+{
+	edict_t *clent;
+	entity_state_t backup_state = { 0 };
+	entity_shared_t backup_shared = { 0 };
+	vec_t *skyorg, origin[3];
+
+	skyorg = TV_Relay_SkyPortalOrigin( relay, origin );
 
 	// pretend client occupies our slot on real server
 	clent = client->edict;
@@ -79,8 +89,8 @@ void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client )
 	relay->fatvis.skyorg = skyorg;		// HACK HACK HACK
 	SNAP_BuildClientFrameSnap( relay->cms, &relay->gi, relay->framenum, relay->realtime, &relay->fatvis,
 		client, relay->module_export->GetGameState( relay->module ),
-		&relay->client_entities,
-		true, tv_mempool );
+		client_entities,
+		true, mempool );
 
 	if( relay->playernum >= 0 )
 	{
@@ -109,7 +119,7 @@ static bool TV_Relay_SendClientDatagram( relay_t *relay, client_t *client )
 
 	// send over all the relevant entity_state_t
 	// and the player_state_t
-	TV_Relay_BuildClientFrameSnap( relay, client );
+	TV_Relay_BuildClientFrameSnap( relay, client, &relay->client_entities, tv_mempool );
 
 	frame = relay->curFrame;
 	SNAP_WriteFrameSnapToClient( &relay->gi, client, &msg, relay->framenum, relay->serverTime, relay->baselines,
@@ -161,6 +171,152 @@ void TV_Relay_ReconnectClients( relay_t *relay )
 	}
 }
 
+/*
+* TV_Relay_StartViewerLoad
+* 
+* Adds synthetic viewers to the relay, the first ones multiview and the
+* rest spread over the players' POVs
+*/
+void TV_Relay_StartViewerLoad( relay_t *relay, int numViewers, int numMultiview )
+{
+	int i;
+	viewerload_t *load = &relay->viewerload;
+
+	TV_Relay_StopViewerLoad( relay );
+
+	if( numViewers <= 0 )
+		return;
+
+	load->numViewers = numViewers;
+	load->numMultiview = min( numMultiview, numViewers );
+	load->viewers = Mem_Alloc( relay->upstream->mempool, sizeof( client_t ) * numViewers );
+	load->edicts = Mem_Alloc( relay->upstream->mempool, sizeof( edict_t ) * numViewers );
+	load->gclients = Mem_Alloc( relay->upstream->mempool, sizeof( gclient_t ) * numViewers );
+	for( i = 0; i < numViewers; i++ )
+	{
+		load->edicts[i].r.client = &load->gclients[i];
+		load->viewers[i].edict = &load->edicts[i];
+		load->viewers[i].relay = relay;
+		load->viewers[i].reliable = true;
+		load->viewers[i].mv = ( i < load->numMultiview );
+		load->viewers[i].lastframe = -1;
+	}
+
+	// the viewers ack every frame right away, so only the last ones are delta'd from
+	load->client_entities.num_entities = numViewers * 8 * MAX_SNAP_ENTITIES;
+	load->client_entities.entities = Mem_Alloc( relay->upstream->mempool, sizeof( entity_state_t ) * load->client_entities.num_entities );
+	load->client_entities.deltacache = SNAP_CreateDeltaCache( relay->upstream->mempool );
+	load->fanout = SNAP_CreateFanoutCache( relay->upstream->mempool );
+
+	Com_Printf( "%s" S_COLOR_WHITE ": Added %i synthetic viewers (%i multiview)\n", relay->upstream->name, 
+		load->numViewers, load->numMultiview );
+}
+
+/*
+* TV_Relay_StopViewerLoad
+* 
+* Removes the synthetic viewers and reports what they cost
+*/
+void TV_Relay_StopViewerLoad( relay_t *relay )
+{
+	int i;
+	double frameTime, viewerTime;
+	snapfanoutstats_t stats;
+	viewerload_t *load = &relay->viewerload;
+
+	if( !load->viewers )
+		return;
+
+	if( load->frames )
+	{
+		SNAP_FanoutCacheStats( load->fanout, &stats );
+
+		frameTime = (double)load->time / load->frames;
+		viewerTime = frameTime / load->numViewers;
+
+		Com_Printf( "%s" S_COLOR_WHITE ": %i synthetic viewers (%i multiview), %u frames\n", relay->upstream->name, 
+			load->numViewers, load->numMultiview, load->frames );
+		Com_Printf( "%.3fms per frame, %.2fus per viewer, %u bytes per viewer\n", frameTime / 1000.0, viewerTime, 
+			(unsigned)( load->bytes / load->frames / load->numViewers ) );
+		if( relay->snapFrameTime && viewerTime > 0 )
+			Com_Printf( "%.0f viewers per core at %u snaps per second\n", 1000000.0 / ( viewerTime * 1000 / relay->snapFrameTime ),
+				1000 / relay->snapFrameTime );
+		if( stats.frames )
+			Com_Printf( "fan-out: %.1f views per frame, %u frames shared, %u encodings shared\n", (double)stats.builtFrames / stats.frames,
+				stats.sharedFrames, stats.reusedBodies );
+	}
+
+	for( i = 0; i < load->numViewers; i++ )
+		SNAP_FreeClientFrames( &load->viewers[i] );
+	Mem_Free( load->viewers );
+	Mem_Free( load->edicts );
+	Mem_Free( load->gclients );
+	Mem_Free( load->client_entities.entities );
+	SNAP_FreeDeltaCache( &load->client_entities.deltacache );
+	SNAP_FreeFanoutCache( &load->fanout );
+
+	memset( load, 0, sizeof( *load ) );
+}
+
+/*
+* TV_Relay_SendViewerLoad
+* 
+* Builds and encodes the frame for each synthetic viewer the same way as
+* for real ones, then throws the message away
+*/
+static void TV_Relay_SendViewerLoad( relay_t *relay )
+{
+	int i, numpovs;
+	int povs[MAX_CLIENTS];
+	uint8_t msg_buf[MAX_MSGLEN];
+	uint64_t time;
+	msg_t msg;
+	edict_t *ent, *pov;
+	client_t *viewer;
+	snapshot_t *frame;
+	viewerload_t *load = &relay->viewerload;
+
+	numpovs = 0;
+	for( i = 0; i < relay->gi.max_clients && i < relay->gi.num_edicts - 1; i++ )
+	{
+		ent = EDICT_NUM( relay, i + 1 );
+		if( ent->r.inuse && ent->r.client && !( ent->r.svflags & SVF_NOCLIENT ) )
+			povs[numpovs++] = i + 1;
+	}
+	if( !numpovs )
+		return;
+
+	load->client_entities.fanout = tv_snapfanout->integer ? load->fanout : NULL;
+	frame = relay->curFrame;
+
+	time = Sys_Microseconds();
+
+	for( i = 0, viewer = load->viewers; i < load->numViewers; i++, viewer++ )
+	{
+		// chase the POV through the viewer's own entity, which then takes our
+		// slot on the real server like a real viewer's does
+		pov = EDICT_NUM( relay, povs[i % numpovs] );
+		ent = viewer->edict;
+		ent->s = pov->s;
+		ent->r = pov->r;
+		ent->r.client = &load->gclients[i];
+		if( pov->r.client )
+			load->gclients[i] = *pov->r.client;
+
+		TV_Relay_BuildClientFrameSnap( relay, viewer, &load->client_entities, relay->upstream->mempool );
+
+		MSG_Init( &msg, msg_buf, sizeof( msg_buf ) );
+		SNAP_WriteFrameSnapToClient( &relay->gi, viewer, &msg, relay->framenum, relay->serverTime, relay->baselines,
+			&load->client_entities, frame->numgamecommands, frame->gamecommands, frame->gamecommandsData );
+
+		viewer->lastframe = relay->framenum;
+		load->bytes += msg.cursize;
+	}
+
+	load->time += Sys_Microseconds() - time;
+	load->frames++;
+}
+
 /*
 * TV_Relay_SendClientMessages
 */
@@ -171,6 +327,8 @@ void TV_Relay_SendClientMessages( relay_t *relay )
 
 	assert( relay );
 
+	relay->client_entities.fanout = tv_snapfanout->integer ? relay->fanout : NULL;
+
 	// send a message to each connected client
 	for( i = 0, client = tvs.clients; i < tv_maxclients->integer; i++, client++ )
 	{
@@ -189,6 +347,9 @@ void TV_Relay_SendClientMessages( relay_t *relay )
 			}
 		}
 	}
+
+	if( relay->viewerload.viewers )
+		TV_Relay_SendViewerLoad( relay );
 }
 
 /*
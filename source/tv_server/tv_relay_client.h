@@ -32,6 +32,9 @@ bool TV_Relay_CanConnect( relay_t *relay, client_t *client, char *userinfo );
 void TV_Relay_ClientConnect( relay_t *relay, client_t *client );
 bool TV_Relay_ClientCommand_f( relay_t *relay, client_t *client );
 
-void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client );
+void TV_Relay_BuildClientFrameSnap( relay_t *relay, client_t *client, struct client_entities_s *client_entities, mempool_t *mempool );
+
+void TV_Relay_StartViewerLoad( relay_t *relay, int numViewers, int numMultiview );
+void TV_Relay_StopViewerLoad( relay_t *relay );
 
 #endif // __TV_RELAY_CLIENT_H
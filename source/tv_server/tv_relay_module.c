@@ -66,7 +66,7 @@ static inline void TV_Module_CM_TransformedBoxTrace( relay_t *relay, trace_t *tr
 		return;
 	}
 
-	CM_TransformedBoxTrace( relay->cms, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
+	CM_TransformedBoxTrace( relay->cms, NULL, tr, start, end, mins, maxs, cmodel, brushmask, origin, angles );
 }
 
 static inline void TV_Module_CM_RoundUpToHullSize( relay_t *relay, vec3_t mins, vec3_t maxs, struct cmodel_s *cmodel )
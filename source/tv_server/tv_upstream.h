@@ -94,6 +94,7 @@ struct upstream_s
 
 		bool playing;
 		int filehandle;
+		snapdemowriter_t *writer;
 		int filelen;
 		char *filename, *tempname;
 		bool random;
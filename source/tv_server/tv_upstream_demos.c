@@ -177,7 +177,10 @@ void TV_Upstream_WriteDemoMessage( upstream_t *upstream, msg_t *msg )
 	}
 
 	// the first eight bytes are just packet sequencing stuff
-	SNAP_RecordDemoMessage( upstream->demo.filehandle, msg, 8 );
+	if( upstream->demo.writer )
+		SNAP_DemoWriterRecordMessage( upstream->demo.writer, msg, 8 );
+	else
+		SNAP_RecordDemoMessage( upstream->demo.filehandle, msg, 8 );
 }
 
 /*
@@ -264,6 +267,8 @@ void TV_Upstream_StartDemoRecord( upstream_t *upstream, const char *demoname, bo
 */
 void TV_Upstream_StopDemoRecord( upstream_t *upstream, bool silent, bool cancel )
 {
+	snapdemowriterstats_t stats = { 0 };
+
 	assert( upstream );
 
 	if( !upstream->demo.recording )
@@ -273,7 +278,10 @@ void TV_Upstream_StopDemoRecord( upstream_t *upstream, bool silent, bool cancel
 		return;
 	}
 
-	// finish up
+	// flush the pending frames and finish up
+	SNAP_DestroyDemoWriter( &upstream->demo.writer, &stats );
+	if( stats.errors )
+		Com_Printf( S_COLOR_YELLOW "Warning: %u demo messages failed to write\n", stats.errors );
 	SNAP_StopDemoRecording( upstream->demo.filehandle );
 
 	FS_FCloseFile( upstream->demo.filehandle );
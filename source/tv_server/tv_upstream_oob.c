@@ -52,10 +52,16 @@ static void TV_Upstream_Challenge_f( upstream_t *upstream, msg_t *msg )
 */
 static void TV_Upstream_ClientConnectPacket( upstream_t *upstream, msg_t *msg )
 {
+	int codec;
+
 	if( upstream->state != CA_CONNECTING )
 		return;
 
+	MSG_ReadStringLine( msg ); // session
+	codec = Com_NetCodecForName( MSG_ReadStringLine( msg ) );
+
 	Netchan_Setup( &upstream->netchan, upstream->socket, &upstream->serveraddress, Netchan_GamePort() );
+	upstream->netchan.codec = codec < 0 ? NETCODEC_ZLIB : codec;
 	upstream->state = CA_HANDSHAKE;
 	TV_Upstream_AddReliableCommand( upstream, "new" );
 
@@ -51,6 +51,9 @@ static void TV_Upstream_ParseFrame( upstream_t *upstream, msg_t *msg )
 			SNAP_BeginDemoRecording( upstream->demo.filehandle, 0x10000 + upstream->servercount, 
 				upstream->snapFrameTime, upstream->levelname, upstream->reliable ? SV_BITFLAGS_RELIABLE : 0, 
 				upstream->purelist, upstream->configstrings[0], upstream->baselines );
+
+			// the frames are written from now on by the writer thread
+			upstream->demo.writer = SNAP_CreateDemoWriter( upstream->demo.filehandle, SNAP_DEMO_WRITER_BUFSIZE );
 		}
 
 		if( !upstream->demo.waiting )